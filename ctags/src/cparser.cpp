@@ -0,0 +1,808 @@
+/*
+  Copyright (C) 2000 Konstantin Stupnik
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+  Built-in generator of tags for C/C++ declarations.
+  Produces lines in the same extended format as exuberant ctags
+  with --fields=+n, so they can be merged directly into tags file.
+  Function bodies are skipped, only declarations in file, namespace
+  and class scope are tagged.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include "String.hpp"
+#include "Array.hpp"
+#include "tags.h"
+
+enum TokenType{
+  tkEof,
+  tkIdent,
+  tkNumber,
+  tkString,
+  tkPunct,
+  tkScope,
+};
+
+struct Token{
+  int type;
+  const char *start;
+  int len;
+  int line;
+  const char *linestart;
+
+  bool Is(const char* str)const
+  {
+    return (int)strlen(str)==len && !strncmp(start,str,len);
+  }
+  bool IsPunct(char c)const
+  {
+    return type==tkPunct && *start==c;
+  }
+};
+
+enum ScopeType{
+  stBlock,
+  stExtern,
+  stNamespace,
+  stClass,
+  stStruct,
+  stUnion,
+  stEnum,
+};
+
+struct Scope{
+  int type;
+  String name;
+  bool isTypedef;
+};
+
+static const char* keywords[]={
+  "alignas","alignof","asm","auto","bool","break","case","catch","char",
+  "class","const","constexpr","const_cast","continue","decltype","default",
+  "delete","do","double","dynamic_cast","else","enum","explicit","export",
+  "extern","false","final","float","for","friend","goto","if","inline","int",
+  "long","mutable","namespace","new","noexcept","nullptr","operator",
+  "override","private","protected","public","register","reinterpret_cast",
+  "return","short","signed","sizeof","static","static_assert","static_cast",
+  "struct","switch","template","this","throw","true","try","typedef",
+  "typeid","typename","union","unsigned","using","virtual","void","volatile",
+  "wchar_t","while","__attribute__","__declspec","__cdecl","__stdcall",
+  "__fastcall","__inline","__forceinline",NULL
+};
+
+static bool IsKeyword(const Token& t)
+{
+  if(t.type!=tkIdent)return false;
+  for(const char** kw=keywords;*kw;kw++)
+  {
+    if(t.Is(*kw))return true;
+  }
+  return false;
+}
+
+static bool IsName(const Token& t)
+{
+  return t.type==tkIdent && !IsKeyword(t);
+}
+
+class CParser{
+protected:
+  const char *p;
+  const char *end;
+  int line;
+  const char *linestart;
+  const char *file;
+  Vector<char*>& dst;
+  Vector<Token> stmt;
+  Array<Scope> scopes;
+
+  void NewLine()
+  {
+    line++;
+    linestart=p;
+  }
+
+  void SkipLine()
+  {
+    while(p<end && *p!='\n')
+    {
+      if(*p=='\\' && p+1<end && p[1]=='\n')
+      {
+        p+=2;
+        NewLine();
+        continue;
+      }
+      p++;
+    }
+  }
+
+  void SkipBlockComment()
+  {
+    p+=2;
+    while(p<end && !(*p=='*' && p+1<end && p[1]=='/'))
+    {
+      if(*p++=='\n')NewLine();
+    }
+    if(p<end)p+=2;
+  }
+
+  void Preprocessor();
+  void SkipBranch(bool toEndif);
+  Token Next();
+
+  void AddTag(const Token& name,char kind,const String& nameOverride,
+              const String& qualifier);
+  String ScopePath(int& kind);
+
+  int FindFunction(int& nameFrom,int& nameTo);
+  void TagFunction(int nameFrom,int nameTo,char kind);
+  bool FindClass(int& kwIdx,int& nameIdx);
+  void TagVariables(char kind);
+  void SkipBlock();
+  void SkipAngles();
+  bool OpenBrace();
+  void EndStatement();
+public:
+  CParser(const char* data,int size,const char* tagfile,Vector<char*>& lines):
+    p(data),end(data+size),line(1),linestart(data),file(tagfile),dst(lines){}
+  void Parse();
+};
+
+void CParser::Preprocessor()
+{
+  p++;
+  while(p<end && (*p==' ' || *p=='\t'))p++;
+  const char *d=p;
+  while(p<end && isalpha(*p))p++;
+  if(p-d==6 && !strncmp(d,"define",6))
+  {
+    while(p<end && (*p==' ' || *p=='\t'))p++;
+    Token t;
+    t.type=tkIdent;
+    t.start=p;
+    t.line=line;
+    t.linestart=linestart;
+    while(p<end && (isalnum(*p) || *p=='_' || *p=='$'))p++;
+    t.len=p-t.start;
+    if(t.len)AddTag(t,'d',String(),String());
+  }else if(p-d==2 && !strncmp(d,"if",2))
+  {
+    while(p<end && (*p==' ' || *p=='\t'))p++;
+    if(p<end && *p=='0' && (p+1==end || !isalnum(p[1])))
+    {
+      SkipLine();
+      SkipBranch(false);
+      return;
+    }
+  }else if(p-d==4 && (!strncmp(d,"else",4) || !strncmp(d,"elif",4)))
+  {
+    //only the first branch is followed, as ctags does,
+    //so that braces opened in both branches are counted once
+    SkipLine();
+    SkipBranch(true);
+    return;
+  }
+  SkipLine();
+}
+
+/*
+  Skip lines of conditional branch up to its #endif, or up to
+  #else or #elif of the same level unless toEndif. Branch after
+  #if 0 is followed like the first one.
+*/
+void CParser::SkipBranch(bool toEndif)
+{
+  int depth=0;
+  while(p<end)
+  {
+    if(*p=='\n')
+    {
+      p++;
+      NewLine();
+    }
+    while(p<end && (*p==' ' || *p=='\t'))p++;
+    if(p<end && *p=='#')
+    {
+      p++;
+      while(p<end && (*p==' ' || *p=='\t'))p++;
+      const char *d=p;
+      while(p<end && isalpha(*p))p++;
+      int len=p-d;
+      if(len>=2 && !strncmp(d,"if",2))
+      {
+        depth++;
+      }else if(len==5 && !strncmp(d,"endif",5))
+      {
+        if(depth--==0)
+        {
+          SkipLine();
+          return;
+        }
+      }else if(depth==0 && !toEndif && len==4 &&
+               (!strncmp(d,"else",4) || !strncmp(d,"elif",4)))
+      {
+        SkipLine();
+        return;
+      }
+      SkipLine();
+      continue;
+    }
+    //comments may hide directives: /* #endif */
+    while(p<end && *p!='\n')
+    {
+      if(*p=='/' && p+1<end && p[1]=='*')
+      {
+        SkipBlockComment();
+      }else if(*p=='/' && p+1<end && p[1]=='/')
+      {
+        SkipLine();
+      }else if(*p=='\\' && p+1<end && p[1]=='\n')
+      {
+        p+=2;
+        NewLine();
+      }else
+      {
+        p++;
+      }
+    }
+  }
+}
+
+Token CParser::Next()
+{
+  Token t;
+  for(;;)
+  {
+    while(p<end && isspace(*p))
+    {
+      if(*p++=='\n')NewLine();
+    }
+    if(p>=end)
+    {
+      t.type=tkEof;
+      t.start=p;
+      t.len=0;
+      t.line=line;
+      t.linestart=linestart;
+      return t;
+    }
+    if(*p=='/' && p+1<end && p[1]=='/')
+    {
+      SkipLine();
+      continue;
+    }
+    if(*p=='/' && p+1<end && p[1]=='*')
+    {
+      SkipBlockComment();
+      continue;
+    }
+    if(*p=='#')
+    {
+      const char *q=p;
+      while(q>linestart && (q[-1]==' ' || q[-1]=='\t'))q--;
+      if(q==linestart)
+      {
+        Preprocessor();
+        continue;
+      }
+    }
+    break;
+  }
+  t.start=p;
+  t.line=line;
+  t.linestart=linestart;
+  if(isalpha(*p) || *p=='_' || *p=='$')
+  {
+    t.type=tkIdent;
+    while(p<end && (isalnum(*p) || *p=='_' || *p=='$'))p++;
+  }else if(isdigit(*p))
+  {
+    t.type=tkNumber;
+    while(p<end && (isalnum(*p) || *p=='.' || *p=='\''))p++;
+  }else if(*p=='"' || *p=='\'')
+  {
+    t.type=tkString;
+    char q=*p++;
+    while(p<end && *p!=q && *p!='\n')
+    {
+      if(*p=='\\' && p+1<end)p++;
+      p++;
+    }
+    if(p<end && *p==q)p++;
+  }else if(*p==':' && p+1<end && p[1]==':')
+  {
+    t.type=tkScope;
+    p+=2;
+  }else
+  {
+    t.type=tkPunct;
+    p++;
+  }
+  t.len=p-t.start;
+  return t;
+}
+
+//qualified name of current scope and kind of innermost named scope
+String CParser::ScopePath(int& kind)
+{
+  String path;
+  kind=stBlock;
+  for(int i=0;i<scopes.Count();i++)
+  {
+    if(scopes[i].name.Length()==0)continue;
+    if(path.Length())path+="::";
+    path+=scopes[i].name;
+    kind=scopes[i].type;
+  }
+  return path;
+}
+
+void CParser::AddTag(const Token& name,char kind,const String& nameOverride,
+                     const String& qualifier)
+{
+  String tag;
+  if(nameOverride.Length())
+  {
+    tag=nameOverride;
+  }else
+  {
+    tag.Set(name.start,0,name.len);
+  }
+  tag+='\t';
+  tag+=file;
+  tag+="\t/^";
+  const char *eol=name.linestart;
+  while(eol<end && *eol!='\n' && *eol!='\r')eol++;
+  const int maxpattern=512;
+  bool full=eol-name.linestart<=maxpattern;
+  if(!full)eol=name.linestart+maxpattern;
+  for(const char* c=name.linestart;c<eol;c++)
+  {
+    if(*c=='\\' || *c=='/')tag+='\\';
+    tag+=*c;
+  }
+  if(full)tag+='$';
+  tag+="/;\"\t";
+  tag+=kind;
+  tag+="\tline:";
+  tag+=name.line;
+  int sk=stBlock;
+  String scope=kind=='d'?String():ScopePath(sk);
+  if(qualifier.Length())
+  {
+    if(scope.Length())scope+="::";
+    scope+=qualifier;
+    sk=stClass;
+  }
+  if(scope.Length())
+  {
+    const char *skname="class";
+    switch(sk)
+    {
+      case stNamespace:skname="namespace";break;
+      case stStruct:skname="struct";break;
+      case stUnion:skname="union";break;
+      case stEnum:skname="enum";break;
+    }
+    tag+='\t';
+    tag+=skname;
+    tag+=':';
+    tag+=scope;
+  }
+  tag+='\n';
+  dst.Push(strdup(tag));
+}
+
+/*
+  Find name of function in current statement.
+  Parameter list is the last top level '(' that follows a name,
+  constructor initializer list, trailing return type and
+  initializers end the search.
+  Returns index of the '(' or -1.
+*/
+int CParser::FindFunction(int& nameFrom,int& nameTo)
+{
+  int depth=0,paren=-1;
+  for(int i=0;i<stmt.Count();i++)
+  {
+    const Token& t=stmt[i];
+    if(depth==0 && t.Is("operator"))
+    {
+      //operator name extends up to its parameter list: operator==, operator()
+      int j=i+1;
+      if(j+1<stmt.Count() && stmt[j].IsPunct('(') && stmt[j+1].IsPunct(')'))j+=2;
+      while(j<stmt.Count() && !stmt[j].IsPunct('('))j++;
+      if(j==stmt.Count())return -1;
+      paren=j;
+      nameFrom=i;
+      nameTo=j-1;
+      depth++;
+      i=j;
+    }else if(t.IsPunct('('))
+    {
+      if(depth==0 && i>0 && IsName(stmt[i-1]))
+      {
+        paren=i;
+        nameFrom=nameTo=i-1;
+        if(nameFrom>0 && stmt[nameFrom-1].IsPunct('~'))nameFrom--;
+      }
+      depth++;
+    }else if(t.IsPunct(')'))
+    {
+      if(depth>0)depth--;
+    }else if(depth==0)
+    {
+      if(t.IsPunct('=') && paren==-1)return -1;
+      if(paren!=-1 && (t.IsPunct(':') || t.IsPunct('=')))break;
+      if(t.IsPunct('-') && i+1<stmt.Count() && stmt[i+1].IsPunct('>'))break;
+    }
+  }
+  if(paren==-1)return -1;
+  while(nameFrom>1 && stmt[nameFrom-1].type==tkScope && stmt[nameFrom-2].type==tkIdent)
+  {
+    nameFrom-=2;
+  }
+  return paren;
+}
+
+void CParser::TagFunction(int nameFrom,int nameTo,char kind)
+{
+  //name is the part after last ::, the rest is class qualifier
+  int last=nameFrom;
+  for(int i=nameFrom;i<=nameTo;i++)
+  {
+    if(stmt[i].type==tkScope)last=i+1;
+  }
+  String name,qualifier;
+  for(int i=nameFrom;i<last-1;i++)
+  {
+    qualifier.Concat(stmt[i].start,0,stmt[i].len);
+  }
+  for(int i=last;i<=nameTo;i++)
+  {
+    if(i>last && stmt[i].type==tkIdent && stmt[i-1].type==tkIdent)name+=' ';
+    name.Concat(stmt[i].start,0,stmt[i].len);
+  }
+  AddTag(stmt[last],kind,name,qualifier);
+}
+
+bool CParser::FindClass(int& kwIdx,int& nameIdx)
+{
+  int depth=0;
+  for(int i=0;i<stmt.Count();i++)
+  {
+    const Token& t=stmt[i];
+    if(t.IsPunct('(') || t.IsPunct('<'))depth++;
+    else if((t.IsPunct(')') || t.IsPunct('>')) && depth>0)depth--;
+    else if(depth==0 && (t.Is("class") || t.Is("struct") || t.Is("union") || t.Is("enum")))
+    {
+      kwIdx=i;
+      int j=i+1;
+      if(t.Is("enum") && j<stmt.Count() && (stmt[j].Is("class") || stmt[j].Is("struct")))j++;
+      while(j<stmt.Count() && (stmt[j].Is("__declspec") || stmt[j].Is("__attribute__") ||
+                               stmt[j].Is("alignas")))
+      {
+        j++;
+        if(j<stmt.Count() && stmt[j].IsPunct('('))
+        {
+          int d=0;
+          for(;j<stmt.Count();j++)
+          {
+            if(stmt[j].IsPunct('('))d++;
+            else if(stmt[j].IsPunct(')') && --d==0)break;
+          }
+          j++;
+        }
+      }
+      nameIdx=-1;
+      while(j<stmt.Count() && (stmt[j].type==tkIdent || stmt[j].type==tkScope))
+      {
+        if(stmt[j].type==tkIdent && !stmt[j].Is("final"))nameIdx=j;
+        j++;
+      }
+      if(j==stmt.Count() || stmt[j].IsPunct(':'))return true;
+      if(stmt[j].IsPunct('<'))return true;
+    }
+  }
+  return false;
+}
+
+void CParser::TagVariables(char kind)
+{
+  int depth=0,angle=0;
+  int last=-1,qual=-1;
+  bool init=false;
+  for(int i=0;i<=stmt.Count();i++)
+  {
+    if(i==stmt.Count() || (depth==0 && angle==0 &&
+       (stmt[i].IsPunct(',') || stmt[i].IsPunct('=') ||
+        stmt[i].IsPunct('[') || stmt[i].IsPunct(':'))))
+    {
+      if(!init && last!=-1)
+      {
+        //qualified definition of static member: int A::b=0;
+        String qualifier;
+        for(int j=qual;j<last-1;j++)
+        {
+          qualifier.Concat(stmt[j].start,0,stmt[j].len);
+        }
+        AddTag(stmt[last],qualifier.Length()?'m':kind,String(),qualifier);
+      }
+      last=-1;
+      if(i==stmt.Count())break;
+      init=!stmt[i].IsPunct(',');
+      continue;
+    }
+    const Token& t=stmt[i];
+    if(t.IsPunct('(') || t.IsPunct('[') || t.IsPunct('{'))
+    {
+      depth++;
+    }else if(t.IsPunct(')') || t.IsPunct(']') || t.IsPunct('}'))
+    {
+      if(depth>0)depth--;
+    }else if(init)
+    {
+      continue;
+    }else if(t.IsPunct('<') && i>0 && stmt[i-1].type==tkIdent)
+    {
+      angle++;
+    }else if(t.IsPunct('>') && angle>0)
+    {
+      angle--;
+    }else if(IsName(t) && angle==0)
+    {
+      //name in parens is allowed only as (*name) or (&name)
+      if(depth==0 || (i>1 && (stmt[i-1].IsPunct('*') || stmt[i-1].IsPunct('&')) &&
+                      stmt[i-2].IsPunct('(')))
+      {
+        last=qual=i;
+        while(qual>1 && stmt[qual-1].type==tkScope && stmt[qual-2].type==tkIdent)qual-=2;
+      }
+    }
+  }
+}
+
+void CParser::SkipBlock()
+{
+  int depth=1;
+  for(;;)
+  {
+    Token t=Next();
+    if(t.type==tkEof)return;
+    if(t.IsPunct('{'))depth++;
+    else if(t.IsPunct('}') && --depth==0)return;
+  }
+}
+
+void CParser::SkipAngles()
+{
+  Token t=Next();
+  if(!t.IsPunct('<'))
+  {
+    p=t.start;
+    return;
+  }
+  int depth=1;
+  while(depth>0)
+  {
+    t=Next();
+    if(t.type==tkEof)return;
+    if(t.IsPunct('<'))depth++;
+    else if(t.IsPunct('>'))depth--;
+    else if(t.IsPunct('{') || t.IsPunct(';'))
+    {
+      p=t.start;
+      return;
+    }
+  }
+}
+
+/*
+  Handle '{' that ends the tokens of current statement.
+  Returns true if the statement goes on after the block,
+  as declarators do after initializer: int a[]={1,2},b;
+*/
+bool CParser::OpenBrace()
+{
+  int kw,name;
+  bool isTypedef=stmt.Count() && stmt[0].Is("typedef");
+  if(stmt.Count() && stmt[0].Is("namespace"))
+  {
+    Scope s;
+    s.type=stNamespace;
+    s.isTypedef=false;
+    if(stmt.Count()>1 && stmt[1].type==tkIdent)
+    {
+      AddTag(stmt[1],'n',String(),String());
+      s.name.Set(stmt[1].start,0,stmt[1].len);
+    }
+    scopes.Push(s);
+    return false;
+  }
+  if(stmt.Count()==2 && stmt[0].Is("extern") && stmt[1].type==tkString)
+  {
+    Scope s;
+    s.type=stExtern;
+    s.isTypedef=false;
+    scopes.Push(s);
+    return false;
+  }
+  if(FindClass(kw,name))
+  {
+    Scope s;
+    const Token& k=stmt[kw];
+    s.type=k.Is("class")?stClass:k.Is("struct")?stStruct:k.Is("union")?stUnion:stEnum;
+    s.isTypedef=isTypedef;
+    if(name!=-1)
+    {
+      static const char kinds[]={'c','s','u','g'};
+      AddTag(stmt[name],kinds[s.type-stClass],String(),String());
+      s.name.Set(stmt[name].start,0,stmt[name].len);
+    }
+    scopes.Push(s);
+    return false;
+  }
+  int from,to;
+  if(FindFunction(from,to)!=-1)
+  {
+    TagFunction(from,to,'f');
+    SkipBlock();
+    return false;
+  }
+  SkipBlock();
+  //initializer: int a[]={1,2}; Point p{1,2}; auto f=[](){};
+  bool init=stmt.Count()>1 && IsName(stmt[-1]);
+  for(int i=0;i<stmt.Count() && !init;i++)
+  {
+    init=stmt[i].IsPunct('=');
+  }
+  if(!init)return false;
+  Token t;
+  t.type=tkPunct;
+  t.start="}";
+  t.len=1;
+  t.line=line;
+  t.linestart=linestart;
+  stmt.Push(t);
+  return true;
+}
+
+void CParser::EndStatement()
+{
+  if(stmt.Count()==0)return;
+  const Token& first=stmt[0];
+  bool inClass=scopes.Count() && scopes[-1].type>=stClass && scopes[-1].type!=stEnum;
+  if(first.Is("using") || first.Is("friend") || first.Is("return") ||
+     first.Is("static_assert") || first.Is("namespace"))
+  {
+    stmt.Clean();
+    return;
+  }
+  if(first.Is("typedef"))
+  {
+    TagVariables('t');
+    stmt.Clean();
+    return;
+  }
+  int kw,name;
+  if(stmt.Count()<=3 && FindClass(kw,name))
+  {
+    //forward declaration
+    stmt.Clean();
+    return;
+  }
+  int from,to;
+  if(FindFunction(from,to)!=-1)
+  {
+    TagFunction(from,to,'p');
+  }else if(!first.Is("extern"))
+  {
+    TagVariables(inClass?'m':'v');
+  }
+  stmt.Clean();
+}
+
+void CParser::Parse()
+{
+  for(;;)
+  {
+    Token t=Next();
+    if(t.type==tkEof)break;
+    bool inEnum=scopes.Count() && scopes[-1].type==stEnum;
+    if(inEnum)
+    {
+      if(t.IsPunct(',') || t.IsPunct('}'))
+      {
+        if(stmt.Count() && IsName(stmt[0]))AddTag(stmt[0],'e',String(),String());
+        stmt.Clean();
+      }
+      if(!t.IsPunct('}'))
+      {
+        if(!t.IsPunct(','))stmt.Push(t);
+        continue;
+      }
+    }
+    if(t.IsPunct(';'))
+    {
+      EndStatement();
+    }else if(t.IsPunct('{'))
+    {
+      if(!OpenBrace())stmt.Clean();
+    }else if(t.IsPunct('}'))
+    {
+      stmt.Clean();
+      if(scopes.Count()==0)continue;
+      Scope s;
+      scopes.Pop(s);
+      //declarators after class body: typedef struct {...} name;
+      if(s.type>=stClass && s.isTypedef)
+      {
+        Token td;
+        td.type=tkIdent;
+        td.start="typedef";
+        td.len=7;
+        td.line=line;
+        td.linestart=linestart;
+        stmt.Push(td);
+      }
+    }else if(t.Is("template") && stmt.Count()==0)
+    {
+      SkipAngles();
+    }else if(t.IsPunct(':') && stmt.Count()==1 &&
+             (stmt[0].Is("public") || stmt[0].Is("private") || stmt[0].Is("protected")))
+    {
+      stmt.Clean();
+    }else
+    {
+      stmt.Push(t);
+    }
+  }
+}
+
+static const char* cppExts[]={
+  ".c",".cc",".cpp",".cxx",".c++",".h",".hh",".hpp",".hxx",".h++",".inl",NULL
+};
+
+bool IsCppFile(const char* filename)
+{
+  const char *ext=strrchr(filename,'.');
+  if(!ext)return false;
+  for(const char** e=cppExts;*e;e++)
+  {
+    if(!stricmp(ext,*e))return true;
+  }
+  return false;
+}
+
+int GenerateTags(const char* filename,const char* tagfile,Vector<char*>& dst)
+{
+  FILE *f=fopen(filename,"rb");
+  if(!f)return 0;
+  fseek(f,0,SEEK_END);
+  long size=ftell(f);
+  fseek(f,0,SEEK_SET);
+  char *data=new char[size+1];
+  size=fread(data,1,size,f);
+  fclose(f);
+  data[size]=0;
+  CParser parser(data,size,tagfile,dst);
+  parser.Parse();
+  delete [] data;
+  return 1;
+}
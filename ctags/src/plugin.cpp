@@ -616,6 +616,7 @@ static void UpdateConfig()
     config.exe="ctags.exe";
     config.opt="--c++-types=+px --c-types=+px --fields=+n";
     config.autoload="";
+    config.builtin=true;
     memset(wordChars,0,sizeof(wordChars));
     for(int i=0;i<256;i++)
     {
@@ -666,6 +667,13 @@ static void UpdateConfig()
   {
     config.casesens=true;
   }
+  if(r.Get("builtinparser",buf,sizeof(buf)))
+  {
+    config.builtin=!stricmp(buf,"true");
+  }else
+  {
+    config.builtin=true;
+  }
 }
 
 FARAPI(HANDLE) OpenPlugin(int OpenFrom,int Item)
@@ -685,14 +693,15 @@ FARAPI(HANDLE) OpenPlugin(int OpenFrom,int Item)
     MenuList ml;
     enum{
       miFindSymbol,miUndo,miResetUndo,
-      miComplete,miBrowseFile,miBrowseClass,
+      miComplete,miBrowseFile,miBrowseClass,miGotoSymbol,
     };
     ml<<MI(MFindSymbol,miFindSymbol)
       <<MI(MCompleteSymbol,miComplete)
       <<MI(MUndoNavigation,miUndo)
       <<MI(MResetUndo,miResetUndo)
       <<MI(MBrowseSymbolsInFile,miBrowseFile)
-      <<MI(MBrowseClass,miBrowseClass);
+      <<MI(MBrowseClass,miBrowseClass)
+      <<MI(MGotoSymbol,miGotoSymbol);
     int res=Menu(GetMsg(MPlugin),ml,0);
     if(res==-1)return INVALID_HANDLE_VALUE;
     switch(res)
@@ -818,6 +827,25 @@ FARAPI(HANDLE) OpenPlugin(int OpenFrom,int Item)
         if(ti)NavigateTo(ti);
         FreeTagsArray(ta);
       }break;
+      case miGotoSymbol:
+      {
+        String word=GetWord();
+        char buf[256];
+        if(!I.InputBox(GetMsg(MGotoSymbolTitle),GetMsg(MInputSymbol),NULL,
+                    word,buf,sizeof(buf),NULL,0))return INVALID_HANDLE_VALUE;
+        if(!buf[0])return INVALID_HANDLE_VALUE;
+        EditorInfo ei;
+        I.EditorControl(ECTL_GETINFO,&ei);
+        PTagArray ta=FindFuzzy(ei.FileName,buf,100);
+        if(!ta)
+        {
+          Msg(MNothingFound);
+          return INVALID_HANDLE_VALUE;
+        }
+        TagInfo *ti=TagsMenu(ta);
+        if(ti)NavigateTo(ti);
+        FreeTagsArray(ta);
+      }break;
     }
   }
   else
@@ -981,7 +1009,7 @@ FARAPI(int) Configure(int item)
 {
   struct InitDialogItem InitItems[]={
         /*Type         X1 Y2 X2 Y2  F S           Flags D Data */
-/*00*/    DI_DOUBLEBOX, 3, 1,64,13, 0,0,              0,0,(char*)MPlugin,
+/*00*/    DI_DOUBLEBOX, 3, 1,64,14, 0,0,              0,0,(char*)MPlugin,
 /*01*/    DI_TEXT,      5, 2, 0, 0, 0,0,              0,0,(char*)MPathToExe,
 /*02*/    DI_EDIT,      5, 3,62, 3, 1,0,              0,0,"",
 /*03*/    DI_TEXT,      5, 4, 0, 0, 0,0,              0,0,(char*)MCmdLineOptions,
@@ -991,9 +1019,10 @@ FARAPI(int) Configure(int item)
 /*07*/    DI_TEXT,      5, 8, 0, 0, 0,0,              0,0,(char*)MWordChars,
 /*08*/    DI_EDIT,      5, 9,62, 9, 1,0,              0,0,"",
 /*09*/    DI_CHECKBOX,  5, 10,62,10,1,0,              0,0,(char*)MCaseSensFilt,
-/*10*/    DI_TEXT,      5,11,62,10, 1,0,DIF_SEPARATOR|DIF_BOXCOLOR,0,"",
-/*11*/    DI_BUTTON,    0,12, 0, 0, 0,0,DIF_CENTERGROUP,1,(char *)MOk,
-/*12*/    DI_BUTTON,    0,12, 0, 0, 0,0,DIF_CENTERGROUP,0,(char *)MCancel
+/*10*/    DI_CHECKBOX,  5, 11,62,11,1,0,              0,0,(char*)MBuiltinParser,
+/*11*/    DI_TEXT,      5,12,62,11, 1,0,DIF_SEPARATOR|DIF_BOXCOLOR,0,"",
+/*12*/    DI_BUTTON,    0,13, 0, 0, 0,0,DIF_CENTERGROUP,1,(char *)MOk,
+/*13*/    DI_BUTTON,    0,13, 0, 0, 0,0,DIF_CENTERGROUP,0,(char *)MCancel
   };
 
   struct FarDialogItem DialogItems[sizeof(InitItems)/sizeof(InitItems[0])];
@@ -1045,12 +1074,20 @@ FARAPI(int) Configure(int item)
   {
     DialogItems[9].Param.Selected=1;
   }
-  int ExitCode=I.Dialog(I.ModuleNumber,-1,-1,68,15,"ctagscfg",DialogItems,sizeof(DialogItems)/sizeof(DialogItems[0]));
-  if(ExitCode!=11)return FALSE;
+  if(r.Get("builtinparser",buf,sizeof(buf)))
+  {
+    DialogItems[10].Param.Selected=!stricmp(buf,"true");
+  }else
+  {
+    DialogItems[10].Param.Selected=1;
+  }
+  int ExitCode=I.Dialog(I.ModuleNumber,-1,-1,68,16,"ctagscfg",DialogItems,sizeof(DialogItems)/sizeof(DialogItems[0]));
+  if(ExitCode!=12)return FALSE;
   r.Set("pathtoexe",DialogItems[2].Data.Data);
   r.Set("commandline",DialogItems[4].Data.Data);
   r.Set("autoload",DialogItems[6].Data.Data);
   r.Set("wordchars",DialogItems[8].Data.Data);
   r.Set("casesensfilt",DialogItems[9].Param.Selected?"True":"False");
+  r.Set("builtinparser",DialogItems[10].Param.Selected?"True":"False");
   return TRUE;
 }
@@ -26,13 +26,344 @@
 #include "Array.hpp"
 #include "tags.h"
 
+/*
+  Index file layout (all offsets are 64 bit, so tags files over 2Gb are fine):
+
+    IndexHeader
+    TagOffset names[count]      - tag lines sorted by line
+    TagOffset byFile[count]     - tag lines sorted by source file
+    TagOffset byClass[clsCount] - tag lines with class:/struct: sorted by class
+    srcCount records of source files:
+      unsigned short len; char name[len]; long long mtime;
+
+  Both index and tags file are read through windows mapped at 64 bit
+  offsets, so no seeking/reading is done during search, and files
+  larger than address space of the process can be searched.
+*/
+
+typedef unsigned long long TagOffset;
+
+static const char IndexMagic[4]={'T','I','D','X'};
+static const int IndexVersion=2;
+
+struct IndexHeader{
+  char magic[4];
+  int version;
+  int count;
+  int clsCount;
+  int srcCount;
+  int reserved;
+  TagOffset tagsSize;
+};
+
+//number of windows kept mapped at once by one MappedFile
+static const int MapViews=4;
+//offset of a view must be multiple of allocation granularity
+static const TagOffset MapGranularity=65536;
+//lookups touch few pages around binary search probes
+#ifndef LOOKUPWINDOW
+#define LOOKUPWINDOW (4*1024*1024)
+#endif
+static const TagOffset LookupWindow=LOOKUPWINDOW;
+//scanning and sorting all lines, whole file in 64 bit process
+#ifndef SCANWINDOW
+#define SCANWINDOW (sizeof(SIZE_T)>4?~(TagOffset)0:64*1024*1024)
+#endif
+static const TagOffset ScanWindow=SCANWINDOW;
+//longest line that can be mapped
+static const TagOffset MaxLine=16*1024*1024;
+
+/*
+  Read only file mapping, mapped by windows on demand.
+  Pointer returned by Map stays valid until MapViews-1
+  other windows are mapped.
+*/
+struct MappedFile{
+  HANDLE hFile;
+  HANDLE hMap;
+  TagOffset size;
+  TagOffset window;
+  struct View{
+    const char* data;
+    TagOffset off;
+    TagOffset len;
+    unsigned used;
+  };
+  View views[MapViews];
+  unsigned tick;
+
+  MappedFile():hFile(INVALID_HANDLE_VALUE),hMap(NULL),size(0),window(LookupWindow),tick(0)
+  {
+    memset(views,0,sizeof(views));
+  }
+  ~MappedFile()
+  {
+    Close();
+  }
+
+  bool Open(const char* filename,TagOffset wnd=LookupWindow)
+  {
+    Close();
+    window=wnd;
+    hFile=CreateFile(filename,GENERIC_READ,FILE_SHARE_READ|FILE_SHARE_WRITE|FILE_SHARE_DELETE,
+                     NULL,OPEN_EXISTING,FILE_ATTRIBUTE_NORMAL,NULL);
+    if(hFile==INVALID_HANDLE_VALUE)return false;
+    DWORD hi=0;
+    DWORD lo=GetFileSize(hFile,&hi);
+    if(lo==INVALID_FILE_SIZE && GetLastError()!=NO_ERROR)
+    {
+      Close();
+      return false;
+    }
+    size=((TagOffset)hi<<32)|lo;
+    if(size==0)return true;
+    hMap=CreateFileMapping(hFile,NULL,PAGE_READONLY,0,0,NULL);
+    if(!hMap)
+    {
+      Close();
+      return false;
+    }
+    return true;
+  }
+
+  void Close()
+  {
+    for(int i=0;i<MapViews;i++)
+    {
+      if(views[i].data)UnmapViewOfFile(views[i].data);
+    }
+    memset(views,0,sizeof(views));
+    if(hMap)CloseHandle(hMap);
+    if(hFile!=INVALID_HANDLE_VALUE)CloseHandle(hFile);
+    hFile=INVALID_HANDLE_VALUE;
+    hMap=NULL;
+    size=0;
+  }
+
+  //len bytes at off, NULL if they are out of file or can't be mapped
+  const char* Map(TagOffset off,TagOffset len)
+  {
+    if(!hMap || off>size || len>size-off)return NULL;
+    View* v=&views[0];
+    for(int i=0;i<MapViews;i++)
+    {
+      View& w=views[i];
+      if(w.data && off>=w.off && off+len<=w.off+w.len)
+      {
+        w.used=++tick;
+        return w.data+(off-w.off);
+      }
+      if(!w.data)v=&w;
+      else if(v->data && w.used<v->used)v=&w;
+    }
+    if(v->data)UnmapViewOfFile(v->data);
+    v->data=NULL;
+    TagOffset start=off-off%MapGranularity;
+    TagOffset wlen=window;
+    if(wlen<off+len-start)wlen=off+len-start;
+    if(wlen>size-start)wlen=size-start;
+    if(wlen!=(TagOffset)(SIZE_T)wlen)return NULL;
+    v->data=(const char*)MapViewOfFile(hMap,FILE_MAP_READ,(DWORD)(start>>32),(DWORD)start,(SIZE_T)wlen);
+    if(!v->data)return NULL;
+    v->off=start;
+    v->len=wlen;
+    v->used=++tick;
+    return v->data+(off-start);
+  }
+
+  //line at off as a whole, len includes \n if there is one
+  const char* MapLine(TagOffset off,int& len)
+  {
+    if(off>=size)return NULL;
+    TagOffset left=size-off;
+    TagOffset want=left<4096?left:4096;
+    for(;;)
+    {
+      const char *p=Map(off,want);
+      if(!p)return NULL;
+      const char *eol=(const char*)memchr(p,'\n',(size_t)want);
+      if(eol || want==left)
+      {
+        len=eol?eol-p+1:(int)want;
+        return p;
+      }
+      if(want==MaxLine)return NULL;
+      want*=4;
+      if(want>MaxLine)want=MaxLine;
+      if(want>left)want=left;
+    }
+  }
+};
+
+static TagOffset ReadOffset(MappedFile& index,TagOffset section,int i)
+{
+  TagOffset val=0;
+  const char *p=index.Map(section+(TagOffset)i*sizeof(TagOffset),sizeof(TagOffset));
+  if(p)memcpy(&val,p,sizeof(val));
+  return val;
+}
+
+//one record of source files list, off is moved to the next one
+static bool ReadSrcFile(MappedFile& index,TagOffset& off,String& fn,long long& modt)
+{
+  unsigned short fsz;
+  const char *p=index.Map(off,sizeof(fsz));
+  if(!p)return false;
+  memcpy(&fsz,p,sizeof(fsz));
+  off+=sizeof(fsz);
+  p=index.Map(off,fsz+sizeof(modt));
+  if(!p)return false;
+  fn.Set(p,0,fsz);
+  memcpy(&modt,p+fsz,sizeof(modt));
+  off+=fsz+sizeof(modt);
+  return true;
+}
+
+//chars of a name as a bit mask: letters, digits, _ and :, anything else
+static unsigned CharBit(unsigned char c)
+{
+  c=tolower(c);
+  if(c>='a' && c<='z')return 1<<(c-'a');
+  if(isdigit(c))return 1<<26;
+  if(c=='_')return 1<<27;
+  if(c==':')return 1<<28;
+  return 1<<29;
+}
+
+//adjacent chars as one of 32 bits
+static unsigned PairBit(unsigned char a,unsigned char b)
+{
+  return 1<<((tolower(a)*31+tolower(b))&31);
+}
+
+struct FuzzyPool{
+  char *data;
+  int len;
+  int size;
+
+  FuzzyPool():data(NULL),len(0),size(0){}
+  ~FuzzyPool()
+  {
+    free(data);
+  }
+  int Append(const char* str,int n)
+  {
+    if(len+n>size)
+    {
+      size=size*2>len+n?size*2:len+n+65536;
+      data=(char*)realloc(data,size);
+    }
+    memcpy(data+len,str,n);
+    len+=n;
+    return len-n;
+  }
+};
+
+/*
+  Distinct names of tags file, for fuzzy search. Equal names are
+  adjacent in names section, lines [line,next.line) have the name,
+  refs [ref,next.ref) are classes of those of them that have one.
+  There is one more entry at the end, so that next always exists.
+*/
+struct FuzzyName{
+  unsigned mask;
+  int off;
+  int line;
+  int ref;
+};
+
+//what is tested before anything else of a name, 20 bytes per name
+struct FuzzyQuick{
+  unsigned mask;
+  //CharBit of chars at word starts, PairBit of adjacent chars
+  unsigned starts;
+  unsigned pairs;
+  //length up to 255, lower case first char
+  unsigned char len;
+  unsigned char first;
+  //one or two classes of tags of the name, FuzzyNoClass if there are
+  //less, FuzzyManyClasses in the first one if there are more
+  unsigned short cls[2];
+};
+
+struct FuzzyRef{
+  int line;
+  int cls;
+};
+
+struct FuzzyNames{
+  Vector<FuzzyName> names;
+  Vector<FuzzyQuick> quick;
+  //masks of names with their class::name forms, scanned first
+  Vector<unsigned> anyMask;
+  Vector<FuzzyRef> refs;
+  //only mask and off are used for classes
+  Vector<FuzzyName> classes;
+  //how much of current pattern each class matches and
+  //FuzzyClassLimits for it, patlen-1 for each class
+  Vector<int> clsMatch;
+  Vector<int> clsLimits;
+  //best of clsLimits over all classes, patlen-1 values
+  Vector<int> clsTop;
+  //lim[0]+clsQuick is a limit of class::name with the class, for names
+  //with : and without it, followed by the best of them and by nothing
+  //for FuzzyNoClass
+  Vector<int> clsQuick;
+  //names that pass the mask, each job fills its own part
+  Vector<int> cand;
+  FuzzyPool pool;
+  FuzzyPool clsPool;
+
+  int Count()const
+  {
+    return names.Count()-1;
+  }
+};
+
 struct TagFileInfo{
   String filename;
   String indexFile;
   Array<String> loadBases;
   time_t modtm;
   bool mainaload;
-  Vector<int> offsets;
+  MappedFile index;
+  IndexHeader header;
+  const IndexHeader* hdr;
+  //positions of index sections in index file
+  TagOffset names;
+  TagOffset byFile;
+  TagOffset byClass;
+  TagOffset srcFiles;
+  //read on first fuzzy search
+  FuzzyNames* fuzzy;
+
+  TagFileInfo():hdr(NULL),names(0),byFile(0),byClass(0),srcFiles(0),fuzzy(NULL){}
+  ~TagFileInfo()
+  {
+    delete fuzzy;
+  }
+
+  int Count()
+  {
+    return hdr?hdr->count:0;
+  }
+
+  TagOffset Name(int i)
+  {
+    return ReadOffset(index,names,i);
+  }
+
+  void CloseIndex()
+  {
+    index.Close();
+    delete fuzzy;
+    fuzzy=NULL;
+    hdr=NULL;
+    names=0;
+    byFile=0;
+    byClass=0;
+    srcFiles=0;
+  }
 
   void addToLoadBases(const String& base)
   {
@@ -57,11 +388,6 @@ struct TagFileInfo{
 
 Vector<TagFileInfo*> files;
 
-static void SetStr(String& s,const char* buf,SMatch& m)
-{
-  s.Set(buf,m.start,m.end-m.start);
-}
-
 //int Msg(const char*);
 
 static void QuoteMeta(String& str)
@@ -116,80 +442,259 @@ static void ReplaceSpaces(String& str)
   str=dst;
 }
 
-RegExp reParse("/(.+?)\\t(.*?)\\t(\\d+|\\/.*?\\/(?<=[^\\\\]\\/));\"\\t(\\w)(?:\\tline:(\\d+))?(?:\\t(\\S*))?/");
+/*
+  Fields of tags line in extended format:
+  name<TAB>file<TAB>address;"<TAB>kind[<TAB>field:value...]
+  address is either line number or /pattern/ with escaped slashes.
+  Pointers refer to the parsed line, nothing is allocated.
+*/
+struct TagFields{
+  const char *name;
+  int namelen;
+  const char *file;
+  int filelen;
+  const char *addr;
+  int addrlen;
+  char kind;
+  int line;
+  const char *info;
+  int infolen;
+};
 
-TagInfo* ParseLine(const char* buf,const String& base)
+static inline bool IsWordChar(char c)
 {
-  String pos;
-  String file;
-  SMatch m[10];
-  int n=10;
-  if(reParse.Match(buf,m,n))
+  return isalnum(c) || c=='_';
+}
+
+static inline bool IsLineEnd(char c)
+{
+  return c=='\r' || c=='\n';
+}
+
+//end of address at p, if it is followed by ;" tab and kind, NULL otherwise
+static const char* AddrEnd(const char* p)
+{
+  if(isdigit(*p))
   {
-    TagInfo *i=new TagInfo;
-    SetStr(i->name,buf,m[1]);
-    SetStr(file,buf,m[2]);
-    if(file[1]!=':' && file[0]!='\\')
-    {
-      file.Insert(0,base);
-    }
-    i->file=file;
-    SetStr(pos,buf,m[3]);
-    if(pos[0]=='/')
-    {
-      QuoteMeta(pos);
-      ReplaceSpaces(pos);
-      i->re=pos;
-      if(m[5].start!=-1)
-      {
-        SetStr(pos,buf,m[5]);
-        i->lineno=pos.ToInt();
-      }
-    }else
-    {
-      i->lineno=pos.ToInt();
-    }
-    SetStr(pos,buf,m[4]);
-    i->type=pos[0];
-    if(m[5].start!=-1)
-    {
-      SetStr(i->info,buf,m[6]);
-    }
-    return i;
+    while(isdigit(*p))p++;
+    return !strncmp(p,";\"\t",3) && IsWordChar(p[3])?p:NULL;
+  }
+  if(*p!='/')return NULL;
+  //closing slash is the first one that is not escaped and is followed by the rest
+  for(const char *e=p+1;*e && !IsLineEnd(*e);e++)
+  {
+    if(*e=='/' && e[-1]!='\\' && !strncmp(e+1,";\"\t",3) && IsWordChar(e[4]))return e+1;
   }
   return NULL;
 }
 
+/*
+  Split line the same way the regexp used before did:
+  /(.+?)\t(.*?)\t(\d+|\/.*?\/(?<=[^\\]\/));"\t(\w)(?:\tline:(\d+))?(?:\t(\S*))?/
+  Name ends at the first tab, file at the first tab that is followed
+  by a valid address. Kind is one char, info is the field after line:
+  and is taken only if there is line: field.
+*/
+static bool SplitLine(const char* buf,TagFields& tf)
+{
+  if(!*buf || IsLineEnd(*buf))return false;
+  const char *p=buf+1;
+  while(*p && *p!='\t' && !IsLineEnd(*p))p++;
+  if(*p!='\t')return false;
+  tf.name=buf;
+  tf.namelen=p-buf;
+  tf.file=++p;
+  const char *end=NULL;
+  for(;;p++)
+  {
+    while(*p && *p!='\t' && !IsLineEnd(*p))p++;
+    if(*p!='\t')return false;
+    end=AddrEnd(p+1);
+    if(end)break;
+  }
+  tf.filelen=p-tf.file;
+  tf.addr=p+1;
+  tf.addrlen=end-tf.addr;
+  p=end+3;
+  tf.kind=*p++;
+  tf.line=-1;
+  tf.info=NULL;
+  tf.infolen=0;
+  if(!strncmp(p,"\tline:",6) && isdigit(p[6]))
+  {
+    p+=6;
+    tf.line=atoi(p);
+    while(isdigit(*p))p++;
+    tf.info=p;
+    if(*p=='\t')
+    {
+      tf.info=++p;
+      while(*p && !isspace(*p))p++;
+    }
+    tf.infolen=p-tf.info;
+  }
+  return true;
+}
+
+TagInfo* ParseLine(const char* buf,const String& base)
+{
+  TagFields tf;
+  if(!SplitLine(buf,tf))return NULL;
+  TagInfo *i=new TagInfo;
+  i->name.Set(tf.name,0,tf.namelen);
+  i->file.Set(tf.file,0,tf.filelen);
+  if(i->file[1]!=':' && i->file[0]!='\\')
+  {
+    i->file.Insert(0,base);
+  }
+  if(tf.addr[0]=='/')
+  {
+    i->re.Set(tf.addr,0,tf.addrlen);
+    QuoteMeta(i->re);
+    ReplaceSpaces(i->re);
+    i->lineno=tf.line;
+  }else
+  {
+    i->lineno=atoi(tf.addr);
+  }
+  i->type=tf.kind;
+  if(tf.info)
+  {
+    i->info.Set(tf.info,0,tf.infolen);
+  }
+  return i;
+}
+
 static char strbuf[16384];
 
+//copy line at given offset of mapped tags file to strbuf, like fgets in text mode
+static char* ReadLine(MappedFile& tf,TagOffset off,char* buf=strbuf,size_t size=sizeof(strbuf))
+{
+  buf[0]=0;
+  if(off>=tf.size)return buf;
+  TagOffset left=tf.size-off;
+  size_t len=left<size-1?(size_t)left:size-1;
+  const char *p=tf.Map(off,len);
+  if(!p)return buf;
+  const char *eol=(const char*)memchr(p,'\n',len);
+  if(eol)len=eol-p+1;
+  memcpy(buf,p,len);
+  if(eol && len>1 && buf[len-2]=='\r')
+  {
+    buf[len-2]='\n';
+    len--;
+  }
+  buf[len]=0;
+  return buf;
+}
+
+//returns pointer to the value of class: or struct: field, or empty string
+static const char* GetClass(const char* line)
+{
+  const char* cls=strstr(line,"\tclass:");
+  if(cls)return cls+7;
+  cls=strstr(line,"\tstruct:");
+  if(cls)return cls+8;
+  return "";
+}
+
+//positions are relative to the start of line, -1 if there is no such field
 struct LineInfo{
-  char *line;
-  int pos;
-  char *fn;
-  char *cls;
+  TagOffset pos;
+  int len;
+  int fn;
+  int fnlen;
+  int filelen;
+  int cls;
+  int clslen;
 };
 
+//fill LineInfo for the line at pos, returns position of the next line,
+//or 0 if line can't be mapped. li.fn is -1 for comments and malformed lines.
+static TagOffset GetLineInfo(MappedFile& tf,TagOffset pos,LineInfo& li)
+{
+  int len;
+  const char *p=tf.MapLine(pos,len);
+  if(!p)return 0;
+  TagOffset next=pos+len;
+  if(p[len-1]=='\n')len--;
+  if(len>0 && p[len-1]=='\r')len--;
+  li.pos=pos;
+  li.len=len;
+  li.fn=-1;
+  li.cls=-1;
+  li.clslen=0;
+  if(len==0 || p[0]=='!')return next;
+  const char *lend=p+len;
+  const char *tab=(const char*)memchr(p,'\t',len);
+  if(!tab)return next;
+  li.fn=tab+1-p;
+  li.fnlen=len-li.fn;
+  tab=(const char*)memchr(p+li.fn,'\t',li.fnlen);
+  li.filelen=tab?tab-(p+li.fn):li.fnlen;
+  while(tab)
+  {
+    tab++;
+    int rest=lend-tab;
+    if((rest>6 && !strncmp(tab,"class:",6)) || (rest>7 && !strncmp(tab,"struct:",7)))
+    {
+      const char *cls=(const char*)memchr(tab,':',rest)+1;
+      li.cls=cls-p;
+      tab=(const char*)memchr(cls,'\t',lend-cls);
+      li.clslen=(tab?tab:lend)-cls;
+      break;
+    }
+    tab=(const char*)memchr(tab,'\t',rest);
+  }
+  return next;
+}
+
+static int MemCmp(const char* a,int alen,const char* b,int blen)
+{
+  int cmp=memcmp(a,b,alen<blen?alen:blen);
+  if(cmp!=0)return cmp;
+  return alen-blen;
+}
+
+//tags file the LineInfo comparators read lines from
+static MappedFile* sortFile;
+
+//equal keys are ordered by position, so index does not depend on qsort order
+static int PosCmp(const LineInfo* a,const LineInfo* b)
+{
+  return a->pos<b->pos?-1:a->pos>b->pos?1:0;
+}
+
 int LinesCmp(const void* v1,const void* v2)
 {
-  LineInfo *a=*(LineInfo**)v1;
-  LineInfo *b=*(LineInfo**)v2;
-  return strcmp(a->line,b->line);
+  const LineInfo *a=(const LineInfo*)v1;
+  const LineInfo *b=(const LineInfo*)v2;
+  const char *la=sortFile->Map(a->pos,a->len);
+  const char *lb=sortFile->Map(b->pos,b->len);
+  int cmp=MemCmp(la,a->len,lb,b->len);
+  return cmp?cmp:PosCmp(a,b);
 }
 
 int FilesCmp(const void* v1,const void* v2)
 {
-  LineInfo *a=*(LineInfo**)v1;
-  LineInfo *b=*(LineInfo**)v2;
-  int cmp=stricmp(a->fn,b->fn);
-  if(cmp!=0)return cmp;
-  return strcmp(a->line,b->line);
+  const LineInfo *a=(const LineInfo*)v1;
+  const LineInfo *b=(const LineInfo*)v2;
+  const char *la=sortFile->Map(a->pos,a->len);
+  const char *lb=sortFile->Map(b->pos,b->len);
+  int cmp=memicmp(la+a->fn,lb+b->fn,a->fnlen<b->fnlen?a->fnlen:b->fnlen);
+  if(cmp==0)cmp=a->fnlen-b->fnlen;
+  if(cmp==0)cmp=MemCmp(la,a->len,lb,b->len);
+  return cmp?cmp:PosCmp(a,b);
 }
 
 int ClsCmp(const void* v1,const void* v2)
 {
-  LineInfo *a=*(LineInfo**)v1;
-  LineInfo *b=*(LineInfo**)v2;
-  return strcmp(a->cls,b->cls);
+  const LineInfo *a=(const LineInfo*)v1;
+  const LineInfo *b=(const LineInfo*)v2;
+  const char *la=sortFile->Map(a->pos,a->len);
+  const char *lb=sortFile->Map(b->pos,b->len);
+  int cmp=MemCmp(la+a->cls,a->clslen,lb+b->cls,b->clslen);
+  return cmp?cmp:PosCmp(a,b);
 }
 
 int StrCmp(const void* v1,const void* v2)
@@ -197,191 +702,146 @@ int StrCmp(const void* v1,const void* v2)
   return strcmp(*(char**)v1,*(char**)v2);
 }
 
-
-static int CreateIndex(TagFileInfo* fi)
+static bool WriteOffsets(FILE* g,const Vector<LineInfo>& lines)
 {
-  int pos=0;
-  String file;
-  FILE *f=fopen(fi->filename,"rb");
-  if(!f)return 0;
-  fseek(f,0,SEEK_END);
-  int sz=ftell(f);
-  fseek(f,0,SEEK_SET);
-  fi->offsets.Clean();
-//  fi->offsets.SetSize(sz/80);
-  Vector<LineInfo*> lines;
-  Vector<LineInfo*> classes;
-  lines.SetSize(sz/80);
+  Vector<TagOffset> offsets;
+  offsets.Init(lines.Count());
+  for(int i=0;i<lines.Count();i++)
+  {
+    offsets[i]=lines[i].pos;
+  }
+  if(offsets.Count()==0)return true;
+  return fwrite(&offsets[0],sizeof(TagOffset),offsets.Count(),g)==(size_t)offsets.Count();
+}
 
-  Hash<int> files;
-  fgets(strbuf,sizeof(strbuf),f);
-  if(strncmp(strbuf,"!_TAG_FILE_FORMAT",17))
+//source files and their modification times, sorted by name
+static bool WriteSrcFiles(FILE* g,Hash<long long>& srcfiles)
+{
+  StrList names,sorted;
+  char *key;
+  long long val;
+  srcfiles.First();
+  while(srcfiles.Next(key,val))
   {
-    fclose(f);
-    return 0;
+    names<<key;
   }
+  names.Sort(sorted);
+  for(int i=0;i<sorted.Count();i++)
+  {
+    unsigned short fsz=sorted[i].Length();
+    val=srcfiles[sorted[i]];
+    fwrite(&fsz,sizeof(fsz),1,g);
+    fwrite(sorted[i].Str(),fsz,1,g);
+    fwrite(&val,sizeof(val),1,g);
+  }
+  return !ferror(g);
+}
 
-  LineInfo *li;
-  struct LIPool{
-    LineInfo *ptr;
-    int used;
-    int size;
-    LIPool *next;
-    LineInfo* getNext(LIPool*& page)
-    {
-      if(used==size)
-      {
-        next=new LIPool(size);
-        page=page->next;
-      }
-      return &page->ptr[page->used++];
-    }
-    LIPool(int count)
-    {
-      size=count;
-      ptr=new LineInfo[size];
-      used=0;
-      next=0;
-    }
-    ~LIPool()
-    {
-      delete [] ptr;
-    }
-  };
-  LIPool *poolfirst,*pool;
-  poolfirst=new LIPool(sz/100);
-  pool=poolfirst;
-  char *linespool=new char[sz+16];
-  int linespoolpos=0;
+bool LoadIndex(TagFileInfo* fi);
 
+static int CreateIndex(TagFileInfo* fi)
+{
+  fi->CloseIndex();
+  MappedFile tf;
+  if(!tf.Open(fi->filename,ScanWindow))return 0;
+  const char *p=tf.Map(0,17);
+  if(!p || strncmp(p,"!_TAG_FILE_FORMAT",17))return 0;
 
-  pos=ftell(f);
-  bool sorted=true;
-  while(fgets(strbuf,sizeof(strbuf),f))
-  {
-    if(strbuf[0]=='!')
-    {
-      pos=ftell(f);
-      continue;
-    }
-    li=pool->getNext(pool);
-    int len=strlen(strbuf);
-    li->line=linespool+linespoolpos;
-    if(strbuf[len-1]==0x0d || strbuf[len-1]==0x0a)len--;
-    memcpy(li->line,strbuf,len);
-    li->line[len]=0;
-    if(sorted && lines.Count()>1 && strcmp(li->line,lines[-1]->line)<0)
-    {
-      sorted=false;
-    }
-    linespoolpos+=len+1;
-    //strdup(strbuf);
-    li->pos=pos;
-    li->fn=strchr(li->line,'\t')+1;
-    file.Set(li->fn,0,strchr(li->fn,'\t')-li->fn);
+  Vector<LineInfo> lines;
+  Vector<LineInfo> classes;
+  lines.SetSize((int)(tf.size/80));
+
+  Hash<int> files;
+  String file;
+  TagOffset pos=0;
+  while(pos<tf.size)
+  {
+    LineInfo li;
+    pos=GetLineInfo(tf,pos,li);
+    if(!pos)return 0;
+    if(li.fn<0)continue;
+    file.Set(tf.Map(li.pos,li.len)+li.fn,0,li.filelen);
     files.Insert(file,1);
-    li->cls=strchr(li->line,'\t');
-    do{
-      if(li->cls)li->cls++;
-      if(li->cls && (!strncmp(li->cls,"class:",6) || !strncmp(li->cls,"struct:",7)))
-      {
-        li->cls=strchr(li->cls,':')+1;
-        char *tmp=strchr(li->cls,'\t');
-        if(tmp)*tmp=0;
-        classes.Push(li);
-        break;
-      }
-    }while((li->cls=strchr(li->cls,'\t')));
+    if(li.cls>=0)classes.Push(li);
     lines.Push(li);
-//    fi->offsets.Push(pos);
-    pos=ftell(f);
   }
-  fclose(f);
+  sortFile=&tf;
+
   FILE *g=fopen(fi->indexFile,"wb");
-  if(!g)
-  {
-    delete [] linespool;
-    while(poolfirst)
-    {
-      pool=poolfirst->next;
-      delete poolfirst;
-      poolfirst=pool;
-    }
-    return 0;
-  }
+  if(!g)return 0;
+
+  IndexHeader hdr;
+  memset(&hdr,0,sizeof(hdr));
+  memcpy(hdr.magic,IndexMagic,sizeof(hdr.magic));
+  hdr.version=IndexVersion;
+  hdr.count=lines.Count();
+  hdr.clsCount=classes.Count();
+  hdr.tagsSize=tf.size;
+  bool ok=fwrite(&hdr,sizeof(hdr),1,g)==1;
+
   if(lines.Count())
-    qsort(&lines[0],lines.Count(),sizeof(LineInfo*),LinesCmp);
-  //fi->offsets.Clean();
-  fi->offsets.Init(lines.Count());
-  int i;
-  for(i=0;i<lines.Count();i++)
-  {
-    fi->offsets[i]=lines[i]->pos;
-  }
-  int cnt=fi->offsets.Count();
-  fwrite(&cnt,4,1,g);
-  fwrite(&fi->offsets[0],4,fi->offsets.Count(),g);
+    qsort(&lines[0],lines.Count(),sizeof(LineInfo),LinesCmp);
+  ok=ok && WriteOffsets(g,lines);
   if(lines.Count())
-    qsort(&lines[0],lines.Count(),sizeof(LineInfo*),FilesCmp);
-  for(i=0;i<lines.Count();i++)
-  {
-    fwrite(&lines[i]->pos,4,1,g);
-//    free(lines[i].line);
-  }
+    qsort(&lines[0],lines.Count(),sizeof(LineInfo),FilesCmp);
+  ok=ok && WriteOffsets(g,lines);
   if(classes.Count())
-    qsort(&classes[0],classes.Count(),sizeof(LineInfo*),ClsCmp);
-  sz=classes.Count();
-  fwrite(&sz,4,1,g);
-  for(i=0;i<classes.Count();i++)
-  {
-    fwrite(&classes[i]->pos,4,1,g);
-  }
-  delete [] linespool;
-  while(poolfirst)
-  {
-    pool=poolfirst->next;
-    delete poolfirst;
-    poolfirst=pool;
-  }
-  int fstart=ftell(g);
-  fwrite(&fstart,4,1,g);
+    qsort(&classes[0],classes.Count(),sizeof(LineInfo),ClsCmp);
+  ok=ok && WriteOffsets(g,classes);
+
   char *key;
   int val;
   files.First();
   struct stat st;
-  cnt=0;
   String base=fi->filename;
   base.Delete(base.RIndex("\\")+1);
+  Hash<long long> srcfiles;
   while(files.Next(key,val))
   {
     file=base+key;
     if(stat(file,&st)==-1)continue;
-    unsigned short fsz=strlen(key);
-    fwrite(&fsz,sizeof(fsz),1,g);
-    fwrite(key,fsz,1,g);
-    fwrite(&st.st_mtime,sizeof(st.st_mtime),1,g);
-    cnt++;
+    srcfiles.Insert(key,st.st_mtime);
+  }
+  hdr.srcCount=srcfiles.GetCount();
+  ok=ok && WriteSrcFiles(g,srcfiles);
+  fseek(g,0,SEEK_SET);
+  fwrite(&hdr,sizeof(hdr),1,g);
+  ok=ok && !ferror(g);
+  ok=fclose(g)==0 && ok;
+  if(!ok)
+  {
+    remove(fi->indexFile);
+    return 0;
   }
-  fseek(g,fstart,SEEK_SET);
-  fwrite(&cnt,sizeof(cnt),1,g);
-  fclose(g);
 
   utimbuf tm;
   tm.actime=fi->modtm;
   tm.modtime=fi->modtm;
   utime(fi->indexFile,&tm);
-  return 1;
+  return LoadIndex(fi)?1:0;
 }
 
-void LoadIndex(TagFileInfo* fi)
+bool LoadIndex(TagFileInfo* fi)
 {
-  FILE *f=fopen(fi->indexFile,"rb");
-  int sz;
-  fread(&sz,4,1,f);
-  fi->offsets.Clean();
-  fi->offsets.Init(sz);
-  fread(&fi->offsets[0],4,sz,f);
-  fclose(f);
+  fi->CloseIndex();
+  if(!fi->index.Open(fi->indexFile))return false;
+  const IndexHeader* hdr=(const IndexHeader*)fi->index.Map(0,sizeof(IndexHeader));
+  if(!hdr ||
+     memcmp(hdr->magic,IndexMagic,sizeof(hdr->magic)) ||
+     hdr->version!=IndexVersion ||
+     hdr->count<0 || hdr->clsCount<0 ||
+     fi->index.size<sizeof(IndexHeader)+sizeof(TagOffset)*((TagOffset)hdr->count*2+hdr->clsCount))
+  {
+    fi->CloseIndex();
+    return false;
+  }
+  fi->header=*hdr;
+  fi->hdr=&fi->header;
+  fi->names=sizeof(IndexHeader);
+  fi->byFile=fi->names+sizeof(TagOffset)*(TagOffset)hdr->count;
+  fi->byClass=fi->byFile+sizeof(TagOffset)*(TagOffset)hdr->count;
+  fi->srcFiles=fi->byClass+sizeof(TagOffset)*(TagOffset)hdr->clsCount;
+  return true;
 }
 
 bool FindIdx(TagFileInfo* fi)
@@ -452,17 +912,15 @@ int Load(const char* _filename,const char *base,bool mainaload)
   struct stat sti;
   if(fi->indexFile.Length()>0)
   {
-    if(stat(fi->indexFile,&sti)!=-1 && sti.st_mtime==st.st_mtime)
+    if(stat(fi->indexFile,&sti)!=-1 && sti.st_mtime==st.st_mtime && LoadIndex(fi))
     {
-      LoadIndex(fi);
       return 1;
     }
   }else
   if(FindIdx(fi))
   {
-    if(stat(fi->indexFile,&sti)!=-1 && sti.st_mtime==st.st_mtime)
+    if(stat(fi->indexFile,&sti)!=-1 && sti.st_mtime==st.st_mtime && LoadIndex(fi))
     {
-      LoadIndex(fi);
       return 1;
     }
   }
@@ -516,32 +974,42 @@ int Load(const char* _filename,const char *base,bool mainaload)
   return 0;
 }
 
-static void FindInFile(TagFileInfo* fi,const char* str,PTagArray ta)
+static String GetBase(TagFileInfo* fi)
 {
-  FILE *f=fopen(fi->filename,"rt");
-  if(!f)return;
-  struct stat st;
-  fstat(fileno(f),&st);
-  String name,base=fi->filename;
+  String base=fi->filename;
   int ri=base.RIndex("\\");
   if(ri!=-1)
   {
     base.Delete(ri+1);
   }
-  if(fi->modtm!=st.st_mtime)
+  return base;
+}
+
+static void CheckModified(TagFileInfo* fi,const String& base)
+{
+  struct stat st;
+  if(stat(fi->filename,&st)!=-1 && fi->modtm!=st.st_mtime)
   {
     Load(fi->filename,base);
   }
+}
+
+static void FindInFile(TagFileInfo* fi,const char* str,PTagArray ta)
+{
+  String base=GetBase(fi);
+  CheckModified(fi,base);
+  MappedFile tf;
+  if(!fi->hdr || !tf.Open(fi->filename))return;
+  TagOffset section=fi->names;
   int len=strlen(str);
-  int pos;
+  int pos=0;
   int left=0;
-  int right=fi->offsets.Count()-1;
-  int cmp;
+  int right=fi->Count()-1;
+  int cmp=1;
   while(left<=right)
   {
     pos=(right+left)/2;
-    fseek(f,fi->offsets[pos],SEEK_SET);
-    fgets(strbuf,sizeof(strbuf),f);
+    ReadLine(tf,ReadOffset(fi->index,section,pos));
     cmp=strncmp(str,strbuf,len);
     if(!cmp && strbuf[len]=='\t')
     {
@@ -559,8 +1027,7 @@ static void FindInFile(TagFileInfo* fi,const char* str,PTagArray ta)
     int endpos=pos;
     while(pos>0)
     {
-      fseek(f,fi->offsets[pos-1],SEEK_SET);
-      fgets(strbuf,sizeof(strbuf),f);
+      ReadLine(tf,ReadOffset(fi->index,section,pos-1));
       if(!strncmp(str,strbuf,len) && strbuf[len]=='\t')
       {
         pos--;
@@ -569,10 +1036,9 @@ static void FindInFile(TagFileInfo* fi,const char* str,PTagArray ta)
         break;
       }
     }
-    while(endpos<fi->offsets.Count()-1)
+    while(endpos<fi->Count()-1)
     {
-      fseek(f,fi->offsets[endpos+1],SEEK_SET);
-      fgets(strbuf,sizeof(strbuf),f);
+      ReadLine(tf,ReadOffset(fi->index,section,endpos+1));
       if(!strncmp(str,strbuf,len) && strbuf[len]=='\t')
       {
         endpos++;
@@ -583,46 +1049,35 @@ static void FindInFile(TagFileInfo* fi,const char* str,PTagArray ta)
     }
     for(int i=pos;i<=endpos;i++)
     {
-      fseek(f,fi->offsets[i],SEEK_SET);
-      fgets(strbuf,sizeof(strbuf),f);
+      ReadLine(tf,ReadOffset(fi->index,section,i));
       TagInfo* t=ParseLine(strbuf,base);
       if(t)ta->Push(t);
     }
   }
-  fclose(f);
+}
+
+static const char* GetFileField(const char* line)
+{
+  const char* file=strchr(line,'\t');
+  return file?file+1:"";
 }
 
 void FindFile(TagFileInfo* fi,const char* str,PTagArray ta)
 {
-  FILE *g=fopen(fi->indexFile,"rb");
-  if(!g)return;
-  int sz;
-  fread(&sz,4,1,g);
-  fseek(g,4+sz*4,SEEK_SET);
-  Vector<int> offsets;
-  offsets.Init(sz);
-  if(sz)fread(&offsets[0],4,sz,g);
-  fclose(g);
-  FILE *f=fopen(fi->filename,"rb");
-  if(!f)return;
+  MappedFile tf;
+  if(!fi->hdr || !tf.Open(fi->filename))return;
+  TagOffset section=fi->byFile;
   int len=strlen(str);
   int left=0;
-  int right=offsets.Count()-1;
-  int cmp;
-  int pos;
-  char *file;
-  String base=fi->filename;
-  int ri=base.RIndex("\\");
-  if(ri!=-1)
-  {
-    base.Delete(ri+1);
-  }
+  int right=fi->Count()-1;
+  int cmp=1;
+  int pos=0;
+  const char *file="";
+  String base=GetBase(fi);
   while(left<=right)
   {
     pos=(right+left)/2;
-    fseek(f,offsets[pos],SEEK_SET);
-    fgets(strbuf,sizeof(strbuf),f);
-    file=strchr(strbuf,'\t')+1;
+    file=GetFileField(ReadLine(tf,ReadOffset(fi->index,section,pos)));
     cmp=strnicmp(str,file,len);
     if(!cmp && file[len]=='\t')
     {
@@ -640,9 +1095,7 @@ void FindFile(TagFileInfo* fi,const char* str,PTagArray ta)
     int endpos=pos;
     while(pos>0)
     {
-      fseek(f,offsets[pos-1],SEEK_SET);
-      fgets(strbuf,sizeof(strbuf),f);
-      file=strchr(strbuf,'\t')+1;
+      file=GetFileField(ReadLine(tf,ReadOffset(fi->index,section,pos-1)));
       if(!strnicmp(str,file,len) && file[len]=='\t')
       {
         pos--;
@@ -651,11 +1104,9 @@ void FindFile(TagFileInfo* fi,const char* str,PTagArray ta)
         break;
       }
     }
-    while(endpos<offsets.Count()-1)
+    while(endpos<fi->Count()-1)
     {
-      fseek(f,offsets[endpos+1],SEEK_SET);
-      fgets(strbuf,sizeof(strbuf),f);
-      file=strchr(strbuf,'\t')+1;
+      file=GetFileField(ReadLine(tf,ReadOffset(fi->index,section,endpos+1)));
       if(!strnicmp(str,file,len) && file[len]=='\t')
       {
         endpos++;
@@ -668,11 +1119,9 @@ void FindFile(TagFileInfo* fi,const char* str,PTagArray ta)
     int i;
     for(i=pos;i<=endpos;i++)
     {
-      fseek(f,offsets[i],SEEK_SET);
-      fgets(strbuf,sizeof(strbuf),f);
-      lines.Push(strdup(strbuf));
+      lines.Push(strdup(ReadLine(tf,ReadOffset(fi->index,section,i))));
     }
-    qsort(&lines[0],lines.Count(),4,StrCmp);
+    qsort(&lines[0],lines.Count(),sizeof(char*),StrCmp);
     for(i=0;i<lines.Count();i++)
     {
       TagInfo *ti=ParseLine(lines[i],base);
@@ -680,58 +1129,28 @@ void FindFile(TagFileInfo* fi,const char* str,PTagArray ta)
       free(lines[i]);
     }
   }
-  fclose(f);
 }
 
 void FindClass(TagFileInfo* fi,const char* str,PTagArray ta)
 {
-  FILE *g=fopen(fi->indexFile,"rb");
-  if(!g)return;
-  int sz;
-  fread(&sz,4,1,g);
-  fseek(g,4+sz*4*2,SEEK_SET);
-  fread(&sz,4,1,g);
-  Vector<int> offsets;
-  offsets.Init(sz);
-  if(sz)fread(&offsets[0],4,sz,g);
-  fclose(g);
-  FILE *f=fopen(fi->filename,"rb");
-  if(!f)return;
+  MappedFile tf;
+  if(!fi->hdr || !tf.Open(fi->filename))return;
+  TagOffset section=fi->byClass;
+  int count=fi->hdr->clsCount;
   int len=strlen(str);
   int left=0;
-  int right=offsets.Count()-1;
-  int cmp;
-  int pos;
-  const char *cls;
-  String base=fi->filename;
-  int ri=base.RIndex("\\");
-  if(ri!=-1)
-  {
-    base.Delete(ri+1);
-  }
+  int right=count-1;
+  int cmp=1;
+  int pos=0;
+  const char *cls="";
+  String base=GetBase(fi);
 
   while(left<=right)
   {
     pos=(right+left)/2;
-    fseek(f,offsets[pos],SEEK_SET);
-    fgets(strbuf,sizeof(strbuf),f);
-    cls=strstr(strbuf,"\tclass:");
-    if(!cls)
-    {
-      cls=strstr(strbuf,"\tstruct:");
-      if(!cls)
-      {
-        cls="";
-      }else
-      {
-        cls+=8;
-      }
-    }else
-    {
-      cls+=7;
-    }
-    cmp=strncmp(str,cls,len);
-    if(!cmp && !isident(cls[len]))
+    cls=GetClass(ReadLine(tf,ReadOffset(fi->index,section,pos)));
+    cmp=strncmp(str,cls,len);
+    if(!cmp && !isident(cls[len]))
     {
       break;
     }else if(cmp<=0)
@@ -747,23 +1166,7 @@ void FindClass(TagFileInfo* fi,const char* str,PTagArray ta)
     int endpos=pos;
     while(pos>0)
     {
-      fseek(f,offsets[pos-1],SEEK_SET);
-      fgets(strbuf,sizeof(strbuf),f);
-      cls=strstr(strbuf,"\tclass:");
-      if(!cls)
-      {
-        cls=strstr(strbuf,"\tstruct:");
-        if(!cls)
-        {
-          cls="";
-        }else
-        {
-          cls+=8;
-        }
-      }else
-      {
-        cls+=7;
-      }
+      cls=GetClass(ReadLine(tf,ReadOffset(fi->index,section,pos-1)));
       if(!strncmp(str,cls,len) && !isident(cls[len]))
       {
         pos--;
@@ -772,26 +1175,9 @@ void FindClass(TagFileInfo* fi,const char* str,PTagArray ta)
         break;
       }
     }
-    while(endpos<offsets.Count()-1)
+    while(endpos<count-1)
     {
-      fseek(f,offsets[endpos+1],SEEK_SET);
-      fgets(strbuf,sizeof(strbuf),f);
-      cls=strstr(strbuf,"\tclass:");
-      cls=strstr(strbuf,"\tclass:");
-      if(!cls)
-      {
-        cls=strstr(strbuf,"\tstruct:");
-        if(!cls)
-        {
-          cls="";
-        }else
-        {
-          cls+=8;
-        }
-      }else
-      {
-        cls+=7;
-      }
+      cls=GetClass(ReadLine(tf,ReadOffset(fi->index,section,endpos+1)));
       if(!strncmp(str,cls,len) && !isident(cls[len]))
       {
         endpos++;
@@ -803,11 +1189,9 @@ void FindClass(TagFileInfo* fi,const char* str,PTagArray ta)
     Vector<char*> lines;
     for(int i=pos;i<=endpos;i++)
     {
-      fseek(f,offsets[i],SEEK_SET);
-      fgets(strbuf,sizeof(strbuf),f);
-      lines.Push(strdup(strbuf));
+      lines.Push(strdup(ReadLine(tf,ReadOffset(fi->index,section,i))));
     }
-    qsort(&lines[0],lines.Count(),4,StrCmp);
+    qsort(&lines[0],lines.Count(),sizeof(char*),StrCmp);
     for(int i=0;i<lines.Count();i++)
     {
       TagInfo *ti=ParseLine(lines[i],base);
@@ -815,35 +1199,25 @@ void FindClass(TagFileInfo* fi,const char* str,PTagArray ta)
       free(lines[i]);
     }
   }
-  fclose(f);
 }
 
 static void CheckFiles(TagFileInfo* fi,StrList& dst)
 {
-  FILE *g=fopen(fi->indexFile,"rb");
-  int sz;
-  fread(&sz,4,1,g);
-  fseek(g,sz*4*2,SEEK_CUR);
-  fread(&sz,4,1,g);
-  fseek(g,sz*4,SEEK_CUR);
-  fread(&sz,4,1,g);
-  char fn[512];
-  unsigned short fsz;
-  time_t modt;
+  if(!fi->hdr)return;
+  TagOffset off=fi->srcFiles;
+  String fn,base=fi->filename;
+  base.Delete(base.RIndex("\\")+1);
+  long long modt;
   struct stat st;
-  for(int i=0;i<sz;i++)
+  //deleted files are changed too, their tags are dropped by merge
+  for(int i=0;i<fi->hdr->srcCount;i++)
   {
-    fread(&fsz,sizeof(fsz),1,g);
-    fread(fn,fsz,1,g);
-    fn[fsz]=0;
-    fread(&modt,sizeof(modt),1,g);
-    if(stat(fn,&st)==-1)continue;
-    if(st.st_mtime!=modt)
+    if(!ReadSrcFile(fi->index,off,fn,modt))break;
+    if(stat(base+fn,&st)==-1 || st.st_mtime!=modt)
     {
       dst<<fn;
     }
   }
-  fclose(g);
 }
 
 int CheckChangedFiles(const char* filename,StrList& dst)
@@ -886,33 +1260,23 @@ PTagArray Find(const char* symbol,const char* file)
   return ta;
 }
 
+//can be called from several threads at once, so uses own line buffer
 static void FindPartsInFile(TagFileInfo* fi,const char* str,StrList& dst)
 {
-  FILE *f=fopen(fi->filename,"rt");
-  if(!f)return;
-  struct stat st;
-  fstat(fileno(f),&st);
-  String name,base=fi->filename;
-  int ri=base.RIndex("\\");
-  if(ri!=-1)
-  {
-    base.Delete(ri+1);
-  }
-  if(fi->modtm!=st.st_mtime)
-  {
-    Load(fi->filename,base);
-  }
+  MappedFile tf;
+  if(!fi->hdr || !tf.Open(fi->filename))return;
+  char buf[sizeof(strbuf)];
+  TagOffset section=fi->names;
   int len=strlen(str);
-  int pos;
+  int pos=0;
   int left=0;
-  int right=fi->offsets.Count()-1;
-  int cmp;
+  int right=fi->Count()-1;
+  int cmp=1;
   while(left<=right)
   {
     pos=(right+left)/2;
-    fseek(f,fi->offsets[pos],SEEK_SET);
-    fgets(strbuf,sizeof(strbuf),f);
-    cmp=strncmp(str,strbuf,len);
+    ReadLine(tf,ReadOffset(fi->index,section,pos),buf,sizeof(buf));
+    cmp=strncmp(str,buf,len);
     if(!cmp)
     {
       break;
@@ -929,9 +1293,8 @@ static void FindPartsInFile(TagFileInfo* fi,const char* str,StrList& dst)
     int endpos=pos;
     while(pos>0)
     {
-      fseek(f,fi->offsets[pos-1],SEEK_SET);
-      fgets(strbuf,sizeof(strbuf),f);
-      if(!strncmp(str,strbuf,len))
+      ReadLine(tf,ReadOffset(fi->index,section,pos-1),buf,sizeof(buf));
+      if(!strncmp(str,buf,len))
       {
         pos--;
       }else
@@ -939,11 +1302,10 @@ static void FindPartsInFile(TagFileInfo* fi,const char* str,StrList& dst)
         break;
       }
     }
-    while(endpos<fi->offsets.Count()-1)
+    while(endpos<fi->Count()-1)
     {
-      fseek(f,fi->offsets[endpos+1],SEEK_SET);
-      fgets(strbuf,sizeof(strbuf),f);
-      if(!strncmp(str,strbuf,len))
+      ReadLine(tf,ReadOffset(fi->index,section,endpos+1),buf,sizeof(buf));
+      if(!strncmp(str,buf,len))
       {
         endpos++;
       }else
@@ -953,51 +1315,931 @@ static void FindPartsInFile(TagFileInfo* fi,const char* str,StrList& dst)
     }
     for(int i=pos;i<=endpos;i++)
     {
-      fseek(f,fi->offsets[i],SEEK_SET);
-      fgets(strbuf,sizeof(strbuf),f);
-      char *tab=strchr(strbuf,'\t');
+      ReadLine(tf,ReadOffset(fi->index,section,i),buf,sizeof(buf));
+      char *tab=strchr(buf,'\t');
       if(tab)
       {
         *tab=0;
-        dst.Push(strbuf);
+        dst.Push(buf);
       }
     }
   }
-  fclose(f);
 }
 
+typedef void (*JobProc)(void* param,int idx);
+
+struct JobQueue{
+  JobProc proc;
+  void* param;
+  int count;
+  volatile LONG next;
+};
+
+static DWORD WINAPI JobThread(LPVOID param)
+{
+  JobQueue* q=(JobQueue*)param;
+  int i;
+  while((i=InterlockedIncrement(&q->next)-1)<q->count)
+  {
+    q->proc(q->param,i);
+  }
+  return 0;
+}
+
+//run count jobs on a pool of threads, one per cpu, calling thread works too
+static void RunJobs(JobProc proc,void* param,int count)
+{
+  JobQueue q;
+  q.proc=proc;
+  q.param=param;
+  q.count=count;
+  q.next=0;
+  SYSTEM_INFO si;
+  GetSystemInfo(&si);
+  int nthreads=si.dwNumberOfProcessors;
+  if(nthreads>count)nthreads=count;
+  if(nthreads>MAXIMUM_WAIT_OBJECTS)nthreads=MAXIMUM_WAIT_OBJECTS;
+  Vector<HANDLE> threads;
+  int i;
+  for(i=1;i<nthreads;i++)
+  {
+    DWORD tid;
+    HANDLE h=CreateThread(NULL,0,JobThread,&q,0,&tid);
+    if(h)threads.Push(h);
+  }
+  JobThread(&q);
+  if(threads.Count())
+  {
+    WaitForMultipleObjects(threads.Count(),&threads[0],TRUE,INFINITE);
+    for(i=0;i<threads.Count();i++)
+    {
+      CloseHandle(threads[i]);
+    }
+  }
+}
+
+struct PartsJob{
+  TagFileInfo* fi;
+  const char* part;
+  StrList res;
+};
+
+static void PartsProc(void* param,int idx)
+{
+  PartsJob& job=(*(Array<PartsJob>*)param)[idx];
+  FindPartsInFile(job.fi,job.part,job.res);
+}
+
+static bool PartsLess(Array<PartsJob>& jobs,Vector<int>& cur,int a,int b)
+{
+  return strcmp(jobs[a].res[cur[a]],jobs[b].res[cur[b]])<0;
+}
+
+static void PartsSiftDown(Array<PartsJob>& jobs,Vector<int>& cur,Vector<int>& heap,int i)
+{
+  int n=heap.Count();
+  for(;;)
+  {
+    int min=i;
+    int l=i*2+1,r=l+1;
+    if(l<n && PartsLess(jobs,cur,heap[l],heap[min]))min=l;
+    if(r<n && PartsLess(jobs,cur,heap[r],heap[min]))min=r;
+    if(min==i)break;
+    int t=heap[i];
+    heap[i]=heap[min];
+    heap[min]=t;
+    i=min;
+  }
+}
 
+/*
+  Every tags file is searched by one of worker threads.
+  Results of each file are already sorted, so they are
+  merged through a heap and deduplicated without sorting again.
+*/
 void FindParts(const char* file, const char* part,StrList& dst)
 {
   String filename=file;
   filename.ToLower();
   dst.Clean();
-  StrList tmp;
+  Vector<TagFileInfo*> sel;
   int i;
   for(i=0;i<files.Count();i++)
   {
     if(files[i]->mainaload ||
        files[i]->isLoadBase(filename))
     {
-      FindPartsInFile(files[i],part,tmp);
+      CheckModified(files[i],GetBase(files[i]));
+      sel.Push(files[i]);
     }
   }
-  if(tmp.Count()==0)return;
-  tmp.Sort(dst);
-  i=1;
-  String *s=&dst[0];
-  while(i<dst.Count())
+  if(sel.Count()==0)return;
+  Array<PartsJob> jobs;
+  jobs.Init(sel.Count());
+  for(i=0;i<sel.Count();i++)
+  {
+    jobs[i].fi=sel[i];
+    jobs[i].part=part;
+  }
+  RunJobs(PartsProc,&jobs,jobs.Count());
+
+  //heap of jobs ordered by their current name
+  Vector<int> cur,heap;
+  cur.Fill(jobs.Count(),0);
+  for(i=0;i<jobs.Count();i++)
+  {
+    if(jobs[i].res.Count())heap.Push(i);
+  }
+  for(i=heap.Count()/2-1;i>=0;i--)
+  {
+    PartsSiftDown(jobs,cur,heap,i);
+  }
+  while(heap.Count())
   {
-    if(dst[i]==*s)
+    int top=heap[0];
+    String& s=jobs[top].res[cur[top]++];
+    if(dst.Count()==0 || s!=dst[dst.Count()-1])
     {
-      dst.Delete();
-    }else
+      dst<<s;
+    }
+    if(cur[top]==jobs[top].res.Count())
+    {
+      heap.Pop(heap[0]);
+    }
+    if(heap.Count())PartsSiftDown(jobs,cur,heap,0);
+  }
+}
+
+static inline bool IsBoundary(const char* s,int i)
+{
+  if(i==0)return true;
+  char p=s[i-1],c=s[i];
+  if(p=='_' || p==':' || p=='~' || p=='.')return true;
+  if(isupper(c) && islower(p))return true;
+  if(isalpha(c) && isdigit(p))return true;
+  return false;
+}
+
+static unsigned char lowerTable[256];
+
+//longer patterns are not searched, input box does not allow them anyway
+const int FuzzyMaxPattern=255;
+//FuzzyScore of matched char, bonuses for consecutive match,
+//word start, name start and same case, gaps cost 1 per char up to 8
+const int FuzzyChar=16;
+const int FuzzyRun=16;
+const int FuzzyWord=14;
+const int FuzzyFirst=8;
+const int FuzzyCase=2;
+const int FuzzyMaxGap=8;
+//every that name is scored before the search to find a threshold
+const int FuzzySampleStep=32;
+//names tested by quick limits at a time, then the bar is read again
+const int FuzzyBlock=1024;
+//FuzzyQuick::cls of names without classes and with more than two
+const int FuzzyNoClass=0xffff;
+const int FuzzyManyClasses=0xfffe;
+
+static bool IsSubseq(const char* pat,int patlen,const char* s,int len)
+{
+  if(patlen==0)return true;
+  int i=0;
+  unsigned char c=lowerTable[(unsigned char)pat[0]];
+  for(int j=0;j<len;j++)
+  {
+    if(lowerTable[(unsigned char)s[j]]==c)
     {
-      s=&dst[i];
-      i++;
-      if(i==dst.Count())break;
+      if(++i==patlen)return true;
+      c=lowerTable[(unsigned char)pat[i]];
     }
   }
+  return false;
+}
+
+//bonus for exact length, penalty for longer names
+static int FuzzyLength(int patlen,int len)
+{
+  if(len==patlen)return 20;
+  return -((len-patlen)/2<32?(len-patlen)/2:32);
+}
+
+/*
+  Score of subsequence match of pat in s, -1 if pat is not a subsequence.
+  Matches are greedy, but a char is moved forward to a word boundary
+  (after _ or ::, or a camel case hump) if the rest of pattern still fits.
+  Consecutive matches score a bit higher than boundary ones, so OpenFile
+  is before o_p_e_n for open, but two boundaries beat one run, so FooBar
+  is before afb for fb. Match at the start of name scores higher still,
+  gaps and length lower the score.
+*/
+static int FuzzyScore(const char* pat,int patlen,const char* s,int len)
+{
+  //latest[i] is the last position where pat[i..] can start
+  int latest[FuzzyMaxPattern+1];
+  latest[patlen]=len;
+  int i,j=len-1;
+  for(i=patlen-1;i>=0;i--,j--)
+  {
+    unsigned char c=lowerTable[(unsigned char)pat[i]];
+    while(j>=0 && lowerTable[(unsigned char)s[j]]!=c)j--;
+    if(j<0)return -1;
+    latest[i]=j;
+  }
+  int score=0,prev=-2;
+  j=0;
+  for(i=0;i<patlen;i++)
+  {
+    unsigned char c=lowerTable[(unsigned char)pat[i]];
+    while(lowerTable[(unsigned char)s[j]]!=c)j++;
+    if(prev!=j-1 && !IsBoundary(s,j))
+    {
+      for(int k=j+1;k<latest[i+1];k++)
+      {
+        if(lowerTable[(unsigned char)s[k]]==c && IsBoundary(s,k))
+        {
+          j=k;
+          break;
+        }
+      }
+    }
+    score+=FuzzyChar;
+    if(prev==j-1)
+    {
+      score+=FuzzyRun;
+    }else if(prev>=0)
+    {
+      score-=j-prev-1<FuzzyMaxGap?j-prev-1:FuzzyMaxGap;
+    }
+    if(IsBoundary(s,j))score+=FuzzyWord;
+    if(j==0)score+=FuzzyFirst;
+    if(s[j]==pat[i])score+=FuzzyCase;
+    prev=j;
+    j++;
+  }
+  return score+FuzzyLength(patlen,len);
+}
+
+struct FuzzyHit{
+  int score;
+  int namelen;
+  int file;
+  int line;
+};
+
+//better first, equal scores by name length, then in file order
+static int FuzzyHitCmp(const void* v1,const void* v2)
+{
+  const FuzzyHit *a=(const FuzzyHit*)v1;
+  const FuzzyHit *b=(const FuzzyHit*)v2;
+  if(a->score!=b->score)return b->score-a->score;
+  if(a->namelen!=b->namelen)return a->namelen-b->namelen;
+  if(a->file!=b->file)return a->file-b->file;
+  return a->line-b->line;
+}
+
+struct FuzzyJob{
+  FuzzyNames* names;
+  int file;
+  int from;
+  int to;
+  const char* pat;
+  int patlen;
+  unsigned patmask;
+  int step;
+  //CharBit of pattern chars and PairBit of each with previous one,
+  //and numbers of those bits
+  const unsigned* chars;
+  const unsigned* pairs;
+  const int* charBits;
+  const int* pairBits;
+  //masks of pat[t..], name that lacks them has no limit for pat[t..]
+  const unsigned* rest;
+  //class part limits of classes, patlen-1 for each
+  const int* clsLimits;
+  //best class part limits, NULL if class::name is not limited
+  const int* clsTop;
+  //FuzzyWord of pattern chars and FuzzyRun of pairs by bytes of starts
+  //and pairs, 8 tables of 256, their sum is lim[0] less the chars
+  const int* quickTab;
+  //FuzzyLength of names by FuzzyQuick::len, and of class::name
+  int lenTab[256];
+  int clsLenTab[256];
+  int maxcount;
+  //heap of best hits of the job, worst at the top
+  Vector<FuzzyHit> hits;
+  //FuzzyBar of the worst hit that can still get into the result,
+  //shared by all jobs: any job with maxcount hits limits them all
+  LONG volatile* bar;
+  //FuzzyBar of the top of full hits, -1 until they are full,
+  //names after it lose even when equal
+  LONG top;
+};
+
+//score and name length in one value that is greater for better hits,
+//equal names lengths have equal values
+static LONG FuzzyBar(int score,int namelen)
+{
+  if(score<-16384)score=-16384;
+  if(score>16383)score=16383;
+  if(namelen>0xffff)namelen=0xffff;
+  return (LONG)(((score+16384)<<16)|(0xffff-namelen));
+}
+
+static void RaiseFuzzyBar(LONG volatile* bar,LONG val)
+{
+  LONG cur;
+  while((cur=*bar)<val && InterlockedCompareExchange(bar,val,cur)!=cur);
+}
+
+/*
+  Upper limits of FuzzyScore for a name, from chars at word starts and pairs
+  of adjacent chars it has. lim[t] is for pat[t..] with pat[t] not following
+  a matched char, lim[patlen] is 0, -1000000 if name lacks chars of pat[t..].
+*/
+static void FuzzyLimits(const FuzzyJob& job,const FuzzyQuick& n,int* lim)
+{
+  //bits are shifted rather than tested, names are too random for branches
+  int t=job.patlen-1;
+  lim[job.patlen]=0;
+  lim[t]=FuzzyChar+FuzzyCase+((n.starts>>job.charBits[t])&1)*FuzzyWord;
+  for(t--;t>=0;t--)
+  {
+    lim[t]=lim[t+1]+FuzzyChar+FuzzyCase+
+           ((n.starts>>job.charBits[t])&1)*FuzzyWord+
+           ((n.pairs>>job.pairBits[t+1])&1)*FuzzyRun;
+  }
+  for(t=job.patlen-1;t>=0;t--)
+  {
+    lim[t]=(n.mask&job.rest[t])==job.rest[t]?lim[t]:-1000000;
+  }
+}
+
+//best FuzzyLength of names at least len chars long
+static int FuzzyMaxLength(int patlen,int len)
+{
+  return len<=patlen?FuzzyLength(patlen,patlen):FuzzyLength(patlen,len);
+}
+
+/*
+  Best scores of class part of class::name, when last char of pattern
+  is not :. bound[i] is for pat[..i] matched in class:: and the rest
+  in name, with gap to name start. Taken over all ways to match it.
+*/
+static void FuzzyClassLimits(const char* pat,int patlen,const char* cls,int clslen,Vector<int>& rows,int* bound)
+{
+  const int none=-1000000;
+  char buf[512];
+  int len=clslen+2;
+  for(int i=0;i<patlen-1;i++)bound[i]=none;
+  //longer ones are not tried at all
+  if(len>(int)sizeof(buf))return;
+  memcpy(buf,cls,clslen);
+  memcpy(buf+clslen,"::",2);
+  rows.Fill(len*2,none);
+  int *prev=&rows[0],*cur=&rows[len];
+  for(int i=0;i<patlen-1;i++)
+  {
+    unsigned char c=lowerTable[(unsigned char)pat[i]];
+    int far=none;
+    for(int j=0;j<len;j++)
+    {
+      //longer gaps cost the same
+      int farj=j-FuzzyMaxGap-2;
+      if(farj>=0 && prev[farj]>far)far=prev[farj];
+      cur[j]=none;
+      if(lowerTable[(unsigned char)buf[j]]!=c)continue;
+      int score=i==0?0:far-FuzzyMaxGap;
+      for(int k=j-1;i>0 && k>=0 && k>farj;k--)
+      {
+        if(prev[k]==none)continue;
+        int v=prev[k]+(k==j-1?FuzzyRun:-(j-k-1));
+        if(v>score)score=v;
+      }
+      if(score<=none/2)continue;
+      score+=FuzzyChar;
+      if(IsBoundary(buf,j))score+=FuzzyWord;
+      if(j==0)score+=FuzzyFirst;
+      if(buf[j]==pat[i])score+=FuzzyCase;
+      cur[j]=score;
+      int gap=len-1-j;
+      score+=gap==0?FuzzyRun:-(gap<FuzzyMaxGap?gap:FuzzyMaxGap);
+      if(score>bound[i])bound[i]=score;
+    }
+    int *t=prev;
+    prev=cur;
+    cur=t;
+  }
+}
+
+static void AddFuzzyHit(FuzzyJob& job,const FuzzyHit& hit)
+{
+  Vector<FuzzyHit>& h=job.hits;
+  int i;
+  if(h.Count()<job.maxcount)
+  {
+    h.Push(hit);
+    for(i=h.Count()-1;i>0 && FuzzyHitCmp(&h[(i-1)/2],&h[i])<0;i=(i-1)/2)
+    {
+      FuzzyHit t=h[i];
+      h[i]=h[(i-1)/2];
+      h[(i-1)/2]=t;
+    }
+  }else
+  {
+    if(FuzzyHitCmp(&hit,&h[0])>=0)return;
+    h[0]=hit;
+    for(i=0;;)
+    {
+      int c=i*2+1;
+      if(c>=h.Count())break;
+      if(c+1<h.Count() && FuzzyHitCmp(&h[c+1],&h[c])>0)c++;
+      if(FuzzyHitCmp(&h[c],&h[i])<=0)break;
+      FuzzyHit t=h[i];
+      h[i]=h[c];
+      h[c]=t;
+      i=c;
+    }
+  }
+  if(h.Count()==job.maxcount)
+  {
+    job.top=FuzzyBar(h[0].score,h[0].namelen);
+    RaiseFuzzyBar(job.bar,job.top);
+  }
+}
+
+//class: or struct: field of line, scanning extension fields backwards from its end
+static const char* FindClassField(const char* tab,const char* eol,int& len)
+{
+  while(eol>tab && (eol[-1]=='\r' || eol[-1]=='\n'))eol--;
+  const char *p=eol;
+  while(p>tab)
+  {
+    const char *t=p-1;
+    while(t>tab && *t!='\t')t--;
+    if(t==tab)break;
+    int flen=p-t-1;
+    const char *cls=NULL;
+    if(flen>6 && !strncmp(t+1,"class:",6))cls=t+7;
+    else if(flen>7 && !strncmp(t+1,"struct:",7))cls=t+8;
+    if(cls)
+    {
+      len=p-cls;
+      return cls;
+    }
+    if(t[-1]=='"' && t[-2]==';')break;
+    p=t;
+  }
+  return NULL;
+}
+
+//read distinct names and classes of all tags of fi
+static FuzzyNames* ReadFuzzyNames(TagFileInfo* fi)
+{
+  MappedFile tf;
+  if(!tf.Open(fi->filename,ScanWindow))return NULL;
+  FuzzyNames* fn=new FuzzyNames;
+  Hash<int> clsIds;
+  String cls;
+  FuzzyName n;
+  FuzzyQuick q;
+  for(int i=0;i<fi->Count();i++)
+  {
+    int linelen=0;
+    const char *line=tf.MapLine(fi->Name(i),linelen);
+    const char *tab=line?(const char*)memchr(line,'\t',linelen):NULL;
+    int namelen=tab?tab-line:0;
+    int cur=fn->names.Count()-1;
+    if(cur<0 || fn->pool.len-fn->names[cur].off!=namelen ||
+       memcmp(fn->pool.data+fn->names[cur].off,line,namelen))
+    {
+      q.mask=0;
+      q.starts=0;
+      q.pairs=0;
+      for(int j=0;j<namelen;j++)
+      {
+        q.mask|=CharBit(line[j]);
+        if(IsBoundary(line,j))q.starts|=CharBit(line[j]);
+        if(j>0)q.pairs|=PairBit(line[j-1],line[j]);
+      }
+      q.len=namelen<0xff?namelen:0xff;
+      q.first=namelen>0?tolower((unsigned char)line[0]):0;
+      q.cls[0]=q.cls[1]=FuzzyNoClass;
+      fn->quick.Push(q);
+      n.mask=q.mask;
+      n.off=fn->pool.Append(line,namelen);
+      n.line=i;
+      n.ref=fn->refs.Count();
+      fn->names.Push(n);
+      fn->anyMask.Push(n.mask);
+    }
+    int clslen;
+    const char *clsp=tab?FindClassField(tab,line+linelen,clslen):NULL;
+    if(!clsp)continue;
+    cls.Set(clsp,0,clslen);
+    FuzzyRef ref;
+    ref.line=i;
+    if(!clsIds.Exists(cls))
+    {
+      n.mask=0;
+      for(int j=0;j<clslen;j++)n.mask|=CharBit(clsp[j]);
+      n.off=fn->clsPool.Append(clsp,clslen);
+      clsIds.Insert(cls,fn->classes.Count());
+      fn->classes.Push(n);
+    }
+    ref.cls=clsIds[cls];
+    fn->refs.Push(ref);
+    fn->anyMask[fn->anyMask.Count()-1]|=fn->classes[ref.cls].mask|CharBit(':');
+    FuzzyQuick& last=fn->quick.Last();
+    int id=ref.cls<FuzzyManyClasses?ref.cls:FuzzyManyClasses;
+    if(last.cls[0]==FuzzyNoClass)last.cls[0]=id;
+    else if(last.cls[0]!=id && last.cls[0]!=FuzzyManyClasses && last.cls[1]!=id)
+    {
+      if(last.cls[1]==FuzzyNoClass)last.cls[1]=id;
+      else
+      {
+        last.cls[0]=FuzzyManyClasses;
+        last.cls[1]=FuzzyNoClass;
+      }
+    }
+  }
+  n.mask=0;
+  n.off=fn->pool.len;
+  n.line=fi->Count();
+  n.ref=fn->refs.Count();
+  fn->names.Push(n);
+  n.off=fn->clsPool.len;
+  fn->classes.Push(n);
+  return fn;
+}
+
+//sum of 8 quickTab tables for bytes of starts and pairs of a name
+static inline int FuzzyTabSum(const int* tab,const FuzzyQuick& q)
+{
+  return tab[q.starts&0xff]+tab[256+(q.starts>>8&0xff)]+
+         tab[512+(q.starts>>16&0xff)]+tab[768+(q.starts>>24)]+
+         tab[1024+(q.pairs&0xff)]+tab[1280+(q.pairs>>8&0xff)]+
+         tab[1536+(q.pairs>>16&0xff)]+tab[1792+(q.pairs>>24)];
+}
+
+//limit of class::name with class cls, or with any class for FuzzyManyClasses
+static int FuzzyClassLimit(const FuzzyJob& job,int cls,const int* lim,int len)
+{
+  const FuzzyNames& fn=*job.names;
+  const int *cl=job.clsTop;
+  int clslen=1;
+  if(cls!=FuzzyManyClasses)
+  {
+    //class that matches none or all of pattern is not tried
+    int k=fn.clsMatch[cls];
+    if(!job.clsLimits || k==0 || k==job.patlen)return -1000000;
+    cl=job.clsLimits+cls*(job.patlen-1);
+    clslen=fn.classes[cls+1].off-fn.classes[cls].off;
+  }
+  int best=-1000000;
+  for(int t=0;t<job.patlen-1;t++)
+  {
+    int v=cl[t]+lim[t+1];
+    best=v>best?v:best;
+  }
+  return best+FuzzyMaxLength(job.patlen,clslen+2+len);
+}
+
+//hit with at most that score cannot get into the result
+static inline bool FuzzyLoses(const FuzzyJob& job,int score,int namelen)
+{
+  //names are scanned in line order, equal hits of the job are before it
+  LONG v=FuzzyBar(score,namelen);
+  return v<*job.bar || v<=job.top;
+}
+
+static void FuzzyProc(void* param,int idx)
+{
+  FuzzyJob& job=(*(Array<FuzzyJob>*)param)[idx];
+  FuzzyNames& fn=*job.names;
+  const FuzzyName* names=&fn.names[0];
+  const FuzzyQuick* quick=&fn.quick[0];
+  const unsigned* anyMask=&fn.anyMask[0];
+  unsigned qmask=CharBit(':');
+  char qname[512];
+  int lim[FuzzyMaxPattern+1];
+  FuzzyHit hit;
+  hit.file=job.file;
+  //mask drops most names, without branches, they would be mispredicted
+  int *cand=&fn.cand[job.from];
+  int count=0;
+  for(int i=job.from;i<job.to;i+=job.step)
+  {
+    cand[count]=i;
+    count+=(anyMask[i]&job.patmask)==job.patmask;
+  }
+  const int *tab=job.quickTab;
+  const int *clsQuick=&fn.clsQuick[0];
+  const int ncls=fn.classes.Count()-1;
+  const unsigned colon=CharBit(':');
+  const int chars=job.patlen*(FuzzyChar+FuzzyCase);
+  const unsigned char first=lowerTable[(unsigned char)job.pat[0]];
+  const unsigned last=job.chars[job.patlen-1];
+  for(int from=0;from<count;from+=FuzzyBlock)
+  {
+    int to=from+FuzzyBlock<count?from+FuzzyBlock:count;
+    if(job.clsTop)
+    {
+      //lim[0] from tables, with looser limits of class::name by classes
+      //of the name, drops most of the rest without branches too
+      const LONG bar=*job.bar>job.top?*job.bar:job.top+1;
+      int kept=from;
+      for(int c=from;c<to;c++)
+      {
+        int i=cand[c];
+        const FuzzyQuick& q=quick[i];
+        int sum=chars+FuzzyTabSum(tab,q);
+        int best=(q.mask&job.patmask)==job.patmask?
+                 sum+(q.first==first?FuzzyFirst:0)+job.lenTab[q.len]:-16384;
+        int nocolon=(q.mask&colon)==0;
+        int c0=clsQuick[(q.cls[0]<ncls?q.cls[0]:q.cls[0]==FuzzyManyClasses?ncls:ncls+1)*2+nocolon];
+        int c1=clsQuick[(q.cls[1]<ncls?q.cls[1]:q.cls[1]==FuzzyManyClasses?ncls:ncls+1)*2+nocolon];
+        int cls=(c0>c1?c0:c1)+sum+job.clsLenTab[q.len];
+        cls=q.mask&last?cls:-16384;
+        best=cls>best?cls:best;
+        best=best>-16384?best:-16384;
+        cand[kept]=i;
+        kept+=(LONG)(((best+16384)<<16)|(0xffff-q.len))>=bar;
+      }
+      to=kept;
+    }
+    for(int c=from;c<to;c++)
+    {
+      int i=cand[c];
+      const FuzzyQuick& q=quick[i];
+      bool whole=(q.mask&job.patmask)==job.patmask;
+      bool qualified=q.cls[0]!=FuzzyNoClass && (q.mask&last);
+      FuzzyLimits(job,q,lim);
+      if(job.clsTop)
+      {
+        //limit of both name and class::name, class one is taken with
+        //classes of the name or with the best class if it has more,
+        //most of the rest lose here without reading name or its classes
+        int best=whole?lim[0]+(q.first==first?FuzzyFirst:0)+FuzzyLength(job.patlen,q.len):-1000000;
+        if(qualified)
+        {
+          int v=FuzzyClassLimit(job,q.cls[0],lim,q.len);
+          best=v>best?v:best;
+          if(q.cls[1]!=FuzzyNoClass)
+          {
+            v=FuzzyClassLimit(job,q.cls[1],lim,q.len);
+            best=v>best?v:best;
+          }
+        }
+        if(FuzzyLoses(job,best,q.len))continue;
+      }
+      const FuzzyName& n=names[i];
+      const FuzzyName& next=names[i+1];
+      int namelen=next.off-n.off;
+      const char *name=fn.pool.data+n.off;
+      hit.namelen=namelen;
+      if(whole)
+      {
+        //name that cannot get into the result is not scored
+        int best=lim[0];
+        if(lowerTable[(unsigned char)name[0]]==lowerTable[(unsigned char)job.pat[0]])best+=FuzzyFirst;
+        best+=FuzzyLength(job.patlen,namelen);
+        if(FuzzyLoses(job,best,namelen))
+        {
+          if(n.ref==next.ref || IsSubseq(job.pat,job.patlen,name,namelen))continue;
+        }else
+        {
+          hit.score=FuzzyScore(job.pat,job.patlen,name,namelen);
+          if(hit.score>=0)
+          {
+            for(hit.line=n.line;hit.line<next.line;hit.line++)AddFuzzyHit(job,hit);
+            continue;
+          }
+        }
+      }
+      //try class::name, name must match at least the last char of pattern
+      if(!qualified)continue;
+      for(int r=n.ref;r<next.ref;r++)
+      {
+        const FuzzyRef& ref=fn.refs[r];
+        int k=fn.clsMatch[ref.cls];
+        if(k==job.patlen || (k==0 && job.pat[0]!=':'))continue;
+        const FuzzyName& c=fn.classes[ref.cls];
+        int clslen=fn.classes[ref.cls+1].off-c.off;
+        if(job.clsLimits)
+        {
+          const int *cl=job.clsLimits+ref.cls*(job.patlen-1);
+          int best=-1000000;
+          for(int t=0;t<job.patlen-1;t++)
+          {
+            if(cl[t]+lim[t+1]>best)best=cl[t]+lim[t+1];
+          }
+          if(FuzzyLoses(job,best+FuzzyLength(job.patlen,clslen+2+namelen),namelen))continue;
+        }
+        if(((n.mask|c.mask|qmask)&job.patmask)!=job.patmask)continue;
+        //rest of pattern after what class matches must fit into ::name
+        if(job.pat[k]==':')k++;
+        if(k<job.patlen && job.pat[k]==':')k++;
+        if(!IsSubseq(job.pat+k,job.patlen-k,name,namelen))continue;
+        if(clslen+2+namelen>(int)sizeof(qname))continue;
+        memcpy(qname,fn.clsPool.data+c.off,clslen);
+        memcpy(qname+clslen,"::",2);
+        memcpy(qname+clslen+2,name,namelen);
+        hit.score=FuzzyScore(job.pat,job.patlen,qname,clslen+2+namelen);
+        if(hit.score<0)continue;
+        hit.line=ref.line;
+        AddFuzzyHit(job,hit);
+      }
+    }
+  }
+}
+
+/*
+  Subsequence search over names of all loaded tags files.
+  Returns at most maxcount tags ordered by match quality.
+  Distinct names are read once per index and kept in memory,
+  names with chars that pattern does not have are skipped by mask,
+  the rest is split into chunks that are scored in parallel.
+*/
+PTagArray FindFuzzy(const char* file,const char* pattern,int maxcount)
+{
+  String filename=file;
+  filename.ToLower();
+  int patlen=strlen(pattern);
+  if(patlen==0 || patlen>FuzzyMaxPattern || maxcount<=0)return NULL;
+  for(int c=0;c<256;c++)
+  {
+    lowerTable[c]=tolower(c);
+  }
+  unsigned patmask=0;
+  unsigned chars[FuzzyMaxPattern],pairs[FuzzyMaxPattern];
+  int charBits[FuzzyMaxPattern],pairBits[FuzzyMaxPattern];
+  unsigned rest[FuzzyMaxPattern+1];
+  //names without : have class part of class::name up to the last : at least
+  int colon=-1;
+  for(int k=0;k<patlen;k++)
+  {
+    chars[k]=CharBit(pattern[k]);
+    pairs[k]=k>0?PairBit(pattern[k-1],pattern[k]):0;
+    patmask|=chars[k];
+    for(charBits[k]=0;!(chars[k]>>charBits[k]&1);charBits[k]++);
+    for(pairBits[k]=0;k>0 && !(pairs[k]>>pairBits[k]&1);pairBits[k]++);
+    if(pattern[k]==':')colon=k;
+  }
+  rest[patlen]=0;
+  for(int k=patlen-1;k>=0;k--)rest[k]=rest[k+1]|chars[k];
+  bool clsLimits=patlen>1 && pattern[patlen-1]!=':';
+  //classes that match no or all of pattern are not tried,
+  //unless it starts with :, the rest is limited by clsLimits
+  bool clsTop=pattern[0]!=':' && pattern[patlen-1]!=':';
+  int quickTab[8*256];
+  memset(quickTab,0,sizeof(quickTab));
+  for(int k=0;k<patlen;k++)
+  {
+    for(int v=0;v<256;v++)
+    {
+      if(v>>(charBits[k]&7)&1)quickTab[(charBits[k]>>3)*256+v]+=FuzzyWord;
+      if(k>0 && v>>(pairBits[k]&7)&1)quickTab[(4+(pairBits[k]>>3))*256+v]+=FuzzyRun;
+    }
+  }
+  const int chunk=65536;
+  Vector<int> rows;
+  Vector<TagFileInfo*> sel;
+  int i,njobs=0;
+  for(i=0;i<files.Count();i++)
+  {
+    if(files[i]->mainaload ||
+       files[i]->isLoadBase(filename))
+    {
+      CheckModified(files[i],GetBase(files[i]));
+      if(!files[i]->hdr)continue;
+      if(!files[i]->fuzzy)files[i]->fuzzy=ReadFuzzyNames(files[i]);
+      if(!files[i]->fuzzy)continue;
+      FuzzyNames& fn=*files[i]->fuzzy;
+      fn.clsMatch.Init(fn.classes.Count());
+      fn.cand.Init(fn.Count());
+      if(clsLimits)fn.clsLimits.Init(fn.classes.Count()*(patlen-1));
+      fn.clsTop.Init(patlen);
+      for(int t=0;t<patlen;t++)fn.clsTop[t]=-1000000;
+      for(int c=0;c<fn.classes.Count()-1;c++)
+      {
+        const char *cls=fn.clsPool.data+fn.classes[c].off;
+        int clslen=fn.classes[c+1].off-fn.classes[c].off,k=0;
+        for(int l=0;l<clslen && k<patlen;l++)
+        {
+          if(lowerTable[(unsigned char)cls[l]]==lowerTable[(unsigned char)pattern[k]])k++;
+        }
+        fn.clsMatch[c]=k;
+        if(clsLimits && k>0 && k<patlen)
+        {
+          FuzzyClassLimits(pattern,patlen,cls,clslen,rows,&fn.clsLimits[c*(patlen-1)]);
+          for(int t=0;t<patlen-1;t++)
+          {
+            if(fn.clsLimits[c*(patlen-1)+t]>fn.clsTop[t])fn.clsTop[t]=fn.clsLimits[c*(patlen-1)+t];
+          }
+        }
+      }
+      //lim[t+1] is at most lim[0] less chars of pat[..t]
+      int ncls=fn.classes.Count()-1;
+      fn.clsQuick.Init((ncls+2)*2);
+      for(int c=0;c<(ncls+2)*2;c++)fn.clsQuick[c]=-1000000;
+      for(int c=0;c<=ncls;c++)
+      {
+        if(c<ncls && (!clsLimits || fn.clsMatch[c]==0 || fn.clsMatch[c]==patlen))continue;
+        const int *cl=c<ncls?&fn.clsLimits[c*(patlen-1)]:&fn.clsTop[0];
+        for(int t=0;t<patlen-1;t++)
+        {
+          int v=cl[t]-(t+1)*(FuzzyChar+FuzzyCase);
+          if(v>fn.clsQuick[c*2])fn.clsQuick[c*2]=v;
+          if(t>=colon && v>fn.clsQuick[c*2+1])fn.clsQuick[c*2+1]=v;
+        }
+      }
+      sel.Push(files[i]);
+      njobs+=(files[i]->fuzzy->Count()+chunk-1)/chunk;
+    }
+  }
+  if(njobs==0)return NULL;
+  Array<FuzzyJob> jobs;
+  jobs.Init(njobs);
+  LONG volatile bar=FuzzyBar(-1000000,0xffff);
+  int j=0;
+  for(i=0;i<sel.Count();i++)
+  {
+    int count=sel[i]->fuzzy->Count();
+    for(int from=0;from<count;from+=chunk,j++)
+    {
+      FuzzyJob& job=jobs[j];
+      job.names=sel[i]->fuzzy;
+      job.file=i;
+      job.from=from;
+      job.to=from+chunk<count?from+chunk:count;
+      job.pat=pattern;
+      job.patlen=patlen;
+      job.patmask=patmask;
+      job.chars=chars;
+      job.pairs=pairs;
+      job.charBits=charBits;
+      job.pairBits=pairBits;
+      job.rest=rest;
+      job.clsLimits=clsLimits?&sel[i]->fuzzy->clsLimits[0]:NULL;
+      job.clsTop=clsTop?&sel[i]->fuzzy->clsTop[0]:NULL;
+      job.quickTab=quickTab;
+      for(int l=0;l<256;l++)
+      {
+        job.lenTab[l]=FuzzyLength(patlen,l);
+        job.clsLenTab[l]=FuzzyMaxLength(patlen,l+3);
+      }
+      job.step=FuzzySampleStep;
+      job.maxcount=maxcount;
+      job.bar=&bar;
+      job.top=-1;
+    }
+  }
+  //score of maxcount-th best name of a sample is a lower bound for the result
+  Vector<FuzzyHit> hits;
+  for(int pass=0;pass<2;pass++)
+  {
+    RunJobs(FuzzyProc,&jobs,jobs.Count());
+    hits.Clean();
+    for(i=0;i<jobs.Count();i++)
+    {
+      for(j=0;j<jobs[i].hits.Count();j++)
+      {
+        hits.Push(jobs[i].hits[j]);
+      }
+    }
+    if(hits.Count()>0)
+    {
+      qsort(&hits[0],hits.Count(),sizeof(FuzzyHit),FuzzyHitCmp);
+      if(hits.Count()>maxcount)hits.Delete(maxcount,-1);
+    }
+    if(pass>0)break;
+    if(hits.Count()==maxcount)RaiseFuzzyBar(&bar,FuzzyBar(hits[maxcount-1].score,hits[maxcount-1].namelen));
+    for(i=0;i<jobs.Count();i++)
+    {
+      jobs[i].step=1;
+      jobs[i].hits.Clean();
+      jobs[i].top=-1;
+    }
+  }
+  if(hits.Count()==0)return NULL;
+
+  PTagArray ta=new TagArray;
+  Array<MappedFile> tfs;
+  tfs.Init(sel.Count());
+  for(i=0;i<hits.Count();i++)
+  {
+    TagFileInfo* fi=sel[hits[i].file];
+    MappedFile& tf=tfs[hits[i].file];
+    if(!tf.hMap && !tf.Open(fi->filename))continue;
+    TagInfo *ti=ParseLine(ReadLine(tf,fi->Name(hits[i].line)),GetBase(fi));
+    if(ti)ta->Push(ti);
+  }
+  if(ta->Count()==0)
+  {
+    delete ta;
+    ta=NULL;
+  }
+  return ta;
 }
 
 PTagArray FindFileSymbols(const char* file)
@@ -1134,7 +2376,7 @@ int Count()
   int cnt=0;
   for(int i=0;i<files.Count();i++)
   {
-    cnt+=files[i]->offsets.Count();
+    cnt+=files[i]->Count();
   }
   return cnt;
 }
@@ -1163,92 +2405,452 @@ void UnloadTags(int idx)
   }
 }
 
-int MergeFiles(const char* target,const char* mfile)
+//lines [pos,pos+len) of merged tags file, that were at oldpos in old one if kept
+struct DeltaRun{
+  TagOffset oldpos;
+  TagOffset pos;
+  TagOffset len;
+};
+
+/*
+  Runs of adjacent lines. They are written to temporary file while
+  merge goes and mapped back for index update, so memory used by merge
+  does not depend on size of tags files.
+*/
+struct DeltaRuns{
+  String filename;
+  FILE *f;
+  DeltaRun last;
+  int count;
+  MappedFile map;
+
+  DeltaRuns(const char* fn):filename(fn),f(NULL),count(0)
+  {
+    memset(&last,0,sizeof(last));
+  }
+  ~DeltaRuns()
+  {
+    if(f)fclose(f);
+    map.Close();
+    remove(filename);
+  }
+
+  bool Create()
+  {
+    f=fopen(filename,"wb");
+    if(!f)return false;
+    setvbuf(f,NULL,_IOFBF,65536);
+    return true;
+  }
+  void Push(TagOffset oldpos,TagOffset pos,int len)
+  {
+    if(last.len && last.oldpos+last.len==oldpos && last.pos+last.len==pos)
+    {
+      last.len+=len;
+      return;
+    }
+    Flush();
+    last.oldpos=oldpos;
+    last.pos=pos;
+    last.len=len;
+  }
+  void Flush()
+  {
+    if(!last.len)return;
+    fwrite(&last,sizeof(last),1,f);
+    count++;
+    last.len=0;
+  }
+  //finish writing and map runs for reading
+  bool Close()
+  {
+    Flush();
+    bool ok=!ferror(f);
+    ok=fclose(f)==0 && ok;
+    f=NULL;
+    return ok && (count==0 || map.Open(filename,ScanWindow));
+  }
+
+  int Count()const
+  {
+    return count;
+  }
+  const DeltaRun& operator[](int i)
+  {
+    return *(const DeltaRun*)map.Map((TagOffset)i*sizeof(DeltaRun),sizeof(DeltaRun));
+  }
+};
+
+//where lines of old tags file went and which lines are new
+struct IndexDelta{
+  DeltaRuns kept;
+  //added lines have no old position, their new one is used instead
+  DeltaRuns added;
+
+  IndexDelta():kept("tags.kept"),added("tags.added"){}
+};
+
+static bool GetFileName(const char* line,String& file)
 {
-  FILE *f=fopen(target,"rt");
-  if(!f)return 0;
-  FILE *g=fopen(mfile,"rt");
-  if(!g)
+  const char *tab=strchr(line,'\t');
+  if(!tab)return false;
+  tab++;
+  const char *tab2=strchr(tab,'\t');
+  if(!tab2)return false;
+  file.Set(tab,0,tab2-tab);
+  return true;
+}
+
+//reads lines of any length from tags file, keeping track of line offsets
+struct LineReader{
+  FILE *f;
+  char **mem;
+  int memCount;
+  char *buf;
+  int size;
+  int len;
+  TagOffset pos;
+  TagOffset next;
+
+  LineReader():f(NULL),mem(NULL),memCount(0),buf(NULL),size(0),len(0),pos(0),next(0){}
+  ~LineReader()
   {
-    fclose(f);
-    return 0;
+    Close();
   }
-  fgets(strbuf,sizeof(strbuf),g);
-  if(strncmp(strbuf,"!_TAG_FILE_FORMAT",17))
+
+  bool Open(const char* filename)
   {
-    fclose(f);
-    fclose(g);
-    return 0;
+    f=fopen(filename,"rb");
+    if(!f)return false;
+    setvbuf(f,NULL,_IOFBF,65536);
+    size=1024;
+    buf=(char*)malloc(size);
+    return Read();
   }
-  fgets(strbuf,sizeof(strbuf),f);
-  if(strncmp(strbuf,"!_TAG_FILE_FORMAT",17))
+
+  //read lines from memory, lines are not owned by reader
+  bool Open(char** lines,int count)
   {
-    fclose(f);
-    fclose(g);
-    return 0;
+    mem=lines;
+    memCount=count;
+    return Read();
   }
-  fseek(f,0,SEEK_SET);
-  FILE *h=fopen("tags.temp","wt");
-  if(!h)
+
+  void Close()
   {
-    fclose(f);
-    fclose(g);
-    return 0;
+    if(f)fclose(f);
+    if(!mem)free(buf);
+    f=NULL;
+    mem=NULL;
+    buf=NULL;
+    len=0;
+  }
+
+  bool Read()
+  {
+    len=0;
+    pos=next;
+    if(mem)
+    {
+      if(memCount==0)return false;
+      buf=*mem++;
+      memCount--;
+      len=strlen(buf);
+      next+=len;
+      return true;
+    }
+    if(!f)return false;
+    for(;;)
+    {
+      if(!fgets(buf+len,size-len,f))break;
+      len+=strlen(buf+len);
+      if(buf[len-1]=='\n')break;
+      if(len==size-1)
+      {
+        size*=2;
+        buf=(char*)realloc(buf,size);
+      }
+    }
+    next+=len;
+    return len>0;
+  }
+
+  bool Eof()const
+  {
+    return len==0;
+  }
+
+  bool IsFormat()const
+  {
+    return len>=17 && !strncmp(buf,"!_TAG_FILE_FORMAT",17);
+  }
+};
+
+/*
+  Merge sorted tags files into target.
+  Lines of target that belong to source files listed in changed or
+  present in any of mfiles or generated are dropped.
+  generated are tag lines produced in memory, without format header.
+  Files are streamed, only current line of every file is kept in memory.
+*/
+int MergeFiles(const char* target,StrList& mfiles,Vector<char*>& generated,
+               StrList& changed,IndexDelta& delta)
+{
+  int nfiles=mfiles.Count()+1;
+  int k=nfiles+(generated.Count()?1:0);
+  Array<LineReader> in;
+  in.Init(k);
+  int i;
+  for(i=0;i<nfiles;i++)
+  {
+    if(!in[i].Open(i==0?target:(const char*)mfiles[i-1]) || !in[i].IsFormat())return 0;
   }
-  char strbuf[1024]={0};
-  Vector<char*> a;
   Hash<int> files;
   String file;
-
-  while(fgets(strbuf,sizeof(strbuf),g))
+  if(generated.Count())
   {
-    if(strbuf[0]=='!')continue;
-    a.Push(strdup(strbuf));
-    char *tab=strchr(strbuf,'\t');
-    if(tab)
+    qsort(&generated[0],generated.Count(),sizeof(char*),StrCmp);
+    in[nfiles].Open(&generated[0],generated.Count());
+    for(i=0;i<generated.Count();i++)
     {
-      tab++;
-      char *tab2=strchr(tab,'\t');
-      file.Set(tab,0,tab2-tab-1);
-      files[file]=1;
+      if(GetFileName(generated[i],file))files[file]=1;
     }
   }
-  fclose(g);
-  int i=0;
-  while(fgets(strbuf,sizeof(strbuf),f))
+  for(i=0;i<changed.Count();i++)
+  {
+    files[changed[i]]=1;
+  }
+  for(i=1;i<nfiles;i++)
   {
-    if(strbuf[0]=='!')
+    LineReader rd;
+    rd.Open(mfiles[i-1]);
+    for(;!rd.Eof();rd.Read())
     {
-      fprintf(h,"%s",strbuf);
-      continue;
+      if(rd.buf[0]!='!' && GetFileName(rd.buf,file))
+      {
+        files[file]=1;
+      }
     }
-    char *tab=strchr(strbuf,'\t');
-    if(tab)
+  }
+
+  if(!delta.kept.Create() || !delta.added.Create())return 0;
+  FILE *h=fopen("tags.temp","wb");
+  if(!h)return 0;
+  setvbuf(h,NULL,_IOFBF,65536);
+  TagOffset outpos=0;
+  for(;;)
+  {
+    int min=-1;
+    for(i=0;i<k;i++)
     {
-      tab++;
-      char *tab2=strchr(tab,'\t');
-      file.Set(tab,0,tab2-tab-1);
-      if(files.Exists(file))continue;
+      LineReader& rd=in[i];
+      while(!rd.Eof())
+      {
+        if(rd.buf[0]=='!')
+        {
+          if(i==0)
+          {
+            fwrite(rd.buf,rd.len,1,h);
+            outpos+=rd.len;
+          }
+        }else if(i!=0 || !GetFileName(rd.buf,file) || !files.Exists(file))
+        {
+          break;
+        }
+        rd.Read();
+      }
+      if(rd.Eof())continue;
+      if(min==-1 || strcmp(rd.buf,in[min].buf)<0)
+      {
+        min=i;
+      }
     }
-    while(i<a.Count() && strcmp(a[i],strbuf)<0)
+    if(min==-1)break;
+    LineReader& rd=in[min];
+    fwrite(rd.buf,rd.len,1,h);
+    if(min==0)
+    {
+      delta.kept.Push(rd.pos,outpos,rd.len);
+    }else
     {
-      fprintf(h,"%s",a[i]);
-      i++;
+      delta.added.Push(outpos,outpos,rd.len);
     }
-    fprintf(h,"%s",strbuf);
+    outpos+=rd.len;
+    rd.Read();
   }
-  while(i<a.Count())
+  for(i=0;i<k;i++)
   {
-    fprintf(h,"%s",a[i]);
-    i++;
+    in[i].Close();
+  }
+  int rc=ferror(h)?0:1;
+  if(fclose(h)!=0)rc=0;
+  if(!delta.kept.Close() || !delta.added.Close())rc=0;
+  if(!rc)
+  {
+    remove("tags.temp");
+    return 0;
   }
-  fclose(f);
-  fclose(h);
   remove(target);
   rename("tags.temp",target);
   return 1;
 }
 
+static bool FindNewPos(IndexDelta& delta,TagOffset oldpos,TagOffset& newpos)
+{
+  int left=0;
+  int right=delta.kept.Count()-1;
+  while(left<=right)
+  {
+    int pos=(right+left)/2;
+    DeltaRun r=delta.kept[pos];
+    if(oldpos<r.oldpos)
+    {
+      right=pos-1;
+    }else if(oldpos>=r.oldpos+r.len)
+    {
+      left=pos+1;
+    }else
+    {
+      newpos=r.pos+(oldpos-r.oldpos);
+      return true;
+    }
+  }
+  return false;
+}
+
+//remap surviving entries of one old index section and merge added lines into it
+static void MergeSection(MappedFile& tf,IndexDelta& delta,
+                         MappedFile& index,TagOffset old,int oldcount,
+                         Vector<LineInfo>& added,int (*cmp)(const void*,const void*),
+                         Vector<TagOffset>& dst)
+{
+  if(added.Count())
+    qsort(&added[0],added.Count(),sizeof(LineInfo),cmp);
+  int j=0;
+  TagOffset pos;
+  LineInfo li;
+  for(int i=0;i<oldcount;i++)
+  {
+    if(!FindNewPos(delta,ReadOffset(index,old,i),pos) || !GetLineInfo(tf,pos,li))continue;
+    while(j<added.Count() && cmp(&added[j],&li)<0)
+    {
+      dst.Push(added[j++].pos);
+    }
+    dst.Push(pos);
+  }
+  while(j<added.Count())
+  {
+    dst.Push(added[j++].pos);
+  }
+}
+
+static bool WriteOffsets(FILE* g,Vector<TagOffset>& offsets)
+{
+  if(offsets.Count()==0)return true;
+  return fwrite(&offsets[0],sizeof(TagOffset),offsets.Count(),g)==(size_t)offsets.Count();
+}
+
+/*
+  Update index of merged tags file without full rebuild.
+  Old index is still mapped and describes the tags file before merge,
+  delta tells where its lines went and which lines are new.
+*/
+static int UpdateIndex(TagFileInfo* fi,IndexDelta& delta,StrList& changed)
+{
+  if(!fi->hdr)return 0;
+  struct stat st;
+  if(stat(fi->filename,&st)==-1)return 0;
+  MappedFile tf;
+  if(!tf.Open(fi->filename,ScanWindow))return 0;
+  if(delta.kept.Count())
+  {
+    DeltaRun r=delta.kept[delta.kept.Count()-1];
+    if(r.oldpos+r.len>fi->hdr->tagsSize)return 0;
+  }
+
+  Vector<LineInfo> lines;
+  Vector<LineInfo> classes;
+  Hash<long long> srcfiles;
+  String file,base=fi->filename;
+  base.Delete(base.RIndex("\\")+1);
+
+  TagOffset off=fi->srcFiles;
+  long long modt;
+  for(int i=0;i<fi->hdr->srcCount;i++)
+  {
+    if(!ReadSrcFile(fi->index,off,file,modt))break;
+    srcfiles.Insert(file,modt);
+  }
+  for(int i=0;i<changed.Count();i++)
+  {
+    srcfiles.Delete(changed[i]);
+  }
+
+  //files of added lines get current modification time, as in full rebuild
+  Hash<int> addedFiles;
+  LineInfo li;
+  for(int i=0;i<delta.added.Count();i++)
+  {
+    DeltaRun r=delta.added[i];
+    for(TagOffset pos=r.pos;pos<r.pos+r.len;)
+    {
+      pos=GetLineInfo(tf,pos,li);
+      if(!pos)return 0;
+      if(li.fn<0)continue;
+      lines.Push(li);
+      if(li.cls>=0)classes.Push(li);
+      file.Set(tf.Map(li.pos,li.len)+li.fn,0,li.filelen);
+      if(addedFiles.Exists(file))continue;
+      addedFiles.Insert(file,1);
+      srcfiles.Delete(file);
+      struct stat sts;
+      if(stat(base+file,&sts)!=-1)srcfiles.Insert(file,sts.st_mtime);
+    }
+  }
+
+  Vector<TagOffset> names,byFile,byClass;
+  sortFile=&tf;
+  MergeSection(tf,delta,fi->index,fi->names,fi->hdr->count,lines,LinesCmp,names);
+  MergeSection(tf,delta,fi->index,fi->byFile,fi->hdr->count,lines,FilesCmp,byFile);
+  MergeSection(tf,delta,fi->index,fi->byClass,fi->hdr->clsCount,classes,ClsCmp,byClass);
+
+  String tmpFile=fi->indexFile+".tmp";
+  FILE *g=fopen(tmpFile,"wb");
+  if(!g)return 0;
+  IndexHeader hdr;
+  memset(&hdr,0,sizeof(hdr));
+  memcpy(hdr.magic,IndexMagic,sizeof(hdr.magic));
+  hdr.version=IndexVersion;
+  hdr.count=names.Count();
+  hdr.clsCount=byClass.Count();
+  hdr.srcCount=srcfiles.GetCount();
+  hdr.tagsSize=tf.size;
+  bool ok=fwrite(&hdr,sizeof(hdr),1,g)==1;
+  ok=ok && WriteOffsets(g,names);
+  ok=ok && WriteOffsets(g,byFile);
+  ok=ok && WriteOffsets(g,byClass);
+  ok=ok && WriteSrcFiles(g,srcfiles);
+  ok=fclose(g)==0 && ok;
+  if(!ok)
+  {
+    remove(tmpFile);
+    return 0;
+  }
+  fi->CloseIndex();
+  remove(fi->indexFile);
+  if(rename(tmpFile,fi->indexFile)!=0)
+  {
+    remove(tmpFile);
+    return 0;
+  }
+  fi->modtm=st.st_mtime;
+  utimbuf tm;
+  tm.actime=fi->modtm;
+  tm.modtime=fi->modtm;
+  utime(fi->indexFile,&tm);
+  return LoadIndex(fi)?1:0;
+}
+
 bool Execute(const char* cmd)
 {
   STARTUPINFO si;
@@ -1270,20 +2872,23 @@ int TagCurrentDir()
   return 1;
 }
 
-int UpdateTagsFile(const char* file)
+static TagFileInfo* FindTagFile(const String& filename)
 {
-  TagFileInfo *fi=NULL;
-  int i;
-  String filename=file;
-  filename.ToLower();
-  for(i=0;i<files.Count();i++)
+  for(int i=0;i<files.Count();i++)
   {
     if(files[i]->filename==filename)
     {
-      fi=files[i];
-      break;
+      return files[i];
     }
   }
+  return NULL;
+}
+
+int UpdateTagsFile(const char* file)
+{
+  String filename=file;
+  filename.ToLower();
+  TagFileInfo *fi=FindTagFile(filename);
   if(!fi)
   {
     struct stat st;
@@ -1293,33 +2898,60 @@ int UpdateTagsFile(const char* file)
     tfi.modtm=st.st_mtime;
     if(!FindIdx(&tfi))return 0;
     if(Load(filename,"")!=1)return 0;
+    fi=FindTagFile(filename);
+    if(!fi)return 0;
   }
   StrList sl;
   if(!CheckChangedFiles(filename,sl))return 0;
   if(sl.Count()==0)return 1;
-  sl.SaveToFile("tags.changes");
-  String cmd=config.exe+" ";
-  String opt=config.opt;
-  opt.Replace("-R","");
-  RegExp re("/\\*(\\.\\S*)?/");
-  SMatch m[4];
-  int n=4;
-  while(re.Search(opt,m,n))
-  {
-    opt.Delete(m[0].start,m[0].end-m[0].start);
-  }
-  cmd+=opt;
-  cmd+=" -f tags.update -L tags.changes";
-  //extern int Msg(const char* err);
-  //Msg(cmd);
-  if(!Execute(cmd))
+  //C/C++ sources are parsed in-process, the rest is passed to ctags
+  Vector<char*> generated;
+  StrList ext;
+  int i;
+  for(i=0;i<sl.Count();i++)
+  {
+    struct stat st;
+    if(stat(sl[i],&st)==-1)continue;
+    if(config.builtin && IsCppFile(sl[i]) && GenerateTags(sl[i],sl[i],generated))continue;
+    ext<<sl[i];
+  }
+  StrList mfiles;
+  if(ext.Count())
+  {
+    ext.SaveToFile("tags.changes");
+    String cmd=config.exe+" ";
+    String opt=config.opt;
+    opt.Replace("-R","");
+    RegExp re("/\\*(\\.\\S*)?/");
+    SMatch m[4];
+    int n=4;
+    while(re.Search(opt,m,n))
+    {
+      opt.Delete(m[0].start,m[0].end-m[0].start);
+    }
+    cmd+=opt;
+    cmd+=" -f tags.update -L tags.changes";
+    //extern int Msg(const char* err);
+    //Msg(cmd);
+    if(!Execute(cmd))
+    {
+      remove("tags.changes");
+      for(i=0;i<generated.Count();i++)free(generated[i]);
+      return 0;
+    }
+    mfiles<<"tags.update";
+  }
+  IndexDelta delta;
+  int merged=MergeFiles(file,mfiles,generated,sl,delta);
+  for(i=0;i<generated.Count();i++)free(generated[i]);
+  if(ext.Count())
   {
     remove("tags.changes");
-    return 0;
+    remove("tags.update");
+  }
+  if(!merged || !UpdateIndex(fi,delta,sl))
+  {
+    Load(file,"");
   }
-  MergeFiles(file,"tags.update");
-  remove("tags.changes");
-  remove("tags.update");
-  Load(file,"");
   return 1;
 }
@@ -62,6 +62,10 @@ enum{
   MWordChars,
   MCaseSensFilt,
   MNotFoundAsk,
+  MGotoSymbol,
+  MGotoSymbolTitle,
+  MInputSymbol,
+  MBuiltinParser,
 };
 
 struct Config{
@@ -69,6 +73,7 @@ struct Config{
   String opt;
   String autoload;
   bool casesens;
+  bool builtin;
 };
 
 extern Config config;
@@ -105,10 +110,14 @@ int Count();
 void FindParts(const char* file,const char* part,StrList& dst);
 PTagArray FindFileSymbols(const char* file);
 PTagArray FindClassSymbols(const char* file,const char* classname);
+PTagArray FindFuzzy(const char* file,const char* pattern,int maxcount);
 void Autoload(const char* fn);
 void GetFiles(StrList& dst);
 int TagCurrentDir();
 int UpdateTagsFile(const char* file);
 
+bool IsCppFile(const char* filename);
+int GenerateTags(const char* filename,const char* tagfile,Vector<char*>& dst);
+
 
 #endif
@@ -0,0 +1,254 @@
+/*
+  Copyright (C) 2000 Konstantin Stupnik
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+  Test of built-in C/C++ tags generator. Tags of a sample source are
+  compared with test/cparser.tags, output of universal ctags for it.
+  Given ctags executable as argument, compares with its output as well,
+  with --record rewrites the reference from it:
+  cparsertest [--record] [ctags]
+*/
+
+#include <windows.h>
+#include <unistd.h>
+#include "tags.cpp"
+
+Config config;
+
+int isident(int c)
+{
+  return isalnum(c) || c=='_';
+}
+
+//only the first branch of #ifdef has tags, braces of the others are not
+//counted; #if 0 is skipped, its #else is followed
+static const char* sample[]={
+  "#define MAX_ITEMS 10",
+  "namespace geo {",
+  "enum Color { Red, Green=2, Blue };",
+  "struct Point {",
+  "  int x;",
+  "  int y;",
+  "};",
+  "class Shape {",
+  "public:",
+  "  Shape();",
+  "  virtual ~Shape();",
+  "  virtual double Area() const;",
+  "private:",
+  "  int id;",
+  "  int corners[4]={0,0,0,0};",
+  "};",
+  "double Shape::Area() const",
+  "{",
+  "  return 0;",
+  "}",
+  "int Count(int a,int b);",
+  "}",
+  "typedef unsigned int uint32;",
+  "union Value {",
+  "  int i;",
+  "  double d;",
+  "};",
+  "struct P { int a,b; };",
+  "int arr[10]={1,2};",
+  "struct P p={1,2};",
+  "static const char *names[]={",
+  "  \"first\",",
+  "  \"second\",",
+  "};",
+  "struct geo::Point origin={0,0},corner;",
+  "int counter;",
+  "#ifdef UNICODE",
+  "int Print(const wchar_t* s)",
+  "{",
+  "#elif defined(ANSI)",
+  "int Print(const char* s,int len)",
+  "{",
+  "#else",
+  "int Print(const char* s)",
+  "{",
+  "#endif",
+  "  return 0;",
+  "}",
+  "#if 0",
+  "int disabled;",
+  "#else",
+  "int enabled;",
+  "#endif",
+  "#if 0",
+  "/* #endif */",
+  "int hidden(void)",
+  "{",
+  "}",
+  "#endif",
+  "int main(int argc,char* argv[])",
+  "{",
+  "  return Print(\"\");",
+  "}"
+};
+
+static const char* refFile="test/cparser.tags";
+//only the fields that are compared, line numbers instead of patterns
+static const char* ctagsOptions=" --options=NONE --kinds-C++=+p --fields=kns --excmd=number -f - ";
+
+static int failed;
+
+//line, name, kind and scope of tag line, other fields are ignored
+static String Key(const char* tag)
+{
+  const char *tab=strchr(tag,'\t');
+  if(!tab)return tag;
+  String name;
+  name.Set(tag,0,tab-tag);
+  const char *fields=strstr(tab,";\"\t");
+  if(!fields)return "bad line: "+String(tag);
+  fields+=3;
+  int line=0;
+  String kind,scope;
+  while(*fields && *fields!='\n' && *fields!='\r')
+  {
+    const char *e=fields;
+    while(*e && *e!='\t' && *e!='\n' && *e!='\r')e++;
+    String f;
+    f.Set(fields,0,e-fields);
+    if(kind.Length()==0)kind=f;
+    else if(!strncmp(fields,"line:",5))line=atoi(fields+5);
+    else if(!strncmp(fields,"class:",6) || !strncmp(fields,"struct:",7) ||
+            !strncmp(fields,"union:",6) || !strncmp(fields,"enum:",5) ||
+            !strncmp(fields,"namespace:",10))scope=f;
+    fields=*e=='\t'?e+1:e;
+  }
+  char buf[32];
+  sprintf(buf,"%4d ",line);
+  return buf+name+" "+kind+" "+scope;
+}
+
+static int KeyCmp(const void* a,const void* b)
+{
+  return strcmp(*(const char**)a,*(const char**)b);
+}
+
+static void Sort(StrList& keys)
+{
+  Vector<const char*> v;
+  for(int i=0;i<keys.Count();i++)v.Push(keys[i]);
+  qsort(&v[0],v.Count(),sizeof(const char*),KeyCmp);
+  StrList sorted;
+  for(int i=0;i<v.Count();i++)sorted<<v[i];
+  keys=sorted;
+}
+
+//both lists sorted, prints keys found in one of them only
+static void Compare(const char* what,StrList& got,StrList& expected)
+{
+  Sort(got);
+  Sort(expected);
+  int i=0,j=0;
+  while(i<got.Count() || j<expected.Count())
+  {
+    int cmp=i==got.Count()?1:j==expected.Count()?-1:strcmp(got[i],expected[j]);
+    if(cmp==0)
+    {
+      i++;
+      j++;
+      continue;
+    }
+    if(cmp<0)printf("FAIL %s: extra   %s\n",what,got[i++].Str());
+    else printf("FAIL %s: missing %s\n",what,expected[j++].Str());
+    failed++;
+  }
+}
+
+int main(int argc,char* argv[])
+{
+  RegExp::InitLocale();
+  char fn[64];
+  sprintf(fn,"/tmp/cparsertest.%d.cpp",(int)getpid());
+  FILE *f=fopen(fn,"wb");
+  for(unsigned i=0;i<sizeof(sample)/sizeof(sample[0]);i++)
+  {
+    fprintf(f,"%s\n",sample[i]);
+  }
+  fclose(f);
+
+  Vector<char*> lines;
+  GenerateTags(fn,fn,lines);
+  StrList got,expected;
+  for(int i=0;i<lines.Count();i++)
+  {
+    got<<Key(lines[i]);
+    free(lines[i]);
+  }
+
+  bool record=argc>1 && !strcmp(argv[1],"--record");
+  const char *ctagsExe=argc>(record?2:1)?argv[record?2:1]:NULL;
+  if(ctagsExe)
+  {
+    String cmd=ctagsExe;
+    cmd+=ctagsOptions;
+    cmd+=fn;
+    cmd+=" 2>/dev/null";
+    StrList ctags,recorded;
+    FILE *p=popen(cmd,"r");
+    char buf[4096];
+    while(p && fgets(buf,sizeof(buf),p))
+    {
+      if(buf[0]=='!')continue;
+      ctags<<Key(buf);
+      //temporary name of the sample is not recorded
+      const char *tab=strchr(buf,'\t');
+      const char *tab2=tab?strchr(tab+1,'\t'):NULL;
+      if(!tab2)continue;
+      String line;
+      line.Set(buf,0,tab-buf);
+      recorded<<line+"\tsample.cpp"+tab2;
+    }
+    if(p)pclose(p);
+    if(ctags.Count()==0)
+    {
+      printf("FAIL: no tags from %s\n",ctagsExe);
+      failed++;
+    }else if(record)
+    {
+      FILE *out=fopen(refFile,"wb");
+      for(int i=0;out && i<recorded.Count();i++)fputs(recorded[i],out);
+      if(out)fclose(out);
+    }else
+    {
+      Compare(ctagsExe,got,ctags);
+    }
+  }
+
+  FILE *ref=fopen(refFile,"rb");
+  char buf[4096];
+  while(ref && fgets(buf,sizeof(buf),ref))
+  {
+    if(buf[0]!='!')expected<<Key(buf);
+  }
+  if(ref)fclose(ref);
+  if(expected.Count()==0)
+  {
+    printf("FAIL: no tags in %s\n",refFile);
+    failed++;
+  }else
+  {
+    Compare("reference",got,expected);
+  }
+  remove(fn);
+  printf("cparsertest: %d tags, %d failed\n",got.Count(),failed);
+  return failed?1:0;
+}
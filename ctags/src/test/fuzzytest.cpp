@@ -0,0 +1,355 @@
+/*
+  Copyright (C) 2000 Konstantin Stupnik
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+  Test of fuzzy search. Names of ranking corpus must be ordered by
+  FuzzyScore as listed and FindFuzzy must return them in that order.
+  Results of FindFuzzy over generated tags files must be the same
+  as of scoring every line, so skipped names can't change them.
+*/
+
+#include <windows.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "tags.cpp"
+#include "tagsgen.h"
+
+Config config;
+
+int isident(int c)
+{
+  return isalnum(c) || c=='_';
+}
+
+static int failed;
+
+static void Fail(const char* what,const char* arg)
+{
+  printf("FAIL %s: %s\n",what,arg);
+  failed++;
+}
+
+static void FreeTags(PTagArray ta)
+{
+  if(!ta)return;
+  for(int i=0;i<ta->Count();i++)delete (*ta)[i];
+  delete ta;
+}
+
+//pattern and names from better to worse match
+static const char* corpus[][10]={
+  {"gsn","gsn","gsnTable","get_some_name","GetSomeName","GetSomethingNew",
+         "GlobalSettingsManagerName","getsomename","xgxsxn",NULL},
+  {"fb","fb_init","foo_bar","fooBar","FooBar","FastBuffer","afb","xfxb",NULL},
+  {"open","open","Open","OpenFile","OpenTagsFile","o_p_e_n","isOpen","fopen","reopen",NULL},
+  {"ReadLine","ReadLine","readline","ReadLines","ReadLineInfo","Read_Line",
+              "ThreadLine","ReadALine",NULL},
+  {"idx","idx","Idx","GetIdx","index","IndexFile","FileIndex",NULL},
+  {"Class::Find","Class::Find","Class::FindAll","ClassA::Find","XClass::Find","Class::refind",NULL},
+  {"tfiCrIdx","TagFileInfo::CreateIdx","TagFileInfo::CreateIndex",NULL},
+};
+
+static const char* nonMatches[][2]={
+  {"gsn","sng"},
+  {"fb","bf"},
+  {"open","opne"},
+  {"idx","id"},
+  {"Class::Find","ClassFind"},
+  {"ab",""},
+};
+
+static void TestRanking()
+{
+  const int rows=sizeof(corpus)/sizeof(corpus[0]);
+  for(int r=0;r<rows;r++)
+  {
+    const char *pat=corpus[r][0];
+    FuzzyHit prev;
+    for(int i=1;corpus[r][i];i++)
+    {
+      FuzzyHit hit;
+      hit.score=FuzzyScore(pat,strlen(pat),corpus[r][i],strlen(corpus[r][i]));
+      hit.namelen=strlen(corpus[r][i]);
+      hit.file=hit.line=0;
+      if(hit.score<0)Fail(pat,corpus[r][i]);
+      else if(i>1 && FuzzyHitCmp(&prev,&hit)>=0)Fail(pat,corpus[r][i]);
+      prev=hit;
+    }
+  }
+  for(int i=0;i<(int)(sizeof(nonMatches)/sizeof(nonMatches[0]));i++)
+  {
+    const char *pat=nonMatches[i][0],*name=nonMatches[i][1];
+    if(FuzzyScore(pat,strlen(pat),name,strlen(name))>=0)Fail(pat,name);
+  }
+}
+
+static int LineCmp(const void* a,const void* b)
+{
+  return strcmp(*(const char**)a,*(const char**)b);
+}
+
+//corpus names as tags, qualified ones as members of their classes
+static void WriteCorpusTags(const char* filename)
+{
+  Vector<char*> lines;
+  char buf[512];
+  const int rows=sizeof(corpus)/sizeof(corpus[0]);
+  for(int r=0;r<rows;r++)
+  {
+    for(int i=1;corpus[r][i];i++)
+    {
+      const char *name=corpus[r][i],*sep=strstr(name,"::");
+      if(sep)
+      {
+        sprintf(buf,"%s\tsrc\\corpus.cpp\t%d;\"\tf\tline:%d\tclass:%.*s\n",
+                sep+2,r*10+i,r*10+i,(int)(sep-name),name);
+      }else
+      {
+        sprintf(buf,"%s\tsrc\\corpus.cpp\t%d;\"\tf\tline:%d\n",name,r*10+i,r*10+i);
+      }
+      lines.Push(strdup(buf));
+    }
+  }
+  //member whose class does not match
+  lines.Push(strdup("CreateIndex\tsrc\\corpus.cpp\t1;\"\tf\tline:1\tclass:Tags\n"));
+  qsort(&lines[0],lines.Count(),sizeof(char*),LineCmp);
+  FILE* f=fopen(filename,"wb");
+  GenHeader(f);
+  for(int i=0;i<lines.Count();i++)
+  {
+    fputs(lines[i],f);
+    free(lines[i]);
+  }
+  fclose(f);
+}
+
+static void TestCorpusSearch()
+{
+  const int rows=sizeof(corpus)/sizeof(corpus[0]);
+  for(int r=0;r<rows;r++)
+  {
+    const char *pat=corpus[r][0];
+    PTagArray ta=FindFuzzy("",pat,100);
+    int next=1;
+    for(int i=0;ta && i<ta->Count();i++)
+    {
+      TagInfo *ti=(*ta)[i];
+      //names of other rows may be between
+      String name=ti->name;
+      const char *cls=strstr(ti->info,"class:");
+      if(cls)
+      {
+        name=cls+6;
+        name+="::";
+        name+=ti->name;
+      }
+      if(corpus[r][next] && name==corpus[r][next])next++;
+    }
+    if(corpus[r][next])Fail("FindFuzzy",corpus[r][next]);
+    FreeTags(ta);
+  }
+  PTagArray ta=FindFuzzy("","tfiCrIdx",1);
+  if(!ta || (*ta)[0]->name!="CreateIdx" || !strstr((*ta)[0]->info,"class:TagFileInfo"))
+  {
+    Fail("FindFuzzy","tfiCrIdx");
+  }
+  FreeTags(ta);
+}
+
+//String == does not take null and empty strings for equal
+static bool Eq(const String& a,const String& b)
+{
+  return a.Length()==b.Length() && (a.Length()==0 || !memcmp((const char*)a,(const char*)b,a.Length()));
+}
+
+struct RefLine{
+  int file;
+  int line;
+  char* text;
+};
+
+static Vector<RefLine> refLines;
+//index of first line of each file in refLines
+static Vector<int> fileStart;
+
+static void ReadRefLines()
+{
+  for(int f=0;f<files.Count();f++)
+  {
+    fileStart.Push(refLines.Count());
+    MappedFile tf;
+    tf.Open(files[f]->filename);
+    for(int i=0;i<files[f]->Count();i++)
+    {
+      RefLine rl;
+      rl.file=f;
+      rl.line=i;
+      rl.text=strdup(ReadLine(tf,files[f]->Name(i)));
+      refLines.Push(rl);
+    }
+  }
+}
+
+static bool HasChar(const char* s,int len,char c)
+{
+  for(int i=0;i<len;i++)
+  {
+    if(tolower(s[i])==tolower(c))return true;
+  }
+  return false;
+}
+
+/*
+  Every line scored: name, or class::name if name does not match,
+  pattern does not fit into class alone and name has its last char.
+*/
+static void BruteFuzzy(const char* pat,int maxcount,Vector<FuzzyHit>& hits)
+{
+  int patlen=strlen(pat);
+  char qname[1024];
+  for(int i=0;i<refLines.Count();i++)
+  {
+    const char *line=refLines[i].text;
+    int namelen=strchr(line,'\t')-line;
+    FuzzyHit hit;
+    hit.namelen=namelen;
+    hit.file=refLines[i].file;
+    hit.line=refLines[i].line;
+    hit.score=FuzzyScore(pat,patlen,line,namelen);
+    if(hit.score<0)
+    {
+      const char *cls=GetClass(line);
+      int clslen=strcspn(cls,"\t\r\n");
+      if(clslen==0 || IsSubseq(pat,patlen,cls,clslen))continue;
+      if(!HasChar(line,namelen,pat[patlen-1]))continue;
+      if(clslen+2+namelen>512)continue;
+      sprintf(qname,"%.*s::%.*s",clslen,cls,namelen,line);
+      hit.score=FuzzyScore(pat,patlen,qname,strlen(qname));
+      if(hit.score<0)continue;
+    }
+    hits.Push(hit);
+  }
+  if(hits.Count())qsort(&hits[0],hits.Count(),sizeof(FuzzyHit),FuzzyHitCmp);
+  if(hits.Count()>maxcount)hits.Delete(maxcount,-1);
+}
+
+static void RandomPattern(char* pat)
+{
+  const RefLine& rl=refLines[(GenRand()<<15|GenRand())%refLines.Count()];
+  char src[1024];
+  int namelen=strchr(rl.text,'\t')-rl.text;
+  const char *cls=GetClass(rl.text);
+  int clslen=strcspn(cls,"\t\r\n");
+  if(clslen && GenRand()%3==0)
+  {
+    //spans class and name, with or without ::
+    sprintf(src,"%.*s%s%.*s",clslen,cls,GenRand()%2?"::":"",namelen,rl.text);
+  }else
+  {
+    sprintf(src,"%.*s",namelen,rl.text);
+  }
+  int srclen=strlen(src),len=0;
+  int want=1+GenRand()%6;
+  for(int i=0;i<srclen && len<want;i++)
+  {
+    if(GenRand()%(srclen-i)>=want-len)continue;
+    pat[len]=src[i];
+    if(GenRand()%4==0)pat[len]=isupper(src[i])?tolower(src[i]):toupper(src[i]);
+    len++;
+  }
+  pat[len]=0;
+  //patterns that hardly match anything
+  if(GenRand()%10==0 && len>0)pat[0]='q';
+}
+
+static void TestExact(int queries)
+{
+  const int counts[]={1,10,50,200};
+  int found=0;
+  for(int q=0;q<queries;q++)
+  {
+    char pat[64];
+    RandomPattern(pat);
+    if(!pat[0])continue;
+    int maxcount=counts[GenRand()%4];
+    Vector<FuzzyHit> exp;
+    BruteFuzzy(pat,maxcount,exp);
+    PTagArray ta=FindFuzzy("",pat,maxcount);
+    int count=ta?ta->Count():0;
+    bool ok=count==exp.Count();
+    for(int i=0;ok && i<count;i++)
+    {
+      TagInfo *ti=(*ta)[i];
+      const RefLine& rl=refLines[fileStart[exp[i].file]+exp[i].line];
+      TagInfo *ei=ParseLine(rl.text,GetBase(files[rl.file]));
+      ok=ei && Eq(ei->name,ti->name) && Eq(ei->file,ti->file) && ei->lineno==ti->lineno && Eq(ei->re,ti->re);
+      delete ei;
+    }
+    if(count)found++;
+    if(!ok)
+    {
+      printf("FAIL FindFuzzy %s/%d: %d tags, expected %d\n",pat,maxcount,count,exp.Count());
+      failed++;
+    }
+    FreeTags(ta);
+  }
+  printf("fuzzytest: %d queries, %d with tags\n",queries,found);
+}
+
+int main()
+{
+  RegExp::InitLocale();
+  for(int c=0;c<256;c++)
+  {
+    lowerTable[c]=tolower(c);
+  }
+  char dir[64];
+  sprintf(dir,"/tmp/fuzzytest.%d",(int)getpid());
+  mkdir(dir,0755);
+  String corpusFile=dir;
+  corpusFile+="/corpus";
+  String bigFile=dir;
+  bigFile+="/tags";
+  String smallFile=dir;
+  smallFile+="/tags2";
+
+  TestRanking();
+
+  WriteCorpusTags(corpusFile);
+  if(Load(corpusFile,"")!=0)Fail("Load",corpusFile);
+  TestCorpusSearch();
+  UnloadTags(-1);
+
+  //more names than one job scores, so that chunks and sample are used
+  GenTagsFile(bigFile,80000,300,60,1);
+  GenTagsFile(smallFile,3000,50,20,2);
+  if(Load(bigFile,"")!=0)Fail("Load",bigFile);
+  if(Load(smallFile,"")!=0)Fail("Load",smallFile);
+  ReadRefLines();
+  genSeed=7;
+  TestExact(300);
+  UnloadTags(-1);
+
+  remove(corpusFile);
+  remove(corpusFile+".idx");
+  remove(bigFile);
+  remove(bigFile+".idx");
+  remove(smallFile);
+  remove(smallFile+".idx");
+  rmdir(dir);
+  printf("fuzzytest: %d failed\n",failed);
+  return failed?1:0;
+}
@@ -0,0 +1,59 @@
+/*
+  Copyright (C) 2000 Konstantin Stupnik
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+  FindParts as it was before tags files were searched concurrently:
+  results of all files are concatenated, sorted and deduplicated.
+  Reference for tests and benchmarks of the k-way merge.
+*/
+
+#ifndef __OLDPARTS_H__
+#define __OLDPARTS_H__
+
+static void OldFindParts(const char* file, const char* part,StrList& dst)
+{
+  String filename=file;
+  filename.ToLower();
+  dst.Clean();
+  StrList tmp;
+  int i;
+  for(i=0;i<files.Count();i++)
+  {
+    if(files[i]->mainaload ||
+       files[i]->isLoadBase(filename))
+    {
+      FindPartsInFile(files[i],part,tmp);
+    }
+  }
+  if(tmp.Count()==0)return;
+  tmp.Sort(dst);
+  i=1;
+  String *s=&dst[0];
+  while(i<dst.Count())
+  {
+    if(dst[i]==*s)
+    {
+      dst.Delete();
+    }else
+    {
+      s=&dst[i];
+      i++;
+      if(i==dst.Count())break;
+    }
+  }
+}
+
+#endif
@@ -0,0 +1,113 @@
+/*
+  Copyright (C) 2000 Konstantin Stupnik
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+  Test of FindParts. Several tags files with overlapping names are
+  loaded, and results of k-way merge of per file results must be
+  the same as of the old sort and deduplication of all of them.
+*/
+
+#include <windows.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "tags.cpp"
+#include "tagsgen.h"
+#include "oldparts.h"
+
+Config config;
+
+int isident(int c)
+{
+  return isalnum(c) || c=='_';
+}
+
+static const int tagFiles=7;
+static const int queries=500;
+
+static bool Same(StrList& a,StrList& b)
+{
+  if(a.Count()!=b.Count())return false;
+  for(int i=0;i<a.Count();i++)
+  {
+    if(a[i]!=b[i])return false;
+  }
+  return true;
+}
+
+int main()
+{
+  RegExp::InitLocale();
+  char dir[64];
+  sprintf(dir,"/tmp/partstest.%d",(int)getpid());
+  mkdir(dir,0755);
+  //files of different sizes, names of smaller ones are prefixes of names of bigger ones
+  Vector<char*> names;
+  for(int i=0;i<tagFiles;i++)
+  {
+    char fn[128];
+    sprintf(fn,"%s/tags%d",dir,i);
+    GenTagsFile(fn,500+i*3000,100,30,1+i%3);
+    if(Load(fn,"")!=0)
+    {
+      printf("FAIL: can't load %s\n",fn);
+      return 1;
+    }
+    FILE* f=fopen(fn,"rb");
+    char buf[1024];
+    while(fgets(buf,sizeof(buf),f))
+    {
+      if(buf[0]=='!')continue;
+      *strchr(buf,'\t')=0;
+      names.Push(strdup(buf));
+    }
+    fclose(f);
+  }
+  genSeed=99;
+  int failed=0,found=0;
+  for(int q=0;q<queries;q++)
+  {
+    char part[64];
+    const char* name=names[(GenRand()<<15|GenRand())%names.Count()];
+    //short prefixes match most of names, they are slow and few
+    int len=q%25==0?GenRand()%4:4+GenRand()%6;
+    if(len>(int)strlen(name))len=strlen(name);
+    memcpy(part,name,len);
+    part[len]=0;
+    //prefixes that are not in any file
+    if(q%10==0 && len>0)part[len-1]='z'+1;
+    StrList got,exp;
+    FindParts("",part,got);
+    OldFindParts("",part,exp);
+    if(got.Count())found++;
+    if(!Same(got,exp))
+    {
+      printf("FAIL %s: %d names, expected %d\n",part,got.Count(),exp.Count());
+      failed++;
+    }
+  }
+  UnloadTags(-1);
+  for(int i=0;i<tagFiles;i++)
+  {
+    char fn[128];
+    sprintf(fn,"%s/tags%d",dir,i);
+    remove(fn);
+    strcat(fn,".idx");
+    remove(fn);
+  }
+  rmdir(dir);
+  printf("partstest: %d queries, %d with names, %d failed\n",queries,found,failed);
+  return failed?1:0;
+}
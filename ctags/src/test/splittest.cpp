@@ -0,0 +1,207 @@
+/*
+  Copyright (C) 2000 Konstantin Stupnik
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+  Differential test of ParseLine against the regular expression
+  it replaced. Lines are built from tags file fields and then mutated:
+  escaped slashes, numeric addresses, missing or long kinds, extra
+  tabs and fields. Both parsers must agree on every line.
+*/
+
+#include <windows.h>
+#include "tags.cpp"
+#include "tagsgen.h"
+
+Config config;
+
+int isident(int c)
+{
+  return isalnum(c) || c=='_';
+}
+
+//parser before SplitLine, as it was
+RegExp reParse("/(.+?)\\t(.*?)\\t(\\d+|\\/.*?\\/(?<=[^\\\\]\\/));\"\\t(\\w)(?:\\tline:(\\d+))?(?:\\t(\\S*))?/");
+
+static void SetStr(String& s,const char* buf,SMatch& m)
+{
+  s.Set(buf,m.start,m.end-m.start);
+}
+
+TagInfo* OldParseLine(const char* buf,const String& base)
+{
+  String pos;
+  String file;
+  SMatch m[10];
+  int n=10;
+  if(reParse.Match(buf,m,n))
+  {
+    TagInfo *i=new TagInfo;
+    SetStr(i->name,buf,m[1]);
+    SetStr(file,buf,m[2]);
+    if(file[1]!=':' && file[0]!='\\')
+    {
+      file.Insert(0,base);
+    }
+    i->file=file;
+    SetStr(pos,buf,m[3]);
+    if(pos[0]=='/')
+    {
+      QuoteMeta(pos);
+      ReplaceSpaces(pos);
+      i->re=pos;
+      if(m[5].start!=-1)
+      {
+        SetStr(pos,buf,m[5]);
+        i->lineno=pos.ToInt();
+      }
+    }else
+    {
+      i->lineno=pos.ToInt();
+    }
+    SetStr(pos,buf,m[4]);
+    i->type=pos[0];
+    if(m[5].start!=-1)
+    {
+      SetStr(i->info,buf,m[6]);
+    }
+    return i;
+  }
+  return NULL;
+}
+
+static const char* Pick(const char** a,int n)
+{
+  return a[GenRand()%n];
+}
+
+#define PICK(a) Pick(a,sizeof(a)/sizeof(a[0]))
+
+static const char* names[]={"main","a","Foo::bar","operator<","x y","_1",":","n\\t"};
+static const char* fileNames[]={"src\\a.cpp","c:\\src\\b.h","\\abs.c","a b.c","","x\ty.c","f:"};
+static const char* patterns[]={"/^int main()$/","/^foo\\/bar$/","/^a\\\\/","/^x\\/$/","//","/a/b/",
+                               "/^  if (a) $/","/^\\/\\/ c$/","/^q;\"\t/","/^/"};
+static const char* numbers[]={"1","42","007","12a","","99999"};
+static const char* kinds[]={"f","v","_","9","kind:f","kind:","fv","","-","line:3"};
+static const char* fields[]={"line:12","line:","line:x","class:Foo","struct:S","signature:(int a)",
+                             "kind:c","f","","a b","access:public","line:3\tclass:C"};
+static const char* ends[]={"\n","\r\n","","\t\n"," \n"};
+
+static void BuildLine(char* buf)
+{
+  buf[0]=0;
+  strcat(buf,PICK(names));
+  strcat(buf,"\t");
+  strcat(buf,PICK(fileNames));
+  strcat(buf,"\t");
+  strcat(buf,GenRand()%2?PICK(patterns):PICK(numbers));
+  strcat(buf,";\"\t");
+  strcat(buf,PICK(kinds));
+  int nf=GenRand()%4;
+  for(int i=0;i<nf;i++)
+  {
+    strcat(buf,"\t");
+    strcat(buf,PICK(fields));
+  }
+  strcat(buf,PICK(ends));
+}
+
+//random edits with characters that matter to both parsers
+static void Mutate(char* buf)
+{
+  static const char special[]="\t/\;\":1a_ \n";
+  int n=GenRand()%3;
+  for(int i=0;i<n;i++)
+  {
+    int len=strlen(buf);
+    int pos=len?GenRand()%len:0;
+    switch(GenRand()%3)
+    {
+      case 0:if(len)buf[pos]=special[GenRand()%(sizeof(special)-1)];break;
+      case 1:if(len)memmove(buf+pos,buf+pos+1,len-pos);break;
+      default:
+        memmove(buf+pos+1,buf+pos,len-pos+1);
+        buf[pos]=special[GenRand()%(sizeof(special)-1)];
+        break;
+    }
+  }
+}
+
+static String Show(const char* s)
+{
+  String res;
+  for(;*s;s++)
+  {
+    if(*s=='\t')res+="\\t";
+    else if(*s=='\n')res+="\\n";
+    else if(*s=='\r')res+="\\r";
+    else res+=*s;
+  }
+  return res;
+}
+
+static String Describe(TagInfo* ti)
+{
+  if(!ti)return "NULL";
+  char num[32];
+  sprintf(num,"%d",ti->lineno);
+  String res="name="+ti->name+" file="+ti->file+" re="+ti->re+" line="+num+" kind=";
+  res+=ti->type;
+  res+=" info="+ti->info;
+  return res;
+}
+
+//empty strings may be NULL or not, == tells them apart
+static bool Eq(const String& a,const String& b)
+{
+  return a.Length()==b.Length() && (a.Length()==0 || !memcmp((const char*)a,(const char*)b,a.Length()));
+}
+
+static bool Same(TagInfo* a,TagInfo* b)
+{
+  if(!a || !b)return a==b;
+  return Eq(a->name,b->name) && Eq(a->file,b->file) && Eq(a->re,b->re) &&
+         a->lineno==b->lineno && a->type==b->type && Eq(a->info,b->info);
+}
+
+int main()
+{
+  RegExp::InitLocale();
+  const int count=300000;
+  int failed=0,parsed=0;
+  String base="c:\\base\\";
+  genSeed=5;
+  for(int i=0;i<count;i++)
+  {
+    char buf[1024];
+    BuildLine(buf);
+    if(i%2)Mutate(buf);
+    TagInfo* a=ParseLine(buf,base);
+    TagInfo* b=OldParseLine(buf,base);
+    if(b)parsed++;
+    if(!Same(a,b))
+    {
+      if(failed<20)
+      {
+        printf("FAIL %s\n  got      %s\n  expected %s\n",Show(buf).Str(),Show(Describe(a)).Str(),Show(Describe(b)).Str());
+      }
+      failed++;
+    }
+    delete a;
+    delete b;
+  }
+  printf("splittest: %d lines, %d parsed, %d failed\n",count,parsed,failed);
+  return failed?1:0;
+}
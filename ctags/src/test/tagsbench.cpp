@@ -0,0 +1,351 @@
+/*
+  Copyright (C) 2000 Konstantin Stupnik
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+  Benchmarks of tags engine on generated tags files.
+  Usage: tagsbench lookup [megabytes] [queries]
+         tagsbench merge [megabytes] [update megabytes] [rss ceiling megabytes]
+         tagsbench parts [megabytes per file] [max files] [queries]
+         tagsbench fuzzy [tags] [top] [milliseconds limit]
+*/
+
+#include <windows.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+#include "tags.cpp"
+#include "tagsgen.h"
+#include "oldparts.h"
+
+Config config;
+
+int isident(int c)
+{
+  return isalnum(c) || c=='_';
+}
+
+static double Now()
+{
+  timespec ts;
+  clock_gettime(CLOCK_MONOTONIC,&ts);
+  return ts.tv_sec+ts.tv_nsec/1e9;
+}
+
+//resident and peak resident set size in megabytes
+static void PrintRss(const char* when)
+{
+  FILE* f=fopen("/proc/self/status","r");
+  if(!f)return;
+  char line[256];
+  long rss=0,hwm=0;
+  while(fgets(line,sizeof(line),f))
+  {
+    sscanf(line,"VmRSS: %ld",&rss);
+    sscanf(line,"VmHWM: %ld",&hwm);
+  }
+  fclose(f);
+  printf("%s: rss %ld MB, peak %ld MB\n",when,rss/1024,hwm/1024);
+}
+
+//forget peak resident set size, so that it is measured for one step only
+static void ResetPeakRss()
+{
+  FILE* f=fopen("/proc/self/clear_refs","w");
+  if(!f)return;
+  fputs("5",f);
+  fclose(f);
+}
+
+static long PeakRss()
+{
+  FILE* f=fopen("/proc/self/status","r");
+  if(!f)return 0;
+  char line[256];
+  long hwm=0;
+  while(fgets(line,sizeof(line),f))
+  {
+    sscanf(line,"VmHWM: %ld",&hwm);
+  }
+  fclose(f);
+  return hwm/1024;
+}
+
+static long long FileSize(const char* fn)
+{
+  struct stat st;
+  return stat(fn,&st)==0?st.st_size:0;
+}
+
+static int DblCmp(const void* a,const void* b)
+{
+  double x=*(const double*)a,y=*(const double*)b;
+  return x<y?-1:x>y?1:0;
+}
+
+static void PrintLatency(const char* what,double* t,int n)
+{
+  qsort(t,n,sizeof(double),DblCmp);
+  printf("%s: %d queries, p50 %.1f us, p99 %.1f us, max %.1f us\n",
+         what,n,t[n/2]*1e6,t[n*99/100]*1e6,t[n-1]*1e6);
+}
+
+static String dir;
+
+//generated tags file of about mb megabytes, reused if it is already there
+static String MakeTags(const char* name,long long mb,int files,int classes,unsigned seed)
+{
+  String fn=dir;
+  fn+="/";
+  fn+=name;
+  struct stat st;
+  if(stat(fn,&st)==0 && st.st_size>=mb*1024*1024*9/10)return fn;
+  double t=Now();
+  //generator writes about 150 bytes per tag
+  int lines=GenTagsFile(fn,(int)(mb*1024*1024/150),files,classes,seed);
+  stat(fn,&st);
+  printf("generated %s: %d lines, %lld MB in %.1f s\n",name,lines,(long long)st.st_size/(1024*1024),Now()-t);
+  remove(fn+".idx");
+  return fn;
+}
+
+//names at random places of tags file
+static void PickNames(const char* fn,int n,Vector<char*>& names)
+{
+  FILE* f=fopen(fn,"rb");
+  struct stat st;
+  stat(fn,&st);
+  char buf[1024];
+  genSeed=12345;
+  while(names.Count()<n)
+  {
+    long long off=((long long)GenRand()<<30|(long long)GenRand()<<15|GenRand())%st.st_size;
+    fseeko(f,off,SEEK_SET);
+    if(!fgets(buf,sizeof(buf),f) || !fgets(buf,sizeof(buf),f) || buf[0]=='!')continue;
+    *strchr(buf,'\t')=0;
+    names.Push(strdup(buf));
+  }
+  fclose(f);
+}
+
+static int Lookup(long long mb,int queries)
+{
+  String fn=MakeTags("lookup",mb,5000,2000,1);
+  double t=Now();
+  if(Load(fn,"")<0)
+  {
+    printf("failed to load %s\n",fn.Str());
+    return 1;
+  }
+  printf("loaded %d tags in %.1f s\n",Count(),Now()-t);
+  PrintRss("after load");
+
+  Vector<char*> names;
+  PickNames(fn,queries,names);
+  double* lat=new double[queries];
+  int found=0;
+  for(int i=0;i<queries;i++)
+  {
+    t=Now();
+    PTagArray ta=Find(names[i],"");
+    lat[i]=Now()-t;
+    if(ta)
+    {
+      found++;
+      for(int j=0;j<ta->Count();j++)delete (*ta)[j];
+      delete ta;
+    }
+  }
+  PrintLatency("Find",lat,queries);
+  printf("found %d of %d\n",found,queries);
+  PrintRss("after lookups");
+  delete [] lat;
+  UnloadTags(-1);
+  return found==queries?0:1;
+}
+
+/*
+  Merge of update tags file into big tags file, as after ctags run on
+  changed sources. Update touches tenth of source files, its lines are
+  spread over the whole target. Target is generated again for every run,
+  since merge replaces it.
+*/
+static int Merge(long long mb,long long updmb,long ceiling)
+{
+  String target=dir;
+  target+="/merge";
+  remove(target);
+  double t=Now();
+  int lines=GenTagsFile(target,(int)(mb*1024*1024/150),5000,2000,1);
+  String upd=MakeTags("merge.update",updmb,500,200,2);
+  printf("target %d lines, %lld MB, update %lld MB, generated in %.1f s\n",
+         lines,FileSize(target)/(1024*1024),FileSize(upd)/(1024*1024),Now()-t);
+
+  StrList mfiles,changed;
+  mfiles<<upd;
+  Vector<char*> generated;
+  IndexDelta delta;
+  long long insize=FileSize(target)+FileSize(upd);
+  ResetPeakRss();
+  long before=PeakRss();
+  t=Now();
+  int rc=MergeFiles(target,mfiles,generated,changed,delta);
+  t=Now()-t;
+  long peak=PeakRss();
+  if(!rc)
+  {
+    printf("merge failed\n");
+    return 1;
+  }
+  printf("MergeFiles: %.1f s, %.1f MB/s, %d kept runs, %d added runs, result %lld MB\n",
+         t,insize/(1024.0*1024)/t,delta.kept.Count(),delta.added.Count(),FileSize(target)/(1024*1024));
+  printf("peak rss: %ld MB before merge, %ld MB during merge, ceiling %ld MB\n",before,peak,ceiling);
+  remove(target);
+  return peak<=ceiling?0:1;
+}
+
+/*
+  FindParts latency against number of loaded tags files, for k-way
+  merge of per file results and for the old sort of all of them.
+  Files are generated with different seeds, so names overlap.
+*/
+static int Parts(long long mb,int maxfiles,int queries)
+{
+  Vector<char*> names;
+  int nfiles;
+  for(nfiles=1;nfiles<=maxfiles;nfiles*=2)
+  {
+    for(int i=files.Count();i<nfiles;i++)
+    {
+      char name[32];
+      sprintf(name,"parts%d",i);
+      String fn=MakeTags(name,mb,5000,2000,1+i);
+      if(Load(fn,"")<0)
+      {
+        printf("failed to load %s\n",fn.Str());
+        return 1;
+      }
+      if(i==0)PickNames(fn,queries,names);
+    }
+    double* lat=new double[queries];
+    double* oldlat=new double[queries];
+    long long total=0;
+    for(int i=0;i<queries;i++)
+    {
+      //prefixes of 4 to 7 chars match from tens to thousands names
+      char part[16];
+      int len=4+i%4;
+      memcpy(part,names[i],len);
+      part[len]=0;
+      StrList res;
+      double t=Now();
+      FindParts("",part,res);
+      lat[i]=Now()-t;
+      total+=res.Count();
+      t=Now();
+      OldFindParts("",part,res);
+      oldlat[i]=Now()-t;
+    }
+    printf("%d files, %lld names per query\n",nfiles,total/queries);
+    PrintLatency("  FindParts",lat,queries);
+    PrintLatency("  sort and dedup",oldlat,queries);
+    delete [] lat;
+    delete [] oldlat;
+  }
+  UnloadTags(-1);
+  return 0;
+}
+
+/*
+  FindFuzzy over one tags file with given number of tag lines.
+  First query also reads names of all tags, p99 of the rest must fit limit.
+*/
+static int Fuzzy(int count,int top,double limit)
+{
+  char name[32];
+  sprintf(name,"fuzzy%d",count);
+  String fn=dir;
+  fn+="/";
+  fn+=name;
+  struct stat st;
+  if(stat(fn,&st)!=0)
+  {
+    //generator writes two lines per tag on average
+    GenTagsFile(fn,count/2,5000,2000,3);
+    remove(fn+".idx");
+  }
+  double t=Now();
+  if(Load(fn,"")<0)
+  {
+    printf("failed to load %s\n",fn.Str());
+    return 1;
+  }
+  printf("loaded %d tags in %.1f s\n",Count(),Now()-t);
+  const char* pats[]={"gsn","GetSet","fileidx","ParseBuf","lcr","Class7::Find","aabz","NameCount","x_y","tree"};
+  const int npats=sizeof(pats)/sizeof(pats[0]);
+  const int rounds=20;
+  double lat[npats*rounds];
+  int n=0;
+  for(int r=0;r<=rounds;r++)
+  {
+    for(int i=0;i<npats;i++)
+    {
+      t=Now();
+      PTagArray ta=FindFuzzy("",pats[i],top);
+      t=Now()-t;
+      if(r==0)printf("  %-14s %3d tags, first %s, %.1f ms\n",pats[i],ta?ta->Count():0,
+                     ta?(*ta)[0]->name.Str():"-",t*1000);
+      else lat[n++]=t;
+      if(ta)
+      {
+        for(int j=0;j<ta->Count();j++)delete (*ta)[j];
+        delete ta;
+      }
+    }
+  }
+  PrintLatency("FindFuzzy",lat,n);
+  PrintRss("after search");
+  UnloadTags(-1);
+  return lat[n*99/100]*1000<=limit?0:1;
+}
+
+int main(int argc,char* argv[])
+{
+  RegExp::InitLocale();
+  if(argc<2)
+  {
+    printf("usage: tagsbench lookup [megabytes] [queries]\n");
+    printf("       tagsbench merge [megabytes] [update megabytes] [rss ceiling megabytes]\n");
+    printf("       tagsbench parts [megabytes per file] [max files] [queries]\n");
+    printf("       tagsbench fuzzy [tags] [top] [milliseconds limit]\n");
+    return 1;
+  }
+  const char* tmp=getenv("TAGSBENCH_DIR");
+  dir=tmp?tmp:"/tmp/tagsbench";
+  mkdir(dir,0755);
+  //merge writes temporary file to current directory
+  if(chdir(dir)!=0)return 1;
+  const char* mode=argv[1];
+  if(!strcmp(mode,"lookup"))
+    return Lookup(argc>2?atoll(argv[2]):2048,argc>3?atoi(argv[3]):100000);
+  if(!strcmp(mode,"merge"))
+    return Merge(argc>2?atoll(argv[2]):2048,argc>3?atoll(argv[3]):256,argc>4?atol(argv[4]):64);
+  if(!strcmp(mode,"parts"))
+    return Parts(argc>2?atoll(argv[2]):32,argc>3?atoi(argv[3]):32,argc>4?atoi(argv[4]):1000);
+  if(!strcmp(mode,"fuzzy"))
+    return Fuzzy(argc>2?atoi(argv[2]):5000000,argc>3?atoi(argv[3]):50,argc>4?atof(argv[4]):50);
+  printf("unknown mode %s\n",mode);
+  return 1;
+}
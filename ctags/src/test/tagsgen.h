@@ -0,0 +1,132 @@
+/*
+  Copyright (C) 2000 Konstantin Stupnik
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+  Generator of sorted tags files in extended format for tests
+  and benchmarks. Output depends on the seed only, names grow
+  with the tag number, so lines come out sorted without sorting.
+*/
+
+#ifndef __TAGSGEN_H__
+#define __TAGSGEN_H__
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static unsigned genSeed=1;
+
+static unsigned GenRand()
+{
+  genSeed=genSeed*1103515245+12345;
+  return (genSeed>>16)&0x7fff;
+}
+
+static const char* genKinds="fvcmpdst";
+static const char* genWords[]={"Get","Set","Load","Save","Find","Parse","Buffer","Index","Name","Count",
+                               "Item","List","Tree","Node","File","Line","Open","Close","Read","Write"};
+
+//name of tag number i, names of bigger numbers compare greater
+static void GenName(int i,char* buf)
+{
+  char prefix[8];
+  for(int j=5;j>=0;j--)
+  {
+    prefix[j]='a'+i%26;
+    i/=26;
+  }
+  prefix[6]=0;
+  const char* w1=genWords[GenRand()%20];
+  const char* w2=genWords[GenRand()%20];
+  switch(GenRand()%3)
+  {
+    case 0:sprintf(buf,"%s%s%s",prefix,w1,w2);break;
+    case 1:sprintf(buf,"%s_%s_%s",prefix,w1,w2);break;
+    default:sprintf(buf,"%s",prefix);break;
+  }
+}
+
+static void GenFile(int n,char* buf)
+{
+  sprintf(buf,"src\\mod%02d\\file%03d.cpp",n/1000%100,n%1000);
+}
+
+static void GenClass(int n,char* buf)
+{
+  sprintf(buf,"Class%s%d",genWords[n%20],n%500);
+}
+
+static void GenHeader(FILE* f)
+{
+  fputs("!_TAG_FILE_FORMAT\t2\t/extended format; --format=1 will not append ;\" to lines/\n",f);
+  fputs("!_TAG_FILE_SORTED\t1\t/0=unsorted, 1=sorted, 2=foldcase/\n",f);
+  fputs("!_TAG_PROGRAM_NAME\tExuberant Ctags\t//\n",f);
+}
+
+/*
+  One to three lines for tag number i, sorted among themselves.
+  files is number of distinct source files (at least 15), classes of classes.
+  Returns number of lines written.
+*/
+static int GenTag(FILE* f,int i,int files,int classes)
+{
+  char name[64];
+  GenName(i,name);
+  int n=1+GenRand()%3;
+  int step=1+GenRand()%7;
+  int first=GenRand()%(files-2*step);
+  for(int k=0;k<n;k++)
+  {
+    char file[64];
+    GenFile(first+k*step,file);
+    char kind=genKinds[GenRand()%8];
+    int line=1+GenRand()%3000;
+    switch(GenRand()%4)
+    {
+      case 0:
+        fprintf(f,"%s\t%s\t%d;\"\t%c\n",name,file,line,kind);
+        break;
+      case 1:
+        fprintf(f,"%s\t%s\t/^int %s(int x)$/;\"\t%c\tline:%d\n",name,file,name,kind,line);
+        break;
+      default:
+      {
+        char cls[64];
+        GenClass(GenRand()%classes,cls);
+        fprintf(f,"%s\t%s\t/^  void %s::%s() const$/;\"\t%c\tclass:%s\n",name,file,cls,name,kind,cls);
+        break;
+      }
+    }
+  }
+  return n;
+}
+
+//tags file with count tags, returns number of tag lines
+static int GenTagsFile(const char* filename,int count,int files,int classes,unsigned seed)
+{
+  FILE* f=fopen(filename,"wb");
+  if(!f)return -1;
+  static char buf[1<<20];
+  setvbuf(f,buf,_IOFBF,sizeof(buf));
+  genSeed=seed;
+  GenHeader(f);
+  int lines=0;
+  for(int i=0;i<count;i++)lines+=GenTag(f,i,files,classes);
+  fclose(f);
+  return lines;
+}
+
+#endif
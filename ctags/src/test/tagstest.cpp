@@ -0,0 +1,251 @@
+/*
+  Copyright (C) 2000 Konstantin Stupnik
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+  Tests of tags engine. A generated tags file is loaded and
+  results of every kind of lookup are compared with brute force
+  search over its lines. Built twice: with default mapping windows
+  and with the smallest ones, so lines cross window borders.
+*/
+
+#include <windows.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "tags.cpp"
+#include "tagsgen.h"
+
+Config config;
+
+int isident(int c)
+{
+  return isalnum(c) || c=='_';
+}
+
+static int failed;
+
+static void Fail(const char* what,const char* arg)
+{
+  printf("FAIL %s: %s\n",what,arg);
+  failed++;
+}
+
+static char dir[64];
+static String tagsFile;
+static Vector<char*> tagLines;
+static Vector<char*> tagNames;
+static String base;
+
+static void ReadTagLines(const char* filename)
+{
+  FILE* f=fopen(filename,"rb");
+  char buf[1024];
+  while(fgets(buf,sizeof(buf),f))
+  {
+    if(buf[0]=='!')continue;
+    tagLines.Push(strdup(buf));
+    tagNames.Push(strdup(buf));
+    *strchr(tagNames[tagNames.Count()-1],'\t')=0;
+  }
+  fclose(f);
+}
+
+static String Field(const char* line,int n)
+{
+  String res;
+  for(;n>0 && line;n--)
+  {
+    line=strchr(line,'\t');
+    if(line)line++;
+  }
+  if(!line)return res;
+  const char* end=line+strcspn(line,"\t\r\n");
+  res.Set(line,0,end-line);
+  return res;
+}
+
+static String Key(TagInfo* ti)
+{
+  char num[16];
+  sprintf(num,"|%d|%c|",ti->lineno,ti->type);
+  return ti->file+num+ti->re+"|"+ti->info;
+}
+
+//keys of tags in ta and of expected lines must be the same, in order if sorted
+static void Compare(const char* what,const char* arg,PTagArray ta,Vector<char*>& expected,bool sorted)
+{
+  StrList got,exp,sgot,sexp;
+  int i;
+  if(ta)for(i=0;i<ta->Count();i++)got<<Key((*ta)[i]);
+  for(i=0;i<expected.Count();i++)
+  {
+    TagInfo* ti=ParseLine(expected[i],base);
+    if(ti)exp<<Key(ti);
+    delete ti;
+  }
+  if(!sorted)
+  {
+    got.Sort(sgot);
+    exp.Sort(sexp);
+  }
+  StrList& g=sorted?got:sgot;
+  StrList& e=sorted?exp:sexp;
+  if(g.Count()!=e.Count())
+  {
+    char msg[256];
+    sprintf(msg,"%s: %d tags, expected %d",arg,g.Count(),e.Count());
+    Fail(what,msg);
+    return;
+  }
+  for(i=0;i<g.Count();i++)
+  {
+    if(g[i]!=e[i])
+    {
+      Fail(what,arg);
+      return;
+    }
+  }
+}
+
+static void FreeTags(PTagArray ta)
+{
+  if(!ta)return;
+  for(int i=0;i<ta->Count();i++)delete (*ta)[i];
+  delete ta;
+}
+
+static void TestFind()
+{
+  for(int i=0;i<tagLines.Count();i+=7)
+  {
+    const char* name=tagNames[i];
+    Vector<char*> exp;
+    for(int j=0;j<tagLines.Count();j++)
+    {
+      if(!strcmp(tagNames[j],name))exp.Push(tagLines[j]);
+    }
+    PTagArray ta=Find(name,"");
+    Compare("Find",name,ta,exp,false);
+    FreeTags(ta);
+  }
+  const char* missing[]={"zzzzzz","aaaaa","","aaaaaa_","\x7f"};
+  for(unsigned i=0;i<sizeof(missing)/sizeof(missing[0]);i++)
+  {
+    PTagArray ta=Find(missing[i],"");
+    if(ta)Fail("Find missing",missing[i]);
+    FreeTags(ta);
+  }
+}
+
+static void TestFile()
+{
+  for(int n=0;n<200;n+=13)
+  {
+    char file[64];
+    GenFile(n,file);
+    Vector<char*> exp;
+    for(int j=0;j<tagLines.Count();j++)
+    {
+      if(!stricmp(Field(tagLines[j],1),file))exp.Push(tagLines[j]);
+    }
+    qsort(&exp[0],exp.Count(),sizeof(char*),StrCmp);
+    PTagArray ta=new TagArray;
+    FindFile(files[0],file,ta);
+    Compare("FindFile",file,ta,exp,true);
+    FreeTags(ta);
+  }
+}
+
+static void TestClass()
+{
+  for(int n=0;n<50;n+=3)
+  {
+    char cls[64];
+    GenClass(n,cls);
+    String field="class:";
+    field+=cls;
+    Vector<char*> exp;
+    for(int j=0;j<tagLines.Count();j++)
+    {
+      if(Field(tagLines[j],4)==field)exp.Push(tagLines[j]);
+    }
+    if(exp.Count())qsort(&exp[0],exp.Count(),sizeof(char*),StrCmp);
+    PTagArray ta=FindClassSymbols("",cls);
+    Compare("FindClassSymbols",cls,ta,exp,true);
+    FreeTags(ta);
+  }
+}
+
+static void TestParts()
+{
+  const char* parts[]={"a","aaab","aaac_","aab","b","zz",""};
+  for(unsigned k=0;k<sizeof(parts)/sizeof(parts[0]);k++)
+  {
+    StrList exp;
+    int len=strlen(parts[k]);
+    for(int j=0;j<tagLines.Count();j++)
+    {
+      if(strncmp(tagNames[j],parts[k],len))continue;
+      if(exp.Count()==0 || exp[exp.Count()-1]!=tagNames[j])exp<<tagNames[j];
+    }
+    StrList got;
+    FindParts("",parts[k],got);
+    bool ok=got.Count()==exp.Count();
+    for(int i=0;ok && i<got.Count();i++)ok=got[i]==exp[i];
+    if(!ok)Fail("FindParts",parts[k]);
+  }
+}
+
+static void TestFuzzy()
+{
+  PTagArray ta=FindFuzzy("","GetSet",10);
+  if(!ta || ta->Count()!=10)Fail("FindFuzzy","GetSet");
+  if(ta)for(int i=0;i<ta->Count();i++)
+  {
+    if(FuzzyScore("GetSet",6,(*ta)[i]->name,(*ta)[i]->name.Length())<0)Fail("FindFuzzy",(*ta)[i]->name);
+  }
+  FreeTags(ta);
+}
+
+int main()
+{
+  RegExp::InitLocale();
+  sprintf(dir,"/tmp/tagstest.%d",(int)getpid());
+  mkdir(dir,0755);
+  tagsFile=dir;
+  tagsFile+="/tags";
+  GenTagsFile(tagsFile,20000,200,50,1);
+  ReadTagLines(tagsFile);
+
+  if(Load(tagsFile,"")!=0 || Count()!=tagLines.Count())Fail("Load","index not created");
+  base=GetBase(files[0]);
+  TestFind();
+  TestFile();
+  TestClass();
+  TestParts();
+  TestFuzzy();
+
+  //index is reused by the next load
+  UnloadTags(-1);
+  if(Load(tagsFile,"")!=1 || Count()!=tagLines.Count())Fail("Load","index not reused");
+  TestFind();
+  UnloadTags(-1);
+
+  remove(tagsFile+".idx");
+  remove(tagsFile);
+  rmdir(dir);
+  printf("tagstest: %d failed\n",failed);
+  return failed?1:0;
+}
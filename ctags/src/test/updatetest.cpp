@@ -0,0 +1,218 @@
+/*
+  Copyright (C) 2000 Konstantin Stupnik
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+  Test of incremental index update. Sources of a generated project
+  are edited and deleted at random, tags are updated the way
+  UpdateTagsFile does it, and the updated index must be equal byte
+  for byte to the index created from scratch for the same tags file.
+*/
+
+#include <windows.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "tags.cpp"
+#include "tagsgen.h"
+
+Config config;
+
+int isident(int c)
+{
+  return isalnum(c) || c=='_';
+}
+
+static int failed;
+
+static const int srcCount=40;
+static const int rounds=60;
+static bool exists[srcCount];
+static time_t srcTime=1000000000;
+
+static void SrcName(int n,char* buf)
+{
+  GenFile(n,buf);
+}
+
+//C++ source with names shared between files, so that sections have equal keys
+static void WriteSource(int n)
+{
+  char fn[64];
+  SrcName(n,fn);
+  FILE* f=fopen(fn,"wb");
+  int count=2+GenRand()%10;
+  for(int i=0;i<count;i++)
+  {
+    const char* w1=genWords[GenRand()%20];
+    const char* w2=genWords[GenRand()%20];
+    switch(GenRand()%5)
+    {
+      case 0:fprintf(f,"#define %s_%s %d\n",w1,w2,i);break;
+      case 1:fprintf(f,"int %s%s(int x);\n",w1,w2);break;
+      case 2:fprintf(f,"int %s%s(int x){ return x; }\n",w1,w2);break;
+      case 3:
+        fprintf(f,"class %s{\npublic:\n  int %s;\n  void %s();\n};\n",w1,w2,w2);
+        fprintf(f,"void %s::%s(){ }\n",w1,w2);
+        break;
+      default:fprintf(f,"static int %s%s=%d;\n",w1,w2,i);break;
+    }
+  }
+  fclose(f);
+  utimbuf tm;
+  tm.actime=tm.modtime=++srcTime;
+  utime(fn,&tm);
+  exists[n]=true;
+}
+
+static void WriteTags(const char* filename,Vector<char*>& lines,bool dup)
+{
+  if(lines.Count())qsort(&lines[0],lines.Count(),sizeof(char*),StrCmp);
+  FILE* f=fopen(filename,"wb");
+  GenHeader(f);
+  for(int i=0;i<lines.Count();i++)
+  {
+    fputs(lines[i],f);
+    //same line twice, as ctags writes for repeated declarations
+    if(dup && i==lines.Count()/2)fputs(lines[i],f);
+  }
+  fclose(f);
+}
+
+static void FreeLines(Vector<char*>& lines)
+{
+  for(int i=0;i<lines.Count();i++)free(lines[i]);
+  lines.Clean();
+}
+
+static bool ReadFile(const char* filename,String& data)
+{
+  FILE* f=fopen(filename,"rb");
+  if(!f)return false;
+  char buf[4096];
+  int n;
+  data="";
+  while((n=fread(buf,1,sizeof(buf),f))>0)
+  {
+    String part;
+    part.Set(buf,0,n);
+    data+=part;
+  }
+  fclose(f);
+  return true;
+}
+
+static void Check(bool ok,const char* what,int round)
+{
+  if(ok)return;
+  printf("FAIL round %d: %s\n",round,what);
+  failed++;
+}
+
+static void Round(TagFileInfo* fi,int round)
+{
+  int edits=1+GenRand()%4;
+  for(int i=0;i<edits;i++)
+  {
+    int n=GenRand()%srcCount;
+    if(GenRand()%5==0 && exists[n])
+    {
+      char fn[64];
+      SrcName(n,fn);
+      remove(fn);
+      exists[n]=false;
+    }else
+    {
+      WriteSource(n);
+    }
+  }
+
+  StrList changed;
+  Check(CheckChangedFiles("tags",changed)==1,"CheckChangedFiles",round);
+  //half of changed files go through generated lines, the rest through update file
+  Vector<char*> generated,external;
+  for(int i=0;i<changed.Count();i++)
+  {
+    if(i%2==0)GenerateTags(changed[i],changed[i],generated);
+    else GenerateTags(changed[i],changed[i],external);
+  }
+  StrList mfiles;
+  if(round%3!=0)
+  {
+    WriteTags("tags.update",external,round%2==0);
+    mfiles<<"tags.update";
+  }else
+  {
+    for(int i=0;i<external.Count();i++)generated.Push(external[i]);
+    external.Clean();
+  }
+  IndexDelta delta;
+  Check(MergeFiles("tags",mfiles,generated,changed,delta)==1,"MergeFiles",round);
+  FreeLines(generated);
+  FreeLines(external);
+  remove("tags.update");
+  Check(UpdateIndex(fi,delta,changed)==1,"UpdateIndex",round);
+
+  String updated,created;
+  Check(ReadFile(fi->indexFile,updated),"read updated index",round);
+  Check(CreateIndex(fi)==1,"CreateIndex",round);
+  Check(ReadFile(fi->indexFile,created),"read created index",round);
+  Check(updated.Length()>0 && updated==created,"updated index differs from created",round);
+  changed.Clean();
+  CheckChangedFiles("tags",changed);
+  Check(changed.Count()==0,"changed files after update",round);
+}
+
+int main()
+{
+  RegExp::InitLocale();
+  char dir[64];
+  sprintf(dir,"/tmp/updatetest.%d",(int)getpid());
+  mkdir(dir,0755);
+  if(chdir(dir)!=0)return 1;
+  genSeed=7;
+
+  Vector<char*> lines;
+  for(int n=0;n<srcCount;n++)
+  {
+    char fn[64];
+    WriteSource(n);
+    SrcName(n,fn);
+    GenerateTags(fn,fn,lines);
+  }
+  WriteTags("tags",lines,true);
+  FreeLines(lines);
+  if(Load("tags","")!=0 || !files[0]->hdr)
+  {
+    printf("FAIL: index not created\n");
+    return 1;
+  }
+  for(int round=0;round<rounds;round++)
+  {
+    Round(files[0],round);
+  }
+  UnloadTags(-1);
+
+  for(int n=0;n<srcCount;n++)
+  {
+    char fn[64];
+    SrcName(n,fn);
+    remove(fn);
+  }
+  remove("tags");
+  remove("tags.idx");
+  if(chdir("/tmp")==0)rmdir(dir);
+  printf("updatetest: %d rounds, %d failed\n",rounds,failed);
+  return failed?1:0;
+}
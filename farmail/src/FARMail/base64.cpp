@@ -27,88 +27,109 @@ static const char BASE64[] =
   'z','0','1','2','3','4','5','6','7','8','9','+','/'
 };
 
-void EncodeBase64 ( char * dest, char *source , int num )
-{
- int i = 0, i0,i1,i2,i3;
- char ch[5];
-
- *dest = 0;
- ch[4] = 0;
-
- while ( i < num ) {
-
-    DWORD dw ;
-
-    int c1, c2, c3;
-
-    c1 = (unsigned char)source[i];
-    i++;
-    if ( i<num ) c2 = (unsigned char)source[i]; else c2 = 0;
-    i++;
-    if ( i<num ) c3 = (unsigned char)source[i]; else c3 = 0;
-    i++;
+#define XX  0xFF // not a base64 character
+#define PAD 0x40 // '='
 
-    dw = c3;
-    dw += ( c2 << 8 );
-    dw += ( c1 << 16 );
-
-    i0 = ( dw & 0xFC0000 ) >> 18 ;
-    i1 = ( dw & 0x3F000  ) >> 12 ;
-    i2 = ( dw & 0xFC0    ) >> 6 ;
-    i3 = ( dw & 0x3F     )      ;
-
-    ch[0] = BASE64[ i0 ];
-    ch[1] = BASE64[ i1 ];
-    ch[2] = BASE64[ i2 ];
-    ch[3] = BASE64[ i3 ];
-
-    if ( i > num )   ch[3] = '=';
-    if ( i > num+1 ) ch[2] = '=';
+static const unsigned char DECODE64[256] =
+{
+   XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX,
+   XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX,
+   XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, 62, XX, XX, XX, 63,
+   52, 53, 54, 55, 56, 57, 58, 59, 60, 61, XX, XX, XX,PAD, XX, XX,
+   XX,  0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14,
+   15, 16, 17, 18, 19, 20, 21, 22, 23, 24, 25, XX, XX, XX, XX, XX,
+   XX, 26, 27, 28, 29, 30, 31, 32, 33, 34, 35, 36, 37, 38, 39, 40,
+   41, 42, 43, 44, 45, 46, 47, 48, 49, 50, 51, XX, XX, XX, XX, XX,
+   XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX,
+   XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX,
+   XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX,
+   XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX,
+   XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX,
+   XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX,
+   XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX,
+   XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX, XX
+};
 
-    lstrcat( dest, ch );
+int EncodeBase64 ( char * dest, char *source , int num )
+{
+ const unsigned char *src = (const unsigned char *)source;
+ char *ptr = dest;
+
+ for ( ; num >= 3 ; num -= 3, src += 3 ) {
+    DWORD dw = ( src[0] << 16 ) | ( src[1] << 8 ) | src[2];
+    *ptr++ = BASE64[ dw >> 18 ];
+    *ptr++ = BASE64[ ( dw >> 12 ) & 0x3F ];
+    *ptr++ = BASE64[ ( dw >> 6 ) & 0x3F ];
+    *ptr++ = BASE64[ dw & 0x3F ];
  }
 
+ if ( num > 0 ) {
+    DWORD dw = ( src[0] << 16 ) | ( num > 1 ? src[1] << 8 : 0 );
+    *ptr++ = BASE64[ dw >> 18 ];
+    *ptr++ = BASE64[ ( dw >> 12 ) & 0x3F ];
+    *ptr++ = num > 1 ? BASE64[ ( dw >> 6 ) & 0x3F ] : '=';
+    *ptr++ = '=';
+ }
 
+ *ptr = 0;
+ return (int)( ptr - dest );
 }
 
 
-static DWORD __GetCode( char c )
+// Encodes num bytes as lines of BASE64_LINE bytes ending with CRLF, the
+// last line may be shorter. dest needs ( num / BASE64_LINE + 1 ) * 78 + 1
+// chars.
+int EncodeBase64Lines ( char * dest, char *source , int num )
 {
- DWORD i;
- for ( i=0; i<64; i++ )
-    if ( BASE64[i] == c ) return i;
- return 0;
-}
+ char *ptr = dest;
 
+ for ( ; num > 0 ; num -= BASE64_LINE, source += BASE64_LINE ) {
+    ptr += EncodeBase64( ptr, source, num < BASE64_LINE ? num : BASE64_LINE );
+    *ptr++ = '\r';
+    *ptr++ = '\n';
+ }
 
+ *ptr = 0;
+ return (int)( ptr - dest );
+}
 
 
-void DecodeBase64 ( char * dest, char *source , int num )
+// Whitespace, line breaks and other foreign characters are skipped. A
+// missing padding is tolerated, and '=' ends a group so that concatenated
+// encodings ("QQ==QQ==") decode as a whole. Returns the number of bytes
+// written, dest is zero terminated as well.
+int DecodeBase64 ( char * dest, char *source , int num )
 {
- *dest = '\0';
-
- while ( num > 0 ) {
-
-    char c3,c4;
-
-    DWORD i1 = __GetCode( *(source++) );
-    DWORD i2 = __GetCode( *(source++) );
-    DWORD i3 = __GetCode( c3 = *(source++) );
-    DWORD i4 = __GetCode( c4 = *(source++) );
-
-    DWORD dw = i4 + ( i3 << 6 ) + ( i2 << 12 ) + (i1 << 18 );
-
-    int cc1 = ( dw & 0xFF0000 ) >> 16;
-    int cc2 = ( dw & 0x00FF00 ) >> 8;
-    int cc3 = ( dw & 0xFF ) ;
-
-    strcatchr( dest, (char)cc1 );
-    if ( c3 != '=' ) strcatchr( dest, (char)cc2 );
-    if ( c4 != '=' ) strcatchr( dest, (char)cc3 );
-
-    num-=4;
-
+ const unsigned char *src = (const unsigned char *)source, *end = src + num;
+ char *ptr = dest;
+ DWORD dw = 0;
+ int n = 0;
+
+ for ( ;; ) {
+
+    // the end of input acts as padding
+    unsigned char c = ( src < end ) ? DECODE64[ *src++ ] : PAD;
+
+    if ( c < PAD ) {
+       dw = ( dw << 6 ) | c;
+       if ( ++n < 4 ) continue;
+       *ptr++ = (char)( dw >> 16 );
+       *ptr++ = (char)( dw >> 8 );
+       *ptr++ = (char)dw;
+       dw = 0;
+       n = 0;
+    } else if ( c == PAD ) {
+       if ( n >= 2 ) {
+          dw <<= 6 * ( 4 - n );
+          *ptr++ = (char)( dw >> 16 );
+          if ( n == 3 ) *ptr++ = (char)( dw >> 8 );
+       }
+       dw = 0;
+       n = 0;
+       if ( src >= end ) break;
+    }
  }
- strcatchr( dest, '\0' );
 
+ *ptr = 0;
+ return (int)( ptr - dest );
 }
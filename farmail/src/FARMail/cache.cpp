@@ -127,35 +127,9 @@ int MessageCache::UseCachedData( PluginPanelItem **_pPanelItem, int *_pItemsNumb
 
 int MessageCache::ClearCachedData(void)
 {
-  if(MailboxPath[0])
-  {
-    WaitForSingleObject(UidlMutex,INFINITE);
-    HKEY key_root;
-    if(RegOpenKeyEx(HKEY_CURRENT_USER,MailboxPath,0,KEY_ALL_ACCESS,&key_root)==ERROR_SUCCESS)
-    {
-      HKEY key_new; DWORD Disposition;
-      if((RegCreateKeyEx(key_root,UidlKey,0,NULL,0,KEY_READ,NULL,&key_new,&Disposition))==ERROR_SUCCESS)
-      {
-        RegCloseKey(key_new);
-      }
-      if(RegDeleteKey(key_root,UidlKey)==ERROR_SUCCESS)
-      {
-        if((RegCreateKeyEx(key_root,UidlKey,0,NULL,0,KEY_WRITE,NULL,&key_new,&Disposition))==ERROR_SUCCESS)
-        {
-          for(int i=0;i<pItemsNumber;i++)
-          {
-            if(pPanelItem[i].CustomColumnNumber>4&&pPanelItem[i].CustomColumnData[4]&&lstrlen(pPanelItem[i].CustomColumnData[4])&&!(pPanelItem[i].UserData&MESSAGE_STATE_DELETED))
-            {
-              RegSetValueEx(key_new,pPanelItem[i].CustomColumnData[4],0,REG_DWORD,(LPBYTE)&pPanelItem[i].UserData,sizeof(pPanelItem[i].UserData));
-            }
-          }
-          RegCloseKey(key_new);
-        }
-      }
-      RegCloseKey(key_root);
-    }
-    ReleaseMutex(UidlMutex);
-  }
+  //drops the states of messages that are gone from the server
+  if(MailboxPath[0]) Uidls.Save(pPanelItem,pItemsNumber);
+  Uidls.Free();
   return InternalClearCachedData();
 }
 
@@ -201,6 +175,7 @@ bool MessageCache::MarkMessage(const char *uidl, DWORD state)
       {
         pPanelItem[i].UserData=state;
         pPanelItem[i].FindData.dwFileAttributes=MapStateToAttribute(state);
+        Uidls.Set(uidl,state);
         Res=true;
       }
       else
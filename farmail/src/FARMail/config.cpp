@@ -104,6 +104,7 @@ void ReadRegistryConnection(void)
     lstrcpy(Opt.IMAP_Inbox,INBOX);
   GetRegKey2(  hRoot, PluginCommonKey, NULLSTR, DISPLAYZEROSIZEMESS, &Opt.DisplayZeroSizeMess, 0 );
   GetRegKey2(  hRoot, PluginCommonKey, NULLSTR, DISABLETOP,     &Opt.DisableTOP, 0 );
+  GetRegKey2(  hRoot, PluginCommonKey, NULLSTR, MAXCONNECTIONS, &Opt.MaxConnections, 4 );
 }
 
 void ReadRegistryUidl(void)
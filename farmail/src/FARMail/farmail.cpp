@@ -110,6 +110,7 @@ const char USEHEADER         [] = "SearchHeader";
 const char RESUME            [] = "ResumeDownload";
 const char FILEDATE          [] = "UseMessageDate";
 const char DISABLETOP        [] = "DisableTOP";
+const char MAXCONNECTIONS    [] = "MaxConnections";
 
 const char NAMEFORMAT        [] = "NameFormat";
 const char USENAMEF          [] = "UseNameFt";
@@ -193,6 +194,9 @@ void WINAPI _export SetStartupInfo(const struct PluginStartupInfo *Info)
   while ( p > Opt.LOGFILE3 && *p != '.' ) p--;
   if ( *p == '.' ) { *(++p) = 'i'; *(++p) = 'm'; *(++p) = 'a'; *(++p) = 'p'; *(++p) = '\0'; }
 
+  lstrcpy( Opt.UIDLDIR, _Info.ModuleName );
+  lstrcpy( FSF.PointToName( Opt.UIDLDIR ), "Uidl\\" );
+
   memset (&Opt.Modes, 0, sizeof (Opt.Modes));
 
   Opt.Modes[PLUGIN_PANEL_MAILBOXES][0].lpColumnTypes = z_strdup ("N,C0");
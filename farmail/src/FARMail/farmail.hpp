@@ -37,6 +37,13 @@
 #endif
 
 #define BUFFER_SIZE 512
+#define RECV_BUFFER_SIZE (BUFFER_SIZE*32)
+#define SAVE_BUFFER_SIZE 0x10000
+#define POP3_WINDOW 16
+#define SMTP_WINDOW 16
+#define SMTP_CHUNK_HEAD 32
+#define BASE64_LINE (19*3)            // bytes of one 76 chars line
+#define BASE64_BLOCK (BASE64_LINE*64) // bytes encoded at once
 #define SD_SEND 0x01
 
 #define PROGRESS_LEN 30
@@ -213,6 +220,7 @@ typedef struct Options
   char LOGFILE[MAX_PATH];
   char LOGFILE2[MAX_PATH];
   char LOGFILE3[MAX_PATH];
+  char UIDLDIR[MAX_PATH];
   char EXT[20];
 
   int  DisplayZeroSizeMess;
@@ -240,6 +248,7 @@ typedef struct Options
   int  Resume;
   int  FileDate;
   int  DisableTOP;
+  int  MaxConnections;
 
   char Format[100];
 
@@ -302,6 +311,40 @@ typedef struct POPSERVER {
    char MailboxPath[200];
 } POPSERVER;
 
+typedef struct
+{
+  char *Uidl;
+  DWORD Hash;
+  DWORD State;
+} UIDLENTRY;
+
+// Per-mailbox message states, kept in Opt.UIDLDIR as a log of "state uidl"
+// lines. The log is read with a single ReadFile into a hash table, each
+// state change is appended, and Save() rewrites it with the messages that
+// are still on the server.
+class UidlStore
+{
+  private:
+    char MailboxPath[200];
+    char FileName[MAX_PATH];
+    UIDLENTRY *Table;
+    int TableSize;
+    int Count;
+    UIDLENTRY *Find(const char *uidl,DWORD hash);
+    BOOL Insert(const char *uidl,DWORD state);
+    BOOL LoadFile(const char *name);
+    BOOL LoadRegistry(void);
+    BOOL Rewrite(PluginPanelItem *Items,int ItemsNumber);
+  public:
+    UidlStore();
+    ~UidlStore();
+    void Load(const char *MailboxPath);
+    DWORD Get(const char *uidl);
+    void Set(const char *uidl,DWORD state);
+    BOOL Save(PluginPanelItem *Items,int ItemsNumber);
+    void Free(void);
+};
+
 class MessageCache
 {
  private:
@@ -321,6 +364,7 @@ class MessageCache
     bool MarkMessage(const char *uidl, DWORD state);
     bool MarkMessage(int i, DWORD state);
     bool ClearState(DWORD state);
+    UidlStore Uidls;
 };
 
 
@@ -399,13 +443,17 @@ class MailClient
    BOOL Disconnect();
    BOOL Noop();
    BOOL Reset();
-   BOOL Retrieve(int MsgNumber,int OpMode);
+   BOOL Retrieve(int MsgNumber,int OpMode,HANDLE fp=INVALID_HANDLE_VALUE,int UseInbox=FALSE);
    BOOL Top(int MsgNumber, int);
    BOOL Statistics();
    char *GetErrorMessage();
    BOOL List();
    BOOL CorrectList(void);
    BOOL Uidl(void);
+   BOOL TopAhead(int MsgNumber, int);
+   BOOL RetrieveAhead(int MsgNumber);
+   BOOL DeleteAhead(int MsgNumber);
+   BOOL Flush(void);
 
    int NumberMail;
    int TotalSize;
@@ -418,6 +466,8 @@ class MailClient
    int    ResponseBufferLen;
    BOOL   FastDownload;
    BOOL   FastDelete;
+   BOOL   Silent;        // nothing is shown on screen, for background sessions
+   BOOL   Pipelining;
    char ServerName[80];
    FMSocket PopServer;
 
@@ -433,8 +483,30 @@ class MailClient
    HANDLE fplog;
    char _Name[100];
    long _Size;
-
-   BOOL GetResponseBuffer( char *InitBuf, int initsize , const char * endstr , char *pname , long tsize, long isize=0 );
+   HANDLE _File;
+   int _UseInbox;
+
+   // server responses are read by lines
+   char  InBuf[RECV_BUFFER_SIZE];
+   int   InPos, InLen;
+   char *Line;
+   int   LineLen, LineSize;
+
+   // commands sent ahead, their responses are not read yet
+   char  Queued[POP3_WINDOW][32];
+   int   QueuedType[POP3_WINDOW];
+   int   QHead, QCount;
+   BOOL  DeleteFailed;
+   BOOL  QueueFailed;   // nothing is sent ahead after a failed response
+
+   BOOL SendCommand( const char *cmd );
+   BOOL SendAhead( const char *cmd, int type );
+   BOOL SkipQueued( void );
+   BOOL QueuedData( void );
+   int RecvLine( void );
+   BOOL AddResponse( const char *data, int len, int &n );
+   BOOL GetResponseBuffer( char *InitBuf, int initsize , char *pname , long tsize, long isize=0 );
+   BOOL SaveResponse( HANDLE fp, int UseInbox, char *pname , long tsize, long isize=0 );
    BOOL CheckResponse(int ResponseType);
    BOOL AddMessage( int n, int num, int len );
    int AddLog( const char *s );
@@ -468,12 +540,35 @@ class SMTP
    BOOL AuthLogin(char *user, char *pwd);
    BOOL AuthPlain(char *user, char *pwd);
    char message_id[1000];
+   BOOL Pipelining; // RFC 2920
+   BOOL Chunking;   // RFC 3030 BDAT
 
  private:
    BOOL log;
    char   ErrMessage[BUFFER_SIZE];
    HANDLE fplog;
 
+   // server responses are read by lines
+   char  InBuf[RECV_BUFFER_SIZE];
+   int   InPos, InLen;
+
+   // commands and message data are sent in blocks, a BDAT command
+   // is put in front of the data in the reserved head
+   char  OutBuf[SMTP_CHUNK_HEAD+SAVE_BUFFER_SIZE+1];
+   int   OutLen;
+
+   // checks for responses not read yet
+   int   Pending[SMTP_WINDOW];
+   int   PHead, PCount;
+   BOOL  Failed;
+
+   int RecvLine( char *buf, int size );
+   BOOL Queue( const char *cmd, int ResponseType );
+   BOOL ReadPending( int count );
+   BOOL SendChunk( BOOL last );
+   BOOL SendOut( void );
+   void LogOut( void );
+
    const char *GetSMTPError(int code);
    BOOL CheckResponse(int ResponseType);
    int AddLog(const char *s);
@@ -527,6 +622,13 @@ class IMAP
    char  *GetMsgTail( int num , long startpos , long endpos , const char *_name );
    void   FreeMsgText( void );
 
+   int    FetchHeaders( void );
+   char  *NextHeader( void );
+   int    EndFetch( void );
+   int    FetchNum;
+   long   FetchSize;
+   char   FetchUID[24];
+
    char  *GetErrorMessage();
    int    connected;
    int MessageNumber;
@@ -551,6 +653,9 @@ class IMAP
  private:
 
    int  CheckTag( char *buffer, int len /*, char *tagpos*/ );
+   int  Receive( char *buf, int size );
+   int  ReadLine( void );
+   BOOL ReadLiteral( char *buf, long len );
 
    long TagCounter;
    BOOL log;
@@ -566,6 +671,13 @@ class IMAP
    char * MessageBuffer;
    long   MessageLen;
 
+   // streamed responses are read by lines and literals
+   char   InBuf[RECV_BUFFER_SIZE];
+   int    InPos, InLen;
+   char * Line;
+   int    LineLen, LineSize;
+   int    FetchStat;
+
    char   ErrMessage[BUFFER_SIZE];
    HANDLE fplog;
    int AddLog( const char *s , int );
@@ -589,6 +701,7 @@ class IMAP
 #define RETR_CHECK              9
 #define TOP_CHECK              10
 #define UIDL_CHECK             11
+#define CAPA_CHECK             12
 
 #define MESSAGE_STATE_NEW       1
 #define MESSAGE_STATE_READ      2
@@ -633,6 +746,8 @@ class FARMail
     HANDLE      tempfp;
     char        tempfp_name[MAX_PATH];
     char        savefp_name[MAX_PATH];
+    char       *savebuf;
+    int         savebuf_len;
     MessageCache Cache;
     int         MakeDescription( char *buf, char *format, char *from, char *subj, char *date, int buflen );
     int         CopyMoveIMAP( int move );
@@ -667,6 +782,7 @@ class FARMail
     int ProcessKey(int Key,unsigned int ControlState);
     int FastStatus(struct PluginPanelItem *PanelItem, int ItemsNumber, int OpMode);
     int FastDownload(struct PluginPanelItem *PanelItem, int ItemsNumber, int Move, const char *DestPath, int OpMode);
+    int FastDownloadPOP3(struct PluginPanelItem *PanelItem, int ItemsNumber, int Move, int UseInbox, const char *DestPath);
     int FastExpunge(struct PluginPanelItem *PanelItem, int ItemsNumber, int OpMode);
     int GetFiles(struct PluginPanelItem *PanelItem, int ItemsNumber, int Move, char *DestPath, int OpMode);
     int PutFiles(struct PluginPanelItem *PanelItem,int ItemsNumber, int Move,int OpMode);
@@ -757,6 +873,7 @@ extern const char USEHEADER     [];
 extern const char RESUME        [];
 extern const char FILEDATE      [];
 extern const char DISABLETOP    [];
+extern const char MAXCONNECTIONS[];
 extern const char NAMEFORMAT    [];
 extern const char USENAMEF      [];
 extern const char IMAP_INBOX    [];
@@ -828,20 +945,26 @@ char *RegQueryStringValueEx (
 const char *GetMsg(int MsgId);
 void InitDialogItems(struct InitDialogItem *Init,struct FarDialogItem *Item,int ItemsNumber);
 int FARMailConfig( void );
-void EncodeBase64 ( char * dest, char *source , int num );
+int EncodeBase64 ( char * dest, char *source , int num );
+int EncodeBase64Lines ( char * dest, char *source , int num );
 void EncodeString( uchar *str );
 void DecodeString( uchar *str );
 
 void strcatchr( char *str, char s );
 //int EncodeQuotedPrintable( char *source, int lensrc, char *dest );
 int DecodeQuotedPrintable( char *source, int lensrc, char *dest );
-char * SplitHeaderLine( char *line, char *charset, char *encoding, char *text );
+char * SplitHeaderLine( char *line, char *charset, char *encoding, char *text, int size );
 int GetGeaderField(const char *header,char *field,const char *type,int len);
-void DecodeBase64 ( char * dest, char *source , int num );
+int DecodeBase64 ( char * dest, char *source , int num );
 //void DecodeUUE ( char * dest, char *source , int num );
 int Confirm( int title );
 void FreeMailSend( MAILSEND *parm );
 int GetFreeNumber( char *dir );
+HANDLE CreateFreeFile( char *dir, char *name, DWORD flags );
+#define FREE_RETRIES 100
+void ResetFreeNumber( void );
+BOOL WriteBuffered( HANDLE fp, char *out, int &outlen, const char *data, int len );
+void GetUidlFileName( const char *mailbox, char *file );
 int SayError( const char *s );
 
 const char *get_token( const char *str, int n , int imap );
@@ -883,7 +1006,8 @@ enum {
  SMTP_EHLO_CHECK,
  SMTP_AUTH_CHECK,
  SMTP_LOGIN_CHECK1,
- SMTP_LOGIN_CHECK2
+ SMTP_LOGIN_CHECK2,
+ SMTP_BDAT_CHECK
 };
 
 #define Dialog_Move(Index,NewX,NewY) {SMALL_RECT pos; int width; _Info.SendDlgMessage(hDlg,DM_GETITEMPOSITION,Index,(long)&pos); width=pos.Right-pos.Left; pos.Left=NewX; pos.Top=NewY; pos.Right=pos.Left+width; _Info.SendDlgMessage(hDlg,DM_SETITEMPOSITION,Index,(long)&pos);}
@@ -95,6 +95,373 @@ int FARMail::GetDialogEx(int Move, const char *dir, char *newdir, int *uniq, int
   return !(key == FD_OK);
 }
 
+// Several POP3 accounts are downloaded at once, with at most
+// Opt.MaxConnections sessions at a time. A message is received to
+// a temporary file, it gets its name or is appended to inbox only
+// when complete, and is deleted from server only after that.
+// Temporary files are kept in a hidden subdirectory of the mail
+// folder, so a message is renamed, not copied, to its place.
+
+#define FAST_TEMP_DIR "~fmtemp\\"
+
+struct FastSession
+{
+  POPSERVER *Server;
+  MailClient *Client;       // set while session is connected
+  char Error[BUFFER_SIZE];
+};
+
+struct FastShared
+{
+  FastSession *Sessions;
+  LONG Count;
+  LONG Next;
+  LONG Done;
+  LONG Aborted;             // Esc is pressed, sessions are to stop
+  int Move;
+  int UseInbox;
+  char Dest[MAX_PATH*2];    // directory with backslash or inbox
+  char TempDir[MAX_PATH*2];
+  CRITICAL_SECTION Lock;    // inbox writes and Client
+};
+
+static BOOL CheckForEsc(void)
+{
+  INPUT_RECORD rec;
+  DWORD ReadCount;
+  BOOL esc = FALSE;
+  HANDLE hConInp = GetStdHandle(STD_INPUT_HANDLE);
+
+  while (PeekConsoleInput(hConInp,&rec,1,&ReadCount) && ReadCount)
+  {
+    ReadConsoleInput(hConInp,&rec,1,&ReadCount);
+    if (rec.EventType == KEY_EVENT && rec.Event.KeyEvent.bKeyDown &&
+        rec.Event.KeyEvent.wVirtualKeyCode == VK_ESCAPE)
+      esc = TRUE;
+  }
+  return esc;
+}
+
+// Sessions do not start new messages once Aborted is set, transfers
+// in progress are broken by stopping their sockets.
+static void AbortFastSessions(FastShared *fs)
+{
+  InterlockedExchange(&fs->Aborted, TRUE);
+  EnterCriticalSection(&fs->Lock);
+  for (int i=0; i<fs->Count; i++)
+    if (fs->Sessions[i].Client)
+      fs->Sessions[i].Client->PopServer.StopSocket();
+  LeaveCriticalSection(&fs->Lock);
+}
+
+static BOOL AppendToInbox(HANDLE fp, const char *inbox)
+{
+  DWORD end, rd, wr;
+  BOOL ok;
+
+  HANDLE in = CreateFile(inbox,GENERIC_WRITE,FILE_SHARE_READ,NULL,OPEN_ALWAYS,FILE_ATTRIBUTE_ARCHIVE|FILE_FLAG_SEQUENTIAL_SCAN,NULL);
+  if (in == INVALID_HANDLE_VALUE)
+    return FALSE;
+  char *buf = (char *)z_malloc(SAVE_BUFFER_SIZE);
+  end = SetFilePointer(in,0,NULL,FILE_END);
+  ok = buf && end != INVALID_SET_FILE_POINTER && SetFilePointer(fp,0,NULL,FILE_BEGIN) != INVALID_SET_FILE_POINTER;
+  while (ok)
+  {
+    ok = ReadFile(fp,buf,SAVE_BUFFER_SIZE,&rd,NULL);
+    if (!ok || !rd)
+      break;
+    ok = WriteFile(in,buf,rd,&wr,NULL) && wr == rd;
+  }
+  if (ok)
+    ok = FlushFileBuffers(in);
+  if (!ok && end != INVALID_SET_FILE_POINTER)
+  {
+    // drop partially written message
+    SetFilePointer(in,end,NULL,FILE_BEGIN);
+    SetEndOfFile(in);
+  }
+  if (buf)
+    z_free(buf);
+  CloseHandle(in);
+  return ok;
+}
+
+// Gives complete message its place, fp is closed.
+static BOOL SaveFastMessage(FastShared *fs, HANDLE fp, const char *temp)
+{
+  BOOL ok = FALSE;
+
+  if (fs->UseInbox)
+  {
+    EnterCriticalSection(&fs->Lock);
+    ok = AppendToInbox(fp, fs->Dest);
+    LeaveCriticalSection(&fs->Lock);
+    CloseHandle(fp); // temporary file is deleted on close
+    return ok;
+  }
+  ok = FlushFileBuffers(fp);
+  CloseHandle(fp);
+  if (ok)
+  {
+    char dest[MAX_PATH*2];
+    ok = FALSE;
+    // MoveFile does not replace a message saved by somebody else
+    for (int k=0; k<FREE_RETRIES && !ok; k++)
+    {
+      FSF.sprintf(dest, "%s%08ld.%s", fs->Dest, (long)GetFreeNumber(fs->Dest), Opt.EXT);
+      ok = MoveFile(temp, dest);
+      if (!ok && GetLastError() != ERROR_ALREADY_EXISTS && GetLastError() != ERROR_FILE_EXISTS)
+        break;
+    }
+  }
+  if (!ok)
+    DeleteFile(temp);
+  return ok;
+}
+
+// Sessions run at the same time, so each one logs into its own file:
+// FARMail.pop becomes FARMail.1.pop, FARMail.2.pop and so on.
+static void SessionLogName(char *dest, const char *log, int n)
+{
+  const char *ext = log + lstrlen(log);
+  while (ext > log && *ext != '.' && *ext != '\\') ext--;
+  if (*ext != '.') ext = log + lstrlen(log);
+  lstrcpyn(dest, log, (int)(ext-log)+1);
+  FSF.sprintf(dest+(ext-log), ".%d%s", n, ext);
+}
+
+static void RunFastSession(FastShared *fs, FastSession *s)
+{
+  POPSERVER *current = s->Server;
+  char logfile[MAX_PATH+16];
+  SessionLogName(logfile, Opt.LOGFILE, (int)(s-fs->Sessions)+1);
+  MailClient *clnt = new MailClient((Opt.DebugSession?TRUE:FALSE), logfile, 0);
+  BOOL res;
+
+  clnt->FastDownload = TRUE;
+  clnt->Silent = TRUE;
+  lstrcpy(clnt->ServerName,current->Name);
+  EnterCriticalSection(&fs->Lock);
+  s->Client = clnt;
+  if (fs->Aborted)
+    clnt->PopServer.StopSocket();
+  LeaveCriticalSection(&fs->Lock);
+#ifdef FARMAIL_SSL
+  res = clnt->Connect(current->Url, current->_User, current->_Pass, current->Port, (current->UsePOP3S?CON_SSL:CON_NORMAL));
+#else
+  res = clnt->Connect(current->Url, current->_User, current->_Pass, current->Port);
+#endif
+  if (res)
+    res = clnt->Statistics();
+  if (!res)
+    lstrcpy(s->Error, clnt->GetErrorMessage());
+
+  int ahead = 1;
+  for (int i=1; res && i<=clnt->NumberMail && !fs->Aborted; i++)
+  {
+    char temp[MAX_PATH*2], head[1024];
+    HANDLE fp = INVALID_HANDLE_VALUE;
+    DWORD written;
+
+    if (ahead < i)
+      ahead = i;
+    while (ahead <= clnt->NumberMail && clnt->RetrieveAhead(ahead))
+      ahead++;
+
+    if (GetTempFileName(fs->TempDir, "fml", 0, temp))
+      fp = CreateFile(temp,GENERIC_READ|GENERIC_WRITE,0,NULL,CREATE_ALWAYS,FILE_ATTRIBUTE_TEMPORARY|FILE_FLAG_SEQUENTIAL_SCAN|(fs->UseInbox?FILE_FLAG_DELETE_ON_CLOSE:0),NULL);
+    if (fp == INVALID_HANDLE_VALUE)
+    {
+      lstrcpy(s->Error, ::GetMsg(MesErrOpenFile));
+      break;
+    }
+    EnterCriticalSection(&fs->Lock);
+    FSF.sprintf(head,"From  %s\r\n",GetDateInSMTP());
+    LeaveCriticalSection(&fs->Lock);
+    if (!WriteFile(fp,head,lstrlen(head),&written,NULL))
+    {
+      lstrcpy(s->Error, ::GetMsg(MesErrWriteFile));
+      res = FALSE;
+    }
+    else if (!clnt->Retrieve(i, OPM_SILENT, fp, fs->UseInbox))
+    {
+      lstrcpy(s->Error, clnt->GetErrorMessage());
+      res = FALSE;
+    }
+    if (!res)
+    {
+      CloseHandle(fp);
+      if (!fs->UseInbox)
+        DeleteFile(temp);
+      break;
+    }
+    if (!SaveFastMessage(fs, fp, temp))
+    {
+      lstrcpy(s->Error, ::GetMsg(MesErrWriteFile));
+      break;
+    }
+    if (fs->Move && !clnt->DeleteAhead(i) && !clnt->Delete(i))
+    {
+      lstrcpy(s->Error, clnt->GetErrorMessage());
+      break;
+    }
+    if (i == clnt->NumberMail && !clnt->Flush())
+      lstrcpy(s->Error, clnt->GetErrorMessage());
+  }
+  clnt->Disconnect();
+  EnterCriticalSection(&fs->Lock);
+  s->Client = NULL;
+  LeaveCriticalSection(&fs->Lock);
+  delete clnt;
+}
+
+static DWORD WINAPI FastSessionThread(LPVOID arg)
+{
+  FastShared *fs = (FastShared *)arg;
+  LONG n;
+
+  while (!fs->Aborted && (n = InterlockedIncrement(&fs->Next)) <= fs->Count)
+  {
+    RunFastSession(fs, &fs->Sessions[n-1]);
+    InterlockedIncrement(&fs->Done);
+  }
+  return 0;
+}
+
+// Runs all sessions in at most nthreads threads, while progress is
+// shown and Esc is polled. Returns FALSE if download was aborted.
+static BOOL RunFastSessions(FastShared *fs, int nthreads)
+{
+  HANDLE threads[MAXIMUM_WAIT_OBJECTS];
+  int i;
+
+  if (nthreads > fs->Count)
+    nthreads = fs->Count;
+  if (nthreads > MAXIMUM_WAIT_OBJECTS)
+    nthreads = MAXIMUM_WAIT_OBJECTS;
+  for (i=0; i<nthreads; i++)
+  {
+    DWORD ID;
+    threads[i] = CreateThread(NULL,0,FastSessionThread,(void*)fs,0,&ID);
+    if (!threads[i])
+      break;
+  }
+  nthreads = i;
+  if (nthreads)
+  {
+    Bar *bar = new Bar(fs->Count, ::GetMsg(MesProgressReceiveServers_Title), PROGRESS_LEN);
+    while (WaitForMultipleObjects(nthreads,threads,TRUE,250) == WAIT_TIMEOUT)
+    {
+      if (!fs->Aborted && CheckForEsc())
+        AbortFastSessions(fs);
+      bar->UseBar(fs->Done);
+    }
+    delete bar;
+    for (i=0; i<nthreads; i++)
+      CloseHandle(threads[i]);
+  }
+  else
+    FastSessionThread((void*)fs);
+  return !fs->Aborted;
+}
+
+// Returns 0 if POP3 accounts are to be downloaded one by one,
+// -1 if download was aborted.
+int FARMail::FastDownloadPOP3(struct PluginPanelItem *PanelItem, int ItemsNumber, int Move, int UseInbox, const char *DestPath)
+{
+  FastShared fs;
+  int i, j, count = 0, done;
+
+  for (j=0; j < ItemsNumber; j++)
+    for (i=0; i<ServerCount; i++)
+      if (!lstrcmp(PanelItem[j].FindData.cFileName, server[i].Name))
+      {
+        if (server[i].Type == TYPE_POP3 && *server[i].Url)
+          count++;
+        break;
+      }
+  if (count < 2)
+    return 0;
+
+  if (UseInbox)
+  {
+    FSF.ExpandEnvironmentStr(Opt.PathToInbox,fs.Dest,MAX_PATH);
+    if (!GetTempPath(sizeof(fs.TempDir),fs.TempDir))
+      return 0;
+  }
+  else
+  {
+    lstrcpy(fs.Dest, DestPath);
+    if (!*fs.Dest)
+      return 0;
+    if (fs.Dest[lstrlen(fs.Dest)-1] != '\\')
+    {
+      // all messages to one file are left to the serial way
+      DWORD aa = GetFileAttributes(fs.Dest);
+      if (aa == 0xFFFFFFFF || !(aa&FILE_ATTRIBUTE_DIRECTORY))
+        return 0;
+      lstrcat(fs.Dest, BACKSLASH);
+    }
+    // temporary files are not to be seen among messages
+    FSF.sprintf(fs.TempDir, "%s%s", fs.Dest, FAST_TEMP_DIR);
+    if (!CreateDirectory(fs.TempDir,NULL) && GetLastError() != ERROR_ALREADY_EXISTS)
+      return 0;
+    SetFileAttributes(fs.TempDir, FILE_ATTRIBUTE_HIDDEN|FILE_ATTRIBUTE_DIRECTORY);
+  }
+
+  FastSession *sessions = (FastSession *)z_calloc(count, sizeof(FastSession));
+  if (!sessions)
+  {
+    if (!UseInbox)
+      RemoveDirectory(fs.TempDir);
+    return 0;
+  }
+
+  // mailboxes may not be opened twice
+  if (clnt)
+  {
+    clnt->Disconnect();
+    delete (MailClient *)clnt;
+    clnt = NULL;
+  }
+
+  count = 0;
+  for (j=0; j < ItemsNumber; j++)
+    for (i=0; i<ServerCount; i++)
+      if (!lstrcmp(PanelItem[j].FindData.cFileName, server[i].Name))
+      {
+        if (server[i].Type == TYPE_POP3 && *server[i].Url && ((*server[i].User && *server[i].Pass) || !GetUser(server[i]._User,server[i]._Pass)))
+        {
+          sessions[count++].Server = &server[i];
+          if (PanelItem[j].Flags&PPIF_SELECTED)
+            PanelItem[j].Flags ^= PPIF_SELECTED;
+        }
+        break;
+      }
+
+  fs.Sessions = sessions;
+  fs.Count = count;
+  fs.Next = fs.Done = fs.Aborted = 0;
+  fs.Move = Move;
+  fs.UseInbox = UseInbox;
+  InitializeCriticalSection(&fs.Lock);
+
+  done = RunFastSessions(&fs, Opt.MaxConnections);
+  DeleteCriticalSection(&fs.Lock);
+  if (!UseInbox)
+    RemoveDirectory(fs.TempDir); // left if something could not be moved
+
+  for (i=0; done && i<count; i++)
+    if (*sessions[i].Error)
+    {
+      char buf[BUFFER_SIZE+100];
+      FSF.sprintf(buf, "%s: %s", sessions[i].Server->Name, sessions[i].Error);
+      SayError(buf);
+    }
+  z_free(sessions);
+  return done ? 1 : -1;
+}
+
 int FARMail::FastDownload(struct PluginPanelItem *PanelItem, int ItemsNumber, int Move, const char *DestPath, int OpMode)
 {
 #ifdef TDEBUG
@@ -110,6 +477,7 @@ try {
   BOOL res;
 
   lstrcpy(NewDestPath, DestPath);
+  ResetFreeNumber();
 
   err[0] = GetMsg(MesOverwrite_Title);
   err[1] = NULLSTR;
@@ -125,6 +493,13 @@ try {
   if (!silent && GetDialogEx(Move, DestPath, NewDestPath, &Opt.Unique, &UseInbox))
     return -1;
 
+  // no questions are asked about file names, so accounts may go at once
+  int pop3done = 0;
+  if (UseInbox || Opt.Unique || silent)
+    pop3done = FastDownloadPOP3(PanelItem, ItemsNumber, Move, UseInbox, NewDestPath);
+  if (pop3done < 0)
+    return -1;
+
   for (int j=0; j < ItemsNumber; j++)
   {
     if (clnt)
@@ -145,6 +520,8 @@ try {
     {
       if (!lstrcmp(PanelItem[j].FindData.cFileName, server[i].Name))
       {
+        if (pop3done && server[i].Type == TYPE_POP3)
+          break;
         if (*server[i].Url && ((*server[i].User && *server[i].Pass) || !GetUser(server[i]._User,server[i]._Pass)))
         {
           current = &server[i];
@@ -178,6 +555,7 @@ try {
         continue;
       if (clnt && clnt->connected)
       {
+        int ahead = 1;
         for (i=1; i<=clnt->NumberMail; i++)
         {
           char dest[MAX_PATH*2];
@@ -241,58 +619,66 @@ try {
             }
           }
 
-          if (clnt->Retrieve(i, 0/*OpMode*/))
+          HANDLE fp;
+          DWORD inboxend = 0;
+          if(UseInbox)
           {
-            HANDLE fp;
-            if(UseInbox)
-            {
-              char PathToInboxParsed[MAX_PATH];
-              FSF.ExpandEnvironmentStr(Opt.PathToInbox,PathToInboxParsed,MAX_PATH);
-              fp = CreateFile(PathToInboxParsed,GENERIC_WRITE,FILE_SHARE_READ,NULL,OPEN_ALWAYS,FILE_ATTRIBUTE_ARCHIVE|FILE_FLAG_SEQUENTIAL_SCAN,NULL);
-              if (fp != INVALID_HANDLE_VALUE)
-              {
-                if (SetFilePointer(fp,0,NULL,FILE_END) == INVALID_SET_FILE_POINTER)
-                {
-                  CloseHandle(fp);
-                  fp = INVALID_HANDLE_VALUE;
-                }
-              }
-            }
-            else
-              fp = CreateFile(dest,GENERIC_WRITE,FILE_SHARE_READ,NULL,CREATE_ALWAYS,FILE_ATTRIBUTE_ARCHIVE|FILE_FLAG_SEQUENTIAL_SCAN,NULL);
+            char PathToInboxParsed[MAX_PATH];
+            FSF.ExpandEnvironmentStr(Opt.PathToInbox,PathToInboxParsed,MAX_PATH);
+            fp = CreateFile(PathToInboxParsed,GENERIC_WRITE,FILE_SHARE_READ,NULL,OPEN_ALWAYS,FILE_ATTRIBUTE_ARCHIVE|FILE_FLAG_SEQUENTIAL_SCAN,NULL);
             if (fp != INVALID_HANDLE_VALUE)
             {
+              if ((inboxend = SetFilePointer(fp,0,NULL,FILE_END)) == INVALID_SET_FILE_POINTER)
               {
-                DWORD written;
-                char head[1024];
-                FSF.sprintf(head,"From  %s\r\n",GetDateInSMTP());
-                WriteFile(fp,head,lstrlen(head),&written,NULL);
-              }
-              int wrote = SaveToFile(fp,clnt->GetMsg(),UseInbox);
-              CloseHandle(fp);
-              if (wrote==1)
-              {
-                SayError(::GetMsg(MesErrWriteFile));
-                break;
+                CloseHandle(fp);
+                fp = INVALID_HANDLE_VALUE;
               }
             }
-            else
-            {
-              SayError(::GetMsg(MesErrOpenFile));
-              break;
-            }
-            if (Move && !clnt->Delete(i))
-            {
-              SayError(clnt->GetErrorMessage());
-              break;
-            }
           }
           else
+            fp = CreateFile(dest,GENERIC_WRITE,FILE_SHARE_READ,NULL,CREATE_ALWAYS,FILE_ATTRIBUTE_ARCHIVE|FILE_FLAG_SEQUENTIAL_SCAN,NULL);
+          if (fp == INVALID_HANDLE_VALUE)
+          {
+            SayError(::GetMsg(MesErrOpenFile));
+            break;
+          }
+          {
+            DWORD written;
+            char head[1024];
+            FSF.sprintf(head,"From  %s\r\n",GetDateInSMTP());
+            WriteFile(fp,head,lstrlen(head),&written,NULL);
+          }
+          // keep the window of RETR commands full, messages that are
+          // skipped above are read out by the client
+          if (ahead < i)
+            ahead = i;
+          while (ahead <= clnt->NumberMail && clnt->RetrieveAhead(ahead))
+            ahead++;
+          // message is written to file while it is received
+          BOOL got = clnt->Retrieve(i, 0/*OpMode*/, fp, UseInbox);
+          if (!got && UseInbox)
+          {
+            // drop partially written message from inbox
+            SetFilePointer(fp,inboxend,NULL,FILE_BEGIN);
+            SetEndOfFile(fp);
+          }
+          CloseHandle(fp);
+          if (!got)
+          {
+            if (!UseInbox)
+              DeleteFile(dest);
+            SayError(clnt->GetErrorMessage());
+            break;
+          }
+          if (Move && !clnt->DeleteAhead(i) && !clnt->Delete(i))
           {
             SayError(clnt->GetErrorMessage());
             break;
           }
         }
+        // errors of pipelined DELE commands
+        if (i > clnt->NumberMail && !clnt->Flush())
+          SayError(clnt->GetErrorMessage());
       }
       else
         break;
@@ -661,10 +1047,11 @@ try {
       {
 
         Bar *bar = new Bar(clnt->NumberMail,GetMsg(MsgDelPOP),PROGRESS_LEN);
-        for (int i=1;i<=clnt->NumberMail;i++)
+        int i;
+        for (i=1;i<=clnt->NumberMail;i++)
         {
 
-          if (!clnt->Delete(i))
+          if (!clnt->DeleteAhead(i) && !clnt->Delete(i))
           {
             SayError( clnt->GetErrorMessage() );
             break;
@@ -672,6 +1059,8 @@ try {
           bar->UseBar(i);
         }
         delete bar;
+        if (i > clnt->NumberMail && !clnt->Flush())
+          SayError( clnt->GetErrorMessage() );
       } else break;
     }
     else
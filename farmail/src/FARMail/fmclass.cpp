@@ -222,8 +222,8 @@ int ExtDecodeStr8(char *str,const char *charset,CHARSET_TABLE **CharsetTable)
   int t=FindCharset(charset,CharsetTable );
   if(t>=0)
   {
-    for(int i=0;i<lstrlen(str);i++)
-      str[i]=(*CharsetTable)[t].DecodeTable[str[i]];
+    for(;*str;str++)
+      *str=(*CharsetTable)[t].DecodeTable[*str];
   }
   return 0;
 }
@@ -240,7 +240,8 @@ int DecodeField(char *str,char *charset_h,CHARSET_TABLE **CharsetTable)
     char *decodedtext=_tempbuf+2*str_size;
 
     lstrcpy(tempbuf,str);
-    *str=0;
+    char *out=str;
+    *out=0;
 
     if(charset_h)
     {
@@ -254,16 +255,17 @@ int DecodeField(char *str,char *charset_h,CHARSET_TABLE **CharsetTable)
       char *ptr=strstr(tempbuf,"=?");
       if(ptr)
       {
-        while(tempbuf<ptr)
-        {
-          ExtDecodeChar8(tempbuf,charset_h,CharsetTable);
-          strcatchr(str,*(tempbuf++));
-        }
-        char charset[1000]; //FIXME
-        char encoding[1000]; //FIXME
+        *ptr=0;
+        ExtDecodeStr8(tempbuf,charset_h,CharsetTable);
+        while(*tempbuf) *out++=*tempbuf++;
+        *out=0;
+        *ptr='=';
+        tempbuf=ptr;
+        char charset[1000];
+        char encoding[1000];
 
         *decodedtext=0;
-        tempbuf=SplitHeaderLine(tempbuf,charset,encoding,text);
+        tempbuf=SplitHeaderLine(tempbuf,charset,encoding,text,sizeof(charset));
 
         if (!FSF.LStricmp(encoding,"b"))
         {
@@ -276,16 +278,14 @@ int DecodeField(char *str,char *charset_h,CHARSET_TABLE **CharsetTable)
           DecodeQuotedPrintable(text,lstrlen(text),decodedtext);
         }
         ExtDecodeStr8(decodedtext,charset,CharsetTable);
-        lstrcat(str,decodedtext);
+        lstrcpy(out,decodedtext);
+        out+=lstrlen(out);
         continue;
       }
       else
       {
-        while(*tempbuf)
-        {
-          ExtDecodeChar8(tempbuf,charset_h,CharsetTable);
-          strcatchr(str,*(tempbuf++));
-        }
+        ExtDecodeStr8(tempbuf,charset_h,CharsetTable);
+        lstrcpy(out,tempbuf);
         break;
       }
     }
@@ -391,6 +391,8 @@ FARMail::FARMail()
  *savefp_name = 0;
  *tempfp_name = 0;
  tempfp = NULL;
+ savebuf = NULL;
+ savebuf_len = 0;
 
  if ( !ConstructCharset(&CharsetTable) )
  {
@@ -550,7 +552,11 @@ try {
                 if (res)
                   if (!Opt.DisplayZeroSizeMess)
                     res = clnt->CorrectList();
-                if(current->uidl) clnt->Uidl();
+                if(current->uidl)
+                {
+                  clnt->Uidl();
+                  Cache.Uidls.Load(current->MailboxPath);
+                }
 
              }
              else
@@ -562,7 +568,7 @@ try {
 
              if ( res ) {
 
-                int i;
+                int i, ahead = 0;
 
                 Bar *bar = new Bar(clnt->NumberMail, ::GetMsg(MesConnect_RetrMsgHeaders), PROGRESS_LEN );
 
@@ -584,6 +590,12 @@ try {
                    lstrcpy(NewPanelItem[i].CustomColumnData[2], QUESTIONMARK );
 
 
+                   // keep the window of TOP commands full
+                   if ( !Opt.DisableTOP ) {
+                      if ( ahead < i ) ahead = i;
+                      while ( ahead < clnt->NumberMail && clnt->TopAhead( clnt->MessageNums[ahead] , current->TopValue ) ) ahead++;
+                   }
+
                    if ( !Opt.DisableTOP && clnt->Top( clnt->MessageNums[i] , current->TopValue ) )
                    {
                       char chbf[100], *charsetptr;
@@ -635,7 +647,7 @@ try {
                      NewPanelItem[i].CustomColumnData[4]=z_strdup(clnt->MessageUidls[i]);
                      if(lstrlen(NewPanelItem[i].CustomColumnData[4]))
                      {
-                       NewPanelItem[i].UserData=GetUidlState(NewPanelItem[i].CustomColumnData[4]); //FIXME
+                       NewPanelItem[i].UserData=GetUidlState(NewPanelItem[i].CustomColumnData[4]);
                      }
                    }
                    else
@@ -878,38 +890,35 @@ try {
                 lstrcpy(NewPanelItem[i].CustomColumnData[2], QUESTIONMARK );
                 lstrcpy(NewPanelItem[i].CustomColumnData[3], "0" );
 
+                NewPanelItem[i].CustomColumnData[4] = z_strdup(NULLSTR);
                 NewPanelItem[i].CustomColumnNumber=5;
                 NewPanelItem[i].FindData.dwFileAttributes=FILE_ATTRIBUTE_NORMAL;
                 NewPanelItem[i].FindData.nFileSizeLow = 0;
 
-                if ( !imap->Fetch( i+1, RFC822SIZE ,0,0,NULL ) ) {
-                   int line = 0;
-                   while ( imap->GetRespString( line++) ) {
-                      if ( imap->GetRespToken(0) && !lstrcmp( imap->RespString2, ASTERISK ) ) {
-                         if ( imap->GetRespToken(1) && i+1==FSF.atoi(imap->RespString2) ) {
-                            if ( imap->GetRespToken(2) && !lstrcmp( imap->RespString2, FETCH ) ) {
-                               imap->GetRespToken(3);
-                               lstrcpy( imap->RespString, imap->RespString2 );
-                               FSF.LStrupr( imap->RespString );
-                               if ( imap->GetRespToken(0) && !lstrcmp( imap->RespString2, RFC822SIZE ) ) {
-                                  if ( imap->GetRespToken(1) ) {
-                                      NewPanelItem[i].FindData.nFileSizeLow = FSF.atoi(imap->RespString2);
-                                  }
-                               }
-                            }
-                         }
-                      }
-                   }
-                }
-                if ( !imap->Fetch( i+1, RFC822HEADER ,0,0,NULL) ) {
+                GenerateName(i+1,NewPanelItem[i].FindData.cFileName);
+             }
+
+             // headers of all messages come in one response
+             if ( imap->MessageNumber && !imap->FetchHeaders() ) {
+                char *header;
+
+                while ( ( header = imap->NextHeader() ) != NULL ) {
                    char chbf[100], *charsetptr;
 
-                   NewPanelItem[i].CustomColumnData[4] = z_strdup(imap->GetMsg());
+                   i = imap->FetchNum-1;
+                   if ( i < 0 || i >= imap->MessageNumber ) continue;
+
+                   NewPanelItem[i].FindData.nFileSizeLow = imap->FetchSize;
+                   if ( *imap->FetchUID )
+                      lstrcpyn( NewPanelItem[i].CustomColumnData[3], imap->FetchUID, 41 );
 
-                   GetGeaderField( imap->GetMsg(), NewPanelItem[i].CustomColumnData[0], FROM, 1000 );
-                   GetGeaderField( imap->GetMsg(), NewPanelItem[i].CustomColumnData[1], _DATE, 80 );
-                   GetGeaderField( imap->GetMsg(), NewPanelItem[i].CustomColumnData[2], SUBJECT, 1000 );
-                   GetGeaderField( imap->GetMsg(), chbf,  CONTENTTYPE, 100 );
+                   z_free( NewPanelItem[i].CustomColumnData[4] );
+                   NewPanelItem[i].CustomColumnData[4] = z_strdup(header);
+
+                   GetGeaderField( header, NewPanelItem[i].CustomColumnData[0], FROM, 1000 );
+                   GetGeaderField( header, NewPanelItem[i].CustomColumnData[1], _DATE, 80 );
+                   GetGeaderField( header, NewPanelItem[i].CustomColumnData[2], SUBJECT, 1000 );
+                   GetGeaderField( header, chbf,  CONTENTTYPE, 100 );
 
                    ConvertDate( NewPanelItem[i].CustomColumnData[1], &NewPanelItem[i].FindData );
 
@@ -922,7 +931,7 @@ try {
                    } else {
                       char xsun[100];
                       *xsun = 0;
-                      GetGeaderField( imap->GetMsg(), xsun, "X-Sun-Text-Type:", 100 );
+                      GetGeaderField( header, xsun, "X-Sun-Text-Type:", 100 );
                       if ( *xsun ) {
                          charsetptr = xsun;
                          while ( *charsetptr == 32 ||
@@ -935,33 +944,9 @@ try {
                    DecodeSubj(NewPanelItem[i].CustomColumnData[1], charsetptr );
                    DecodeSubj(NewPanelItem[i].CustomColumnData[0], charsetptr );
 
-                } else {
-                   NewPanelItem[i].CustomColumnData[4] = z_strdup(NULLSTR);
-                }
-                if ( !imap->Fetch( i+1, UID ,0,0,NULL) ) {
-                   int line = 0;
-                   while ( imap->GetRespString( line++) ) {
-                      if ( imap->GetRespToken(0) && !lstrcmp( imap->RespString2, ASTERISK ) ) {
-                         if ( imap->GetRespToken(1) && i+1==FSF.atoi(imap->RespString2) ) {
-                            if ( imap->GetRespToken(2) && !lstrcmp( imap->RespString2, FETCH ) ) {
-                               imap->GetRespToken(3);
-                               lstrcpy( imap->RespString, imap->RespString2 );
-                               FSF.LStrupr( imap->RespString );
-                               if ( imap->GetRespToken(0) && !lstrcmp( imap->RespString2, UID ) ) {
-                                  if ( imap->GetRespToken(1) ) {
-                                     lstrcpy(NewPanelItem[i].CustomColumnData[3], imap->RespString2 );
-                                  }
-                               }
-                            }
-                         }
-                      }
-                   }
-
+                   if ( bar ) bar->UseBar(i+1);
                 }
-
-                GenerateName(i+1,NewPanelItem[i].FindData.cFileName);
-
-                if ( bar ) bar->UseBar(i+1);
+                imap->EndFetch();
              }
              Cache.LoadCachedData(*pPanelItem,*pItemsNumber,NULLSTR);
              // delete sm;
@@ -2168,6 +2153,8 @@ try {
 
   if ( !Level ) return FALSE;
 
+  ResetFreeNumber();
+
   char buf[MAX_PATH*2+100];
   const char *err[8], *err2[6];
   char NewDestPath[512];
@@ -2341,24 +2328,19 @@ try {
               if ( answer == 1 ) all = 1;
            }
 
-           if ( clnt->Retrieve(num, OpMode) )
+           BOOL cd=MakeDirs(NewDestPath,dest);
+           HANDLE fp=cd?CreateFile(dest,GENERIC_WRITE,FILE_SHARE_READ,NULL,CREATE_ALWAYS,FILE_ATTRIBUTE_ARCHIVE|FILE_FLAG_SEQUENTIAL_SCAN,NULL):INVALID_HANDLE_VALUE;
+           if ( fp == INVALID_HANDLE_VALUE )
            {
-              BOOL cd=MakeDirs(NewDestPath,dest);
-              HANDLE fp=CreateFile(dest,GENERIC_WRITE,FILE_SHARE_READ,NULL,CREATE_ALWAYS,FILE_ATTRIBUTE_ARCHIVE|FILE_FLAG_SEQUENTIAL_SCAN,NULL);
-              if(fp!=INVALID_HANDLE_VALUE && cd)
-              {
-                 int wrote = SaveToFile(fp,clnt->GetMsg());
-                 CloseHandle(fp);
-                 SetDate( dest , &PanelItem[i].FindData.ftCreationTime, Opt.FileDate );
-                 if (wrote==1)
-                 {
-                   SayError(::GetMsg(MesErrWriteFile));
-                   return 0;
-                 }
-              } else {
-                 SayError(::GetMsg(MesErrOpenFile));
-                 return 0;
-              }
+              SayError(::GetMsg(MesErrOpenFile));
+              return 0;
+           }
+           // message is written to file while it is received
+           BOOL got = clnt->Retrieve(num, OpMode, fp);
+           CloseHandle(fp);
+           if ( got )
+           {
+              SetDate( dest , &PanelItem[i].FindData.ftCreationTime, Opt.FileDate );
               if (PanelItem[i].Flags&PPIF_SELECTED)
                 PanelItem[i].Flags-=PPIF_SELECTED;
               if ( Move)
@@ -2376,6 +2358,7 @@ try {
               }
 
            } else {
+              DeleteFile( dest );
               SayError( clnt->GetErrorMessage() );
               return 0;
            }
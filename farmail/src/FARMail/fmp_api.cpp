@@ -64,6 +64,7 @@ int WINAPI api_get_header_field(const char *header,const char *field_name,char *
 
 int WINAPI api_get_free_number(char *dir)
 {
+  ResetFreeNumber();
   return GetFreeNumber(dir);
 }
 
@@ -40,6 +40,7 @@ const char RFC822SIZE       [] = "RFC822.SIZE";
 
 enum ERRORS
 {
+  ERR_PENDING = -1,
   ERR_NO = 0,
   ERR_RESPONSE_OK  = 0,
   ERR_SOCKETERROR  = 1,
@@ -262,6 +263,89 @@ int IMAP::CheckTag( char *buffer, int len /*, char *tagpos*/ )
 
 
 
+// Socket.Receive, that returns data left after ReadLine first.
+int IMAP::Receive( char *buf, int size )
+{
+ if ( InPos < InLen ) {
+    int m = InLen - InPos;
+    if ( m > size ) m = size;
+    memcpy( buf, InBuf + InPos, m );
+    InPos += m;
+    return m;
+ }
+ return Socket.Receive( buf, size, Opt.Timeout*1000 );
+}
+
+
+
+// Reads next line of response into Line, CRLF is kept.
+// Returns length of the line or SOCKET_ERROR.
+int IMAP::ReadLine( void )
+{
+ LineLen = 0;
+ for (;;) {
+    if ( InPos >= InLen ) {
+       InPos = InLen = 0;
+       int m = Socket.Receive( InBuf, sizeof(InBuf), Opt.Timeout*1000 );
+       if ( m <= 0 ) {
+          lstrcpy( ErrMessage, ::GetMsg(MesErrWinsock) );
+          return SOCKET_ERROR;
+       }
+       InLen = m;
+    }
+    int start = InPos;
+    while ( InPos < InLen && InBuf[InPos] != '\n' ) InPos++;
+    int eol = InPos < InLen;
+    if ( eol ) InPos++;
+    int len = InPos - start;
+    if ( LineLen + len >= LineSize ) {
+       int size = LineSize ? LineSize : BUFFER_SIZE;
+       while ( size <= LineLen + len ) size *= 2;
+       char *tmp = (char*)z_realloc( Line, size );
+       if ( !tmp ) {
+          lstrcpy( ErrMessage, ::GetMsg(MesNoMem) );
+          return SOCKET_ERROR;
+       }
+       Line = tmp;
+       LineSize = size;
+    }
+    memcpy( Line + LineLen, InBuf + start, len );
+    LineLen += len;
+    if ( eol ) break;
+ }
+ Line[LineLen] = '\0';
+ return LineLen;
+}
+
+
+
+// Reads literal of len bytes into buf, or skips it if buf is NULL.
+BOOL IMAP::ReadLiteral( char *buf, long len )
+{
+ while ( len > 0 ) {
+    if ( InPos >= InLen ) {
+       InPos = InLen = 0;
+       int m = Socket.Receive( InBuf, sizeof(InBuf), Opt.Timeout*1000 );
+       if ( m <= 0 ) {
+          lstrcpy( ErrMessage, ::GetMsg(MesErrWinsock) );
+          return FALSE;
+       }
+       InLen = m;
+    }
+    int m = InLen - InPos;
+    if ( m > len ) m = len;
+    if ( buf ) {
+       memcpy( buf, InBuf + InPos, m );
+       buf += m;
+    }
+    InPos += m;
+    len -= m;
+ }
+ return TRUE;
+}
+
+
+
 int IMAP::ReceiveResponse( int tagflag , long _size, long _startsize, const char *_name )
 {
   char *ptr=NULL;
@@ -283,7 +367,7 @@ int IMAP::ReceiveResponse( int tagflag , long _size, long _startsize, const char
     }
   }
   RealBufferLen = 0;
-  memset( ResponseBuffer, 0,  ResponseBufferLen );
+  *ResponseBuffer = 0;
 
   if ( _name && *_name )
   {
@@ -302,9 +386,9 @@ int IMAP::ReceiveResponse( int tagflag , long _size, long _startsize, const char
 
   while(1)
   {
-    char buf[ BUFFER_SIZE ], *ptr2;
+    char buf[ RECV_BUFFER_SIZE ], *ptr2;
 
-    int m = Socket.Receive( buf, sizeof(buf) , Opt.Timeout*1000 );
+    int m = Receive( buf, sizeof(buf) );
 
     if ( m == SOCKET_ERROR )
     {
@@ -315,7 +399,8 @@ int IMAP::ReceiveResponse( int tagflag , long _size, long _startsize, const char
     if ( RealBufferLen + m >= ResponseBufferLen )
     {
       if(ResponseBufferLen<threshold) ResponseBufferLen=threshold;
-      else ResponseBufferLen+=step;
+      else ResponseBufferLen+=(step>ResponseBufferLen/2?step:ResponseBufferLen/2);
+      if(ResponseBufferLen<=RealBufferLen+m) ResponseBufferLen=RealBufferLen+m+step;
       ResponseBuffer = (char*)z_realloc( ResponseBuffer, ResponseBufferLen );
       if ( !ResponseBuffer )
       {
@@ -391,7 +476,7 @@ int IMAP::ReceiveResponse2( int tagflag )
 
     char buf[ BUFFER_SIZE ], *ptr2;
 
-    int m = Socket.Receive( buf, sizeof(buf) , Opt.Timeout*1000 );
+    int m = Receive( buf, sizeof(buf) );
 
     if ( m == SOCKET_ERROR ) {
        lstrcpy( ErrMessage, ::GetMsg(MesErrWinsock) );
@@ -495,6 +580,7 @@ int IMAP::Connect( char * Host, int port)
    WaitForSingleObject( hTransferSemaphore, INFINITE );
 
    ShortMessage *sm = new ShortMessage( MsgConnectIMAP );
+   InPos = InLen = 0;
 
 #ifdef FARMAIL_SSL
    if (Socket.Connect( Host, port , Opt.Timeout*1000, type) )
@@ -885,6 +971,14 @@ IMAP::IMAP( BOOL _log , char *file , int _interval )
  MessageBuffer = NULL;
  MessageLen = 0;
 
+ InPos = InLen = 0;
+ Line = NULL;
+ LineLen = LineSize = 0;
+ FetchStat = ERR_NO;
+ FetchNum = 0;
+ FetchSize = 0;
+ *FetchUID = 0;
+
  ResponseBufferLen = 0;
  ResponseBuffer = NULL;
 
@@ -934,6 +1028,8 @@ IMAP::~IMAP()
 
  if ( MessageBuffer ) z_free( MessageBuffer );
  MessageLen = 0;
+ if ( Line ) z_free( Line );
+ Line = NULL;
 
  AddLog("--- Closing IMAP4 session..\n", 2);
  if ( fplog != INVALID_HANDLE_VALUE ) CloseHandle(fplog);
@@ -1192,6 +1288,187 @@ void IMAP::FreeMsgText( void )
 
 
 
+// Headers of all messages in the selected mailbox are fetched by one
+// command. Untagged responses are read one by one with NextHeader.
+// If FetchHeaders succeeded, EndFetch must be called at the end.
+int IMAP::FetchHeaders( void )
+{
+ int stat;
+
+ if ( !connected ) return ERR_SOCKETERROR;
+
+ WaitForSingleObject( hTransferSemaphore, INFINITE );
+ IncreaseTag();
+ FetchStat = ERR_PENDING;
+ if ( ( stat = SendCommand( "UID FETCH 1:* (UID RFC822.SIZE BODY.PEEK[HEADER])" ) ) != 0 ) {
+    FetchStat = stat;
+    ReleaseSemaphore( hTransferSemaphore, 1, NULL );
+ }
+ return stat;
+}
+
+
+
+static char *SkipSpaces( char *p )
+{
+ while ( *p == ' ' || *p == '\t' ) p++;
+ return p;
+}
+
+
+
+// Returns length of {n} literal that ends the line, or -1.
+// Line ending may be CRLF or bare LF.
+static long LiteralAtEnd( const char *line, int len )
+{
+ while ( len > 0 && ( line[len-1] == '\r' || line[len-1] == '\n' ) ) len--;
+ if ( len < 3 || line[len-1] != '}' ) return -1;
+ const char *q = line + len - 2;
+ while ( q > line && isdigit( *q ) ) q--;
+ if ( *q != '{' || q == line + len - 2 ) return -1;
+ return atol( q+1 );
+}
+
+
+
+// Returns header of the next message, FetchNum, FetchUID and FetchSize
+// are set. Returns NULL after the tagged response.
+char * IMAP::NextHeader( void )
+{
+ while ( FetchStat == ERR_PENDING ) {
+
+    if ( ReadLine() == SOCKET_ERROR ) {
+       FetchStat = ERR_SOCKETERROR;
+       break;
+    }
+    AddLog( Line, 2 );
+
+    char *p = Line;
+    int taglen = lstrlen( Tag );
+
+    if ( !FSF.LStrnicmp( p, Tag, taglen ) && p[taglen] == ' ' ) {
+       p = SkipSpaces( p + taglen );
+       if ( !FSF.LStrnicmp( p, IMAP_OK, 2 ) ) FetchStat = ERR_RESPONSE_OK;
+       else if ( !FSF.LStrnicmp( p, IMAP_NO, 2 ) ) FetchStat = ERR_RESPONSE_NO;
+       else FetchStat = ERR_RESPONSE_BAD;
+       break;
+    }
+
+    int fetch = 0;
+    if ( *p == '*' ) {
+       p = SkipSpaces( p+1 );
+       FetchNum = FSF.atoi( p );
+       while ( isdigit( *p ) ) p++;
+       p = SkipSpaces( p );
+       if ( FetchNum && !FSF.LStrnicmp( p, FETCH, 5 ) ) {
+          p = SkipSpaces( p+5 );
+          if ( *p == '(' ) { p++; fetch = 1; }
+       }
+    }
+
+    if ( !fetch ) {
+       // other untagged response, only its literal is to be skipped
+       long len = LiteralAtEnd( Line, LineLen );
+       if ( len >= 0 && !ReadLiteral( NULL, len ) ) FetchStat = ERR_SOCKETERROR;
+       continue;
+    }
+
+    FreeMsgText();
+    FetchSize = 0;
+    *FetchUID = 0;
+
+    for (;;) {
+       int kind = 0;
+       char *name;
+
+       p = SkipSpaces( p );
+       if ( *p == ')' || *p == '\r' || *p == '\n' || !*p ) break;
+
+       name = p;
+       for ( int depth = 0; *p && *p != '\r' && *p != '\n' && ( depth || ( *p != ' ' && *p != ')' ) ); p++ ) {
+          if ( *p == '[' ) depth++;
+          else if ( *p == ']' ) depth--;
+       }
+       if ( p-name == 3 && !FSF.LStrnicmp( name, UID, 3 ) ) kind = 1;
+       else if ( p-name == 11 && !FSF.LStrnicmp( name, RFC822SIZE, 11 ) ) kind = 2;
+       else if ( !FSF.LStrnicmp( name, "BODY[HEADER", 11 ) || !FSF.LStrnicmp( name, RFC822HEADER, 13 ) ) kind = 3;
+       p = SkipSpaces( p );
+
+       if ( *p == '{' ) {
+          long len = atol( p+1 );
+          char *buf = NULL;
+          if ( kind == 3 ) {
+             MessageBuffer = buf = (char*)z_malloc( len+1 );
+             if ( buf ) {
+                buf[len] = 0;
+                MessageLen = len;
+             }
+          }
+          if ( !ReadLiteral( buf, len ) || ReadLine() == SOCKET_ERROR ) {
+             FetchStat = ERR_SOCKETERROR;
+             return NULL;
+          }
+          AddLog( Line, 2 );
+          p = Line;
+       } else if ( *p == '(' ) {
+          while ( *p && *p != ')' ) p++;
+          if ( *p ) p++;
+       } else if ( *p == '"' ) {
+          char *value = ++p;
+          while ( *p && *p != '"' ) {
+             if ( *p == '\\' && p[1] ) p++;
+             p++;
+          }
+          if ( kind == 3 && ( MessageBuffer = (char*)z_malloc( p-value+1 ) ) != NULL ) {
+             MessageLen = p-value;
+             memcpy( MessageBuffer, value, MessageLen );
+             MessageBuffer[MessageLen] = 0;
+          }
+          if ( *p ) p++;
+       } else {
+          char *value = p;
+          while ( *p && *p != ' ' && *p != ')' && *p != '\r' && *p != '\n' ) p++;
+          if ( kind == 1 ) {
+             int n = p-value;
+             if ( n >= (int)sizeof(FetchUID) ) n = sizeof(FetchUID)-1;
+             memcpy( FetchUID, value, n );
+             FetchUID[n] = '\0';
+          }
+          else if ( kind == 2 ) FetchSize = atol( value );
+       }
+    }
+
+    if ( !MessageBuffer ) {
+       MessageBuffer = (char*)z_calloc( 1, 1 );
+       MessageLen = 0;
+    }
+    if ( MessageBuffer ) return MessageBuffer;
+ }
+ return NULL;
+}
+
+
+
+int IMAP::EndFetch( void )
+{
+ while ( NextHeader() ) ;
+ FreeMsgText();
+ ReleaseSemaphore( hTransferSemaphore, 1, NULL );
+
+ switch ( FetchStat ) {
+
+    case ERR_RESPONSE_NO:
+    case ERR_RESPONSE_BAD:
+       lstrcpy( ErrMessage , FETCH );
+       lstrcat( ErrMessage , ::GetMsg(MesErrIMAP_NO_BAD) );
+       break;
+
+ }
+ return FetchStat;
+}
+
+
+
 int IMAP::Create(char *dir)
 {
  char buf[BUFFER_SIZE];
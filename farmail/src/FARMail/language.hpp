@@ -186,6 +186,7 @@ MesSelectMailbox_Title,
 MesProgressSend_Title,
 MesProgressReceive_Title,
 MesProgressReceiveFast_Title,
+MesProgressReceiveServers_Title,
 MesProgress_Body,
 
 MesRootPanelTitle,
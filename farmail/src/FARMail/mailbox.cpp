@@ -219,6 +219,8 @@ int FARMail::DeleteMailbox(char *name)
   FSF.sprintf(key,"%s\\%s",PluginMailBoxKey,name);
   DeleteRegSubKeys(hRoot,key);
   DeleteRegKey2(hRoot,PluginMailBoxKey,name);
+  GetUidlFileName(name,key);
+  DeleteFile(key);
   return 0;
 }
 
@@ -229,7 +231,13 @@ int FARMail::UpdateAndRenameMailbox( POPSERVER *server , char * oldname )
 {
  if ( lstrcmp( oldname , server->Name ) ) {
     int stat = InsertMailbox( server );
-    if ( !stat ) stat = DeleteMailbox( oldname );
+    if ( !stat ) {
+       char oldfile[MAX_PATH], newfile[MAX_PATH];
+       GetUidlFileName( oldname, oldfile );
+       GetUidlFileName( server->Name, newfile );
+       MoveFile( oldfile, newfile );
+       stat = DeleteMailbox( oldname );
+    }
     return stat;
  }
  return 0;
@@ -728,8 +736,5 @@ const char UidlKey[]="uidls";
 
 DWORD FARMail::GetUidlState(const char *uidl)
 {
-  HKEY hRoot=HKEY_CURRENT_USER;
-  DWORD Res=0;
-  GetRegKey2(hRoot,current->MailboxPath,UidlKey,uidl,(int *)&Res,MESSAGE_STATE_NEW);
-  return Res;
+  return Cache.Uidls.Get(uidl);
 }
@@ -59,6 +59,15 @@ MailClient::MailClient( BOOL _log , char *file , int _interval )
  MessageLens=NULL;
  MessageNums=NULL;
  MessageUidls=NULL;
+ InPos = InLen = 0;
+ Line = NULL;
+ LineLen = LineSize = 0;
+ _File = INVALID_HANDLE_VALUE;
+ _UseInbox = FALSE;
+ QHead = QCount = 0;
+ DeleteFailed = FALSE;
+ QueueFailed = FALSE;
+ Pipelining = FALSE;
  NumberMail = 0;
  TotalSize  = 0;
  DownloadedSize = 0;
@@ -68,6 +77,7 @@ MailClient::MailClient( BOOL _log , char *file , int _interval )
  hTransferSemaphore = CreateSemaphore( NULL, 1, 1, NULL ); //"POP3SessionSemaphore"
  FastDownload = FALSE;
  FastDelete = FALSE;
+ Silent = FALSE;
  *ServerName = '\0';
 
  EndThread = 0;
@@ -93,6 +103,8 @@ MailClient::~MailClient()
   if(ResponseBuffer) z_free(ResponseBuffer);
   ResponseBuffer=NULL;
   ResponseBufferLen=0;
+  if(Line) z_free(Line);
+  Line=NULL;
   AddLog("Closing MailClient..\n");
   if(fplog!=INVALID_HANDLE_VALUE) CloseHandle(fplog);
   fplog=INVALID_HANDLE_VALUE;
@@ -161,73 +173,290 @@ BOOL MailClient::IsError( char *buf )
  return FALSE;
 }
 
-BOOL MailClient::GetResponseBuffer(char *InitBuf,int initsize,const char *endstr,char *progressname,long tsize,long isize)
+// Sends command to server. If the command was already sent by
+// SendAhead, only responses queued before it are read out.
+BOOL MailClient::SendCommand(const char *cmd)
+{
+  while(QCount)
+  {
+    if(!lstrcmp(Queued[QHead],cmd))
+    {
+      QHead=(QHead+1)%POP3_WINDOW;
+      QCount--;
+      return TRUE;
+    }
+    if(!SkipQueued()) return FALSE;
+  }
+  AddLog(cmd);
+  return PopServer.Send(cmd,lstrlen(cmd),Opt.Timeout*1000)!=SOCKET_ERROR;
+}
+
+// Sends command without waiting for response (RFC 2449 PIPELINING).
+// Returns FALSE if server can't pipeline, window is full or one of
+// the responses has failed: commands go one by one after that.
+BOOL MailClient::SendAhead(const char *cmd,int type)
+{
+  BOOL res=FALSE;
+
+  if(!connected||!Pipelining||QueueFailed) return FALSE;
+  WaitForSingleObject(hTransferSemaphore,INFINITE);
+  // responses to DELE are not waited for by anybody
+  while(QCount==POP3_WINDOW&&QueuedType[QHead]==DELETE_CHECK)
+    if(!SkipQueued()) break;
+  if(QCount<POP3_WINDOW)
+  {
+    AddLog(cmd);
+    if(PopServer.Send(cmd,lstrlen(cmd),Opt.Timeout*1000)!=SOCKET_ERROR)
+    {
+      int n=(QHead+QCount)%POP3_WINDOW;
+      lstrcpyn(Queued[n],cmd,sizeof(Queued[n]));
+      QueuedType[n]=type;
+      QCount++;
+      res=TRUE;
+    }
+  }
+  ReleaseSemaphore(hTransferSemaphore,1,NULL);
+  return res;
+}
+
+// Reads out response to the first queued command and drops it.
+BOOL MailClient::SkipQueued(void)
+{
+  int type=QueuedType[QHead];
+
+  QHead=(QHead+1)%POP3_WINDOW;
+  QCount--;
+  if(RecvLine()==SOCKET_ERROR)
+  {
+    QueueFailed=TRUE;
+    return FALSE;
+  }
+  AddLog(Line);
+  if(IsError(Line))
+  {
+    if(type==DELETE_CHECK)
+    {
+      lstrcpy(ErrMessage,::GetMsg(MesErrDel));
+      DeleteFailed=TRUE;
+    }
+    QueueFailed=TRUE;
+    return TRUE;
+  }
+  if(type==DELETE_CHECK) return TRUE;
+  do
+  {
+    if(RecvLine()==SOCKET_ERROR)
+    {
+      QueueFailed=TRUE;
+      return FALSE;
+    }
+  } while(lstrcmp(Line,"."));
+  return TRUE;
+}
+
+// Whether responses with message data are queued, not just to DELE.
+BOOL MailClient::QueuedData(void)
+{
+  for(int i=0;i<QCount;i++)
+    if(QueuedType[(QHead+i)%POP3_WINDOW]!=DELETE_CHECK) return TRUE;
+  return FALSE;
+}
+
+// Reads out all queued responses. Returns FALSE if any of
+// pipelined DELE commands has failed.
+BOOL MailClient::Flush(void)
+{
+  BOOL res=TRUE;
+
+  WaitForSingleObject(hTransferSemaphore,INFINITE);
+  while(QCount&&res) res=SkipQueued();
+  if(DeleteFailed) res=FALSE;
+  DeleteFailed=FALSE;
+  ReleaseSemaphore(hTransferSemaphore,1,NULL);
+  return res;
+}
+
+BOOL MailClient::TopAhead(int Num,int lines)
 {
   char buf[BUFFER_SIZE];
-  char *start_check; long endlstrlen=lstrlen(endstr),step,threshold;
-  int m,n=initsize;
-  Progress *p=NULL;
+  FSF.sprintf(buf,"TOP %d %d\r\n",Num,lines);
+  return SendAhead(buf,TOP_CHECK);
+}
 
+BOOL MailClient::RetrieveAhead(int MsgNumber)
+{
+  char buf[BUFFER_SIZE];
+  FSF.sprintf(buf,"RETR %d\r\n",MsgNumber);
+  return SendAhead(buf,RETR_CHECK);
+}
 
-  step=tsize/8;
-  if(step<BUFFER_SIZE) step=BUFFER_SIZE;
-  else step=(step/BUFFER_SIZE+1)*BUFFER_SIZE;
-  threshold=((tsize+step)/BUFFER_SIZE+1)*BUFFER_SIZE;
+BOOL MailClient::DeleteAhead(int MsgNumber)
+{
+  char buf[BUFFER_SIZE];
+  FSF.sprintf(buf,"DELE %d\r\n",MsgNumber);
+  return SendAhead(buf,DELETE_CHECK);
+}
 
-  if(!ResponseBuffer)
+// Reads next line of server response into Line, without CRLF.
+// Returns length of the line or SOCKET_ERROR.
+int MailClient::RecvLine(void)
+{
+  LineLen=0;
+  for(;;)
   {
-    ResponseBuffer=(char*)z_calloc(1,ResponseBufferLen);
-    if(!ResponseBuffer)
+    if(InPos>=InLen)
+    {
+      InPos=InLen=0;
+      int m=PopServer.Receive(InBuf,sizeof(InBuf),Opt.Timeout*1000);
+      if(m<=0)
+      {
+        lstrcpy(ErrMessage,::GetMsg(MesErrWinsock));
+        return SOCKET_ERROR;
+      }
+      InLen=m;
+    }
+    int start=InPos;
+    while(InPos<InLen&&InBuf[InPos]!='\n') InPos++;
+    int eol=InPos<InLen;
+    if(eol) InPos++;
+    int len=InPos-start;
+    if(LineLen+len>=LineSize)
+    {
+      int size=LineSize?LineSize:BUFFER_SIZE;
+      while(size<=LineLen+len) size*=2;
+      char *tmp=(char*)z_realloc(Line,size);
+      if(!tmp)
+      {
+        lstrcpy(ErrMessage,::GetMsg(MesNoMem));
+        return SOCKET_ERROR;
+      }
+      Line=tmp;
+      LineSize=size;
+    }
+    for(int i=0;i<len;i++)
+    {
+      char c=InBuf[start+i];
+      Line[LineLen++]=c?c:' '; //FIXME
+    }
+    if(eol) break;
+  }
+  if(LineLen&&Line[LineLen-1]=='\n') LineLen--;
+  if(LineLen&&Line[LineLen-1]=='\r') LineLen--;
+  Line[LineLen]=0;
+  return LineLen;
+}
+
+// Appends data to ResponseBuffer at position n.
+BOOL MailClient::AddResponse(const char *data,int len,int &n)
+{
+  if(n+len>=ResponseBufferLen||!ResponseBuffer)
+  {
+    int size=ResponseBufferLen?ResponseBufferLen:BUFFER_SIZE*2;
+    while(size<=n+len) size*=2;
+    char *tmp=(char*)z_realloc(ResponseBuffer,size);
+    if(!tmp)
     {
       lstrcpy(ErrMessage,::GetMsg(MesNoMem));
       return FALSE;
     }
+    ResponseBuffer=tmp;
+    ResponseBufferLen=size;
   }
+  memcpy(ResponseBuffer+n,data,len);
+  n+=len;
+  ResponseBuffer[n]=0;
+  return TRUE;
+}
 
-  memset(ResponseBuffer,0,ResponseBufferLen);
-  memcpy(ResponseBuffer,InitBuf,initsize);
+// Multi-line response, up to the "." line, is stored in ResponseBuffer
+// after the status line from InitBuf.
+BOOL MailClient::GetResponseBuffer(char *InitBuf,int initsize,char *progressname,long tsize,long isize)
+{
+  int m,n=0,shown=0;
+  Progress *p=NULL;
+
+  if(!AddResponse(InitBuf,initsize,n)) return FALSE;
 
   if(progressname&&*progressname)
   {
     p=new Progress(tsize,progressname);
     p->UseProgress(initsize,initsize+isize);
   }
-  start_check=ResponseBuffer;
-  while(!strstr(start_check,endstr))
+  do
   {
-    memset(buf,0,BUFFER_SIZE);
-    m=PopServer.Receive(buf,sizeof(buf),Opt.Timeout*1000);
-    if(m==SOCKET_ERROR)
+    m=RecvLine();
+    if(m==SOCKET_ERROR||!AddResponse(Line,m,n)||!AddResponse(CRLF,2,n))
     {
-      lstrcpy(ErrMessage,::GetMsg(MesErrWinsock));
       if(p) delete p;
       return FALSE;
     }
-    for(int i=0;i<m;i++)
+    if(p&&n-shown>=RECV_BUFFER_SIZE)
     {
-      if(!buf[i]) buf[i]=' '; //FIXME
+      p->UseProgress(n,n+isize);
+      shown=n;
     }
-    if((n+m)>=ResponseBufferLen)
+  } while(lstrcmp(Line,"."));
+  DownloadedSize+=n;
+  if(p) delete p;
+  return TRUE;
+}
+
+// Multi-line response is written to fp while it is received,
+// without the "." line and with dot-stuffing removed.
+// If writing fails, the rest of response is still read out.
+BOOL MailClient::SaveResponse(HANDLE fp,int UseInbox,char *progressname,long tsize,long isize)
+{
+  int m,outlen=0;
+  long n=0,shown=0;
+  BOOL wrote=TRUE;
+  Progress *p=NULL;
+
+  char *out=(char*)z_malloc(SAVE_BUFFER_SIZE);
+  if(!out)
+  {
+    lstrcpy(ErrMessage,::GetMsg(MesNoMem));
+    return FALSE;
+  }
+  if(progressname&&*progressname)
+  {
+    p=new Progress(tsize,progressname);
+    p->UseProgress(0,isize);
+  }
+  for(;;)
+  {
+    m=RecvLine();
+    if(m==SOCKET_ERROR) break;
+    n+=m+2;
+    const char *data=Line;
+    if(*data=='.')
     {
-      if(ResponseBufferLen<threshold) ResponseBufferLen=threshold;
-      else ResponseBufferLen+=step;
-      ResponseBuffer=(char*)z_realloc(ResponseBuffer,ResponseBufferLen); //FIXME: memory leak, if realloc return NULL
-      if(!ResponseBuffer)
-      {
-        ResponseBufferLen=0;
-        lstrcpy(ErrMessage,::GetMsg(MesNoMem));
-        if(p) delete p;
-        return FALSE;
-      }
-      memset(ResponseBuffer+n,0,ResponseBufferLen-n);
+      if(m==1) break;
+      data++;
+      m--;
+    }
+    if(wrote)
+    {
+      if(UseInbox&&!strncmp(data,"From ",5))
+        wrote=WriteBuffered(fp,out,outlen,">",1);
+      wrote=wrote&&WriteBuffered(fp,out,outlen,data,m);
+      wrote=wrote&&WriteBuffered(fp,out,outlen,CRLF,2);
+    }
+    if(p&&n-shown>=RECV_BUFFER_SIZE)
+    {
+      p->UseProgress(n,n+isize);
+      shown=n;
     }
-    memcpy(ResponseBuffer+n,buf,m);
-    if((n-endlstrlen+1)>0) start_check=ResponseBuffer+n-endlstrlen+1;
-    n+=m;
-    if(p) p->UseProgress(n,n+isize);
   }
-  DownloadedSize+=n;
+  if(wrote) wrote=WriteBuffered(fp,out,outlen,NULL,0);
+  z_free(out);
   if(p) delete p;
+  DownloadedSize+=n;
+  if(m==SOCKET_ERROR) return FALSE;
+  if(!wrote)
+  {
+    lstrcpy(ErrMessage,::GetMsg(MesErrWriteFile));
+    return FALSE;
+  }
   return TRUE;
 }
 
@@ -296,28 +525,10 @@ BOOL MailClient::CheckResponse(int ResponseType)
    char  buf [BUFFER_SIZE*2];
    int n,num,len;
 
-   for (int i=0;i<BUFFER_SIZE*2;i++)
-      buf[i]='\0';
-
-   n = PopServer.Receive(buf, BUFFER_SIZE, Opt.Timeout*1000);
-   while ( n>=0 && !strstr( buf, CRLF ) ) {
-      char buf2[BUFFER_SIZE];
-      for (int i=0;i<BUFFER_SIZE;i++)
-         buf2[i]='\0';
-      int n2  = PopServer.Receive(buf2, sizeof(buf2), Opt.Timeout*1000);
-      if ( n2 == SOCKET_ERROR ) {
-         lstrcpy( ErrMessage, ::GetMsg(MesErrWinsock) );
-         return FALSE;
-      }else {
-         lstrcat( buf, buf2 );
-         n=lstrlen(buf);
-      }
-   }
-
-   if ( n == SOCKET_ERROR ) {
-       lstrcpy( ErrMessage, ::GetMsg(MesErrWinsock) );
-       return FALSE;
-   }
+   if ( RecvLine() == SOCKET_ERROR ) return FALSE;
+   lstrcpyn( buf, Line, sizeof(buf)-2 );
+   lstrcat( buf, CRLF );
+   n = lstrlen( buf );
 
    switch (ResponseType)
    {
@@ -439,7 +650,7 @@ BOOL MailClient::CheckResponse(int ResponseType)
             char *p;
             int nmes = 1;
 
-            if ( !GetResponseBuffer( buf, n , "\r\n.\r\n" , NULL, 0 ) )
+            if ( !GetResponseBuffer( buf, n , NULL, 0 ) )
                return FALSE;
             AddLog( ResponseBuffer );
             p = strstr( ResponseBuffer, CRLF );
@@ -469,17 +680,35 @@ BOOL MailClient::CheckResponse(int ResponseType)
          }
          else
          {
-            if (FastDownload)
+            if ( _File != INVALID_HANDLE_VALUE )
             {
-              //_Size = 0;
-              //FSF.sscanf(buf,"+OK %d",&_Size);
-              if ( !GetResponseBuffer( buf, n , "\r\n.\r\n" , _Name, TotalSize, DownloadedSize ) )
-                return FALSE;
+              // message goes to file, only status line is kept
+              int k = 0;
+              AddLog( buf );
+              if ( !AddResponse( buf, n, k ) ) return FALSE;
+              if (FastDownload)
+              {
+                if ( !SaveResponse( _File, _UseInbox, _Name, TotalSize, DownloadedSize ) )
+                  return FALSE;
+              }
+              else
+                if ( !SaveResponse( _File, _UseInbox, _Name, _Size ) )
+                  return FALSE;
             }
             else
-              if ( !GetResponseBuffer( buf, n , "\r\n.\r\n" , _Name, _Size ) )
-                return FALSE;
-            AddLog( ResponseBuffer );
+            {
+              if (FastDownload)
+              {
+                //_Size = 0;
+                //FSF.sscanf(buf,"+OK %d",&_Size);
+                if ( !GetResponseBuffer( buf, n , _Name, TotalSize, DownloadedSize ) )
+                  return FALSE;
+              }
+              else
+                if ( !GetResponseBuffer( buf, n , _Name, _Size ) )
+                  return FALSE;
+              AddLog( ResponseBuffer );
+            }
          }
          break;
       case TOP_CHECK:
@@ -491,7 +720,7 @@ BOOL MailClient::CheckResponse(int ResponseType)
          }
          else
          {
-            if ( !GetResponseBuffer( buf, n , "\r\n.\r\n" , NULL, 0 ) )
+            if ( !GetResponseBuffer( buf, n , NULL, 0 ) )
                return FALSE;
             AddLog( ResponseBuffer );
          }
@@ -505,7 +734,7 @@ BOOL MailClient::CheckResponse(int ResponseType)
         }
         else
         {
-          if(!GetResponseBuffer(buf,n,"\r\n.\r\n",NULL,0)) return FALSE;
+          if(!GetResponseBuffer(buf,n,NULL,0)) return FALSE;
           AddLog(ResponseBuffer);
           if(MessageUidls)
           {
@@ -544,6 +773,22 @@ BOOL MailClient::CheckResponse(int ResponseType)
           }
         }
         break;
+      case CAPA_CHECK:
+        AddLog(buf);
+        if(!IsError(buf))
+        {
+          char *p;
+          if(!GetResponseBuffer(buf,n,NULL,0)) return FALSE;
+          AddLog(ResponseBuffer);
+          p=ResponseBuffer;
+          while((p=strstr(p,CRLF))!=NULL)
+          {
+            p+=2;
+            if(!FSF.LStrnicmp(p,"PIPELINING",10)&&(p[10]=='\r'||p[10]==' '))
+              Pipelining=TRUE;
+          }
+        }
+        break;
    }
    return TRUE;
 }
@@ -563,7 +808,12 @@ BOOL MailClient::Connect( char * Host, char * User, char * Password, int port)
 
    WaitForSingleObject( hTransferSemaphore, INFINITE );
 
-   ShortMessage *sm = new ShortMessage( MsgConnectPOP );
+   ShortMessage *sm = Silent ? NULL : new ShortMessage( MsgConnectPOP );
+   InPos = InLen = 0;
+   QHead = QCount = 0;
+   DeleteFailed = FALSE;
+   QueueFailed = FALSE;
+   Pipelining = FALSE;
 
 #ifdef FARMAIL_SSL
    if (PopServer.Connect( Host, port , Opt.Timeout*1000, type ) )
@@ -610,6 +860,14 @@ BOOL MailClient::Connect( char * Host, char * User, char * Password, int port)
          ReleaseSemaphore( hTransferSemaphore, 1, NULL );
          return FALSE;
       }
+
+      FSF.sprintf (buf, "CAPA\r\n");
+      AddLog( buf );
+      if ( PopServer.Send( buf, lstrlen (buf) , Opt.Timeout*1000 ) == SOCKET_ERROR || CheckResponse(CAPA_CHECK)==FALSE ) {
+         delete sm;
+         ReleaseSemaphore( hTransferSemaphore, 1, NULL );
+         return FALSE;
+      }
       connected = 1;
       delete sm;
       ReleaseSemaphore( hTransferSemaphore, 1, NULL );
@@ -627,14 +885,13 @@ BOOL MailClient::Delete(int MsgNumber)
   if (!connected) return FALSE;
 
   WaitForSingleObject( hTransferSemaphore, INFINITE );
-  ShortMessage *sm;
+  ShortMessage *sm = NULL;
 
-  if (!FastDelete)
+  if (!FastDelete && !Silent)
     sm = new ShortMessage( MsgDelPOP );
 
   FSF.sprintf(buf, "DELE %d\r\n",MsgNumber );
-  AddLog( buf );
-  if ( PopServer.Send(buf, lstrlen(buf), Opt.Timeout*1000 ) == SOCKET_ERROR )
+  if ( !SendCommand( buf ) )
   {
     if (!FastDelete)
       delete sm;
@@ -664,11 +921,24 @@ BOOL MailClient::Disconnect()
 
    WaitForSingleObject( hTransferSemaphore, INFINITE );
 
-   ShortMessage *sm = new ShortMessage( MsgQuitPOP );
+   ShortMessage *sm = Silent ? NULL : new ShortMessage( MsgQuitPOP );
 
    FSF.sprintf (buf, "QUIT\r\n");
-   AddLog( buf );
-   if ( PopServer.Send(buf, lstrlen (buf), Opt.Timeout*1000 ) == SOCKET_ERROR ) {
+   // messages sent ahead are not wanted any more, they are not read
+   // out: connection is dropped after QUIT. Server may not get to the
+   // QUIT then, and keeps messages deleted in this session.
+   if ( QueuedData() ) {
+      AddLog( buf );
+      PopServer.Send( buf, lstrlen (buf), Opt.Timeout*1000 );
+      PopServer.RecreateSocket();
+      QHead = QCount = 0;
+      connected = 0;
+      lstrcpy( ErrMessage , ::GetMsg(MesErrQuit) );
+      delete sm;
+      ReleaseSemaphore( hTransferSemaphore, 1, NULL );
+      return FALSE;
+   }
+   if ( !SendCommand( buf ) ) {
       delete sm;
       ReleaseSemaphore( hTransferSemaphore, 1, NULL );
       return FALSE;
@@ -692,10 +962,14 @@ BOOL MailClient::Noop()
    if ( !connected ) return FALSE;
 
    if ( WaitForSingleObject( hTransferSemaphore, 0 ) == WAIT_TIMEOUT ) return TRUE;
+   // pipelined responses are on the way, session is alive anyway
+   if ( QCount ) {
+      ReleaseSemaphore( hTransferSemaphore, 1, NULL );
+      return TRUE;
+   }
 
    FSF.sprintf (buf, "NOOP\r\n");
-   AddLog( buf );
-   if ( PopServer.Send(buf, lstrlen (buf), Opt.Timeout*1000 ) == SOCKET_ERROR ) {
+   if ( !SendCommand( buf ) ) {
       ReleaseSemaphore( hTransferSemaphore, 1, NULL );
       return FALSE;
    }
@@ -719,11 +993,10 @@ BOOL MailClient::Reset()
 
    WaitForSingleObject( hTransferSemaphore, INFINITE );
 
-   ShortMessage *sm = new ShortMessage( MsgResetPOP );
+   ShortMessage *sm = Silent ? NULL : new ShortMessage( MsgResetPOP );
 
    FSF.sprintf (buf, "RSET\r\n");
-   AddLog( buf );
-   if ( PopServer.Send(buf, lstrlen (buf), Opt.Timeout*1000 ) == SOCKET_ERROR ) {
+   if ( !SendCommand( buf ) ) {
       delete sm;
       ReleaseSemaphore( hTransferSemaphore, 1, NULL );
       return FALSE;
@@ -739,7 +1012,9 @@ BOOL MailClient::Reset()
 }
 
 
-BOOL MailClient::Retrieve(int  MsgNumber, int OpMode)
+// If fp is given, message is saved to it as it is received,
+// GetMsg() doesn't return it then.
+BOOL MailClient::Retrieve(int  MsgNumber, int OpMode, HANDLE fp, int UseInbox)
 {
    char  buf [BUFFER_SIZE];
 
@@ -748,8 +1023,7 @@ BOOL MailClient::Retrieve(int  MsgNumber, int OpMode)
    WaitForSingleObject( hTransferSemaphore, INFINITE );
 
    FSF.sprintf (buf, "RETR %d\r\n",MsgNumber );
-   AddLog( buf );
-   if ( PopServer.Send(buf, lstrlen (buf), Opt.Timeout*1000 ) == SOCKET_ERROR ) {
+   if ( !SendCommand( buf ) ) {
       ReleaseSemaphore( hTransferSemaphore, 1, NULL );
       return FALSE;
    }
@@ -764,12 +1038,13 @@ BOOL MailClient::Retrieve(int  MsgNumber, int OpMode)
      else
        FSF.sprintf( _Name , ::GetMsg(MesProgressReceive_Title) , MsgNumber );
    }
-   if (CheckResponse(RETR_CHECK)==FALSE) {
-      ReleaseSemaphore( hTransferSemaphore, 1, NULL );
-      return FALSE;
-   }
+   _File = fp;
+   _UseInbox = UseInbox;
+   BOOL res = CheckResponse(RETR_CHECK);
+   _File = INVALID_HANDLE_VALUE;
+   if ( !res ) QueueFailed = TRUE;
    ReleaseSemaphore( hTransferSemaphore, 1, NULL );
-   return TRUE;
+   return res;
 }
 
 
@@ -782,8 +1057,7 @@ BOOL MailClient::Statistics()
    WaitForSingleObject( hTransferSemaphore, INFINITE );
 
    FSF.sprintf (buf, "STAT\r\n");
-   AddLog( buf );
-   if ( PopServer.Send(buf, lstrlen (buf), Opt.Timeout*1000 ) == SOCKET_ERROR ) {
+   if ( !SendCommand( buf ) ) {
       ReleaseSemaphore( hTransferSemaphore, 1, NULL );
       return FALSE;
    }
@@ -821,8 +1095,7 @@ BOOL MailClient::List()
    WaitForSingleObject( hTransferSemaphore, INFINITE );
 
    FSF.sprintf (buf, "LIST\r\n");
-   AddLog( buf );
-   if ( PopServer.Send(buf, lstrlen (buf), Opt.Timeout*1000 ) == SOCKET_ERROR ) {
+   if ( !SendCommand( buf ) ) {
       ReleaseSemaphore( hTransferSemaphore, 1, NULL );
       return FALSE;
    }
@@ -847,12 +1120,12 @@ BOOL MailClient::Top( int Num , int lines )
    WaitForSingleObject( hTransferSemaphore, INFINITE );
 
    FSF.sprintf(buf, "TOP %d %d\r\n", Num, lines );
-   AddLog( buf );
-   if ( PopServer.Send(buf, lstrlen (buf), Opt.Timeout*1000 ) == SOCKET_ERROR ) {
+   if ( !SendCommand( buf ) ) {
       ReleaseSemaphore( hTransferSemaphore, 1, NULL );
       return FALSE;
    }
    if (CheckResponse(TOP_CHECK)==FALSE) {
+      QueueFailed = TRUE;
       ReleaseSemaphore( hTransferSemaphore, 1, NULL );
       return FALSE;
    }
@@ -869,8 +1142,7 @@ BOOL MailClient::Uidl(void)
   if(!connected) return FALSE;
   WaitForSingleObject(hTransferSemaphore,INFINITE);
   FSF.sprintf(buf,"UIDL\r\n");
-  AddLog(buf);
-  if(PopServer.Send(buf,lstrlen(buf),Opt.Timeout*1000)==SOCKET_ERROR)
+  if(!SendCommand(buf))
   {
     ReleaseSemaphore(hTransferSemaphore,1,NULL);
     return FALSE;
@@ -51,123 +51,121 @@ int EncodeQuotedPrintable( char *source, int lensrc, char *dest )
 }
 #endif
 
+static int HexValue( char c )
+{
+  if ( c >= '0' && c <= '9' ) return c - '0';
+  if ( c >= 'A' && c <= 'F' ) return c - 'A' + 10;
+  if ( c >= 'a' && c <= 'f' ) return c - 'a' + 10;
+  return -1;
+}
+
 int DecodeQuotedPrintable( char *source, int lensrc, char *dest )
 {
-  int i=0;
-  *dest = 0;
+  const char *end = source + lensrc;
+  char *out = dest;
 
-  while ( i<lensrc )
+  while ( source < end )
   {
-    int c = source[i];
+    char c = *source++;
     if ( c == '=' )
     {
-      char buf[3];
-      buf[0] = source[++i];
-      buf[1] = source[++i];
-      buf[2] = 0;
-
-      long res;
-      FSF.sscanf( buf, "%lx", &res );
-
-      strcatchr( dest, (char)res );
-
-      i++;
-    }
-    else
-    {
-      if(c=='_') c=' '; //rfc2047 4.2
-      strcatchr( dest, (char)c );
-      i++;
+      int hi = source < end ? HexValue( source[0] ) : -1;
+      int lo = source+1 < end ? HexValue( source[1] ) : -1;
+      if ( hi >= 0 && lo >= 0 )
+      {
+        c = (char)( hi << 4 | lo );
+        source += 2;
+        if ( !c ) continue;
+      }
+      else if ( source < end && ( *source == 0x0d || *source == 0x0a ) )
+      {
+        // soft line break
+        if ( *source == 0x0d ) source++;
+        if ( source < end && *source == 0x0a ) source++;
+        continue;
+      }
     }
+    else if ( c == '_' ) c = ' '; //rfc2047 4.2
+    *out++ = c;
   }
-  return 0;
+  *out = 0;
+  return (int)( out - dest );
 }
 
-char * SplitHeaderLine( char *line, char *charset, char *encoding, char *text )
+// copies at most size-1 chars, the rest up to stop is skipped
+static char *CopyUntil( char *to, char *from, char stop, int size )
 {
- *charset = 0;
- *encoding = 0;
- *text = 0;
-
- char * ptr = strstr( line, "=?" );
- char *ptr2 = strstr( line, "?=" );
-
- if ( !ptr2 ) ptr2 = line+lstrlen(line);
-
- if ( ptr && ptr2 ) {
-    ptr += 2; // charset
-
-    while ( *ptr != '?' && *ptr ) {
-       strcatchr( charset , *ptr );
-       ptr++;
-    }
-    strcatchr( charset, '\0' );
-
-    if ( ! *ptr ) return ptr2;
-    ptr++;
+  char *end = to + size - 1;
+  while ( *from && *from != stop )
+  {
+    if ( to < end ) *to++ = *from;
+    from++;
+  }
+  *to = 0;
+  return from;
+}
 
-    while ( *ptr != '?' && *ptr ) {
-       strcatchr( encoding , *ptr );
-       ptr++;
-    }
-    strcatchr( encoding, '\0' );
+// charset and encoding are cut to size-1 chars, text needs as much room
+// as line
+char * SplitHeaderLine( char *line, char *charset, char *encoding, char *text, int size )
+{
+  *charset = 0;
+  *encoding = 0;
+  *text = 0;
 
-    if ( ! *ptr ) return ptr2;
+  char *ptr = strstr( line, "=?" );
+  if ( !ptr ) return line;
 
-    ptr++;
+  char *ptr2 = strstr( line, "?=" );
+  if ( !ptr2 ) ptr2 = line + lstrlen( line );
 
-    ptr2 = strstr( ptr, "?=" );
-    while ( ( ptr2 && ptr < ptr2 ) || ( !ptr2 && *ptr ) ) {
-       strcatchr( text , *ptr );
-       ptr++;
-    }
+  ptr = CopyUntil( charset, ptr+2, '?', size );
+  if ( !*ptr ) return ptr2;
 
-    if ( ptr2 ) ptr+=2;
-    return ptr;
+  ptr = CopyUntil( encoding, ptr+1, '?', size );
+  if ( !*ptr ) return ptr2;
 
- } else return line;
+  ptr++;
+  ptr2 = strstr( ptr, "?=" );
+  if ( !ptr2 ) return CopyUntil( text, ptr, 0, lstrlen( ptr ) + 1 );
 
+  memcpy( text, ptr, ptr2-ptr );
+  text[ptr2-ptr] = 0;
+  return ptr2+2;
 }
 
 int GetGeaderField(const char *header,char *field,const char *type,int len)
 {
-  char buf[50] = "\n";
-  char *lwr_hdr = z_strdup( header );
-  char *lwr_typ = z_strdup( type );
+  int typelen = lstrlen( type );
+  const char *ptr = NULL, *line;
 
   *field = 0;
 
-  if ( !lwr_hdr || !lwr_typ ) return 1;
-
-  FSF.LStrlwr( lwr_hdr );
-  FSF.LStrlwr( lwr_typ );
-
-  lstrcat( buf, lwr_typ );
-
-  const char *ptr = strstr( lwr_hdr, buf );
-  if ( !ptr ) {
-      // may be it's the first line?
-      ptr = strstr( lwr_hdr, lwr_typ );
-      if ( ptr && ptr != lwr_hdr ) ptr = NULL;
-  } else ptr+=1;
-
-  if ( !ptr ) {
-      z_free(lwr_hdr);
-      z_free(lwr_typ);
-      return 1;
+  for ( line = strchr( header, '\n' ); line; line = strchr( line, '\n' ) )
+  {
+    line++;
+    if ( !FSF.LStrnicmp( line, type, typelen ) )
+    {
+      ptr = line;
+      break;
+    }
+  }
+  if ( !ptr )
+  {
+    // may be it's the first line?
+    if ( FSF.LStrnicmp( header, type, typelen ) ) return 1;
+    ptr = header;
   }
 
-  ptr = header + ( ptr - lwr_hdr );
-
-  ptr += lstrlen( type );
+  ptr += typelen;
   while ( *ptr == 32 || *ptr == 9 ) ptr++;
 
+  char *to = field;
   while ( len )
   {
     if ( *ptr != 0x0d && *ptr != 0x0a && *ptr )
     {
-      strcatchr( field , *ptr );
-      ptr++;
+      *to++ = *ptr++;
       len--;
     }
     else if ( *ptr == 0x0d || *ptr == 0x0a )
@@ -180,14 +178,14 @@ int GetGeaderField(const char *header,char *field,const char *type,int len)
       //by a LWSP-char as equivalent to the LWSP-char.
       if(len)
       {
-        strcatchr(field,' ');
+        *to++ = ' ';
         len--;
       }
     }
     else
       break;
   }
-  strcatchr( field, '\0' );
+  *to = 0;
   //rfc2047 6.2.
   //When displaying a particular header field that contains multiple
   //'encoded-word's, any 'linear-white-space' that separates a pair of
@@ -212,7 +210,5 @@ int GetGeaderField(const char *header,char *field,const char *type,int len)
       field_to++;
     }
   }
-  z_free(lwr_hdr);
-  z_free(lwr_typ);
   return 0;
 }
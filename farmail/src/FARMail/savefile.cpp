@@ -19,6 +19,36 @@
 */
 #include "farmail.hpp"
 
+// The directory is scanned only when it differs from the previous call or
+// after ResetFreeNumber(), then numbers are handed out from FreeNumber. Each
+// number is checked against the disk so files created by somebody else since
+// the scan are skipped. A returned number is reserved even if the caller
+// never creates the file, so the sequence may have gaps. Sessions of fast
+// download save at the same time, so the state is guarded by FreeLock.
+static char FreeMask[MAX_PATH];
+static int FreeNumber=0;
+static LONG FreeLock=0;
+
+static void LockFreeNumber( void )
+{
+  while ( InterlockedCompareExchange( &FreeLock, 1, 0 ) )
+    Sleep( 0 );
+}
+
+static void UnlockFreeNumber( void )
+{
+  InterlockedExchange( &FreeLock, 0 );
+}
+
+// Called at the start of each batch of saves and before single saves, so
+// files deleted or renamed since the last batch are seen by the next scan.
+void ResetFreeNumber( void )
+{
+  LockFreeNumber();
+  FreeNumber=0;
+  UnlockFreeNumber();
+}
+
 int GetFreeNumber( char *dir )
 {
 
@@ -27,27 +57,81 @@ int GetFreeNumber( char *dir )
   int maxval = 0;
 
   char buf[MAX_PATH];
+  const char *slash=( *dir && dir[lstrlen(dir)-1] != '\\' )?"\\":NULLSTR;
 
-  if ( *dir && dir[lstrlen(dir)-1] != '\\' )
-    FSF.sprintf( buf, "%s\\*.%s", dir, Opt.EXT );
-  else
-    FSF.sprintf( buf, "%s*.%s", dir, Opt.EXT );
+  FSF.sprintf( buf, "%s%s*.%s", dir, slash, Opt.EXT );
 
-  hff = FindFirstFile( buf, &fd );
-  if ( hff != INVALID_HANDLE_VALUE )
+  LockFreeNumber();
+  if ( !FreeNumber || FSF.LStricmp(buf,FreeMask) )
   {
-    do
+    hff = FindFirstFile( buf, &fd );
+    if ( hff != INVALID_HANDLE_VALUE )
     {
-      int i = FSF.atoi(fd.cFileName );
-      if ( !i ) i = FSF.atoi(fd.cAlternateFileName );
+      do
+      {
+        int i = FSF.atoi(fd.cFileName );
+        if ( !i ) i = FSF.atoi(fd.cAlternateFileName );
+
+        if ( i>maxval ) maxval = i;
+
+      } while (FindNextFile(hff, &fd));
+      FindClose( hff );
+    }
+    lstrcpy(FreeMask,buf);
+    FreeNumber=maxval+1;
+  }
 
-      if ( i>maxval ) maxval = i;
+  for (;;)
+  {
+    FSF.sprintf( buf, "%s%s%08d.%s", dir, slash, FreeNumber, Opt.EXT );
+    if ( GetFileAttributes(buf) == 0xFFFFFFFF ) break;
+    FreeNumber++;
+  }
 
-    } while (FindNextFile(hff, &fd));
-    FindClose( hff );
+  int num=FreeNumber++;
+  UnlockFreeNumber();
+  return num;
+}
+
+// Creates a message file with a free number in dir, its full name is put
+// to name. The file is created only if it does not exist, so a number taken
+// by another program since the check is skipped and the next one is tried.
+HANDLE CreateFreeFile( char *dir, char *name, DWORD flags )
+{
+  const char *slash=( *dir && dir[lstrlen(dir)-1] != '\\' )?"\\":NULLSTR;
+
+  for ( int k=0; k<FREE_RETRIES; k++ )
+  {
+    FSF.sprintf( name, "%s%s%08d.%s", dir, slash, GetFreeNumber(dir), Opt.EXT );
+    HANDLE fp=CreateFile(name,GENERIC_WRITE,FILE_SHARE_READ,NULL,CREATE_NEW,flags,NULL);
+    if ( fp != INVALID_HANDLE_VALUE )
+      return fp;
+    DWORD err=GetLastError();
+    if ( err != ERROR_FILE_EXISTS && err != ERROR_ALREADY_EXISTS )
+      break;
   }
+  *name=0;
+  return INVALID_HANDLE_VALUE;
+}
 
-  return maxval+1;
+// Collects small writes in out (SAVE_BUFFER_SIZE bytes), data==NULL
+// flushes it. Without a buffer the data is written directly.
+BOOL WriteBuffered(HANDLE fp,char *out,int &outlen,const char *data,int len)
+{
+  DWORD written;
+  if(!out) return !len||(WriteFile(fp,data,len,&written,NULL)&&written==(DWORD)len);
+  if(!data||outlen+len>SAVE_BUFFER_SIZE)
+  {
+    if(outlen&&!(WriteFile(fp,out,outlen,&written,NULL)&&written==(DWORD)outlen)) return FALSE;
+    outlen=0;
+  }
+  if(len>SAVE_BUFFER_SIZE) return WriteFile(fp,data,len,&written,NULL)&&written==(DWORD)len;
+  if(len)
+  {
+    memcpy(out+outlen,data,len);
+    outlen+=len;
+  }
+  return TRUE;
 }
 
 int FARMail::SaveOutgoingMessage( int how, const char *str )
@@ -63,75 +147,67 @@ int FARMail::SaveOutgoingMessage( int how, const char *str )
       char SaveDirParsed[MAX_PATH];
       FSF.ExpandEnvironmentStr(Opt.SaveDir,SaveDirParsed,MAX_PATH);
 
-      int num=GetFreeNumber(SaveDirParsed);
+      ResetFreeNumber();
       savefp=INVALID_HANDLE_VALUE;
       tempfp=INVALID_HANDLE_VALUE;
-      if ( num > 0 )
+      z_free(savebuf);
+      savebuf=(char *)z_malloc(SAVE_BUFFER_SIZE);
+      savebuf_len=0;
+      if (Opt.SaveMessageID && FSF.MkTemp(tempfp_name,"FARMail"))
       {
-        if ( *SaveDirParsed && SaveDirParsed[lstrlen(SaveDirParsed)-1] != '\\' )
-          FSF.sprintf( savefp_name, "%s\\%08d.%s", SaveDirParsed, num, Opt.EXT );
-        else
-          FSF.sprintf( savefp_name, "%s%08d.%s", SaveDirParsed, num, Opt.EXT );
-        if (Opt.SaveMessageID && FSF.MkTemp(tempfp_name,"FARMail"))
-        {
-          tempfp=CreateFile(tempfp_name,GENERIC_READ|GENERIC_WRITE,FILE_SHARE_READ,NULL,CREATE_ALWAYS,FILE_ATTRIBUTE_ARCHIVE|FILE_FLAG_SEQUENTIAL_SCAN,NULL);
-        }
-        if (Opt.UseOutbox && *(Opt.PathToOutbox))
-        {
-          char PathToOutboxParsed[MAX_PATH];
-          FSF.ExpandEnvironmentStr(Opt.PathToOutbox,PathToOutboxParsed,MAX_PATH);
-          savefp=CreateFile(PathToOutboxParsed,GENERIC_WRITE,FILE_SHARE_READ,NULL,OPEN_ALWAYS,FILE_ATTRIBUTE_ARCHIVE|FILE_FLAG_SEQUENTIAL_SCAN,NULL);
-          if(savefp!=INVALID_HANDLE_VALUE)
-            if(SetFilePointer(savefp,0,NULL,FILE_END)==INVALID_SET_FILE_POINTER)
-            {
-              CloseHandle(savefp);
-              savefp=INVALID_HANDLE_VALUE;
-            }
-          if(savefp!=INVALID_HANDLE_VALUE)
+        tempfp=CreateFile(tempfp_name,GENERIC_READ|GENERIC_WRITE,FILE_SHARE_READ,NULL,CREATE_ALWAYS,FILE_ATTRIBUTE_ARCHIVE|FILE_FLAG_SEQUENTIAL_SCAN,NULL);
+      }
+      if (Opt.UseOutbox && *(Opt.PathToOutbox))
+      {
+        char PathToOutboxParsed[MAX_PATH];
+        FSF.ExpandEnvironmentStr(Opt.PathToOutbox,PathToOutboxParsed,MAX_PATH);
+        savefp=CreateFile(PathToOutboxParsed,GENERIC_WRITE,FILE_SHARE_READ,NULL,OPEN_ALWAYS,FILE_ATTRIBUTE_ARCHIVE|FILE_FLAG_SEQUENTIAL_SCAN,NULL);
+        if(savefp!=INVALID_HANDLE_VALUE)
+          if(SetFilePointer(savefp,0,NULL,FILE_END)==INVALID_SET_FILE_POINTER)
           {
-            char head[1024];
-            FSF.sprintf(head,"From  %s\r\n",GetDateInSMTP());
-            WriteFile(savefp,head,lstrlen(head),&transferred,NULL);
+            CloseHandle(savefp);
+            savefp=INVALID_HANDLE_VALUE;
           }
-        }
-        else
+        if(savefp!=INVALID_HANDLE_VALUE)
         {
-          savefp=CreateFile(savefp_name,GENERIC_WRITE,FILE_SHARE_READ,NULL,CREATE_ALWAYS,FILE_ATTRIBUTE_ARCHIVE|FILE_FLAG_SEQUENTIAL_SCAN,NULL);
-          if(savefp!=INVALID_HANDLE_VALUE)
-          {
-            char head[1024];
-            FSF.sprintf(head,"From  %s\r\n",GetDateInSMTP());
-            WriteFile(savefp,head,lstrlen(head),&transferred,NULL);
-          }
+          char head[1024];
+          FSF.sprintf(head,"From  %s\r\n",GetDateInSMTP());
+          WriteFile(savefp,head,lstrlen(head),&transferred,NULL);
         }
       }
-      break;
-    }
-    case SAVE_STR:
-      if(tempfp!=INVALID_HANDLE_VALUE)
+      else
       {
-        if(str[0]=='.'&&str[1]=='.')
-          WriteFile(tempfp,str+1,lstrlen(str+1),&transferred,NULL);
-        else if(str[0]!='.')
+        savefp=CreateFreeFile(SaveDirParsed,savefp_name,FILE_ATTRIBUTE_ARCHIVE|FILE_FLAG_SEQUENTIAL_SCAN);
+        if(savefp!=INVALID_HANDLE_VALUE)
         {
-          if ((Opt.UseOutbox && *(Opt.PathToOutbox)) && !strncmp(str,"From ",5))
-            WriteFile(tempfp,">",1,&transferred,NULL);
-          WriteFile(tempfp,str,lstrlen(str),&transferred,NULL);
+          char head[1024];
+          FSF.sprintf(head,"From  %s\r\n",GetDateInSMTP());
+          WriteFile(savefp,head,lstrlen(head),&transferred,NULL);
         }
       }
-      else if(savefp!=INVALID_HANDLE_VALUE)
+      break;
+    }
+    case SAVE_STR:
+    {
+      HANDLE fp=(tempfp!=INVALID_HANDLE_VALUE)?tempfp:savefp;
+      if(fp!=INVALID_HANDLE_VALUE)
       {
         if(str[0]=='.'&&str[1]=='.')
-          WriteFile(savefp,str+1,lstrlen(str+1),&transferred,NULL);
+          WriteBuffered(fp,savebuf,savebuf_len,str+1,lstrlen(str+1));
         else if(str[0]!='.')
         {
           if ((Opt.UseOutbox && *(Opt.PathToOutbox)) && !strncmp(str,"From ",5))
-            WriteFile(savefp,">",1,&transferred,NULL);
-          WriteFile(savefp,str,lstrlen(str),&transferred,NULL);
+            WriteBuffered(fp,savebuf,savebuf_len,">",1);
+          WriteBuffered(fp,savebuf,savebuf_len,str,lstrlen(str));
         }
       }
       break;
+    }
     case SAVE_CLOSE:
+      if(tempfp!=INVALID_HANDLE_VALUE)
+        WriteBuffered(tempfp,savebuf,savebuf_len,NULL,0);
+      else if(savefp!=INVALID_HANDLE_VALUE)
+        WriteBuffered(savefp,savebuf,savebuf_len,NULL,0);
       if((tempfp!=INVALID_HANDLE_VALUE)&&(savefp!=INVALID_HANDLE_VALUE))
       {
         WriteFile(savefp,"Message-ID: <",13,&transferred,NULL);
@@ -156,6 +232,8 @@ int FARMail::SaveOutgoingMessage( int how, const char *str )
       tempfp=INVALID_HANDLE_VALUE;
       *tempfp_name=0;
       *savefp_name=0;
+      z_free(savebuf);
+      savebuf=NULL;
       break;
     case SAVE_KILL:
       if(tempfp!=INVALID_HANDLE_VALUE)
@@ -173,6 +251,8 @@ int FARMail::SaveOutgoingMessage( int how, const char *str )
       savefp=INVALID_HANDLE_VALUE;
       *tempfp_name=0;
       *savefp_name=0;
+      z_free(savebuf);
+      savebuf=NULL;
       break;
   }
   return 0;
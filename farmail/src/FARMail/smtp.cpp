@@ -93,6 +93,22 @@ BOOL SMTP::AuthPlain( char *user, char *pwd )
 
 
 
+// buf is an uppercased EHLO response
+static BOOL HasExtension( const char *buf, const char *ext )
+{
+ int len = lstrlen( ext );
+
+ while ( buf[0] && buf[1] && buf[2] && buf[3] ) {
+    if ( !strncmp( buf+4, ext, len ) && ( buf[4+len] == '\r' || buf[4+len] == '\n' || buf[4+len] == ' ' || !buf[4+len] ) )
+       return TRUE;
+    buf = strchr( buf, '\n' );
+    if ( !buf ) break;
+    buf++;
+ }
+ return FALSE;
+}
+
+
 int SMTP::SetAuthAlgorithms( char *buf)
 {
  char *ptr = buf;
@@ -135,6 +151,10 @@ SMTP::SMTP( BOOL _log , char *file )
  }
  connected = 0;
  *Auth=0;
+ Pipelining = Chunking = FALSE;
+ InPos = InLen = OutLen = 0;
+ PHead = PCount = 0;
+ Failed = FALSE;
  AddLog("Starting SMTP session..\n");
  lstrcpy( ErrMessage , ::GetMsg(MesErrorBreak) );
  *message_id = 0;
@@ -204,6 +224,7 @@ BOOL SMTP::IsError( char *buf , int response )
        return TRUE;
 
     case SMTP_MAIL_CHECK:
+    case SMTP_BDAT_CHECK:
        // 250 - ok 500, 501, 421 - err 552,451,452-fail
        if ( err == 250 ) return FALSE;
        lstrcpy( ErrMessage , GetSMTPError( err ) );
@@ -281,38 +302,18 @@ int SMTP::AddLog( const char *s )
 BOOL SMTP::CheckResponse(int ResponseType)
 {
    char  *buf = (char*)z_calloc( 1, 32000 );
-   char buf2[ BUFFER_SIZE ];
-   int n;
+   int n, len = 0;
    BOOL stat;
 
    if ( !buf ) return FALSE;
 
+   // only this response is taken, pipelined ones stay in InBuf
    do {
-
-      memset( buf2, 0, sizeof(buf2) );
-
-      n = wsocket.Receive(buf2, sizeof(buf2)-1, Opt.Timeout*1000 );
-
-      if ( n>0 ) {
-
-         char *ptr = buf, *ptr_old = buf;
-
-         lstrcat ( buf , buf2 );
-
-         do {
-            if ( strstr( ptr, CRLF ) ) {
-               ptr_old = ptr;
-               ptr = strstr( ptr, CRLF )+2;
-            } else break;
-         } while(1);
-
-         if ( ptr > buf ) {
-
-            if ( * ( ptr_old+3 )  ==  ' ' ) break;
-
-         }
-
-      }  else break;
+      char *line = buf + len;
+      n = RecvLine( line, 32000 - len );
+      if ( n <= 0 ) break;
+      len += n;
+      if ( n < 4 || line[3] != '-' ) break;
    } while(1);
 
    if ( n == SOCKET_ERROR ) {
@@ -335,6 +336,7 @@ BOOL SMTP::CheckResponse(int ResponseType)
       case SMTP_AUTH_CHECK:
       case SMTP_LOGIN_CHECK1:
       case SMTP_LOGIN_CHECK2:
+      case SMTP_BDAT_CHECK:
 
          AddLog( buf );
          stat = ! ( IsError( buf , ResponseType ) );
@@ -345,9 +347,13 @@ BOOL SMTP::CheckResponse(int ResponseType)
          AddLog( buf );
          if ( FSF.atoi(buf) != 250 ) {
             lstrcpy( ErrMessage , GetSMTPError( FSF.atoi(buf) ) );
+            z_free(buf);
             return FALSE;
          }
          SetAuthAlgorithms(buf);
+         Pipelining = HasExtension( buf, "PIPELINING" );
+         Chunking = HasExtension( buf, "CHUNKING" );
+         z_free(buf);
          return TRUE;
 
      case SMTP_DATA2_CHECK:
@@ -395,16 +401,27 @@ BOOL SMTP::Connect( char * Host, int port)
          return FALSE;
       }
 
-      FSF.sprintf (buf, "HELO %s\r\n", local );
+      // EHLO tells about PIPELINING and CHUNKING, old servers only know HELO
+      FSF.sprintf (buf, "EHLO %s\r\n", local );
       AddLog( buf );
       if ( wsocket.Send( buf, lstrlen (buf) , Opt.Timeout*1000 ) < 0 /*!= lstrlen (buf)*/ ) {
          delete sm;
          return FALSE;
       }
 
-      if(CheckResponse(SMTP_HELLO_CHECK)==FALSE) {
-         delete sm;
-         return FALSE;
+      if(CheckResponse(SMTP_EHLO_CHECK)==FALSE) {
+
+         FSF.sprintf (buf, "HELO %s\r\n", local );
+         AddLog( buf );
+         if ( wsocket.Send( buf, lstrlen (buf) , Opt.Timeout*1000 ) < 0 /*!= lstrlen (buf)*/ ) {
+            delete sm;
+            return FALSE;
+         }
+
+         if(CheckResponse(SMTP_HELLO_CHECK)==FALSE) {
+            delete sm;
+            return FALSE;
+         }
       }
 
       connected = 1;
@@ -510,9 +527,12 @@ BOOL SMTP::Mail( char *from )
 
    if ( !connected ) return TRUE;
 
+   Failed = FALSE;
+   FSF.sprintf (buf, "MAIL FROM:<%s>\r\n", from );
+   if ( Pipelining ) return Queue( buf, SMTP_MAIL_CHECK );
+
    ShortMessage *sm = new ShortMessage( MsgMailSMTP );
 
-   FSF.sprintf (buf, "MAIL FROM:<%s>\r\n", from );
    AddLog( buf );
    if ( wsocket.Send(buf, lstrlen (buf), Opt.Timeout*1000 ) < 0 /*!= lstrlen (buf)*/ ) {
       delete sm;
@@ -534,9 +554,11 @@ BOOL SMTP::Receipt( char *rcp )
 
    if ( !connected ) return TRUE;
 
+   FSF.sprintf (buf, "RCPT TO:<%s>\r\n", rcp );
+   if ( Pipelining ) return Queue( buf, SMTP_RCPT_CHECK );
+
    ShortMessage *sm = new ShortMessage( MsgRcptSMTP );
 
-   FSF.sprintf (buf, "RCPT TO:<%s>\r\n", rcp );
    AddLog( buf );
    if ( wsocket.Send(buf, lstrlen (buf), Opt.Timeout*1000 ) < 0 /*!= lstrlen (buf)*/ ) {
       delete sm;
@@ -558,7 +580,33 @@ BOOL SMTP::Data()
 
    if ( !connected ) return TRUE;
 
+   // with BDAT the message goes right after the envelope
+   if ( Chunking ) return ReadPending( -1 );
+
    FSF.sprintf (buf, "DATA\r\n" );
+   if ( Pipelining ) {
+      if ( !Queue( buf, SMTP_DATA_CHECK ) ) return FALSE;
+      // responses to MAIL and RCPT, DATA is checked below
+      PCount--;
+      if ( !ReadPending( -1 ) ) {
+         char err[BUFFER_SIZE];
+         lstrcpy( err, ErrMessage );
+         // DATA accepted in spite of the failure must be ended with a
+         // single dot (RFC 2920), the session is over after that
+         if ( CheckResponse(SMTP_DATA_CHECK) ) {
+            AddLog( ".\r\n" );
+            if ( wsocket.Send( ".\r\n", 3, Opt.Timeout*1000 ) >= 0 )
+               CheckResponse(SMTP_DATA2_CHECK);
+            Disconnect();
+            wsocket.ShutdownConnection();
+            connected = 0;
+         }
+         lstrcpy( ErrMessage, err );
+         return FALSE;
+      }
+      return CheckResponse(SMTP_DATA_CHECK);
+   }
+
    AddLog( buf );
    if ( wsocket.Send(buf, lstrlen (buf), Opt.Timeout*1000 ) < 0 /*!= lstrlen (buf)*/ ) {
       return FALSE;
@@ -571,19 +619,160 @@ BOOL SMTP::Data()
 
 
 
+// Message data is collected in OutBuf and goes out in SAVE_BUFFER_SIZE
+// blocks, either as is after DATA or as BDAT chunks. line may hold many
+// lines, then they are not to start with a dot. check marks the final
+// ".\r\n" line.
 BOOL SMTP::DataLine( const char *line , int check )
 {
    if ( !connected ) return TRUE;
 
-   AddLog( line );
-   if ( ( wsocket.Send( line, lstrlen (line), Opt.Timeout*1000 ) ) < 0 /*!= lstrlen (line)*/ ) {
+   if ( Chunking ) {
+      if ( check ) {
+         if ( Failed ) return ReadPending( -1 );
+         LogOut();
+         return SendChunk( TRUE );
+      }
+      if ( Failed ) return FALSE;
+      // BDAT data is not dot-stuffed
+      if ( line[0] == '.' && line[1] == '.' ) line++;
+   }
+
+   int len = lstrlen( line );
+   while ( len > 0 ) {
+      int n = SAVE_BUFFER_SIZE - OutLen;
+      if ( n > len ) n = len;
+      memcpy( OutBuf + SMTP_CHUNK_HEAD + OutLen, line, n );
+      OutLen += n;
+      line += n;
+      len -= n;
+      if ( OutLen == SAVE_BUFFER_SIZE ) {
+         LogOut();
+         if ( !( Chunking ? SendChunk( FALSE ) : SendOut() ) ) return FALSE;
+      }
+   }
+
+   if ( check ) {
+      LogOut();
+      if ( !SendOut() ) return FALSE;
+      return CheckResponse(SMTP_DATA2_CHECK);
+   }
+   return TRUE;
+}
+
+
+// Reads one response line with its CRLF into buf, cut to size-1 chars.
+// Returns the number of chars stored or the Receive() result if the
+// connection is over.
+int SMTP::RecvLine( char *buf, int size )
+{
+   int len = 0;
+
+   for (;;) {
+      if ( InPos >= InLen ) {
+         InPos = InLen = 0;
+         int n = wsocket.Receive( InBuf, sizeof(InBuf), Opt.Timeout*1000 );
+         if ( n <= 0 ) {
+            buf[len] = 0;
+            return len ? len : n;
+         }
+         InLen = n;
+      }
+      char c = InBuf[InPos++];
+      if ( len < size-1 ) buf[len++] = c ? c : ' ';
+      if ( c == '\n' ) break;
+   }
+   buf[len] = 0;
+   return len;
+}
+
+
+// Message data goes to the log by blocks as it is sent.
+void SMTP::LogOut( void )
+{
+   if ( OutLen && log && fplog != INVALID_HANDLE_VALUE ) {
+      OutBuf[ SMTP_CHUNK_HEAD + OutLen ] = 0;
+      AddLog( OutBuf + SMTP_CHUNK_HEAD );
+   }
+}
+
+
+BOOL SMTP::SendOut( void )
+{
+   int len = OutLen;
+
+   OutLen = 0;
+   if ( len && wsocket.Send( OutBuf + SMTP_CHUNK_HEAD, len, Opt.Timeout*1000 ) < 0 ) {
+      Failed = TRUE;
+      PCount = 0;
       return FALSE;
    }
+   return TRUE;
+}
+
+
+// Puts a command into OutBuf without waiting for its response (RFC 2920).
+BOOL SMTP::Queue( const char *cmd, int ResponseType )
+{
+   int len = lstrlen( cmd );
+
+   AddLog( cmd );
+   if ( OutLen + len > SAVE_BUFFER_SIZE && !SendOut() ) return FALSE;
+   if ( PCount == SMTP_WINDOW ) ReadPending( 1 );
+   memcpy( OutBuf + SMTP_CHUNK_HEAD + OutLen, cmd, len );
+   OutLen += len;
+   Pending[ ( PHead + PCount ) % SMTP_WINDOW ] = ResponseType;
+   PCount++;
+   return TRUE;
+}
+
 
-   if (check && CheckResponse(SMTP_DATA2_CHECK)==FALSE )
+// Sends what is buffered and reads count queued responses, all of them
+// if count is -1. The first failure of the transaction stays in ErrMessage.
+BOOL SMTP::ReadPending( int count )
+{
+   char err[BUFFER_SIZE];
+   BOOL WasFailed = Failed;
+
+   if ( !SendOut() ) return FALSE;
+   if ( count < 0 || count > PCount ) count = PCount;
+   while ( count-- ) {
+      int type = Pending[PHead];
+      PHead = ( PHead + 1 ) % SMTP_WINDOW;
+      PCount--;
+      if ( !CheckResponse( type ) && !Failed ) {
+         Failed = TRUE;
+         lstrcpy( err, ErrMessage );
+      }
+   }
+   if ( Failed && !WasFailed ) lstrcpy( ErrMessage, err );
+   return !Failed;
+}
+
+
+// Sends OutBuf as one BDAT chunk (RFC 3030). Without PIPELINING every
+// chunk waits for its response, otherwise up to SMTP_WINDOW are in flight.
+BOOL SMTP::SendChunk( BOOL last )
+{
+   char head[SMTP_CHUNK_HEAD];
+   int hlen = FSF.sprintf( head, "BDAT %d%s\r\n", OutLen, last ? " LAST" : NULLSTR );
+
+   AddLog( head );
+   char *ptr = OutBuf + SMTP_CHUNK_HEAD - hlen;
+   memcpy( ptr, head, hlen );
+   int len = hlen + OutLen;
+   OutLen = 0;
+   if ( wsocket.Send( ptr, len, Opt.Timeout*1000 ) < 0 ) {
+      Failed = TRUE;
+      PCount = 0;
       return FALSE;
-   else
-      return TRUE;
+   }
+   if ( PCount == SMTP_WINDOW ) ReadPending( 1 );
+   Pending[ ( PHead + PCount ) % SMTP_WINDOW ] = last ? SMTP_DATA2_CHECK : SMTP_BDAT_CHECK;
+   PCount++;
+   if ( last ) return ReadPending( -1 );
+   if ( !Pipelining ) return ReadPending( 1 );
+   return !Failed;
 }
 
 
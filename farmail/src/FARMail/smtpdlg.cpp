@@ -410,28 +410,31 @@ void FARMail::SendBody(HANDLE fp,MAILSEND *parm,SMTP *smtp,const char *filename,
           SendHeaderLine("Content-Disposition: attachment;", bbuf, parm->encode );
         }
      }
+     // many lines are encoded at once and sent as one block
+     char in[BASE64_BLOCK], out[( BASE64_BLOCK / BASE64_LINE + 1 ) * 78 + 1];
+
      do {
 
         if(fp!=INVALID_HANDLE_VALUE)
         {
           DWORD transferred;
-          if(!ReadFile(fp,buf,19*3,&transferred,NULL)) z=0;
+          if(!ReadFile(fp,in,BASE64_BLOCK,&transferred,NULL)) z=0;
           else z=transferred;
         }
         else
-          z = ReadBlock( buf, 19*3 );
+          z = ReadBlock( in, BASE64_BLOCK );
 
         if ( parm->how == 2 || parm->how == 5 ) {
-          TranscodeStr8Ext( buf, 19*3, parm->charset, parm->encode );
+          TranscodeStr8Ext( in, z, parm->charset, parm->encode );
         }
         curr += z;
         p->UseProgress(curr);
-        EncodeBase64 ( buf2, buf , z );
-        lstrcat( buf2, CRLF );
-        if (!smtp->DataLine( buf2 , 0 )) break;
-        SaveOutgoingMessage( SAVE_STR, buf2 );
+        if ( !z ) break;
+        EncodeBase64Lines ( out, in , z );
+        if (!smtp->DataLine( out , 0 )) break;
+        SaveOutgoingMessage( SAVE_STR, out );
 
-     } while ( z == 19*3 );
+     } while ( z == BASE64_BLOCK );
 
   }
   delete p;
@@ -0,0 +1,72 @@
+/*
+    FARMail plugin for FAR Manager
+    Copyright (C) 2002-2004 FARMail Group
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+
+    Benchmark of base64 coding: MB/s of encoding random data and of
+    decoding it back from lines of 76 characters, as attachments come.
+    Size in MB is the argument, 64 by default.
+*/
+
+#include "farmail.hpp"
+#include "base64.cpp"
+#include "test/farstub.cpp"
+#include <time.h>
+
+#define LINE 57 // bytes of a 76 characters line
+
+static double Now()
+{
+  timespec ts;
+  clock_gettime(CLOCK_MONOTONIC,&ts);
+  return ts.tv_sec+ts.tv_nsec/1e9;
+}
+
+int main(int argc,char *argv[])
+{
+  InitFar();
+  int mb=argc>1?atoi(argv[1]):64;
+  int size=mb*1024*1024/LINE*LINE;
+  char *src=(char*)malloc(size);
+  char *enc=(char*)malloc(size/LINE*(76+2)+1);
+  char *dec=(char*)malloc(size+1);
+  srand(1);
+  for(int i=0;i<size;i++) src[i]=(char)rand();
+
+  double start=Now();
+  char *p=enc;
+  for(int i=0;i<size;i+=LINE)
+  {
+    p+=EncodeBase64(p,src+i,LINE);
+    *p++='\r';
+    *p++='\n';
+  }
+  double enctime=Now()-start;
+
+  start=Now();
+  int n=DecodeBase64(dec,enc,p-enc);
+  double dectime=Now()-start;
+
+  Check(n==size&&!memcmp(src,dec,size),"data goes round");
+  printf("base64bench: %d MB, encode %.0f MB/s, decode %.0f MB/s\n",
+         mb,size/1048576.0/enctime,size/1048576.0/dectime);
+  free(src);
+  free(enc);
+  free(dec);
+  printf("base64bench: %d failed\n",failed);
+  return failed!=0;
+}
@@ -0,0 +1,119 @@
+/*
+    FARMail plugin for FAR Manager
+    Copyright (C) 2002-2004 FARMail Group
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+
+    Test of base64 coding: test vectors of RFC 4648, line breaks,
+    whitespace and other foreign characters in encoded text, missing
+    padding and concatenated encodings, round trip of random data,
+    encoding in lines at once as attachments are sent.
+*/
+
+#include "farmail.hpp"
+#include "base64.cpp"
+#include "test/farstub.cpp"
+
+static const char *Vectors[][2]=
+{
+  {"",""},
+  {"f","Zg=="},
+  {"fo","Zm8="},
+  {"foo","Zm9v"},
+  {"foob","Zm9vYg=="},
+  {"fooba","Zm9vYmE="},
+  {"foobar","Zm9vYmFy"},
+};
+
+static void CheckDecode(const char *in,const char *out,int outlen,const char *what)
+{
+  char buf[256];
+  memset(buf,'#',sizeof(buf));
+  int n=DecodeBase64(buf,(char*)in,lstrlen(in));
+  Check(n==outlen&&!memcmp(buf,out,n)&&!buf[n],what);
+}
+
+static void TestVectors(void)
+{
+  char buf[64],what[64];
+  for(size_t i=0;i<sizeof(Vectors)/sizeof(Vectors[0]);i++)
+  {
+    int n=EncodeBase64(buf,(char*)Vectors[i][0],lstrlen(Vectors[i][0]));
+    sprintf(what,"\"%s\" is encoded",Vectors[i][0]);
+    Check(n==lstrlen(Vectors[i][1])&&!strcmp(buf,Vectors[i][1]),what);
+    sprintf(what,"\"%s\" is decoded",Vectors[i][1]);
+    CheckDecode(Vectors[i][1],Vectors[i][0],lstrlen(Vectors[i][0]),what);
+  }
+}
+
+static void TestForeign(void)
+{
+  CheckDecode("Zm9v\r\nYmFy\r\n","foobar",6,"line breaks are skipped");
+  CheckDecode(" Zm 9v\tYm\tFy ","foobar",6,"whitespace is skipped");
+  CheckDecode("Zm9v!Ym*Fy\x80\xff","foobar",6,"foreign characters are skipped");
+  CheckDecode("Zm9vYg","foob",4,"missing padding is tolerated");
+  CheckDecode("Zm9vYmE","fooba",5,"missing single padding is tolerated");
+  CheckDecode("Zg==Zm8=Zm9v","ffofoo",6,"concatenated encodings are decoded");
+  CheckDecode("Zm9vY","foo",3,"lone character at the end is dropped");
+  CheckDecode("====","",0,"padding alone gives nothing");
+}
+
+static void TestRoundTrip(void)
+{
+  static char src[1024],enc[1500],dec[1100],lines[2000],lines2[2000];
+  srand(1);
+  for(int len=0;len<(int)sizeof(src);len++)
+  {
+    for(int i=0;i<len;i++) src[i]=(char)rand();
+    int n=EncodeBase64(enc,src,len);
+    if(n!=(len+2)/3*4||DecodeBase64(dec,enc,n)!=len||memcmp(src,dec,len))
+    {
+      Check(false,"random data goes round");
+      return;
+    }
+    // as in a message: lines of 76 characters
+    char *p=lines;
+    for(int i=0;i<n;i+=76)
+    {
+      int m=n-i<76?n-i:76;
+      memcpy(p,enc+i,m);
+      p+=m;
+      *p++='\r';
+      *p++='\n';
+    }
+    if(DecodeBase64(dec,lines,p-lines)!=len||memcmp(src,dec,len))
+    {
+      Check(false,"random data in lines goes round");
+      return;
+    }
+    *p=0;
+    if(EncodeBase64Lines(lines2,src,len)!=p-lines||strcmp(lines,lines2))
+    {
+      Check(false,"data is encoded in lines at once");
+      return;
+    }
+  }
+}
+
+int main(int argc,char *argv[])
+{
+  InitFar();
+  TestVectors();
+  TestForeign();
+  TestRoundTrip();
+  printf("base64test: %d failed\n",failed);
+  return failed!=0;
+}
@@ -0,0 +1,209 @@
+/*
+    FARMail plugin for FAR Manager
+    Copyright (C) 2002-2004 FARMail Group
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+
+    Fake mail server of host tests. It listens on 127.0.0.1 and
+    serves given number of connections one after another in its own
+    thread. Commands are read by lines and answered by the test,
+    every line received is appended to Log. If replies can't be
+    sent, Dropped is set and connection is closed. Replies to a command
+    leave Delay ms after the command has arrived, as if the server
+    was that far away: commands sent ahead are not delayed twice.
+*/
+
+#include <netinet/in.h>
+#include <pthread.h>
+#include <stdarg.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <string>
+
+class FakeServer
+{
+  public:
+    int Port;
+    int Delay;
+    std::string Log;
+    BOOL Dropped;   // client has closed connection before reading replies
+
+    FakeServer();
+    virtual ~FakeServer();
+    BOOL Start(int connections=1);
+    void Wait(void);
+  protected:
+    virtual void Greet(void)=0;
+    // returns FALSE to close connection
+    virtual BOOL Command(const char *line)=0;
+    void Reply(const char *fmt,...);
+    void Write(const char *data,int len);
+    BOOL ReadLine(std::string &line);
+    BOOL ReadData(std::string &data,int n);
+  private:
+    int listener,conn,connections;
+    pthread_t thread;
+    BOOL running;
+    char buf[4096];
+    int pos,len;
+    double arrived;
+    static void *Run(void *arg);
+};
+
+static double Now()
+{
+  timespec ts;
+  clock_gettime(CLOCK_MONOTONIC,&ts);
+  return ts.tv_sec+ts.tv_nsec/1e9;
+}
+
+FakeServer::FakeServer()
+{
+  Port=0;
+  Delay=0;
+  Dropped=FALSE;
+  listener=conn=-1;
+  running=FALSE;
+}
+
+FakeServer::~FakeServer()
+{
+  Wait();
+  if(listener!=-1) close(listener);
+}
+
+BOOL FakeServer::Start(int n)
+{
+  sockaddr_in sa;
+  socklen_t salen=sizeof(sa);
+  listener=socket(AF_INET,SOCK_STREAM,0);
+  memset(&sa,0,sizeof(sa));
+  sa.sin_family=AF_INET;
+  sa.sin_addr.s_addr=htonl(INADDR_LOOPBACK);
+  if(listener==-1||bind(listener,(sockaddr*)&sa,sizeof(sa))||listen(listener,n)||
+     getsockname(listener,(sockaddr*)&sa,&salen))
+    return FALSE;
+  Port=ntohs(sa.sin_port);
+  connections=n;
+  running=pthread_create(&thread,NULL,Run,this)==0;
+  return running;
+}
+
+void FakeServer::Wait(void)
+{
+  if(running) pthread_join(thread,NULL);
+  running=FALSE;
+}
+
+void *FakeServer::Run(void *arg)
+{
+  FakeServer *s=(FakeServer*)arg;
+  for(int i=0;i<s->connections;i++)
+  {
+    s->conn=accept(s->listener,NULL,NULL);
+    if(s->conn==-1) break;
+    s->pos=s->len=0;
+    s->arrived=Now();
+    s->Greet();
+    std::string line;
+    while(s->ReadLine(line))
+    {
+      s->Log+=line;
+      s->Log+='\n';
+      if(!s->Command(line.c_str())||s->Dropped) break;
+    }
+    close(s->conn);
+  }
+  return NULL;
+}
+
+// line without CRLF, arrival time of the data it came with is kept
+BOOL FakeServer::ReadLine(std::string &line)
+{
+  line.clear();
+  for(;;)
+  {
+    if(pos==len)
+    {
+      len=recv(conn,buf,sizeof(buf),0);
+      pos=0;
+      if(len<=0)
+      {
+        len=0;
+        return FALSE;
+      }
+      arrived=Now();
+    }
+    char c=buf[pos++];
+    if(c=='\n') break;
+    line+=c;
+  }
+  if(!line.empty()&&line[line.size()-1]=='\r') line.erase(line.size()-1);
+  return TRUE;
+}
+
+// n bytes as they are, for commands followed by data
+BOOL FakeServer::ReadData(std::string &data,int n)
+{
+  data.clear();
+  while((int)data.size()<n)
+  {
+    if(pos==len)
+    {
+      len=recv(conn,buf,sizeof(buf),0);
+      pos=0;
+      if(len<=0)
+      {
+        len=0;
+        return FALSE;
+      }
+      arrived=Now();
+    }
+    int m=len-pos;
+    if(m>n-(int)data.size()) m=n-data.size();
+    data.append(buf+pos,m);
+    pos+=m;
+  }
+  return TRUE;
+}
+
+void FakeServer::Write(const char *data,int n)
+{
+  double wait=arrived+Delay/1000.0-Now();
+  if(wait>0) usleep((useconds_t)(wait*1e6));
+  while(n>0)
+  {
+    int m=send(conn,data,n,MSG_NOSIGNAL);
+    if(m<=0)
+    {
+      Dropped=TRUE;
+      break;
+    }
+    data+=m;
+    n-=m;
+  }
+}
+
+void FakeServer::Reply(const char *fmt,...)
+{
+  char line[1024];
+  va_list args;
+  va_start(args,fmt);
+  int n=vsnprintf(line,sizeof(line)-2,fmt,args);
+  va_end(args);
+  lstrcpy(line+n,"\r\n");
+  Write(line,n+2);
+}
@@ -0,0 +1,211 @@
+/*
+    FARMail plugin for FAR Manager
+    Copyright (C) 2002-2004 FARMail Group
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+
+    FAR side of the plugin for host tests: standard functions are
+    implemented by C runtime, messages are their numbers, progress
+    and message windows are not shown. Included by tests after the
+    sources under test, InitFar() is to be called first.
+*/
+
+#include <malloc.h>
+#include <stdarg.h>
+#include "progress.hpp"
+
+struct PluginStartupInfo _Info;
+FARSTANDARDFUNCTIONS FSF;
+Options Opt;
+
+const char CRLF[] = "\r\n";
+const char NULLSTR[] = "";
+const char ASTERISK[] = "*";
+const char BACKSLASH[] = "\\";
+
+static int failed;
+
+static void Check(bool ok,const char* what)
+{
+  if(ok)return;
+  printf("FAIL: %s\n",what);
+  failed++;
+}
+
+// message number is printed, so failures can be told apart
+const char *GetMsg(int MsgId)
+{
+  static char msgs[1024][16];
+  if(MsgId<0||MsgId>=1024) return "message";
+  if(!*msgs[MsgId]) sprintf(msgs[MsgId],"message %d",MsgId);
+  return msgs[MsgId];
+}
+
+int SayError(const char *s)
+{
+  printf("error: %s\n",s);
+  return 0;
+}
+
+// zeroed as HeapReAlloc with HEAP_ZERO_MEMORY does
+void *z_calloc(size_t nitems,size_t size)
+{
+  return calloc(nitems,size);
+}
+
+void *z_malloc(size_t size)
+{
+  return calloc(1,size);
+}
+
+void *z_realloc(void *block,size_t size)
+{
+  if(!size)
+  {
+    free(block);
+    return NULL;
+  }
+  size_t old=block?malloc_usable_size(block):0;
+  char *res=(char*)realloc(block,size);
+  size_t now=malloc_usable_size(res);
+  if(res&&now>old) memset(res+old,0,now-old);
+  return res;
+}
+
+void z_free(void *block)
+{
+  free(block);
+}
+
+char *z_strdup(const char *block)
+{
+  return strdup(block);
+}
+
+ShortMessage::ShortMessage(int num)
+{
+}
+
+ShortMessage::~ShortMessage()
+{
+}
+
+Progress::Progress(long total,const char *s,long totalshow)
+{
+}
+
+Progress::~Progress()
+{
+}
+
+int Progress::UseProgress(long cur,long curshow)
+{
+  return 0;
+}
+
+Bar::Bar(long total,const char *s,int len)
+{
+}
+
+Bar::~Bar()
+{
+}
+
+int Bar::UseBar(long current)
+{
+  return 0;
+}
+
+void InitDialogItems(struct InitDialogItem *Init,struct FarDialogItem *Item,int ItemsNumber)
+{
+}
+
+static int WINAPIV FarSprintf(char *buf,const char *fmt,...)
+{
+  va_list args;
+  va_start(args,fmt);
+  int res=vsprintf(buf,fmt,args);
+  va_end(args);
+  return res;
+}
+
+static int WINAPIV FarSscanf(const char *buf,const char *fmt,...)
+{
+  va_list args;
+  va_start(args,fmt);
+  int res=vsscanf(buf,fmt,args);
+  va_end(args);
+  return res;
+}
+
+static int WINAPI FarAtoi(const char *s)
+{
+  return atoi(s);
+}
+
+static int WINAPI FarStricmp(const char *s1,const char *s2)
+{
+  return strcasecmp(s1,s2);
+}
+
+static int WINAPI FarStrnicmp(const char *s1,const char *s2,int n)
+{
+  return strncasecmp(s1,s2,n);
+}
+
+static void WINAPI FarStrupr(char *s)
+{
+  for(;*s;s++) *s=toupper(*s);
+}
+
+static char *WINAPI FarPointToName(const char *path)
+{
+  const char *name=path;
+  for(;*path;path++)
+    if(*path=='\\'||*path=='/'||*path==':') name=path+1;
+  return (char*)name;
+}
+
+static DWORD WINAPI FarExpandEnvironmentStr(const char *src,char *dest,size_t size)
+{
+  lstrcpyn(dest,src,size);
+  return lstrlen(dest)+1;
+}
+
+static BOOL WINAPI FarAddEndSlash(char *path)
+{
+  int len=lstrlen(path);
+  if(len&&path[len-1]!='\\'&&path[len-1]!='/') lstrcat(path,"\\");
+  return TRUE;
+}
+
+static void InitFar(void)
+{
+  FSF.StructSize=sizeof(FSF);
+  FSF.sprintf=FarSprintf;
+  FSF.sscanf=FarSscanf;
+  FSF.atoi=FarAtoi;
+  FSF.LStricmp=FarStricmp;
+  FSF.LStrnicmp=FarStrnicmp;
+  FSF.LStrupr=FarStrupr;
+  FSF.PointToName=FarPointToName;
+  FSF.ExpandEnvironmentStr=FarExpandEnvironmentStr;
+  FSF.AddEndSlash=FarAddEndSlash;
+  _Info.StructSize=sizeof(_Info);
+  _Info.FSF=&FSF;
+  Opt.Timeout=5;
+  lstrcpy(Opt.EXT,"msg");
+}
@@ -0,0 +1,206 @@
+/*
+    FARMail plugin for FAR Manager
+    Copyright (C) 2002-2004 FARMail Group
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+
+    Test of parallel POP3 download against several fake servers that
+    are Delay ms away: sessions overlap, so the time of download is
+    close to that of one mailbox, not the sum of all. Esc stops all
+    sessions; nothing is deleted from servers then and no temporary
+    file is left. Times are printed, they are not checked strictly.
+*/
+
+#include "farmail.hpp"
+#include "socket2.cpp"
+#include "mailclnt.cpp"
+#include "imapclnt.cpp"
+#include "savefile.cpp"
+#include "fastdownload.cpp"
+#include "test/farstub.cpp"
+#include "test/pop3server.cpp"
+
+#define SERVERS  4
+#define MESSAGES 6
+#define LATENCY  50
+
+static const char *Dest="/tmp/fasttest/";
+
+// the rest of the plugin, not used by POP3 download
+const char XRESUMEDATA[] = "";
+char *GenerateName(int i, char *str) { return str; }
+const char *get_token(const char *, int, int) { return NULL; }
+char *GetDateInSMTP(void) { return (char*)"Thu, 1 Jan 2004 00:00:00 +0000"; }
+void SayException(const char *) {}
+int MessageCache::ClearCachedData(void) { return 0; }
+int FARMail::GetUser(char *, char *) { return 1; }
+
+static int CountFiles(const char *mask)
+{
+  WIN32_FIND_DATA fd;
+  int n=0;
+  HANDLE h=FindFirstFile(mask,&fd);
+  if(h==INVALID_HANDLE_VALUE) return 0;
+  do if(!(fd.dwFileAttributes&FILE_ATTRIBUTE_DIRECTORY)) n++;
+  while(FindNextFile(h,&fd));
+  FindClose(h);
+  return n;
+}
+
+static void Clean(void)
+{
+  char mask[MAX_PATH],name[MAX_PATH];
+  WIN32_FIND_DATA fd;
+  const char *dirs[2]={Dest,"/tmp/fasttest/" FAST_TEMP_DIR};
+  for(int i=0;i<2;i++)
+  {
+    sprintf(mask,"%s*",dirs[i]);
+    HANDLE h=FindFirstFile(mask,&fd);
+    if(h==INVALID_HANDLE_VALUE) continue;
+    do
+    {
+      sprintf(name,"%s%s",dirs[i],fd.cFileName);
+      if(!(fd.dwFileAttributes&FILE_ATTRIBUTE_DIRECTORY)) DeleteFile(name);
+    }
+    while(FindNextFile(h,&fd));
+    FindClose(h);
+  }
+  ResetFreeNumber();
+}
+
+static void FillMailbox(Pop3Server &srv,int count)
+{
+  srv.Messages.clear();
+  for(int i=1;i<=count;i++)
+  {
+    char head[256];
+    sprintf(head,"From: sender%d@example.org\r\nSubject: message %d\r\n\r\n",i,i);
+    std::string msg=head;
+    for(int j=0;j<i*100;j++) msg+="body line of some length to cross receive buffer\r\n";
+    srv.Messages.push_back(msg);
+  }
+}
+
+// sessions of all servers are run in nthreads threads
+static double Download(Pop3Server *srv,POPSERVER *server,FastSession *sessions,FastShared &fs,int nthreads,BOOL *done)
+{
+  memset(sessions,0,SERVERS*sizeof(FastSession));
+  for(int i=0;i<SERVERS;i++)
+  {
+    FillMailbox(srv[i],MESSAGES);
+    srv[i].Start();
+    memset(&server[i],0,sizeof(POPSERVER));
+    sprintf(server[i].Name,"server%d",i+1);
+    lstrcpy(server[i].Url,"127.0.0.1");
+    server[i].Port=srv[i].Port;
+    lstrcpy(server[i]._User,"user");
+    lstrcpy(server[i]._Pass,"pass");
+    sessions[i].Server=&server[i];
+  }
+  fs.Sessions=sessions;
+  fs.Count=SERVERS;
+  fs.Next=fs.Done=fs.Aborted=0;
+  fs.Move=TRUE;
+  fs.UseInbox=FALSE;
+  lstrcpy(fs.Dest,Dest);
+  sprintf(fs.TempDir,"%s%s",Dest,FAST_TEMP_DIR);
+  CreateDirectory(fs.TempDir,NULL);
+  InitializeCriticalSection(&fs.Lock);
+  double start=Now();
+  *done=RunFastSessions(&fs,nthreads);
+  double time=Now()-start;
+  DeleteCriticalSection(&fs.Lock);
+  for(int i=0;i<SERVERS;i++) srv[i].Wait();
+  return time;
+}
+
+static void TestLatency(void)
+{
+  FastShared fs;
+  FastSession sessions[SERVERS];
+  POPSERVER server[SERVERS];
+  double time[2];
+  BOOL done;
+  char what[128];
+  for(int k=0;k<2;k++)
+  {
+    Pop3Server srv[SERVERS];
+    for(int i=0;i<SERVERS;i++) srv[i].Delay=LATENCY;
+    Clean();
+    time[k]=Download(srv,server,sessions,fs,k?SERVERS:1,&done);
+    Check(done,"download is not aborted");
+    sprintf(what,"all messages are saved with %d threads",k?SERVERS:1);
+    Check(CountFiles("/tmp/fasttest/*.msg")==SERVERS*MESSAGES,what);
+    Check(!CountFiles("/tmp/fasttest/" FAST_TEMP_DIR "*"),"no temporary file is left");
+    for(int i=0;i<SERVERS;i++)
+    {
+      sprintf(what,"mailbox %d is emptied",i+1);
+      Check(srv[i].Messages.empty()&&!*sessions[i].Error,what);
+    }
+  }
+  printf("fasttest: %d servers %d ms away, %d messages each: %.2f s one by one, %.2f s at once\n",
+         SERVERS,LATENCY,MESSAGES,time[0],time[1]);
+  Check(time[1]<time[0]/2,"sessions overlap");
+}
+
+static void *PressEsc(void *arg)
+{
+  INPUT_RECORD rec;
+  DWORD n;
+  usleep(*(int*)arg*1000);
+  memset(&rec,0,sizeof(rec));
+  rec.EventType=KEY_EVENT;
+  rec.Event.KeyEvent.bKeyDown=TRUE;
+  rec.Event.KeyEvent.wVirtualKeyCode=VK_ESCAPE;
+  WriteConsoleInput(GetStdHandle(STD_INPUT_HANDLE),&rec,1,&n);
+  return NULL;
+}
+
+static void TestAbort(void)
+{
+  FastShared fs;
+  FastSession sessions[SERVERS];
+  POPSERVER server[SERVERS];
+  Pop3Server srv[SERVERS];
+  pthread_t esc;
+  int after=LATENCY*10;
+  BOOL done;
+  for(int i=0;i<SERVERS;i++) srv[i].Delay=LATENCY*4;
+  Clean();
+  pthread_create(&esc,NULL,PressEsc,&after);
+  double time=Download(srv,server,sessions,fs,SERVERS,&done);
+  pthread_join(esc,NULL);
+  Check(!done,"download is aborted");
+  Check(time<LATENCY*4*MESSAGES/1000.0,"sessions stop at once");
+  Check(CountFiles("/tmp/fasttest/*.msg")<SERVERS*MESSAGES,"download is not completed");
+  Check(!CountFiles("/tmp/fasttest/" FAST_TEMP_DIR "*"),"no temporary file is left");
+  for(int i=0;i<SERVERS;i++)
+    Check(srv[i].Messages.size()==MESSAGES,"nothing is deleted from servers");
+}
+
+int main(int argc,char *argv[])
+{
+  InitFar();
+  WSADATA wsa;
+  WSAStartup(MAKEWORD(1,1),&wsa);
+  CreateDirectory(Dest,NULL);
+  TestLatency();
+  TestAbort();
+  Clean();
+  RemoveDirectory("/tmp/fasttest/" FAST_TEMP_DIR);
+  printf("fasttest: %d failed\n",failed);
+  return failed!=0;
+}
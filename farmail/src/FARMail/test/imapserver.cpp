@@ -0,0 +1,88 @@
+/*
+    FARMail plugin for FAR Manager
+    Copyright (C) 2002-2004 FARMail Group
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+
+    Fake IMAP server: LOGIN is accepted, UID FETCH returns headers of
+    Messages as literals. Lines of FETCH response end with Eol, and
+    before them untagged responses with literals are sent that look
+    like the end of FETCH if they are not skipped.
+*/
+
+#include <vector>
+#include "fakeserver.cpp"
+
+class ImapServer: public FakeServer
+{
+  public:
+    std::vector<std::string> Messages;
+    std::string Eol;
+
+    ImapServer(){Eol="\r\n";}
+  protected:
+    void Greet(void);
+    BOOL Command(const char *line);
+    void Send(const std::string &s){Write(s.data(),s.size());}
+    void Literal(const char *head,const std::string &data);
+};
+
+void ImapServer::Greet(void)
+{
+  Reply("* OK fake IMAP4rev1 server ready");
+}
+
+// untagged response ending with literal, the rest of it follows
+void ImapServer::Literal(const char *head,const std::string &data)
+{
+  char buf[256];
+  sprintf(buf,"%s {%d}",head,(int)data.size());
+  Send(buf+Eol+data);
+}
+
+BOOL ImapServer::Command(const char *line)
+{
+  std::string tag(line,strcspn(line," "));
+  const char *cmd=line+tag.size();
+  while(*cmd==' ') cmd++;
+  if(!strncasecmp(cmd,"LOGIN",5))
+    Reply("%s OK LOGIN completed",tag.c_str());
+  else if(!strncasecmp(cmd,"UID FETCH",9))
+  {
+    std::string fake=tag+" OK FETCH completed\r\n* 99 FETCH (UID 1)\r\n";
+    Literal("* LIST () \"/\"",fake);
+    Send(Eol);
+    Literal("* OK [ALERT]",fake);
+    Send(" more text"+Eol);
+    for(size_t i=0;i<Messages.size();i++)
+    {
+      char head[256];
+      sprintf(head,"* %d FETCH (UID %d RFC822.SIZE %d BODY[HEADER]",
+              (int)i+1,(int)i+101,(int)Messages[i].size()+100);
+      Literal(head,Messages[i]);
+      Send(")"+Eol);
+    }
+    Send(tag+" OK FETCH completed"+Eol);
+  }
+  else if(!strncasecmp(cmd,"LOGOUT",6))
+  {
+    Reply("* BYE");
+    Reply("%s OK LOGOUT completed",tag.c_str());
+    return FALSE;
+  }
+  else Reply("%s BAD unknown command",tag.c_str());
+  return TRUE;
+}
@@ -0,0 +1,91 @@
+/*
+    FARMail plugin for FAR Manager
+    Copyright (C) 2002-2004 FARMail Group
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+
+    Test of IMAP header listing against fake server: headers of all
+    messages come in one UID FETCH response, literals of other
+    untagged responses are skipped whether lines end with CRLF or
+    bare LF.
+*/
+
+#include "farmail.hpp"
+#include "socket2.cpp"
+#include "imapclnt.cpp"
+#include "test/farstub.cpp"
+#include "test/imapserver.cpp"
+
+static void FillMailbox(ImapServer &srv,int count)
+{
+  srv.Messages.clear();
+  for(int i=1;i<=count;i++)
+  {
+    char head[256];
+    sprintf(head,"From: sender%d@example.org\r\nSubject: message %d\r\n",i,i);
+    std::string msg=head;
+    // a header larger than receive buffer
+    if(i==2) msg+="X-Long: "+std::string(RECV_BUFFER_SIZE*2,'x')+"\r\n";
+    msg+="\r\n";
+    srv.Messages.push_back(msg);
+  }
+}
+
+static void TestHeaders(const char *eol)
+{
+  ImapServer srv;
+  char what[128];
+  FillMailbox(srv,5);
+  srv.Eol=eol;
+  Check(srv.Start(),"server is started");
+
+  IMAP *imap=new IMAP(FALSE,NULL,0);
+  Check(!imap->Connect((char*)"127.0.0.1",srv.Port)&&!imap->Login((char*)"user",(char*)"pass"),"mailbox is opened");
+  imap->MessageNumber=srv.Messages.size();
+  Check(!imap->FetchHeaders(),"headers are requested");
+  int n=0;
+  char *header;
+  while((header=imap->NextHeader())!=NULL)
+  {
+    n++;
+    sprintf(what,"header %d is listed in order",n);
+    Check(imap->FetchNum==n,what);
+    if(imap->FetchNum<1||imap->FetchNum>(int)srv.Messages.size()) continue;
+    const std::string &msg=srv.Messages[imap->FetchNum-1];
+    char uid[24];
+    sprintf(uid,"%d",imap->FetchNum+100);
+    sprintf(what,"UID, size and header %d are read",n);
+    Check(!strcmp(imap->FetchUID,uid)&&imap->FetchSize==(long)msg.size()+100&&header==msg,what);
+  }
+  sprintf(what,"all headers are listed (%s)",*eol=='\r'?"CRLF":"LF");
+  Check(n==(int)srv.Messages.size(),what);
+  Check(imap->EndFetch()==0,"FETCH is completed");
+  Check(imap->Disconnect()==0,"session ends with LOGOUT");
+  delete imap;
+  srv.Wait();
+  Check(srv.Log.find("LOGOUT")!=std::string::npos,"server has got LOGOUT");
+}
+
+int main(int argc,char *argv[])
+{
+  InitFar();
+  WSADATA wsa;
+  WSAStartup(MAKEWORD(1,1),&wsa);
+  TestHeaders("\r\n");
+  TestHeaders("\n");
+  printf("imaptest: %d failed\n",failed);
+  return failed!=0;
+}
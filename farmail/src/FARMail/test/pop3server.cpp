@@ -0,0 +1,125 @@
+/*
+    FARMail plugin for FAR Manager
+    Copyright (C) 2002-2004 FARMail Group
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+
+    Fake POP3 server: mailbox of Messages, CAPA is answered with
+    PIPELINING if Capa is set and rejected otherwise, DELE takes
+    effect on QUIT. RETR and TOP of message FailRetr fail.
+*/
+
+#include <vector>
+#include "fakeserver.cpp"
+
+class Pop3Server: public FakeServer
+{
+  public:
+    BOOL Capa;
+    int FailRetr;
+    std::vector<std::string> Messages;
+    std::vector<int> Deleted;
+
+    Pop3Server(){Capa=TRUE;FailRetr=0;}
+  protected:
+    void Greet(void);
+    BOOL Command(const char *line);
+    BOOL Exists(int n){return n>=1&&n<=(int)Messages.size()&&!Deleted[n-1];}
+    void SendMessage(int n,int lines=-1);
+};
+
+void Pop3Server::Greet(void)
+{
+  Deleted.assign(Messages.size(),0);
+  Reply("+OK fake POP3 server ready");
+}
+
+// multi-line response, lines starting with dot are stuffed,
+// only given number of body lines is sent if it is not negative
+void Pop3Server::SendMessage(int n,int lines)
+{
+  const std::string &msg=Messages[n-1];
+  std::string out;
+  BOOL body=FALSE;
+  for(size_t i=0;i<msg.size();)
+  {
+    size_t eol=msg.find("\r\n",i);
+    if(eol==std::string::npos) eol=msg.size();
+    if(body&&!lines--) break;
+    if(eol==i) body=TRUE;
+    if(msg[i]=='.') out+='.';
+    out.append(msg,i,eol-i);
+    out+="\r\n";
+    i=eol+2;
+  }
+  out+=".\r\n";
+  Write(out.data(),out.size());
+}
+
+BOOL Pop3Server::Command(const char *line)
+{
+  int n=0;
+  const char *arg=strchr(line,' ');
+  if(arg) n=atoi(arg+1);
+  if(!strncasecmp(line,"USER",4)||!strncasecmp(line,"PASS",4)||!strncasecmp(line,"NOOP",4))
+    Reply("+OK");
+  else if(!strncasecmp(line,"CAPA",4))
+  {
+    if(Capa) Reply("+OK\r\nUSER\r\nUIDL\r\nPIPELINING\r\n.");
+    else Reply("-ERR unknown command");
+  }
+  else if(!strncasecmp(line,"STAT",4))
+  {
+    size_t size=0;
+    for(size_t i=0;i<Messages.size();i++) size+=Messages[i].size();
+    Reply("+OK %d %d",(int)Messages.size(),(int)size);
+  }
+  else if(!strncasecmp(line,"RETR",4)||!strncasecmp(line,"TOP",3))
+  {
+    if(!Exists(n)||n==FailRetr) Reply("-ERR no such message");
+    else if(*line=='T'||*line=='t')
+    {
+      Reply("+OK top of message follows");
+      SendMessage(n,atoi(strchr(arg+1,' ')+1));
+    }
+    else
+    {
+      Reply("+OK %d octets",(int)Messages[n-1].size());
+      SendMessage(n);
+    }
+  }
+  else if(!strncasecmp(line,"DELE",4))
+  {
+    if(!Exists(n)) Reply("-ERR no such message");
+    else
+    {
+      Deleted[n-1]=1;
+      Reply("+OK message %d deleted",n);
+    }
+  }
+  else if(!strncasecmp(line,"QUIT",4))
+  {
+    Reply("+OK bye");
+    std::vector<std::string> left;
+    for(size_t i=0;i<Messages.size();i++)
+      if(!Deleted[i]) left.push_back(Messages[i]);
+    Messages=left;
+    Deleted.assign(left.size(),0);
+    return FALSE;
+  }
+  else Reply("-ERR unknown command");
+  return TRUE;
+}
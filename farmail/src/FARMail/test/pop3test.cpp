@@ -0,0 +1,290 @@
+/*
+    FARMail plugin for FAR Manager
+    Copyright (C) 2002-2004 FARMail Group
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+
+    Test of POP3 client against fake server: messages are saved
+    as RETR streams them, commands are pipelined when server lists
+    PIPELINING in CAPA and sent one by one when it has no CAPA,
+    responses are matched to commands in order they were sent.
+    After a failed response nothing is sent ahead, and messages
+    queued before it are not read out on QUIT.
+*/
+
+#include "farmail.hpp"
+#include "socket2.cpp"
+#include "mailclnt.cpp"
+#include "savefile.cpp"
+#include "test/farstub.cpp"
+#include "test/pop3server.cpp"
+
+static const char *TempDir="/tmp/pop3test";
+
+char *GetDateInSMTP(void)
+{
+  return (char*)"Thu, 1 Jan 2004 00:00:00 +0000";
+}
+
+static std::string ReadAll(const char *name)
+{
+  std::string res;
+  FILE *f=fopen(name,"rb");
+  if(!f) return res;
+  char buf[4096];
+  size_t n;
+  while((n=fread(buf,1,sizeof(buf),f))>0) res.append(buf,n);
+  fclose(f);
+  return res;
+}
+
+// messages with dot-stuffed, mbox and long lines
+static void FillMailbox(Pop3Server &srv,int count)
+{
+  srv.Messages.clear();
+  for(int i=1;i<=count;i++)
+  {
+    char head[256];
+    sprintf(head,"From: sender%d@example.org\r\nSubject: message %d\r\n\r\n",i,i);
+    std::string msg=head;
+    msg+=".starts with dot\r\n..two dots\r\n.\r\nFrom the start of line\r\n\r\n";
+    if(i%3==0) msg+=std::string(RECV_BUFFER_SIZE*3+i,'x')+"\r\n";
+    for(int j=0;j<i*50;j++) msg+="body line of some length to cross receive buffer\r\n";
+    srv.Messages.push_back(msg);
+  }
+}
+
+static char *MessageFile(int n)
+{
+  static char name[MAX_PATH];
+  sprintf(name,"%s/%08d.msg",TempDir,n);
+  return name;
+}
+
+// the way fast download walks mailbox: RETRs are sent ahead,
+// each message is deleted as soon as it is saved
+static BOOL Download(MailClient *clnt,int port,BOOL move)
+{
+  if(!clnt->Connect((char*)"127.0.0.1",(char*)"user",(char*)"pass",port)||!clnt->Statistics())
+    return FALSE;
+  int ahead=1;
+  BOOL res=TRUE;
+  for(int i=1;res&&i<=clnt->NumberMail;i++)
+  {
+    if(ahead<i) ahead=i;
+    while(ahead<=clnt->NumberMail&&clnt->RetrieveAhead(ahead)) ahead++;
+    HANDLE fp=CreateFile(MessageFile(i),GENERIC_WRITE,0,NULL,CREATE_ALWAYS,FILE_ATTRIBUTE_ARCHIVE,NULL);
+    res=fp!=INVALID_HANDLE_VALUE&&clnt->Retrieve(i,OPM_SILENT,fp,FALSE);
+    if(fp!=INVALID_HANDLE_VALUE) CloseHandle(fp);
+    if(res&&move&&!clnt->DeleteAhead(i)) res=clnt->Delete(i);
+    if(res&&i==clnt->NumberMail) res=clnt->Flush();
+  }
+  return clnt->Disconnect()&&res;
+}
+
+static void CheckSaved(const std::vector<std::string> &msgs)
+{
+  for(size_t i=0;i<msgs.size();i++)
+  {
+    char what[64];
+    sprintf(what,"message %d is saved as sent",(int)i+1);
+    Check(ReadAll(MessageFile(i+1))==msgs[i],what);
+  }
+}
+
+// commands in order server has got them
+static std::vector<std::string> Commands(const std::string &log)
+{
+  std::vector<std::string> res;
+  for(size_t i=0;i<log.size();)
+  {
+    size_t eol=log.find('\n',i);
+    res.push_back(log.substr(i,eol-i));
+    i=eol+1;
+  }
+  return res;
+}
+
+static int Index(const std::vector<std::string> &cmds,const char *cmd)
+{
+  for(size_t i=0;i<cmds.size();i++)
+    if(cmds[i]==cmd) return i;
+  return -1;
+}
+
+static void TestNoCapa(void)
+{
+  Pop3Server srv;
+  srv.Capa=FALSE;
+  FillMailbox(srv,5);
+  std::vector<std::string> msgs=srv.Messages;
+  Check(srv.Start(),"server is started");
+  MailClient *clnt=new MailClient(FALSE,NULL,0);
+  Check(Download(clnt,srv.Port,TRUE),"mailbox without CAPA is downloaded");
+  Check(!clnt->Pipelining,"commands are not pipelined without CAPA");
+  delete clnt;
+  srv.Wait();
+  CheckSaved(msgs);
+  Check(srv.Messages.empty(),"all messages are deleted");
+  // each command waits for the response to the previous one
+  std::vector<std::string> cmds=Commands(srv.Log);
+  int pos=Index(cmds,"STAT");
+  for(int i=1;i<=5;i++)
+  {
+    char retr[16],dele[16];
+    sprintf(retr,"RETR %d",i);
+    sprintf(dele,"DELE %d",i);
+    Check(pos>=0&&pos+2<(int)cmds.size()&&cmds[pos+1]==retr&&cmds[pos+2]==dele,"RETR and DELE go one by one");
+    pos+=2;
+  }
+  Check(cmds.back()=="QUIT","session ends with QUIT");
+}
+
+static void TestPipelining(void)
+{
+  Pop3Server srv;
+  FillMailbox(srv,POP3_WINDOW*3);
+  std::vector<std::string> msgs=srv.Messages;
+  int count=msgs.size();
+  Check(srv.Start(),"server is started");
+  MailClient *clnt=new MailClient(FALSE,NULL,0);
+  Check(Download(clnt,srv.Port,TRUE),"mailbox is downloaded with pipelining");
+  Check(clnt->Pipelining,"PIPELINING is taken from CAPA");
+  delete clnt;
+  srv.Wait();
+  CheckSaved(msgs);
+  Check(srv.Messages.empty(),"all messages are deleted");
+  std::vector<std::string> cmds=Commands(srv.Log);
+  // RETRs go in order and before the DELE of the same message
+  int prevretr=-1;
+  for(int i=1;i<=count;i++)
+  {
+    char retr[16],dele[16];
+    sprintf(retr,"RETR %d",i);
+    sprintf(dele,"DELE %d",i);
+    int r=Index(cmds,retr),d=Index(cmds,dele);
+    Check(r>prevretr,"RETRs are sent in order");
+    Check(d>r,"message is deleted after it is retrieved");
+    prevretr=r;
+  }
+  // whole window of RETRs is sent before the first message is saved
+  for(int i=2;i<=POP3_WINDOW;i++)
+  {
+    char retr[16];
+    sprintf(retr,"RETR %d",i);
+    Check(Index(cmds,retr)<Index(cmds,"DELE 1"),"window of RETRs is sent ahead");
+  }
+  Check(Index(cmds,"RETR 1")==Index(cmds,"STAT")+1,"RETR follows STAT");
+  Check(cmds.back()=="QUIT","session ends with QUIT");
+}
+
+// nothing is deleted when messages are only copied,
+// RETRs are sent ahead while previous ones are read out
+static void TestCopy(void)
+{
+  Pop3Server srv;
+  FillMailbox(srv,POP3_WINDOW*2+1);
+  std::vector<std::string> msgs=srv.Messages;
+  Check(srv.Start(),"server is started");
+  MailClient *clnt=new MailClient(FALSE,NULL,0);
+  Check(Download(clnt,srv.Port,FALSE),"mailbox is copied");
+  delete clnt;
+  srv.Wait();
+  CheckSaved(msgs);
+  Check(srv.Messages.size()==msgs.size(),"messages are left on server");
+  Check(srv.Log.find("DELE")==std::string::npos,"nothing is deleted");
+}
+
+// the rest of window is not read out when RETR fails: session is
+// dropped after QUIT, and nothing is sent ahead after the error
+static void TestRetrError(void)
+{
+  Pop3Server srv;
+  srv.FailRetr=3;
+  for(int i=1;i<=POP3_WINDOW+4;i++)
+  {
+    char head[64];
+    sprintf(head,"Subject: message %d\r\n\r\n",i);
+    srv.Messages.push_back(head+std::string(512*1024,'x')+"\r\n");
+  }
+  std::vector<std::string> msgs=srv.Messages;
+  Check(srv.Start(),"server is started");
+  char log[MAX_PATH];
+  sprintf(log,"%s/pop3.log",TempDir);
+  DeleteFile(log);
+  MailClient *clnt=new MailClient(TRUE,log,0);
+  Check(!Download(clnt,srv.Port,TRUE),"failed RETR stops download");
+  Check(!clnt->RetrieveAhead(POP3_WINDOW+1),"nothing is sent ahead after failed RETR");
+  Check(!clnt->connected,"session with queued RETRs is dropped");
+  delete clnt;
+  srv.Wait();
+  msgs.resize(2);
+  CheckSaved(msgs);
+  Check(ReadAll(log).find(" QUIT\r\n")!=std::string::npos,"QUIT is sent before connection is dropped");
+  Check(srv.Dropped,"queued messages are not read out");
+}
+
+// TOPs of panel listing go on after one fails, one by one
+static void TestTopError(void)
+{
+  Pop3Server srv;
+  srv.FailRetr=3;
+  FillMailbox(srv,POP3_WINDOW+4);
+  int count=srv.Messages.size();
+  Check(srv.Start(),"server is started");
+  MailClient *clnt=new MailClient(FALSE,NULL,0);
+  Check(clnt->Connect((char*)"127.0.0.1",(char*)"user",(char*)"pass",srv.Port)&&clnt->Statistics(),"mailbox is opened");
+  // stop is the first TOP not sent ahead when one has failed
+  int ahead=1,failed=0,stop=0;
+  BOOL lookahead=FALSE;
+  for(int i=1;i<=count;i++)
+  {
+    if(ahead<i) ahead=i;
+    while(ahead<=count&&clnt->TopAhead(ahead,0)) ahead++;
+    if(stop&&ahead>(i>stop?i:stop)) lookahead=TRUE;
+    if(!clnt->Top(i,0))
+    {
+      failed++;
+      if(!stop) stop=ahead;
+      continue;
+    }
+    char from[64];
+    sprintf(from,"From: sender%d@",i);
+    Check(!strncmp(clnt->GetMsg(),from,strlen(from)),"TOP returns headers of its message");
+    Check(strstr(clnt->GetMsg(),"body line")==NULL,"TOP 0 returns no body");
+  }
+  Check(failed==1,"only TOP of missing message fails");
+  Check(stop&&!lookahead,"nothing is sent ahead after failed TOP");
+  Check(clnt->Disconnect(),"session ends with QUIT");
+  delete clnt;
+  srv.Wait();
+  Check(!srv.Dropped,"all responses are read");
+}
+
+int main(int argc,char *argv[])
+{
+  InitFar();
+  WSADATA wsa;
+  WSAStartup(MAKEWORD(1,1),&wsa);
+  CreateDirectory(TempDir,NULL);
+  TestNoCapa();
+  TestPipelining();
+  TestCopy();
+  TestRetrError();
+  TestTopError();
+  printf("pop3test: %d failed\n",failed);
+  return failed!=0;
+}
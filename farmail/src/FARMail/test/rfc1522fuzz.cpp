@@ -0,0 +1,183 @@
+/*
+    FARMail plugin for FAR Manager
+    Copyright (C) 2002-2004 FARMail Group
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+
+    Fuzz target of header and body decoding: an input is taken as a
+    header for GetGeaderField and the encoded-word loop of DecodeField,
+    and as raw text for quoted-printable, base64 and UUE decoding.
+    Output has to fit the room callers reserve for it, buffers are
+    allocated to their exact size so that a sanitizer sees overruns.
+    With -DLIBFUZZER the target is driven by libFuzzer, otherwise by
+    main() which mutates sample headers; number of inputs is the
+    argument, 20000 by default.
+*/
+
+#include "farmail.hpp"
+#include "base64.cpp"
+#include "rfc1522.cpp"
+#include "uue.cpp"
+#include "test/farstub.cpp"
+#include <string>
+
+#define FIELD_SIZE 1000 // as columns of the panel take it
+#define WORD_SIZE 16    // short charset and encoding buffers get cut
+
+static void Require(bool ok,const char *what)
+{
+  if(ok) return;
+  Check(false,what);
+  abort();
+}
+
+static char *Copy(const unsigned char *data,size_t size)
+{
+  char *s=(char*)malloc(size+1);
+  memcpy(s,data,size);
+  s[size]=0;
+  return s;
+}
+
+// the loop of DecodeField without charset tables
+static void DecodeWords(char *str)
+{
+  int size=lstrlen(str)+1;
+  char *text=(char*)malloc(size),*decoded=(char*)malloc(size);
+  char *charset=(char*)malloc(WORD_SIZE),*encoding=(char*)malloc(WORD_SIZE);
+  char *line=str,*ptr;
+  while((ptr=strstr(line,"=?"))!=NULL)
+  {
+    line=SplitHeaderLine(ptr,charset,encoding,text,WORD_SIZE);
+    Require(line>ptr&&line<=str+size-1,"encoded-word is passed");
+    Require(lstrlen(charset)<WORD_SIZE&&lstrlen(encoding)<WORD_SIZE,"charset and encoding are cut");
+    int len=lstrlen(text);
+    if(!FSF.LStricmp(encoding,"b"))
+      Require(DecodeBase64(decoded,text,len)<=len*3/4,"base64 word fits");
+    else if(!FSF.LStricmp(encoding,"q"))
+      Require(DecodeQuotedPrintable(text,len,decoded)<=len,"quoted-printable word fits");
+  }
+  free(text);
+  free(decoded);
+  free(charset);
+  free(encoding);
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const unsigned char *data,size_t size)
+{
+  int n=(int)size;
+  char *src=Copy(data,size);
+  char *field=(char*)malloc(FIELD_SIZE+1);
+  if(!GetGeaderField(src,field,"Subject:",FIELD_SIZE))
+  {
+    Require(lstrlen(field)<=FIELD_SIZE,"field fits");
+    DecodeWords(field);
+  }
+  DecodeWords(src);
+  free(field);
+
+  char *dest=(char*)malloc(n+1);
+  int len=DecodeQuotedPrintable(src,n,dest);
+  Require(len<=n&&!dest[len],"quoted-printable fits");
+  free(dest);
+
+  dest=(char*)malloc(n*3/4+1);
+  len=DecodeBase64(dest,src,n);
+  Require(len<=n*3/4&&!dest[len],"base64 fits");
+  free(dest);
+
+  dest=(char*)malloc(n*3/4+1);
+  DecodeUUE(dest,src,n);
+  free(dest);
+
+  char *enc=(char*)malloc((n/BASE64_LINE+1)*78+1);
+  dest=(char*)malloc(n+1);
+  len=EncodeBase64Lines(enc,src,n);
+  Require(DecodeBase64(dest,enc,len)==n&&!memcmp(dest,src,n),"data goes round");
+  free(enc);
+  free(dest);
+
+  free(src);
+  return 0;
+}
+
+#ifdef LIBFUZZER
+
+extern "C" int LLVMFuzzerInitialize(int *argc,char ***argv)
+{
+  InitFar();
+  return 0;
+}
+
+#else
+
+static const char *Samples[]=
+{
+  "Subject: =?koi8-r?B?8NLJ18XU?= =?koi8-r?Q?=F0=D2=C9_=D7=C5=D4?=\r\n",
+  "From: a@b\r\nSubject: plain\r\n\t=?utf-8?q?folded=3D?=\r\n more\r\nTo: c@d\r\n",
+  "subject:=?x?b?QUJD?==?x?q?a=\r\n=3d=?=",
+  "Subject: =?=?=?=?" "?=?=?\r\n",
+  "Subject: =?averyveryverylongcharsetname?Base64?QQ?=\r\n",
+  "soft=\r\nbreak=3D=3d=ZZ=\n=",
+  "M86XL86XL86XL86XL86XL86XL86XL86XL86XL86XL86XL86XL86XL86XL86XL\r\n",
+  "#86)C",
+};
+
+static const char *Tokens[]={"=?","?=","?q?","?B?","=","\r\n","\r\n\t","\n ","Subject:"};
+
+static std::string Mutate(std::string s)
+{
+  int steps=1+rand()%8;
+  while(steps--)
+  {
+    size_t pos=s.empty()?0:rand()%(s.size()+1);
+    switch(rand()%5)
+    {
+      case 0:
+        if(pos<s.size()) s[pos]=(char)rand();
+        break;
+      case 1:
+        s.insert(pos,Tokens[rand()%(sizeof(Tokens)/sizeof(Tokens[0]))]);
+        break;
+      case 2:
+        if(pos<s.size()) s.erase(pos,1+rand()%8);
+        break;
+      case 3:
+        s.insert(pos,s.substr(0,rand()%(s.size()+1)));
+        break;
+      case 4:
+        s.resize(pos);
+        break;
+    }
+  }
+  return s;
+}
+
+int main(int argc,char *argv[])
+{
+  InitFar();
+  int count=argc>1?atoi(argv[1]):20000;
+  srand(1);
+  for(int i=0;i<count;i++)
+  {
+    std::string s=Mutate(Samples[rand()%(sizeof(Samples)/sizeof(Samples[0]))]);
+    LLVMFuzzerTestOneInput((const unsigned char*)s.data(),s.size());
+  }
+  printf("rfc1522fuzz: %d inputs, %d failed\n",count,failed);
+  return failed!=0;
+}
+
+#endif
@@ -0,0 +1,136 @@
+/*
+    FARMail plugin for FAR Manager
+    Copyright (C) 2002-2004 FARMail Group
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+
+    Benchmark of message numbering: threads save messages to one
+    folder with CreateFreeFile, while another program puts its own
+    files right where the next numbers are. Every save must get a
+    file of its own and no file of the other program is overwritten.
+    Number of saves is the argument, 100000 by default.
+*/
+
+#include "farmail.hpp"
+#include "savefile.cpp"
+#include "test/farstub.cpp"
+#include <pthread.h>
+#include <unistd.h>
+
+#define THREADS 4
+
+static const char *Dir="/tmp/savebench\\";
+static int Saves;
+static LONG Failed, Foreign;
+static volatile LONG Done;
+
+char *GetDateInSMTP(void)
+{
+  return (char*)"Thu, 1 Jan 2004 00:00:00 +0000";
+}
+
+static BOOL WriteAll(HANDLE fp,const char *data)
+{
+  DWORD written;
+  BOOL ok=WriteFile(fp,data,lstrlen(data),&written,NULL)&&written==(DWORD)lstrlen(data);
+  return CloseHandle(fp)&&ok;
+}
+
+static void *Saver(void *arg)
+{
+  char name[MAX_PATH];
+  for(int i=0;i<Saves/THREADS;i++)
+  {
+    HANDLE fp=CreateFreeFile((char*)Dir,name,0);
+    if(fp==INVALID_HANDLE_VALUE||!WriteAll(fp,"message")) InterlockedIncrement(&Failed);
+  }
+  InterlockedIncrement(&Done);
+  return NULL;
+}
+
+// another program saves under the number just handed out, before it is used
+static void *Intruder(void *arg)
+{
+  char name[MAX_PATH];
+  while(Done<THREADS)
+  {
+    FSF.sprintf(name,"%s%08d.%s",Dir,FreeNumber-1,Opt.EXT);
+    HANDLE fp=CreateFile(name,GENERIC_WRITE,0,NULL,CREATE_NEW,0,NULL);
+    if(fp!=INVALID_HANDLE_VALUE&&WriteAll(fp,"foreign")) InterlockedIncrement(&Foreign);
+    usleep(100);
+  }
+  return NULL;
+}
+
+static void Clean(BOOL verify)
+{
+  char mask[MAX_PATH],name[MAX_PATH],buf[16];
+  WIN32_FIND_DATA fd;
+  int messages=0,foreign=0,broken=0;
+  sprintf(mask,"%s*.%s",Dir,Opt.EXT);
+  HANDLE h=FindFirstFile(mask,&fd);
+  if(h!=INVALID_HANDLE_VALUE)
+  {
+    do
+    {
+      sprintf(name,"%s%s",Dir,fd.cFileName);
+      if(verify)
+      {
+        DWORD n=0;
+        HANDLE fp=CreateFile(name,GENERIC_READ,0,NULL,OPEN_EXISTING,0,NULL);
+        if(fp!=INVALID_HANDLE_VALUE)
+        {
+          ReadFile(fp,buf,sizeof(buf)-1,&n,NULL);
+          CloseHandle(fp);
+        }
+        buf[n]=0;
+        if(!strcmp(buf,"message")) messages++;
+        else if(!strcmp(buf,"foreign")) foreign++;
+        else broken++;
+      }
+      DeleteFile(name);
+    }
+    while(FindNextFile(h,&fd));
+    FindClose(h);
+  }
+  if(!verify) return;
+  Check(messages==Saves&&!Failed,"every save has a file of its own");
+  Check(foreign==Foreign&&!broken,"files of another program are kept");
+}
+
+int main(int argc,char *argv[])
+{
+  pthread_t threads[THREADS+1];
+  InitFar();
+  Saves=argc>1?atoi(argv[1]):100000;
+  Saves-=Saves%THREADS;
+  CreateDirectory(Dir,NULL);
+  Clean(FALSE);
+  ResetFreeNumber();
+
+  DWORD start=GetTickCount();
+  for(int i=0;i<THREADS;i++) pthread_create(&threads[i],NULL,Saver,NULL);
+  pthread_create(&threads[THREADS],NULL,Intruder,NULL);
+  for(int i=0;i<=THREADS;i++) pthread_join(threads[i],NULL);
+  double time=(GetTickCount()-start)/1000.0;
+
+  printf("savebench: %d saves in %d threads, %d foreign files: %.2f s, %.0f saves/s\n",
+         Saves,THREADS,(int)Foreign,time,Saves/time);
+  Clean(TRUE);
+  RemoveDirectory(Dir);
+  printf("savebench: %d failed\n",failed);
+  return failed!=0;
+}
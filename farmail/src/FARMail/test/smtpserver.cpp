@@ -0,0 +1,132 @@
+/*
+    FARMail plugin for FAR Manager
+    Copyright (C) 2002-2004 FARMail Group
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+
+    Fake SMTP server: EHLO lists Extensions, HELO only is spoken if
+    there are none. Recipients in Refused are refused, DATA is still
+    answered 354 as RFC 2920 lets a server do. Messages taken by DATA
+    or BDAT go to Messages with dot-stuffing undone, a message without
+    accepted recipients is refused at its end.
+*/
+
+#include <set>
+#include <vector>
+#include "fakeserver.cpp"
+
+class SmtpServer: public FakeServer
+{
+  public:
+    std::vector<std::string> Extensions;
+    std::set<std::string> Refused;
+    std::vector<std::string> Messages;
+
+    SmtpServer(){Accepted=0;InData=FALSE;}
+  protected:
+    void Greet(void);
+    BOOL Command(const char *line);
+    void EndMessage(void);
+  private:
+    int Accepted;
+    BOOL InData;
+    std::string Message;
+};
+
+void SmtpServer::Greet(void)
+{
+  Reply("220 fake ESMTP server ready");
+}
+
+void SmtpServer::EndMessage(void)
+{
+  if(Accepted)
+  {
+    Messages.push_back(Message);
+    Reply("250 queued as <%d@fake>",(int)Messages.size());
+  }
+  else Reply("554 no valid recipients");
+  Message.clear();
+}
+
+BOOL SmtpServer::Command(const char *line)
+{
+  if(InData)
+  {
+    if(!strcmp(line,"."))
+    {
+      InData=FALSE;
+      EndMessage();
+    }
+    else
+    {
+      Message+=line+(*line=='.');
+      Message+="\r\n";
+    }
+  }
+  else if(!strncasecmp(line,"EHLO",4))
+  {
+    if(Extensions.empty())
+      Reply("502 command not implemented");
+    else
+    {
+      Reply("250-fake");
+      for(size_t i=0;i<Extensions.size();i++)
+        Reply("250%c%s",i+1<Extensions.size()?'-':' ',Extensions[i].c_str());
+    }
+  }
+  else if(!strncasecmp(line,"HELO",4))
+    Reply("250 fake");
+  else if(!strncasecmp(line,"MAIL FROM:",10))
+  {
+    Accepted=0;
+    Message.clear();
+    Reply("250 sender ok");
+  }
+  else if(!strncasecmp(line,"RCPT TO:",8))
+  {
+    std::string rcpt(line+8);
+    if(rcpt.size()>2) rcpt=rcpt.substr(1,rcpt.size()-2);
+    if(Refused.count(rcpt))
+      Reply("550 <%s> unknown user",rcpt.c_str());
+    else
+    {
+      Accepted++;
+      Reply("250 recipient ok");
+    }
+  }
+  else if(!strcasecmp(line,"DATA"))
+  {
+    InData=TRUE;
+    Reply("354 end data with <CRLF>.<CRLF>");
+  }
+  else if(!strncasecmp(line,"BDAT ",5))
+  {
+    std::string chunk;
+    if(!ReadData(chunk,atoi(line+5))) return FALSE;
+    Message+=chunk;
+    if(strstr(line," LAST")) EndMessage();
+    else if(Accepted) Reply("250 %d octets received",(int)chunk.size());
+    else Reply("554 no valid recipients");
+  }
+  else if(!strcasecmp(line,"QUIT"))
+  {
+    Reply("221 bye");
+    return FALSE;
+  }
+  else Reply("500 unknown command");
+  return TRUE;
+}
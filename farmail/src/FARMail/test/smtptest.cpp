@@ -0,0 +1,154 @@
+/*
+    FARMail plugin for FAR Manager
+    Copyright (C) 2002-2004 FARMail Group
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+
+    Test of SMTP sending against fake server: a message with a
+    dot-stuffed line and base64 encoded in blocks arrives intact
+    with HELO only, EHLO, PIPELINING, CHUNKING and both of them; text
+    sent by lines is logged by blocks; a pipelined recipient refused
+    while DATA is accepted ends the data with a dot and the session
+    with QUIT.
+*/
+
+#include <unistd.h>
+#include "farmail.hpp"
+#include "socket2.cpp"
+#include "base64.cpp"
+#include "smtp.cpp"
+#include "test/farstub.cpp"
+#include "test/smtpserver.cpp"
+
+// headers, a line starting with a dot, 200 KB of data in base64 blocks
+static std::string SendMessage(SMTP *smtp)
+{
+  static char in[BASE64_BLOCK],out[(BASE64_BLOCK/BASE64_LINE+1)*78+1];
+  std::string sent="Subject: test\r\n\r\n.leading dot\r\n";
+  Check(smtp->DataLine("Subject: test\r\n\r\n",0),"headers are sent");
+  Check(smtp->DataLine("..leading dot\r\n",0),"stuffed line is sent");
+  srand(1);
+  for(int total=0;total<200*1024;total+=BASE64_BLOCK)
+  {
+    for(int i=0;i<BASE64_BLOCK;i++) in[i]=(char)rand();
+    EncodeBase64Lines(out,in,BASE64_BLOCK);
+    if(!smtp->DataLine(out,0))
+    {
+      Check(false,"block is sent");
+      break;
+    }
+    sent+=out;
+  }
+  return sent;
+}
+
+static void TestSend(const char *ext1,const char *ext2,const char *what)
+{
+  SmtpServer srv;
+  char msg[128];
+  if(ext1) srv.Extensions.push_back(ext1);
+  if(ext2) srv.Extensions.push_back(ext2);
+  Check(srv.Start(),"server is started");
+
+  SMTP *smtp=new SMTP(FALSE,NULL);
+  Check(smtp->Connect((char*)"127.0.0.1",srv.Port),"session is opened");
+  Check(smtp->Mail((char*)"me@example.org")&&smtp->Receipt((char*)"you@example.org")&&
+        smtp->Receipt((char*)"him@example.org")&&smtp->Data(),"envelope is accepted");
+  std::string sent=SendMessage(smtp);
+  sprintf(msg,"message is sent (%s)",what);
+  Check(smtp->DataLine(".\r\n",1)&&!strcmp(smtp->message_id,"1@fake"),msg);
+  Check(smtp->Disconnect(),"session ends");
+  delete smtp;
+  srv.Wait();
+  sprintf(msg,"message arrives intact (%s)",what);
+  Check(srv.Messages.size()==1&&srv.Messages[0]==sent,msg);
+  Check(srv.Log.find("QUIT")!=std::string::npos,"server has got QUIT");
+}
+
+static void TestLog(void)
+{
+  SmtpServer srv;
+  char fn[64];
+  sprintf(fn,"/tmp/smtptest.%d.log",(int)getpid());
+  Check(srv.Start(),"server is started");
+
+  SMTP *smtp=new SMTP(TRUE,fn);
+  Check(smtp->Connect((char*)"127.0.0.1",srv.Port)&&smtp->Mail((char*)"me@example.org")&&
+        smtp->Receipt((char*)"you@example.org")&&smtp->Data(),"logged session is opened");
+  // text is sent by lines
+  std::string sent;
+  for(int i=0;i<3000;i++)
+  {
+    char line[64];
+    sprintf(line,"line %d of text\r\n",i);
+    smtp->DataLine(line,0);
+    sent+=line;
+  }
+  Check(smtp->DataLine(".\r\n",1),"logged message is sent");
+  smtp->Disconnect();
+  delete smtp;
+  srv.Wait();
+
+  HANDLE fp=CreateFile(fn,GENERIC_READ,0,NULL,OPEN_EXISTING,0,NULL);
+  DWORD size=GetFileSize(fp,NULL);
+  CloseHandle(fp);
+  DeleteFile(fn);
+  // a time stamp of each line would add 9 chars per line
+  Check(size>sent.size()&&size<sent.size()+1000,"message data is logged by blocks");
+}
+
+static void TestRefused(const char *ext2)
+{
+  SmtpServer srv;
+  srv.Extensions.push_back("PIPELINING");
+  if(ext2) srv.Extensions.push_back(ext2);
+  srv.Refused.insert("nobody@example.org");
+  Check(srv.Start(),"server is started");
+
+  SMTP *smtp=new SMTP(FALSE,NULL);
+  Check(smtp->Connect((char*)"127.0.0.1",srv.Port),"pipelining session is opened");
+  smtp->Mail((char*)"me@example.org");
+  smtp->Receipt((char*)"nobody@example.org");
+  Check(!smtp->Data(),"refused recipient fails the message");
+  Check(!strcmp(smtp->GetErrorMessage(),GetMsg(MesSMTP_550)),"refusal is reported");
+  Check(smtp->Disconnect(),"session is over");
+  delete smtp;
+  srv.Wait();
+  if(ext2)
+    Check(srv.Log.size()>=5&&srv.Log.compare(srv.Log.size()-5,5,"QUIT\n")==0,"session ends with QUIT");
+  else
+    Check(srv.Log.size()>=12&&srv.Log.compare(srv.Log.size()-12,12,"DATA\n.\nQUIT\n")==0,
+          "accepted DATA ends with dot, session with QUIT");
+  Check(!srv.Dropped&&srv.Messages.empty(),"nothing is delivered");
+}
+
+int main(int argc,char *argv[])
+{
+  WSADATA wsa;
+  WSAStartup(MAKEWORD(2,2),&wsa);
+  InitFar();
+  lstrcpy(Opt.MessageIDTemplate,"250 queued as <%[^>]>");
+  TestSend(NULL,NULL,"HELO");
+  TestSend("8BITMIME",NULL,"EHLO");
+  TestSend("PIPELINING",NULL,"PIPELINING");
+  TestSend("CHUNKING",NULL,"CHUNKING");
+  TestSend("PIPELINING","CHUNKING","PIPELINING and CHUNKING");
+  TestLog();
+  TestRefused(NULL);
+  TestRefused("CHUNKING");
+  printf("smtptest: %d failed\n",failed);
+  return failed!=0;
+}
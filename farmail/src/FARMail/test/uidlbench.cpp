@@ -0,0 +1,147 @@
+/*
+    FARMail plugin for FAR Manager
+    Copyright (C) 2002-2004 FARMail Group
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+
+    Benchmark of message states: listing a mailbox of N messages
+    (the argument, 100000 by default) and saving its states, the old
+    way with a registry lookup per message and the UIDL file way,
+    and the one-time import of the registry key. The registry of host
+    tests is a map in memory, so its times are far below those of the
+    Windows registry and are only a lower bound.
+*/
+
+#include "farmail.hpp"
+#include "uidl.cpp"
+#include "test/farstub.cpp"
+#include <time.h>
+
+const char UidlKey[]="uidls";
+HANDLE UidlMutex;
+
+static const char *Mailbox="Software\\Far\\Plugins\\FARMail\\Mailboxes\\bench";
+static int Count;
+static PluginPanelItem *Items;
+
+static double Now()
+{
+  timespec ts;
+  clock_gettime(CLOCK_MONOTONIC,&ts);
+  return ts.tv_sec+ts.tv_nsec/1e9;
+}
+
+static void MakeItems(void)
+{
+  Items=(PluginPanelItem*)calloc(Count,sizeof(PluginPanelItem));
+  for(int i=0;i<Count;i++)
+  {
+    char uidl[64];
+    sprintf(uidl,"%08x%08x.uidl.%d",i*2654435761u,i,i);
+    Items[i].CustomColumnNumber=5;
+    Items[i].CustomColumnData=(char**)calloc(6,sizeof(char*));
+    Items[i].CustomColumnData[4]=strdup(uidl);
+    Items[i].UserData=i%3?MESSAGE_STATE_READ:MESSAGE_STATE_NEW;
+  }
+}
+
+// the way states were kept before UIDL files
+static void Registry(double *list,double *save)
+{
+  char key[300];
+  HKEY hRoot,hKey;
+  DWORD states=0,expect=0;
+  FSF.sprintf(key,"%s\\%s",Mailbox,UidlKey);
+
+  double start=Now();
+  RegCreateKeyEx(HKEY_CURRENT_USER,Mailbox,0,NULL,0,KEY_ALL_ACCESS,NULL,&hRoot,NULL);
+  RegDeleteKey(hRoot,UidlKey);
+  RegCreateKeyEx(hRoot,UidlKey,0,NULL,0,KEY_WRITE,NULL,&hKey,NULL);
+  for(int i=0;i<Count;i++)
+    RegSetValueEx(hKey,Items[i].CustomColumnData[4],0,REG_DWORD,(LPBYTE)&Items[i].UserData,sizeof(DWORD));
+  RegCloseKey(hKey);
+  RegCloseKey(hRoot);
+  *save=Now()-start;
+
+  start=Now();
+  for(int i=0;i<Count;i++)
+  {
+    DWORD state=MESSAGE_STATE_NEW,type,size=sizeof(state);
+    if(RegOpenKeyEx(HKEY_CURRENT_USER,key,0,KEY_READ,&hKey)==ERROR_SUCCESS)
+    {
+      RegQueryValueEx(hKey,Items[i].CustomColumnData[4],0,&type,(LPBYTE)&state,&size);
+      RegCloseKey(hKey);
+    }
+    states+=state;
+  }
+  *list=Now()-start;
+  for(int i=0;i<Count;i++) expect+=Items[i].UserData;
+  Check(states==expect,"registry states are read");
+}
+
+static void File(double *import,double *list,double *save)
+{
+  UidlStore s;
+  DWORD states=0;
+  char name[MAX_PATH];
+  GetUidlFileName("bench",name);
+  DeleteFile(name);
+
+  // the key written by Registry() is imported
+  double start=Now();
+  s.Load(Mailbox);
+  *import=Now()-start;
+
+  start=Now();
+  s.Load(Mailbox);
+  for(int i=0;i<Count;i++) states+=s.Get(Items[i].CustomColumnData[4]);
+  *list=Now()-start;
+
+  start=Now();
+  Check(s.Save(Items,Count),"states are saved");
+  *save=Now()-start;
+  s.Free();
+
+  UidlStore t;
+  t.Load(Mailbox);
+  DWORD again=0;
+  for(int i=0;i<Count;i++) again+=t.Get(Items[i].CustomColumnData[4]);
+  Check(states==again,"file keeps imported states");
+  t.Free();
+  DeleteFile(name);
+}
+
+int main(int argc,char *argv[])
+{
+  double reglist,regsave,import,list,save;
+  InitFar();
+  Count=argc>1?atoi(argv[1]):100000;
+  lstrcpy(Opt.UIDLDIR,"/tmp/uidlbench\\");
+  CreateDirectory(Opt.UIDLDIR,NULL);
+  UidlMutex=CreateMutex(NULL,FALSE,NULL);
+  MakeItems();
+
+  Registry(&reglist,&regsave);
+  File(&import,&list,&save);
+  printf("uidlbench: %d messages, registry emulated in memory (Windows registry is slower)\n",Count);
+  printf("uidlbench: registry: list %.3f s, save %.3f s\n",reglist,regsave);
+  printf("uidlbench: file:     list %.3f s, save %.3f s, import from registry %.3f s\n",list,save,import);
+
+  RemoveDirectory(Opt.UIDLDIR);
+  CloseHandle(UidlMutex);
+  printf("uidlbench: %d failed\n",failed);
+  return failed!=0;
+}
@@ -0,0 +1,150 @@
+/*
+    FARMail plugin for FAR Manager
+    Copyright (C) 2002-2004 FARMail Group
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+
+    Test of message states kept in UIDL files: a file left as .new by
+    an interrupted rewrite is loaded and moved in place, states set by
+    another FAR since Load() survive Save(), states of messages gone
+    from the server expire, and the old registry key is imported once.
+*/
+
+#include "farmail.hpp"
+#include "uidl.cpp"
+#include "test/farstub.cpp"
+
+const char UidlKey[]="uidls";
+HANDLE UidlMutex;
+
+static const char *Mailbox="Software\\Far\\Plugins\\FARMail\\Mailboxes\\test";
+static const char *UidFile="/tmp/uidltest/test.uid";
+
+// live panel items of the mailbox, uidl is "uidl<n>", state is NEW
+struct Panel
+{
+  PluginPanelItem *Items;
+  int Count;
+  Panel(int count)
+  {
+    Count=count;
+    Items=(PluginPanelItem*)calloc(count,sizeof(PluginPanelItem));
+    for(int i=0;i<count;i++)
+    {
+      char uidl[32];
+      sprintf(uidl,"uidl%d",i+1);
+      Items[i].CustomColumnNumber=5;
+      Items[i].CustomColumnData=(char**)calloc(6,sizeof(char*));
+      for(int j=0;j<4;j++) Items[i].CustomColumnData[j]=strdup("");
+      Items[i].CustomColumnData[4]=strdup(uidl);
+      Items[i].UserData=MESSAGE_STATE_NEW;
+    }
+  }
+  ~Panel()
+  {
+    for(int i=0;i<Count;i++)
+    {
+      for(int j=0;j<5;j++) free(Items[i].CustomColumnData[j]);
+      free(Items[i].CustomColumnData);
+    }
+    free(Items);
+  }
+};
+
+static BOOL Exists(const char *name)
+{
+  return GetFileAttributes(name)!=0xFFFFFFFF;
+}
+
+static void WriteText(const char *name,const char *text)
+{
+  FILE *f=fopen(name,"wb");
+  fputs(text,f);
+  fclose(f);
+}
+
+static void TestNewFile(void)
+{
+  char name[MAX_PATH];
+  sprintf(name,"%s.new",UidFile);
+  DeleteFile(UidFile);
+  WriteText(name,"2 uidl1\r\n4 uidl2\r\n");
+  UidlStore s;
+  s.Load(Mailbox);
+  Check(s.Get("uidl1")==MESSAGE_STATE_READ&&s.Get("uidl2")==MESSAGE_STATE_MARKED,".new file is loaded");
+  Check(Exists(UidFile)&&!Exists(name),".new file is moved in place");
+  s.Free();
+}
+
+static void TestMerge(void)
+{
+  Panel panel(4);
+  DeleteFile(UidFile);
+  UidlStore a,b;
+  a.Load(Mailbox);
+  b.Load(Mailbox);
+  b.Set("uidl1",MESSAGE_STATE_READ);      // the other FAR
+  a.Set("uidl2",MESSAGE_STATE_MARKED);
+  panel.Items[1].UserData=MESSAGE_STATE_MARKED;
+  panel.Items[3].UserData=MESSAGE_STATE_DELETED;
+  a.Set("uidl5",MESSAGE_STATE_READ);      // not on the server any more
+  Check(a.Save(panel.Items,panel.Count),"states are saved");
+  b.Free();
+
+  UidlStore c;
+  c.Load(Mailbox);
+  Check(c.Get("uidl1")==MESSAGE_STATE_READ,"state set by another FAR is kept");
+  Check(c.Get("uidl2")==MESSAGE_STATE_MARKED,"own state is kept");
+  Check(c.Get("uidl3")==MESSAGE_STATE_NEW,"new message stays new");
+  Check(c.Get("uidl4")==MESSAGE_STATE_NEW&&c.Get("uidl5")==MESSAGE_STATE_NEW,"states of gone messages expire");
+  c.Free();
+  a.Free();
+}
+
+static void TestRegistry(void)
+{
+  char key[300];
+  HKEY hKey;
+  DWORD state=MESSAGE_STATE_MARKED;
+  DeleteFile(UidFile);
+  FSF.sprintf(key,"%s\\%s",Mailbox,UidlKey);
+  RegCreateKeyEx(HKEY_CURRENT_USER,key,0,NULL,0,KEY_WRITE,NULL,&hKey,NULL);
+  RegSetValueEx(hKey,"uidl7",0,REG_DWORD,(LPBYTE)&state,sizeof(state));
+  RegCloseKey(hKey);
+
+  UidlStore s;
+  s.Load(Mailbox);
+  Check(s.Get("uidl7")==MESSAGE_STATE_MARKED,"registry states are imported");
+  Check(Exists(UidFile),"imported states are written to file");
+  Check(RegOpenKeyEx(HKEY_CURRENT_USER,key,0,KEY_READ,&hKey)!=ERROR_SUCCESS,"registry key is deleted");
+  s.Free();
+}
+
+int main(int argc,char *argv[])
+{
+  InitFar();
+  lstrcpy(Opt.UIDLDIR,"/tmp/uidltest\\");
+  CreateDirectory(Opt.UIDLDIR,NULL);
+  UidlMutex=CreateMutex(NULL,FALSE,NULL);
+  TestNewFile();
+  TestMerge();
+  TestRegistry();
+  DeleteFile(UidFile);
+  RemoveDirectory(Opt.UIDLDIR);
+  CloseHandle(UidlMutex);
+  printf("uidltest: %d failed\n",failed);
+  return failed!=0;
+}
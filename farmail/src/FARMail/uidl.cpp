@@ -0,0 +1,285 @@
+/*
+    FARMail plugin for FAR Manager
+    Copyright (C) 2002-2005 FARMail Group
+    Copyright (C) 1999,2000 Serge Alexandrov
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+#include "farmail.hpp"
+
+#define UIDL_RECORD 14 // "state uidl\r\n" without the uidl
+
+static DWORD HashUidl(const char *uidl)
+{
+  DWORD hash=2166136261UL;
+  while (*uidl)
+  {
+    hash^=(unsigned char)*uidl++;
+    hash*=16777619UL;
+  }
+  return hash;
+}
+
+static BOOL IsLiveItem(PluginPanelItem *Item)
+{
+  return Item->CustomColumnNumber>4&&Item->CustomColumnData[4]&&lstrlen(Item->CustomColumnData[4])&&!(Item->UserData&MESSAGE_STATE_DELETED);
+}
+
+void GetUidlFileName( const char *mailbox, char *file )
+{
+  lstrcpy(file,Opt.UIDLDIR);
+  char *p=file+lstrlen(file);
+  for (; *mailbox && p<file+MAX_PATH-5; mailbox++, p++)
+    *p=strchr("\\/*?\"<>|",*mailbox)?'_':*mailbox;
+  lstrcpy(p,".uid");
+}
+
+UidlStore::UidlStore()
+{
+  *MailboxPath=0;
+  *FileName=0;
+  Table=NULL;
+  TableSize=Count=0;
+}
+
+UidlStore::~UidlStore()
+{
+  Free();
+}
+
+void UidlStore::Free(void)
+{
+  for (int i=0; i<TableSize; i++)
+    z_free(Table[i].Uidl);
+  z_free(Table);
+  Table=NULL;
+  TableSize=Count=0;
+  *MailboxPath=0;
+  *FileName=0;
+}
+
+// Returns the entry holding uidl or the empty slot where it belongs.
+UIDLENTRY *UidlStore::Find(const char *uidl,DWORD hash)
+{
+  int i=hash&(TableSize-1);
+  while (Table[i].Uidl && (Table[i].Hash!=hash || lstrcmp(Table[i].Uidl,uidl)))
+    i=(i+1)&(TableSize-1);
+  return &Table[i];
+}
+
+BOOL UidlStore::Insert(const char *uidl,DWORD state)
+{
+  if ((Count+1)*2>TableSize)
+  {
+    int NewSize=TableSize?TableSize*2:1024;
+    UIDLENTRY *NewTable=(UIDLENTRY *)z_calloc(NewSize,sizeof(UIDLENTRY));
+    if (!NewTable) return FALSE;
+    for (int i=0; i<TableSize; i++)
+    {
+      if (Table[i].Uidl)
+      {
+        int j=Table[i].Hash&(NewSize-1);
+        while (NewTable[j].Uidl) j=(j+1)&(NewSize-1);
+        NewTable[j]=Table[i];
+      }
+    }
+    z_free(Table);
+    Table=NewTable;
+    TableSize=NewSize;
+  }
+  DWORD hash=HashUidl(uidl);
+  UIDLENTRY *e=Find(uidl,hash);
+  if (!e->Uidl)
+  {
+    if (!(e->Uidl=z_strdup(uidl))) return FALSE;
+    e->Hash=hash;
+    Count++;
+  }
+  e->State=state;
+  return TRUE;
+}
+
+BOOL UidlStore::LoadFile(const char *name)
+{
+  HANDLE fp=CreateFile(name,GENERIC_READ,FILE_SHARE_READ|FILE_SHARE_WRITE,NULL,OPEN_EXISTING,FILE_FLAG_SEQUENTIAL_SCAN,NULL);
+  if (fp==INVALID_HANDLE_VALUE) return FALSE;
+  DWORD size=GetFileSize(fp,NULL), transferred=0;
+  char *buf=(size!=0xFFFFFFFF)?(char *)z_malloc(size+1):NULL;
+  BOOL res=buf&&ReadFile(fp,buf,size,&transferred,NULL)&&transferred==size;
+  CloseHandle(fp);
+  if (res)
+  {
+    // a record without its line break was cut short and is ignored
+    char *line=buf;
+    for (char *p=buf; p<buf+size; p++)
+    {
+      if (*p=='\n')
+      {
+        *p=0;
+        if (p>line && p[-1]=='\r') p[-1]=0;
+        char *uidl=strchr(line,' ');
+        if (uidl && uidl[1]) Insert(uidl+1,FSF.atoi(line));
+        line=p+1;
+      }
+    }
+    // later records must not be glued to the torn one
+    if (line<buf+size) Rewrite(NULL,0);
+  }
+  z_free(buf);
+  return res;
+}
+
+// States kept by older versions in the mailbox registry key.
+BOOL UidlStore::LoadRegistry(void)
+{
+  char key[300];
+  HKEY hKey;
+  FSF.sprintf(key,"%s\\%s",MailboxPath,UidlKey);
+  if (RegOpenKeyEx(HKEY_CURRENT_USER,key,0,KEY_READ,&hKey)!=ERROR_SUCCESS) return FALSE;
+  char name[256];
+  DWORD namesize, type, state, statesize;
+  LONG rc;
+  for (DWORD i=0; ; i++)
+  {
+    namesize=sizeof(name);
+    statesize=sizeof(state);
+    rc=RegEnumValue(hKey,i,name,&namesize,NULL,&type,(LPBYTE)&state,&statesize);
+    if (rc==ERROR_NO_MORE_ITEMS) break;
+    if (rc==ERROR_SUCCESS && type==REG_DWORD && *name) Insert(name,state);
+  }
+  RegCloseKey(hKey);
+  return Count>0;
+}
+
+// Writes the live panel items (or the whole table if Items is NULL) to
+// FileName.new and puts it in place of FileName. A state of an item found
+// in the table is newer than its UserData, as Save() reads the file first.
+BOOL UidlStore::Rewrite(PluginPanelItem *Items,int ItemsNumber)
+{
+  char name[MAX_PATH+4];
+  DWORD size=0, transferred;
+  int i;
+
+  if (Items)
+  {
+    for (i=0; i<ItemsNumber; i++)
+      if (IsLiveItem(&Items[i])) size+=lstrlen(Items[i].CustomColumnData[4])+UIDL_RECORD;
+  }
+  else
+  {
+    for (i=0; i<TableSize; i++)
+      if (Table[i].Uidl) size+=lstrlen(Table[i].Uidl)+UIDL_RECORD;
+  }
+  char *buf=(char *)z_malloc(size+1), *p=buf;
+  if (!buf) return FALSE;
+  if (Items)
+  {
+    for (i=0; i<ItemsNumber; i++)
+    {
+      if (!IsLiveItem(&Items[i])) continue;
+      const char *uidl=Items[i].CustomColumnData[4];
+      UIDLENTRY *e=Table?Find(uidl,HashUidl(uidl)):NULL;
+      p+=FSF.sprintf(p,"%d %s\r\n",(int)(e&&e->Uidl?e->State:Items[i].UserData),uidl);
+    }
+  }
+  else
+  {
+    for (i=0; i<TableSize; i++)
+      if (Table[i].Uidl) p+=FSF.sprintf(p,"%d %s\r\n",(int)Table[i].State,Table[i].Uidl);
+  }
+
+  FSF.sprintf(name,"%s.new",FileName);
+  CreateDirectory(Opt.UIDLDIR,NULL);
+  HANDLE fp=CreateFile(name,GENERIC_WRITE,0,NULL,CREATE_ALWAYS,FILE_ATTRIBUTE_ARCHIVE|FILE_FLAG_SEQUENTIAL_SCAN,NULL);
+  BOOL res=FALSE;
+  if (fp!=INVALID_HANDLE_VALUE)
+  {
+    res=::WriteFile(fp,buf,p-buf,&transferred,NULL)&&transferred==(DWORD)(p-buf)&&FlushFileBuffers(fp);
+    CloseHandle(fp);
+  }
+  if (res && !MoveFileEx(name,FileName,MOVEFILE_REPLACE_EXISTING|MOVEFILE_WRITE_THROUGH))
+  {
+    // no MoveFileEx on Win9x, Load() picks up FileName.new if we stop in between
+    DeleteFile(FileName);
+    res=MoveFile(name,FileName);
+  }
+  z_free(buf);
+  return res;
+}
+
+void UidlStore::Load(const char *_MailboxPath)
+{
+  Free();
+  WaitForSingleObject(UidlMutex,INFINITE);
+  lstrcpy(MailboxPath,_MailboxPath);
+  GetUidlFileName(FSF.PointToName(MailboxPath),FileName);
+  if (!LoadFile(FileName))
+  {
+    char name[MAX_PATH+4];
+    FSF.sprintf(name,"%s.new",FileName);
+    // Rewrite() stopped between deleting FileName and moving the new one
+    if (LoadFile(name))
+      MoveFile(name,FileName);
+    else if (LoadRegistry() && Rewrite(NULL,0))
+    {
+      HKEY hKey;
+      if (RegOpenKeyEx(HKEY_CURRENT_USER,MailboxPath,0,KEY_ALL_ACCESS,&hKey)==ERROR_SUCCESS)
+      {
+        RegDeleteKey(hKey,UidlKey);
+        RegCloseKey(hKey);
+      }
+    }
+  }
+  ReleaseMutex(UidlMutex);
+}
+
+DWORD UidlStore::Get(const char *uidl)
+{
+  if (Table)
+  {
+    UIDLENTRY *e=Find(uidl,HashUidl(uidl));
+    if (e->Uidl) return e->State;
+  }
+  return MESSAGE_STATE_NEW;
+}
+
+void UidlStore::Set(const char *uidl,DWORD state)
+{
+  char rec[256+UIDL_RECORD];
+  DWORD transferred;
+  if (!*FileName || lstrlen(uidl)>=256 || !Insert(uidl,state)) return;
+  int len=FSF.sprintf(rec,"%d %s\r\n",(int)state,uidl);
+  WaitForSingleObject(UidlMutex,INFINITE);
+  CreateDirectory(Opt.UIDLDIR,NULL);
+  HANDLE fp=CreateFile(FileName,GENERIC_WRITE,FILE_SHARE_READ,NULL,OPEN_ALWAYS,FILE_ATTRIBUTE_ARCHIVE,NULL);
+  if (fp!=INVALID_HANDLE_VALUE)
+  {
+    SetFilePointer(fp,0,NULL,FILE_END);
+    ::WriteFile(fp,rec,len,&transferred,NULL);
+    CloseHandle(fp);
+  }
+  ReleaseMutex(UidlMutex);
+}
+
+BOOL UidlStore::Save(PluginPanelItem *Items,int ItemsNumber)
+{
+  if (!*FileName) return FALSE;
+  WaitForSingleObject(UidlMutex,INFINITE);
+  // another FAR may have appended states since Load(), they are kept
+  LoadFile(FileName);
+  BOOL res=Rewrite(Items,ItemsNumber);
+  ReleaseMutex(UidlMutex);
+  return res;
+}
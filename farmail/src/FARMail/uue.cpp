@@ -51,14 +51,15 @@ void DecodeUUE ( char * dest, char *source , int num )
 {
   if ( num > 1 )
   {
-    int i = *(source++) - 0x20;
+    int i = ( *(source++) - 0x20 ) & 0x3F;
     num--;
-    while (i > 0 && i < num)
+    // a short line must not be read past its end
+    while (i > 0 && i < num && num >= 4)
     {
-      int i1 = *(source++) - 0x20;
-      int i2 = *(source++) - 0x20;
-      int i3 = *(source++) - 0x20;
-      int i4 = *(source++) - 0x20;
+      int i1 = ( *(source++) - 0x20 ) & 0x3F;
+      int i2 = ( *(source++) - 0x20 ) & 0x3F;
+      int i3 = ( *(source++) - 0x20 ) & 0x3F;
+      int i4 = ( *(source++) - 0x20 ) & 0x3F;
 
       int a = (i1<<2 & 0xfc) | (i2>>4 & 0x3);
       int b = (i2<<4 & 0xf0) | (i3>>2 & 0xf);
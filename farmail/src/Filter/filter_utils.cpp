@@ -40,8 +40,21 @@ typedef struct __BLOCKLINE
 {
   char filter[1024];
   int  method;
+  int  next; // previous rule with the same header name, -1 if none
 } BLOCKLINE;
 
+#define RULE_BUCKETS 256
+
+// Rules grouped by the header name that starts their pattern ("from:*spam*"
+// goes to "from:"), so a header line is only checked against the rules for
+// its own header plus the rules that can match any line.
+typedef struct __BLOCKRULES
+{
+  BLOCKLINE *lines;
+  int total;
+  int head[RULE_BUCKETS+1]; // last rule of each chain, the extra one is for unbound rules
+} BLOCKRULES;
+
 char *strchr(register const char *s,int c)
 {
   do
@@ -91,7 +104,7 @@ static int GetName(char *file,char *name)
 static BLOCKLINE *GetBlockLines(char *file,int *total,int lwr)
 {
   BLOCKLINE *ptr=NULL;
-  int num=0;
+  int num=0,size=0;
   HANDLE fp=CreateFile(file,GENERIC_READ,FILE_SHARE_READ,NULL,OPEN_EXISTING,FILE_FLAG_SEQUENTIAL_SCAN,NULL);
   if(fp!=INVALID_HANDLE_VALUE)
   {
@@ -114,9 +127,21 @@ static BLOCKLINE *GetBlockLines(char *file,int *total,int lwr)
         FSF.Trim(z+1);
         if(!FSF.LStricmp(str,"select")||!FSF.LStricmp(str,"unselect"))
         {
+          if(num==size)
+          {
+            BLOCKLINE *newptr;
+            size=size?size*2:64;
+            newptr=(BLOCKLINE *)z_realloc(ptr,sizeof(BLOCKLINE)*size);
+            if(!newptr)
+            {
+              z_free(ptr);
+              ptr=NULL;
+              num=0;
+              break;
+            }
+            ptr=newptr;
+          }
           num++;
-          ptr=(BLOCKLINE *)z_realloc(ptr,sizeof(BLOCKLINE)*num);
-          if(!ptr) break;
           if(*str=='u'||*str=='U')
             ptr[num-1].method=BL_UNSELECT;
           else
@@ -230,48 +255,84 @@ static int GetFilter(char *filtername)
   return retval;
 }
 
-static int CompareEStrings(char *str,char *mask,int SkipEndOfStr)
+static int ComparePattern(const char *str,const char *mask)
 {
-  while(*mask)
+  const char *star=NULL,*back=NULL;
+  while(TRUE)
   {
-    if(*mask!=*str&&*mask!='?') return 1;
-    if(!*str) return 1;
-    mask++;
-    str++;
+    if(*mask=='*')
+    {
+      const char *ptr=mask;
+      while(*ptr=='*') ptr++;
+      // a trailing run of several stars has to match at least one char
+      if(!*ptr) return (ptr-mask>1&&!*str)?1:0;
+      star=mask=ptr;
+      back=str;
+    }
+    else if(*str&&(*mask==*str||*mask=='?'))
+    {
+      mask++;
+      str++;
+    }
+    else if(!*mask&&!*str) return 0;
+    else
+    {
+      if(!star||!*back) return 1;
+      mask=star;
+      str=++back;
+    }
   }
-  if(!(*str)||SkipEndOfStr) return 0;
-  return 1;
 }
 
-static int ComparePattern(char *str,char *mask)
+static unsigned int HashHeader(const char *str,int len)
 {
-  int stat;
-  char *ptr=strchr(mask,'*');
-  if(ptr)
+  unsigned int hash=2166136261U;
+  for(int i=0;i<len;i++)
   {
-    *ptr=0;
-    stat=CompareEStrings(str,mask,1);
-    *ptr='*';
-    if(!stat)
-    {
-      if(*(ptr+1))
-      {
-        char *mptr=str+(ptr-mask);
-        while(*mptr)
-        {
-          if(!ComparePattern(mptr,ptr+1)) return 0;
-          mptr++;
-        }
-        return 1;
-      }
-      return 0;
-    }
-    else return stat;
+    hash^=(unsigned char)str[i];
+    hash*=16777619U;
   }
-  else
+  return hash%RULE_BUCKETS;
+}
+
+static void CompileRules(BLOCKRULES *rules,BLOCKLINE *lines,int total)
+{
+  int i,k;
+  rules->lines=lines;
+  rules->total=total;
+  for(i=0;i<=RULE_BUCKETS;i++) rules->head[i]=-1;
+  for(k=0;k<total;k++)
+  {
+    const char *ptr=lines[k].filter;
+    while(*ptr&&*ptr!=':'&&*ptr!='*'&&*ptr!='?') ptr++;
+    i=(*ptr==':')?HashHeader(lines[k].filter,ptr-lines[k].filter+1):RULE_BUCKETS;
+    lines[k].next=rules->head[i];
+    rules->head[i]=k;
+  }
+}
+
+// returns the highest rule above best that matches the line, or best
+static int MatchRules(BLOCKRULES *rules,const char *line,int best)
+{
+  const char *ptr=strchr(line,':');
+  int bound=ptr?rules->head[HashHeader(line,ptr-line+1)]:-1;
+  int unbound=rules->head[RULE_BUCKETS];
+  while(bound>best||unbound>best)
   {
-    return CompareEStrings(str,mask,0);
+    int k;
+    if(bound>unbound)
+    {
+      k=bound;
+      bound=rules->lines[k].next;
+    }
+    else
+    {
+      k=unbound;
+      unbound=rules->lines[k].next;
+    }
+    if(!ComparePattern(line,rules->lines[k].filter)) return k;
   }
+  return best;
 }
 
 static const char FilterHistory[]="FARMailFltHist";
@@ -281,6 +342,7 @@ int RunFilter(HANDLE hPlugin,int index)
   int stat;
   int total=0;
   BLOCKLINE *blocklist=NULL;
+  BLOCKRULES rules;
 
   static struct InitDialogItem InitItems[]=
   {
@@ -326,6 +388,7 @@ int RunFilter(HANDLE hPlugin,int index)
       if(GetFilter(fname)) return 0;
       blocklist=GetBlockLines(fname,&total,DialogItems[C_CHK3].Selected);
       if(!blocklist) return 0;
+      CompileRules(&rules,blocklist,total);
     }
     if(FarInfo.Control(hPlugin,FCTL_GETPANELINFO,(void*)&pis))
     {
@@ -346,7 +409,7 @@ int RunFilter(HANDLE hPlugin,int index)
         if(line)
         {
           int res=0;
-          int match=0;
+          int match=-1;
 
           buff=z_strdup(line);
           if(buff)
@@ -383,18 +446,11 @@ int RunFilter(HANDLE hPlugin,int index)
                   }
                   else
                   {
-                    int k;
-                    for(k=0;k<total;k++)
-                    {
-                      if(!ComparePattern(freethis,blocklist[k].filter)&&k>=match)
-                      {
-                        if(blocklist[k].method==BL_SELECT)
-                          res=1;
-                        else
-                          res=2;
-                        match=k;
-                      }
-                    }
+                    // the last matching rule in the file decides
+                    match=MatchRules(&rules,freethis,match);
+                    if(match>=0)
+                      res=(blocklist[match].method==BL_SELECT)?1:2;
+                    if(match==total-1) break;
                     buff=freethis;
                     *buff=0;
                     line+=2;
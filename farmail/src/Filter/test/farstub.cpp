@@ -0,0 +1,202 @@
+/*
+    Filter sub-plugin for FARMail
+    Copyright (C) 2002-2004 FARMail Group
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+
+    FAR side of the filter for host tests: standard functions are
+    implemented by C runtime, the filter dialog is answered from
+    Dialog, the panel is Panel and the menu of lists picks the first
+    one. Included by tests after the sources under test, InitFar() is
+    to be called first.
+*/
+
+#include <stdarg.h>
+#include <malloc.h>
+#include <vector>
+
+struct PluginStartupInfo FarInfo;
+FARSTANDARDFUNCTIONS FSF;
+struct MailPluginStartupInfo FarMailInfo;
+char DefFiltersDir[MAX_PATH];
+const char NULLSTR[]="";
+
+// items of the filter dialog
+enum
+{
+  DLG_PATTERN=2,
+  DLG_SELECTEDONLY=4,
+  DLG_INVERT=5,
+  DLG_CASE=6,
+  DLG_USEFILE=7,
+  DLG_OK=8,
+};
+
+static struct
+{
+  int Button;
+  char Pattern[512];
+  int SelectedOnly,Invert,Case;
+} Dialog;
+
+static std::vector<PluginPanelItem> Panel;
+
+static int failed;
+
+static void Check(bool ok,const char* what)
+{
+  if(ok)return;
+  printf("FAIL: %s\n",what);
+  failed++;
+}
+
+char *GetMsg(int MsgNum,char *Str)
+{
+  sprintf(Str,"message %d",MsgNum);
+  return Str;
+}
+
+void InitDialogItems(struct InitDialogItem *Init,struct FarDialogItem *Item,int ItemsNumber)
+{
+  memset(Item,0,sizeof(*Item)*ItemsNumber);
+  for(int i=0;i<ItemsNumber;i++)
+  {
+    Item[i].Type=Init[i].Type;
+    Item[i].Selected=Init[i].Selected;
+    Item[i].Flags=Init[i].Flags;
+    if((unsigned long)Init[i].Data<2000)
+      GetMsg((unsigned long)Init[i].Data,Item[i].Data);
+    else
+      lstrcpy(Item[i].Data,Init[i].Data);
+  }
+}
+
+// zeroed as HeapReAlloc with HEAP_ZERO_MEMORY does
+void *z_calloc(size_t nitems,size_t size)
+{
+  return calloc(nitems,size);
+}
+
+void *z_malloc(size_t size)
+{
+  return calloc(1,size);
+}
+
+void *z_realloc(void *block,size_t size)
+{
+  if(!size)
+  {
+    free(block);
+    return NULL;
+  }
+  size_t old=block?malloc_usable_size(block):0;
+  char *res=(char*)realloc(block,size);
+  size_t now=malloc_usable_size(res);
+  if(res&&now>old) memset(res+old,0,now-old);
+  return res;
+}
+
+void z_free(void *block)
+{
+  free(block);
+}
+
+char *z_strdup(const char *block)
+{
+  return strdup(block);
+}
+
+static int WINAPI FarDialogEx(int PluginNumber,int X1,int Y1,int X2,int Y2,const char *HelpTopic,
+                              struct FarDialogItem *Item,int ItemsNumber,DWORD Reserved,DWORD Flags,
+                              FARWINDOWPROC DlgProc,long Param)
+{
+  lstrcpy(Item[DLG_PATTERN].Data,Dialog.Pattern);
+  Item[DLG_SELECTEDONLY].Selected=Dialog.SelectedOnly;
+  Item[DLG_INVERT].Selected=Dialog.Invert;
+  Item[DLG_CASE].Selected=Dialog.Case;
+  return Dialog.Button;
+}
+
+static int WINAPI FarMenu(int PluginNumber,int X,int Y,int MaxHeight,DWORD Flags,const char *Title,
+                          const char *Bottom,const char *HelpTopic,const int *BreakKeys,int *BreakCode,
+                          const struct FarMenuItem *Item,int ItemsNumber)
+{
+  return 0;
+}
+
+static int WINAPI FarMessage(int PluginNumber,DWORD Flags,const char *HelpTopic,
+                             const char * const *Items,int ItemsNumber,int ButtonsNumber)
+{
+  printf("error: %s\n",Items[1]);
+  return 0;
+}
+
+static int WINAPI FarControl(HANDLE hPlugin,int Command,void *Param)
+{
+  if(Command==FCTL_GETPANELINFO)
+  {
+    PanelInfo *pi=(PanelInfo*)Param;
+    memset(pi,0,sizeof(*pi));
+    pi->PanelItems=Panel.empty()?NULL:&Panel[0];
+    pi->ItemsNumber=Panel.size();
+  }
+  return TRUE;
+}
+
+static int WINAPIV FarSprintf(char *buf,const char *fmt,...)
+{
+  va_list args;
+  va_start(args,fmt);
+  int res=vsprintf(buf,fmt,args);
+  va_end(args);
+  return res;
+}
+
+static void WINAPI FarStrlwr(char *s)
+{
+  for(;*s;s++) *s=tolower(*s);
+}
+
+static int WINAPI FarStricmp(const char *s1,const char *s2)
+{
+  return strcasecmp(s1,s2);
+}
+
+static char *WINAPI FarTrim(char *s)
+{
+  char *p=s;
+  while(*p==' '||*p=='\t') p++;
+  memmove(s,p,strlen(p)+1);
+  int len=strlen(s);
+  while(len&&(s[len-1]==' '||s[len-1]=='\t')) s[--len]=0;
+  return s;
+}
+
+static void InitFar(void)
+{
+  FSF.StructSize=sizeof(FSF);
+  FSF.sprintf=FarSprintf;
+  FSF.LStrlwr=FarStrlwr;
+  FSF.LStricmp=FarStricmp;
+  FSF.Trim=FarTrim;
+  FarInfo.StructSize=sizeof(FarInfo);
+  FarInfo.FSF=&FSF;
+  FarInfo.DialogEx=FarDialogEx;
+  FarInfo.Menu=FarMenu;
+  FarInfo.Message=FarMessage;
+  FarInfo.Control=FarControl;
+  FarMailInfo.StructSize=sizeof(FarMailInfo);
+}
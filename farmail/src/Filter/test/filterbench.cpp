@@ -0,0 +1,154 @@
+/*
+    Filter sub-plugin for FARMail
+    Copyright (C) 2002-2004 FARMail Group
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+
+    Benchmark of the pattern filter against the one before rules were
+    indexed: RunFilter over 500 messages with lists of growing number
+    of rules bound to headers, and one mask with more and more stars
+    against a long line. The new time includes reading of the list.
+    Largest number of rules is the argument, 10000 by default.
+*/
+
+#include <string>
+#include "filter.hpp"
+#include "memory.hpp"
+// the filter brings its own strchr, the one of C runtime is declared
+#define strchr FilterStrchr
+#include "filter_utils.cpp"
+#include "crt_file.cpp"
+#include "test/farstub.cpp"
+#include "test/oldfilter.cpp"
+#include <time.h>
+#include <unistd.h>
+
+#define MESSAGES 500
+
+static double Now()
+{
+  timespec ts;
+  clock_gettime(CLOCK_MONOTONIC,&ts);
+  return ts.tv_sec+ts.tv_nsec/1e9;
+}
+
+static void Rules(const char *fn,int total)
+{
+  char fn2[MAX_PATH];
+  std::vector<std::string> headers(MESSAGES);
+  std::vector<char*> columns(MESSAGES);
+  BLOCKLINE *rules=(BLOCKLINE*)z_calloc(total,sizeof(BLOCKLINE));
+  FILE *f=fopen(fn,"wb");
+  fprintf(f,"name=bench\r\n");
+  for(int k=0;k<total;k++)
+  {
+    switch(k%10)
+    {
+      case 0: case 1: case 2: sprintf(rules[k].filter,"from: *@spam%d.example.com*",k); break;
+      case 3: case 4: case 5: sprintf(rules[k].filter,"subject: *offer %d*",k); break;
+      case 6: case 7: case 8: sprintf(rules[k].filter,"received: *relay%d.*",k); break;
+      default: sprintf(rules[k].filter,"*x-mailer-%d*",k); break;
+    }
+    rules[k].method=k%2?BL_UNSELECT:BL_SELECT;
+    fprintf(f,"%s = %s\r\n",k%2?"unselect":"select",rules[k].filter);
+  }
+  fclose(f);
+
+  Panel.assign(MESSAGES,PluginPanelItem());
+  for(int i=0;i<MESSAGES;i++)
+  {
+    char header[1024];
+    sprintf(header,"From: Sender %d <user%d@spam%d.example.com>\r\n"
+                   "To: you@example.org\r\n"
+                   "Subject: special offer %d for you\r\n"
+                   "Date: Mon, 1 Mar 2004 10:00:00 +0300\r\n"
+                   "Received: from relay%d.example.net by mx.example.org\r\n"
+                   "Received: from mx.example.org by pop.example.org\r\n"
+                   "Received: from pop.example.org by localhost\r\n"
+                   "Message-ID: <%d@example.net>\r\n",
+                   i,i,i*7,i*3,i*11,i);
+    headers[i]=header;
+    columns[i]=(char*)headers[i].c_str();
+    memset(&Panel[i],0,sizeof(Panel[i]));
+    sprintf(Panel[i].FindData.cFileName,"%d.msg",i);
+    Panel[i].CustomColumnData=&columns[i];
+    Panel[i].CustomColumnNumber=1;
+  }
+
+  std::vector<DWORD> expect(MESSAGES);
+  double start=Now();
+  for(int i=0;i<MESSAGES;i++)
+    expect[i]=OldSelection(0,OldFilter(headers[i].c_str(),NULL,rules,total,0),0);
+  double oldtime=Now()-start;
+
+  Dialog.Button=DLG_USEFILE;
+  start=Now();
+  RunFilter(NULL,0);
+  double newtime=Now()-start;
+
+  int selected=0;
+  BOOL same=TRUE;
+  for(int i=0;i<MESSAGES;i++)
+  {
+    if(Panel[i].Flags&PPIF_SELECTED) selected++;
+    if((Panel[i].Flags^expect[i])&PPIF_SELECTED) same=FALSE;
+  }
+  sprintf(fn2,"%d rules select as before",total);
+  Check(same,fn2);
+  printf("filterbench: %5d rules, %d messages (%d selected): old %8.2f ms, new %8.2f ms\n",
+         total,MESSAGES,selected,oldtime*1e3,newtime*1e3);
+  z_free(rules);
+}
+
+static void Stars(int stars)
+{
+  char line[64],mask[64];
+  memset(line,'a',40);
+  line[40]=0;
+  char *p=mask;
+  for(int i=0;i<stars;i++)
+  {
+    *p++='*';
+    *p++='a';
+  }
+  lstrcpy(p,"*z");
+
+  double start=Now();
+  int old=OldComparePattern(line,mask);
+  double oldtime=Now()-start;
+  start=Now();
+  int res=ComparePattern(line,mask);
+  double newtime=Now()-start;
+  Check(!old==!res,"mask matches as before");
+  printf("filterbench: %d stars against 40 chars: old %10.3f ms, new %6.3f ms\n",
+         stars+1,oldtime*1e3,newtime*1e3);
+}
+
+int main(int argc,char *argv[])
+{
+  char fn[MAX_PATH];
+  InitFar();
+  int max=argc>1?atoi(argv[1]):10000;
+  sprintf(DefFiltersDir,"/tmp/filterbench.%d/",(int)getpid());
+  CreateDirectory(DefFiltersDir,NULL);
+  sprintf(fn,"%srules.fmf",DefFiltersDir);
+  for(int total=10;total<=max;total*=10) Rules(fn,total);
+  DeleteFile(fn);
+  RemoveDirectory(DefFiltersDir);
+  for(int stars=2;stars<=6;stars+=2) Stars(stars);
+  printf("filterbench: %d failed\n",failed);
+  return failed!=0;
+}
@@ -0,0 +1,217 @@
+/*
+    Filter sub-plugin for FARMail
+    Copyright (C) 2002-2004 FARMail Group
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+
+    Differential test of the pattern filter against the one before
+    rules were indexed: every mask of up to 5 chars of "ab?*" against
+    every string of up to 6 chars of "ab", random longer masks, and
+    RunFilter on random rule lists and headers in all modes of the
+    dialog selects the same messages as the old loop did.
+*/
+
+#include <string>
+#include "filter.hpp"
+#include "memory.hpp"
+// the filter brings its own strchr, the one of C runtime is declared
+#define strchr FilterStrchr
+#include "filter_utils.cpp"
+#include "crt_file.cpp"
+#include "test/farstub.cpp"
+#include "test/oldfilter.cpp"
+#include <unistd.h>
+
+static BOOL SameMatch(const char *str,const char *mask)
+{
+  static char s[64],m[64];
+  lstrcpy(s,str);
+  lstrcpy(m,mask);
+  return (ComparePattern(s,m)==0)==(OldComparePattern(s,m)==0);
+}
+
+// all strings of length up to max over chars
+static void Strings(std::vector<std::string> &list,const char *chars,int max)
+{
+  list.clear();
+  list.push_back("");
+  for(size_t i=0;i<list.size();i++)
+  {
+    if((int)list[i].size()==max) continue;
+    for(const char *c=chars;*c;c++) list.push_back(list[i]+*c);
+  }
+}
+
+static void TestPatterns(void)
+{
+  std::vector<std::string> masks,strs;
+  Strings(masks,"ab?*",5);
+  Strings(strs,"ab",6);
+  char what[128];
+  int bad=0;
+  for(size_t i=0;i<masks.size();i++)
+    for(size_t k=0;k<strs.size();k++)
+      if(!SameMatch(strs[k].c_str(),masks[i].c_str())&&bad++<5)
+      {
+        sprintf(what,"\"%s\" against \"%s\" as before",strs[k].c_str(),masks[i].c_str());
+        Check(false,what);
+      }
+  Check(!bad,"all short masks match as before");
+
+  srand(1);
+  bad=0;
+  for(int n=0;n<200000;n++)
+  {
+    char str[20],mask[16];
+    int len=rand()%sizeof(str);
+    for(int i=0;i<len;i++) str[i]="abc"[rand()%3];
+    str[len]=0;
+    len=rand()%sizeof(mask);
+    for(int i=0;i<len;i++) mask[i]="abc?**"[rand()%6];
+    mask[len]=0;
+    if(!SameMatch(str,mask)&&bad++<5)
+    {
+      sprintf(what,"\"%s\" against \"%s\" as before",str,mask);
+      Check(false,what);
+    }
+  }
+  Check(!bad,"random masks match as before");
+}
+
+static const char *Names[]={"From:","To:","Subject:","X-Spam:","Received:"};
+static const char *Words[]={"spam","ham","a@b.com","Buy","now"," "};
+static const char *Tokens[]={"*","*","?","spam","ham","b","now"," ","*a*"};
+
+#define COUNT(a) (int)(sizeof(a)/sizeof(a[0]))
+
+static std::string RandomCase(const char *s)
+{
+  std::string res(s);
+  for(size_t i=0;i<res.size();i++)
+    if(rand()%4==0) res[i]=toupper(res[i]);
+  return res;
+}
+
+static std::string RandomHeader(void)
+{
+  std::string header;
+  int lines=1+rand()%6;
+  for(int i=0;i<lines;i++)
+  {
+    header+=RandomCase(Names[rand()%COUNT(Names)]);
+    int words=rand()%4;
+    for(int k=0;k<words;k++)
+    {
+      header+=' ';
+      header+=RandomCase(Words[rand()%COUNT(Words)]);
+      if(rand()%8==0) header+=rand()%2?"\r\n\t":"\r\n ";
+    }
+    if(i<lines-1||rand()%2) header+="\r\n";
+  }
+  return header;
+}
+
+static std::string RandomMask(void)
+{
+  std::string mask;
+  switch(rand()%4)
+  {
+    case 0: break;
+    case 1: mask="?o:"; break;
+    default: mask=RandomCase(Names[rand()%COUNT(Names)]); break;
+  }
+  int tokens=rand()%5;
+  for(int i=0;i<tokens;i++) mask+=Tokens[rand()%COUNT(Tokens)];
+  char buf[1024];
+  lstrcpy(buf,mask.c_str());
+  FSF.Trim(buf);
+  return buf;
+}
+
+static void TestRunFilter(void)
+{
+  char fn[MAX_PATH],what[128];
+  sprintf(DefFiltersDir,"/tmp/filtertest.%d/",(int)getpid());
+  CreateDirectory(DefFiltersDir,NULL);
+  sprintf(fn,"%srules.fmf",DefFiltersDir);
+  srand(2);
+  int bad=0;
+  for(int round=0;round<3000;round++)
+  {
+    static BLOCKLINE rules[64];
+    int total=rand()%COUNT(rules);
+    Dialog.Button=rand()%4?DLG_USEFILE:DLG_OK;
+    Dialog.SelectedOnly=rand()%4==0;
+    Dialog.Invert=rand()%4==0;
+    Dialog.Case=rand()%2;
+    lstrcpy(Dialog.Pattern,RandomMask().c_str());
+
+    FILE *f=fopen(fn,"wb");
+    fprintf(f,"name=test\r\n; comment\r\n");
+    for(int k=0;k<total;k++)
+    {
+      rules[k].method=rand()%3?BL_SELECT:BL_UNSELECT;
+      lstrcpy(rules[k].filter,RandomMask().c_str());
+      fprintf(f,"%s = %s\r\n",rules[k].method==BL_SELECT?"select":"unselect",rules[k].filter);
+      if(!Dialog.Case) FSF.LStrlwr(rules[k].filter);
+    }
+    fclose(f);
+    // an empty list is refused before any message is seen
+    if(!total) Dialog.Button=DLG_OK;
+
+    int count=20;
+    std::vector<std::string> headers(count);
+    std::vector<char*> columns(count);
+    std::vector<DWORD> expect(count);
+    Panel.assign(count,PluginPanelItem());
+    for(int i=0;i<count;i++)
+    {
+      headers[i]=RandomHeader();
+      columns[i]=(char*)headers[i].c_str();
+      memset(&Panel[i],0,sizeof(Panel[i]));
+      sprintf(Panel[i].FindData.cFileName,"%d.msg",i);
+      Panel[i].CustomColumnData=&columns[i];
+      Panel[i].CustomColumnNumber=1;
+      Panel[i].Flags=rand()%2?PPIF_SELECTED:0;
+      expect[i]=Panel[i].Flags;
+      if(Dialog.SelectedOnly&&!(expect[i]&PPIF_SELECTED)) continue;
+      char pattern[512];
+      lstrcpy(pattern,Dialog.Pattern);
+      if(!Dialog.Case) FSF.LStrlwr(pattern);
+      int yup=OldFilter(headers[i].c_str(),pattern,Dialog.Button==DLG_OK?NULL:rules,total,Dialog.Case);
+      expect[i]=OldSelection(expect[i],yup,Dialog.Invert);
+    }
+    RunFilter(NULL,0);
+    for(int i=0;i<count;i++)
+      if((Panel[i].Flags&PPIF_SELECTED)!=(expect[i]&PPIF_SELECTED)&&bad++<5)
+      {
+        sprintf(what,"round %d, message %d is selected as before",round,i);
+        Check(false,what);
+      }
+  }
+  Check(!bad,"RunFilter selects as before");
+  DeleteFile(fn);
+  RemoveDirectory(DefFiltersDir);
+}
+
+int main(int argc,char *argv[])
+{
+  InitFar();
+  TestPatterns();
+  TestRunFilter();
+  printf("filtertest: %d failed\n",failed);
+  return failed!=0;
+}
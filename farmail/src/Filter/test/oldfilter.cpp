@@ -0,0 +1,142 @@
+/*
+    Filter sub-plugin for FARMail
+    Copyright (C) 2002-2004 FARMail Group
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+
+    The pattern filter as it was before rules were indexed, reference
+    of tests: a mask is matched recursively at every '*', every line
+    of a header is checked against every rule of the list.
+*/
+
+static int OldCompareEStrings(char *str,char *mask,int SkipEndOfStr)
+{
+  while(*mask)
+  {
+    if(*mask!=*str&&*mask!='?') return 1;
+    if(!*str) return 1;
+    mask++;
+    str++;
+  }
+  if(!(*str)||SkipEndOfStr) return 0;
+  return 1;
+}
+
+static int OldComparePattern(char *str,char *mask)
+{
+  int stat;
+  char *ptr=strchr(mask,'*');
+  if(ptr)
+  {
+    *ptr=0;
+    stat=OldCompareEStrings(str,mask,1);
+    *ptr='*';
+    if(!stat)
+    {
+      if(*(ptr+1))
+      {
+        char *mptr=str+(ptr-mask);
+        while(*mptr)
+        {
+          if(!OldComparePattern(mptr,ptr+1)) return 0;
+          mptr++;
+        }
+        return 1;
+      }
+      return 0;
+    }
+    else return stat;
+  }
+  else
+  {
+    return OldCompareEStrings(str,mask,0);
+  }
+}
+
+// what the loop of RunFilter made of a header: 1 to select, 2 to
+// deselect; rules is NULL for the pattern of the dialog, they and the
+// pattern are lowercased already unless the case matters
+static int OldFilter(const char *line,const char *pattern,BLOCKLINE *blocklist,int total,int cased)
+{
+  int yup=0,res=0,match=-1;
+  char *buff=z_strdup(line);
+  char *freethis=buff;
+  *buff=0;
+  while(*line)
+  {
+    if(*line=='\r'&&*(line+1)=='\n')
+    {
+      if(*(line+2)==32||*(line+2)==9)
+      {
+        line+=2;
+      }
+      else
+      {
+        if(!cased) FSF.LStrlwr(freethis);
+        if(!blocklist)
+        {
+          if(OldComparePattern(freethis,(char*)pattern))
+          {
+            buff=freethis;
+            *buff=0;
+            line+=2;
+          }
+          else
+          {
+            yup=1;
+            break;
+          }
+        }
+        else
+        {
+          int k;
+          for(k=0;k<total;k++)
+          {
+            if(!OldComparePattern(freethis,blocklist[k].filter)&&k>=match)
+            {
+              if(blocklist[k].method==BL_SELECT)
+                res=1;
+              else
+                res=2;
+              match=k;
+            }
+          }
+          buff=freethis;
+          *buff=0;
+          line+=2;
+        }
+      }
+    }
+    else
+    {
+      *(buff++)=*(line++);
+      *(buff)=0;
+    }
+  }
+  z_free(freethis);
+  if(res) yup=res;
+  if(!yup) yup=2;
+  return yup;
+}
+
+// panel flags after the filter
+static DWORD OldSelection(DWORD flags,int yup,int invert)
+{
+  if(yup==1) flags|=PPIF_SELECTED;
+  else if(flags&PPIF_SELECTED) flags-=PPIF_SELECTED;
+  if(invert) flags^=PPIF_SELECTED;
+  return flags;
+}
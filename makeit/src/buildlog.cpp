@@ -0,0 +1,700 @@
+/*
+  Copyright (C) 2000 Konstantin Stupnik
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#include <windows.h>
+#include <stdio.h>
+#include "makeit.h"
+
+//number of lines in one page of saved log
+#define LOG_PAGE 256
+//size of block for reading saved log
+#define LOG_BLOCK 65536
+//size of the log head used to check that log wasn't rewritten
+#define LOG_HEAD 4096
+
+static const char idxmagic[4]={'M','K','I','3'};
+
+struct SLogIndexHeader{
+  char magic[4];
+  LONGLONG size;
+  FILETIME mtime;
+  DWORD headsum;
+  DWORD tailsum;
+  int lines;
+  int pages;
+  int diags;
+  char parser[64];
+};
+
+CBuildLog::CBuildLog()
+{
+  hfile=INVALID_HANDLE_VALUE;
+  lines=0;
+  filtered=0;
+  size=0;
+  headsum=tailsum=0;
+  cachepage[0]=cachepage[1]=-1;
+  cachelast=0;
+  lastdiag=-1;
+  pending=-1;
+  errors=warnings=0;
+}
+
+CBuildLog::~CBuildLog()
+{
+  Clean();
+}
+
+void CBuildLog::FreeDiags(int fromline)
+{
+  SLogDiag d;
+  while(diags.Count() && diags[-1].line>=fromline)
+  {
+    diags.Pop(d);
+    delete d.info;
+  }
+}
+
+void CBuildLog::FreeMatches(int fromline)
+{
+  SLogMatch m;
+  while(matches.Count() && matches[-1].line>=fromline)
+  {
+    matches.Pop(m);
+    delete m.info;
+  }
+}
+
+void CBuildLog::Clean()
+{
+  if(hfile!=INVALID_HANDLE_VALUE)CloseHandle(hfile);
+  hfile=INVALID_HANDLE_VALUE;
+  filename="";
+  mem.Clean();
+  pages.Clean();
+  cache[0].Clean();
+  cache[1].Clean();
+  cachepage[0]=cachepage[1]=-1;
+  FreeDiags(0);
+  FreeMatches(0);
+  tried.Clean();
+  view.Clean();
+  filtered=0;
+  lines=0;
+  size=0;
+  parser="";
+  Regroup();
+}
+
+int CBuildLog::Count()
+{
+  return filtered?view.Count():lines;
+}
+
+int CBuildLog::Source(int index)
+{
+  if(index<0 || index>=Count())return -1;
+  return filtered?view[index]:index;
+}
+
+int CBuildLog::FindDiag(int line)
+{
+  int l=0,r=diags.Count()-1;
+  while(l<=r)
+  {
+    int m=(l+r)/2;
+    if(diags[m].line==line)return m;
+    if(diags[m].line<line)l=m+1;
+    else r=m-1;
+  }
+  return -1;
+}
+
+int CBuildLog::FindView(int line)
+{
+  int l=0,r=view.Count()-1;
+  while(l<=r)
+  {
+    int m=(l+r)/2;
+    if(view[m]==line)return m;
+    if(view[m]<line)l=m+1;
+    else r=m-1;
+  }
+  return -1;
+}
+
+const String& CBuildLog::operator[](int index)
+{
+  static String empty;
+  int src=Source(index);
+  if(src<0 || src>=lines)return empty;
+  if(hfile==INVALID_HANDLE_VALUE)return mem[src];
+  StrList& pg=GetPage(src/LOG_PAGE);
+  if(src%LOG_PAGE>=pg.Count())return empty;
+  return pg[src%LOG_PAGE];
+}
+
+SLineInfo* CBuildLog::Info(int index)
+{
+  int src=Source(index);
+  if(src<0)return NULL;
+  int i=FindDiag(src);
+  return i==-1?NULL:diags[i].info;
+}
+
+//error or warning reported for the first time
+int CBuildLog::IsPrimary(int idx)
+{
+  SLineInfo *li=diags[idx].info;
+  return li->parent==diags[idx].line && !li->dup;
+}
+
+int CBuildLog::Next(int index,int dir)
+{
+  if(filtered)
+  {
+    for(index+=dir;index>=0 && index<view.Count();index+=dir)
+    {
+      int i=FindDiag(Source(index));
+      if(i!=-1 && IsPrimary(i))return index;
+    }
+    return -1;
+  }
+  //first diagnostic after index, or last before it
+  int l=0,r=diags.Count()-1;
+  while(l<=r)
+  {
+    int m=(l+r)/2;
+    if(diags[m].line<=index)l=m+1;
+    else r=m-1;
+  }
+  if(dir>0)
+  {
+    while(l<diags.Count() && !IsPrimary(l))l++;
+    return l<diags.Count()?diags[l].line:-1;
+  }
+  if(l>0 && diags[l-1].line==index)l--;
+  while(l>0 && !IsPrimary(l-1))l--;
+  return l>0?diags[l-1].line:-1;
+}
+
+int CBuildLog::ViewIndex(int line)
+{
+  if(line<0 || line>=lines)return -1;
+  return filtered?FindView(line):line;
+}
+
+static DWORD TextSum(const char* text)
+{
+  DWORD sum=0;
+  for(;*text;text++)sum=sum*31+(unsigned char)*text;
+  return sum;
+}
+
+//same message at the same place
+static String DiagKey(const SLineInfo* li)
+{
+  char buf[32];
+  sprintf(buf,":%d:%08x",li->line,li->sum);
+  String key=li->file;
+  key+=buf;
+  return key;
+}
+
+void CBuildLog::Tally(int idx)
+{
+  SLineInfo *li=diags[idx].info;
+  if(li->dup)return;
+  SFileDiags& fd=files[li->file];
+  if(li->error==DIAG_ERROR)
+  {
+    fd.errors++;
+    errors++;
+  }else
+  {
+    fd.warnings++;
+    warnings++;
+  }
+  if(fd.first==-1)fd.first=diags[idx].line;
+}
+
+/*
+  Diagnostics are grouped as they come:
+  context lines wait for the next error or warning,
+  notes belong to the last one, with context lines before them.
+*/
+void CBuildLog::AddDiag(int line,DWORD sum,const SLineInfo& li)
+{
+  SLogDiag d;
+  d.line=line;
+  d.info=new SLineInfo(li);
+  d.info->parent=-1;
+  d.info->dup=0;
+  d.info->sum=sum;
+  diags.Push(d);
+  int idx=diags.Count()-1;
+  SLineInfo *p=d.info;
+  if(p->error==DIAG_CONTEXT)
+  {
+    if(pending==-1)pending=idx;
+    return;
+  }
+  if(p->error==DIAG_NOTE)
+  {
+    if(lastdiag!=-1)
+    {
+      p->parent=diags[lastdiag].line;
+      p->dup=diags[lastdiag].info->dup;
+      for(int i=pending;pending!=-1 && i<idx;i++)
+      {
+        SLineInfo *c=diags[i].info;
+        if(c->error!=DIAG_CONTEXT || c->parent!=-1)continue;
+        c->parent=p->parent;
+        c->dup=p->dup;
+      }
+      pending=-1;
+    }
+    return;
+  }
+  p->parent=line;
+  String key=DiagKey(p);
+  if(seen.Exists(key))p->dup=1;
+  else seen.Insert(key,1);
+  for(int i=pending;pending!=-1 && i<idx;i++)
+  {
+    SLineInfo *c=diags[i].info;
+    if(c->error!=DIAG_CONTEXT || c->parent!=-1)continue;
+    c->parent=line;
+    c->dup=p->dup;
+  }
+  pending=-1;
+  lastdiag=idx;
+  Tally(idx);
+}
+
+//restore grouping state from diagnostics that are left
+void CBuildLog::Regroup()
+{
+  seen.Empty();
+  files.Empty();
+  errors=warnings=0;
+  lastdiag=-1;
+  pending=-1;
+  for(int i=0;i<diags.Count();i++)
+  {
+    SLineInfo *li=diags[i].info;
+    if(li->error==DIAG_NOTE)continue;
+    if(li->error==DIAG_CONTEXT)
+    {
+      //its diagnostic is going to be parsed again
+      if(li->parent>=lines)
+      {
+        li->parent=-1;
+        li->dup=0;
+      }
+      if(li->parent==-1 && pending==-1)pending=i;
+      continue;
+    }
+    if(!li->dup)seen.Insert(DiagKey(li),1);
+    pending=-1;
+    lastdiag=i;
+    Tally(i);
+  }
+}
+
+void CBuildLog::Add(const char* line,const SLineInfo* li)
+{
+  mem<<line;
+  if(li)AddDiag(lines,TextSum(line),*li);
+  lines++;
+}
+
+void CBuildLog::EnsureLine()
+{
+  if(Count())return;
+  view.Clean();
+  view.Push(-1);
+  filtered=1;
+}
+
+int CBuildLog::Filter(int errorsonly,int pos)
+{
+  Vector<int> newview;
+  int newpos=0;
+  for(int i=0;i<diags.Count();i++)
+  {
+    //repeated diagnostics are dropped with their notes
+    if(diags[i].info->dup)continue;
+    if(errorsonly && diags[i].info->error!=DIAG_ERROR)continue;
+    int old=filtered?FindView(diags[i].line):diags[i].line;
+    if(old==-1)continue;
+    if(old<pos)newpos++;
+    newview.Push(diags[i].line);
+  }
+  view.Swap(newview);
+  filtered=1;
+  return newpos;
+}
+
+LONGLONG CBuildLog::FileSize()
+{
+  DWORD high=0;
+  DWORD low=GetFileSize(hfile,&high);
+  if(low==INVALID_FILE_SIZE && GetLastError()!=NO_ERROR)return 0;
+  return ((LONGLONG)high<<32)|low;
+}
+
+static void Seek(HANDLE h,LONGLONG pos)
+{
+  LONG high=(LONG)(pos>>32);
+  SetFilePointer(h,(LONG)(pos&0xffffffff),&high,FILE_BEGIN);
+}
+
+//checksum of len bytes of the file from pos, len is not more than LOG_HEAD
+static DWORD RangeSum(HANDLE h,LONGLONG pos,LONGLONG len)
+{
+  char buf[LOG_HEAD];
+  DWORD rd=0;
+  DWORD sum=0;
+  Seek(h,pos);
+  if(!ReadFile(h,buf,(DWORD)len,&rd,NULL))return 0;
+  for(DWORD i=0;i<rd;i++)
+  {
+    sum=sum*31+(unsigned char)buf[i];
+  }
+  return sum;
+}
+
+//checksum of first len bytes of the log, but not more than LOG_HEAD
+DWORD CBuildLog::HeadSum(LONGLONG len)
+{
+  return RangeSum(hfile,0,len>LOG_HEAD?LOG_HEAD:len);
+}
+
+//checksum of up to LOG_HEAD bytes before offset len
+DWORD CBuildLog::TailSum(LONGLONG len)
+{
+  if(len<=LOG_HEAD)return RangeSum(hfile,0,len);
+  return RangeSum(hfile,len-LOG_HEAD,LOG_HEAD);
+}
+
+/*
+  Log is what was indexed with something appended:
+  it didn't shrink and both ends of indexed part are the same.
+*/
+int CBuildLog::Appended()
+{
+  return FileSize()>=size && HeadSum(size)==headsum && TailSum(size)==tailsum;
+}
+
+void CBuildLog::AddLine(const String& line,LONGLONG offset)
+{
+  if(lines%LOG_PAGE==0 && lines/LOG_PAGE>=pages.Count())pages.Push(offset);
+  SLineInfo li;
+  if(parser.Length())
+  {
+    if(match_line(parser,line,&li))AddDiag(lines,TextSum(line),li);
+  }else
+  {
+    for(int i=0;i<tried.Count();i++)
+    {
+      if(!match_line(tried[i],line,&li))continue;
+      SLogMatch m;
+      m.parser=i;
+      m.line=lines;
+      m.info=new SLineInfo(li);
+      m.info->sum=TextSum(line);
+      matches.Push(m);
+    }
+  }
+  lines++;
+}
+
+/*
+  Read count lines starting from file offset pos into dst,
+  or pass them to AddLine if dst is NULL.
+  count=-1 reads up to the end of file.
+*/
+int CBuildLog::ReadLines(LONGLONG pos,int count,StrList* dst)
+{
+  char *buf=new char[LOG_BLOCK];
+  String line;
+  LONGLONG linestart=pos;
+  DWORD rd;
+  int cnt=0;
+  Seek(hfile,pos);
+  while(count!=0 && ReadFile(hfile,buf,LOG_BLOCK,&rd,NULL) && rd)
+  {
+    DWORD st=0;
+    for(DWORD i=0;i<rd;i++)
+    {
+      if(buf[i]!=0x0a)continue;
+      line.Concat(buf,st,i-st);
+      if(line.Length() && line[line.Length()-1]==0x0d)line.SetLength(line.Length()-1);
+      if(dst)*dst<<line;
+      else AddLine(line,linestart);
+      cnt++;
+      linestart=pos+i+1;
+      line="";
+      st=i+1;
+      if(count>0 && --count==0)break;
+    }
+    if(count==0)break;
+    line.Concat(buf,st,rd-st);
+    pos+=rd;
+  }
+  if(count!=0 && line.Length())
+  {
+    if(dst)*dst<<line;
+    else AddLine(line,linestart);
+    cnt++;
+  }
+  delete [] buf;
+  return cnt;
+}
+
+/*
+  Parse log starting from the page,
+  everything found after start of the page is dropped.
+*/
+void CBuildLog::Scan(int page)
+{
+  if(pages.Count()==0)pages.Push(0);
+  if(page<0)page=0;
+  if(page>=pages.Count())page=pages.Count()-1;
+  LONGLONG pos=pages[page];
+  lines=page*LOG_PAGE;
+  pages.Delete(page+1,-1);
+  FreeDiags(lines);
+  FreeMatches(lines);
+  Regroup();
+  cachepage[0]=cachepage[1]=-1;
+  size=FileSize();
+  GetFileTime(hfile,NULL,NULL,&mtime);
+  headsum=HeadSum(size);
+  tailsum=TailSum(size);
+  ReadLines(pos,-1,NULL);
+}
+
+StrList& CBuildLog::GetPage(int page)
+{
+  if(cachepage[0]==page)return cache[0];
+  if(cachepage[1]==page)return cache[1];
+  cachelast^=1;
+  StrList& pg=cache[cachelast];
+  pg.Clean();
+  cachepage[cachelast]=page;
+  int cnt=lines-page*LOG_PAGE;
+  if(cnt>LOG_PAGE)cnt=LOG_PAGE;
+  if(page<pages.Count() && cnt>0)ReadLines(pages[page],cnt,&pg);
+  return pg;
+}
+
+String CBuildLog::IndexName()
+{
+  return filename+".mki";
+}
+
+int CBuildLog::LoadIndex(const char* prs)
+{
+  FILE *f=fopen(IndexName(),"rb");
+  if(!f)return 0;
+  SLogIndexHeader hdr;
+  int ok=fread(&hdr,sizeof(hdr),1,f)==1 && !memcmp(hdr.magic,idxmagic,4);
+  hdr.parser[sizeof(hdr.parser)-1]=0;
+  if(ok && prs && strcmp(prs,hdr.parser))ok=0;
+  if(ok)
+  {
+    size=hdr.size;
+    headsum=hdr.headsum;
+    tailsum=hdr.tailsum;
+    ok=Appended();
+  }
+  int i;
+  for(i=0;ok && i<hdr.pages;i++)
+  {
+    LONGLONG pos;
+    if(fread(&pos,sizeof(pos),1,f)!=1)ok=0;
+    else pages.Push(pos);
+  }
+  for(i=0;ok && i<hdr.diags;i++)
+  {
+    int data[8];
+    if(fread(data,sizeof(data),1,f)!=1 || data[7]<0)
+    {
+      ok=0;
+      break;
+    }
+    SLogDiag d;
+    d.line=data[0];
+    d.info=new SLineInfo;
+    d.info->error=data[1];
+    d.info->line=data[2];
+    d.info->col=data[3];
+    d.info->parent=data[4];
+    d.info->dup=data[5];
+    d.info->sum=(DWORD)data[6];
+    if(data[7] && fread(d.info->file.Prepare(data[7]),data[7],1,f)!=1)ok=0;
+    diags.Push(d);
+  }
+  fclose(f);
+  if(!ok)
+  {
+    pages.Clean();
+    FreeDiags(0);
+    return 0;
+  }
+  parser=hdr.parser;
+  lines=hdr.lines;
+  mtime=hdr.mtime;
+  Regroup();
+  return 1;
+}
+
+void CBuildLog::SaveIndex()
+{
+  if(parser.Length()==0 || parser.Length()>=64)return;
+  FILE *f=fopen(IndexName(),"wb");
+  if(!f)return;
+  SLogIndexHeader hdr;
+  memset(&hdr,0,sizeof(hdr));
+  memcpy(hdr.magic,idxmagic,4);
+  hdr.size=size;
+  hdr.mtime=mtime;
+  hdr.headsum=headsum;
+  hdr.tailsum=tailsum;
+  hdr.lines=lines;
+  hdr.pages=pages.Count();
+  hdr.diags=diags.Count();
+  strcpy(hdr.parser,parser);
+  int ok=fwrite(&hdr,sizeof(hdr),1,f)==1;
+  int i;
+  for(i=0;ok && i<pages.Count();i++)
+  {
+    ok=fwrite(&pages[i],sizeof(LONGLONG),1,f)==1;
+  }
+  for(i=0;ok && i<diags.Count();i++)
+  {
+    SLineInfo *li=diags[i].info;
+    int data[8]={diags[i].line,li->error,li->line,li->col,
+                 li->parent,li->dup,(int)li->sum,li->file.Length()};
+    ok=fwrite(data,sizeof(data),1,f)==1;
+    if(ok && data[7])ok=fwrite((const char*)li->file,data[7],1,f)==1;
+  }
+  fclose(f);
+  if(!ok)DeleteFile(IndexName());
+}
+
+int CBuildLog::Load(const char* fname,const char* prs)
+{
+  Clean();
+  hfile=CreateFile(fname,GENERIC_READ,FILE_SHARE_READ|FILE_SHARE_WRITE,
+                   NULL,OPEN_EXISTING,0,NULL);
+  if(hfile==INVALID_HANDLE_VALUE)return 0;
+  filename=fname;
+  if(LoadIndex(prs))
+  {
+    FILETIME tm;
+    GetFileTime(hfile,NULL,NULL,&tm);
+    if(FileSize()!=size || CompareFileTime(&tm,&mtime))
+    {
+      //log was appended since index was saved
+      Scan(pages.Count()-1);
+      SaveIndex();
+    }
+    return 1;
+  }
+  parser=prs?prs:"";
+  //parser is chosen after the scan from those that matched
+  if(!prs)get_parsers(tried);
+  Scan(0);
+  SaveIndex();
+  return 1;
+}
+
+void CBuildLog::Matched(StrList& dst)
+{
+  Vector<int> hit;
+  hit.Fill(tried.Count(),0);
+  for(int i=0;i<matches.Count();i++)hit[matches[i].parser]=1;
+  for(int i=0;i<tried.Count();i++)
+  {
+    if(hit[i])dst<<tried[i];
+  }
+}
+
+void CBuildLog::Classify(const char* prs)
+{
+  parser=prs;
+  view.Clean();
+  filtered=0;
+  int idx=-1;
+  for(int i=0;i<tried.Count();i++)
+  {
+    if(tried[i]==prs)idx=i;
+  }
+  if(idx==-1)
+  {
+    FreeMatches(0);
+    tried.Clean();
+    Scan(0);
+  }else
+  {
+    //lines were matched by the first scan
+    FreeDiags(0);
+    Regroup();
+    for(int i=0;i<matches.Count();i++)
+    {
+      if(matches[i].parser==idx)AddDiag(matches[i].line,matches[i].info->sum,*matches[i].info);
+    }
+    FreeMatches(0);
+    tried.Clean();
+  }
+  SaveIndex();
+}
+
+int CBuildLog::Reload()
+{
+  if(hfile==INVALID_HANDLE_VALUE)return 0;
+  view.Clean();
+  filtered=0;
+  if(Appended())
+  {
+    Scan(pages.Count()-1);
+  }else
+  {
+    Scan(0);
+  }
+  SaveIndex();
+  return 1;
+}
+
+int CBuildLog::SaveToFile(const char* fname)
+{
+  FILE *f=fopen(fname,"wt+");
+  if(!f)return 0;
+  int cnt=Count();
+  for(int i=0;i<cnt;i++)
+  {
+    const String& s=(*this)[i];
+    fwrite((const char*)s,s.Length(),1,f);
+    fwrite("\n",1,1,f);
+  }
+  fclose(f);
+  return 1;
+}
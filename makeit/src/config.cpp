@@ -21,7 +21,7 @@
 #include "xmem.h"
 #include "xmlite.h"
 #include "makeit.h"
-#include "regexp.hpp"
+#include "RegExp.hpp"
 
 static void *Pool=NULL;
 static PXMLNode xconfig=NULL;
@@ -56,11 +56,23 @@ typedef List<SParserType> CParserTypesList;
 
 struct SParser{
   CParserTypesList errors,warnings;
+  //continuation lines of diagnostics
+  CParserTypesList notes,contexts;
+  //contexts, notes, errors and warnings, matched in one pass;
+  //continuation lines go first, since error patterns often match them too
+  RegExpSet set;
+  //definition from config, to see if parser was changed
+  String source;
 };
 
 typedef Hash<SParser*> CParsers;
 
 CParsers parsers;
+//compiled parsers of previous config,
+//reused if their definition wasn't changed
+static CParsers oldparsers;
+
+static char *kinds[]={"error","warning","note","context"};
 
 struct SPrefix{
   SFileType *type;
@@ -91,7 +103,7 @@ int read_config(const char *filename)
   {
     xmemFreePool(Pool);
     Pool=NULL;
-    delete buf;
+    delete [] buf;
     return 0;
   }
   return 1;
@@ -112,7 +124,10 @@ static int init_parser_type(PXMLNode q,SParserType& t)
     t.file=-1;
   tmp=xmlGetItemAttr(q,"line");
   if(!tmp)return 0;
-  t.line=atoi(tmp);
+  if(*tmp)
+    t.line=atoi(tmp);
+  else
+    t.line=-1;
   tmp=xmlGetItemAttr(q,"pos");
   if(tmp)t.col=atoi(tmp);
 //  tmp=xmlGetItemAttr(q,"message");
@@ -120,6 +135,104 @@ static int init_parser_type(PXMLNode q,SParserType& t)
   return 1;
 }
 
+//all attributes of parser elements that affect matching
+static String parser_source(PXMLNode x)
+{
+  static char *attrs[]={"pattern","file","line","pos"};
+  String src;
+  PXMLNode q;
+  for(int k=0;k<4;k++)
+  {
+    PHashLink e=NULL;
+    while(e=xmlEnumNode(x,kinds[k],e,&q))
+    {
+      src+=kinds[k];
+      for(int a=0;a<4;a++)
+      {
+        const char *val=xmlGetItemAttr(q,attrs[a]);
+        src+=val?"\1":"\2";
+        if(val)src+=val;
+      }
+      src+="\n";
+    }
+  }
+  return src;
+}
+
+static void delete_parser(SParser *p)
+{
+  CParserTypesList *lists[]={&p->errors,&p->warnings,&p->notes,&p->contexts};
+  for(int k=0;k<4;k++)
+  {
+    for(int j=0;j<lists[k]->Count();j++)
+    {
+      if((*lists[k])[j].re)delete (*lists[k])[j].re;
+    }
+  }
+  delete p;
+}
+
+static void free_parsers(CParsers& prs)
+{
+  char *k;
+  SParser *p;
+  prs.First();
+  while(prs.Next(k,p))
+  {
+    delete_parser(p);
+  }
+  prs.Empty();
+}
+
+static void invalid_parser(const char *name)
+{
+  const char *m=GetMsg(MInvalidParser);
+  char *buf=new char[strlen(m)+strlen(name)+16];
+  sprintf(buf,m,name);
+  Msg(buf);
+  delete [] buf;
+}
+
+/*
+  Parser is compiled when config is loaded, so that broken
+  parser is reported then and not in the middle of a build.
+  Compiled parser is kept across reloads while its definition
+  is the same.
+*/
+static SParser* compile_parser(PXMLNode x)
+{
+  SParser *prs=new SParser;
+  CParserTypesList *lists[]={&prs->errors,&prs->warnings,&prs->notes,&prs->contexts};
+  PXMLNode q;
+  for(int k=0;k<4;k++)
+  {
+    PHashLink e=NULL;
+    while(e=xmlEnumNode(x,kinds[k],e,&q))
+    {
+      SParserType pt;
+      if(!init_parser_type(q,pt))
+      {
+        if(pt.re)delete pt.re;
+        delete_parser(prs);
+        return NULL;
+      }
+      *lists[k]<<pt;
+    }
+  }
+  int i;
+  for(i=0;i<prs->contexts.Count();i++)prs->set.Add(prs->contexts[i].re);
+  for(i=0;i<prs->notes.Count();i++)prs->set.Add(prs->notes[i].re);
+  for(i=0;i<prs->errors.Count();i++)prs->set.Add(prs->errors[i].re);
+  for(i=0;i<prs->warnings.Count();i++)prs->set.Add(prs->warnings[i].re);
+  return prs;
+}
+
+static SParser* get_parser(const char *name)
+{
+  SParser **pp=parsers.GetPtr(name);
+  return pp?*pp:NULL;
+}
+
 int init_config(SColors *clr,SOptions* opt)
 {
   PXMLNode p,q,x;
@@ -137,6 +250,8 @@ int init_config(SColors *clr,SOptions* opt)
     if(val)clr->text=atoi(val);
     val=xmlGetItemAttr(p,"numbers");
     if(val)clr->number=atoi(val);
+    val=xmlGetItemAttr(p,"note");
+    if(val)clr->note=atoi(val);
   }
   p=xmlGetItem(xconfig,"/makeit-config/options");
   if(p)
@@ -156,48 +271,34 @@ int init_config(SColors *clr,SOptions* opt)
     if(val)opt->autosave=(val && !stricmp(val,"yes"));
   }
   p=xmlGetItem(xconfig,"/makeit-config/parsers");
-  if(!p || !p->hChildren)return 0;
-  x=p->pChildren;
-  while(x)
+  if(!p || !p->hChildren)
   {
-    SParser *prs=new SParser;
-    parsers.Insert(x->szName,prs);
-    //prs=&parsers[x->szName];
-    PHashLink e=NULL;
-    while(e=xmlEnumNode(x,"error",e,&q))
+    free_parsers(oldparsers);
+    return 0;
+  }
+  for(x=p->pChildren;x;x=x->pNext)
+  {
+    String src=parser_source(x);
+    SParser *prs;
+    SParser **old=oldparsers.GetPtr(x->szName);
+    if(old && (*old)->source==src)
     {
-      SParserType pt;
-      if(!init_parser_type(q,pt))
-      {
-        const char *m=GetMsg(MInvalidParser);
-        char *buf=new char[strlen(m)+strlen(x->szName)+16];
-        sprintf(buf,m,x->szName);
-        Msg(buf);
-        delete buf;
-        parsers.Delete(x->szName);
-      }else
-      {
-        prs->errors<<pt;
-      }
-    }
-    while(e=xmlEnumNode(x,"warning",e,&q))
+      prs=*old;
+      oldparsers.Delete(x->szName);
+    }else
     {
-      SParserType pt;
-      if(!init_parser_type(q,pt))
-      {
-        const char *m=GetMsg(MInvalidParser);
-        char *buf=new char[strlen(m)+strlen(x->szName)+16];
-        sprintf(buf,m,x->szName);
-        Msg(buf);
-        delete buf;
-        parsers.Delete(x->szName);
-      }else
+      prs=compile_parser(x);
+      if(!prs)
       {
-        prs->warnings<<pt;
+        invalid_parser(x->szName);
+        continue;
       }
+      prs->source=src;
     }
-    x=x->pNext;
+    parsers.Insert(x->szName,prs);
   }
+  //parsers removed from config or changed
+  free_parsers(oldparsers);
   p=xmlGetItem(xconfig,"/makeit-config/types");
   if(!p || !p->hChildren)
   {
@@ -222,7 +323,7 @@ int init_config(SColors *clr,SOptions* opt)
       char *buf=new char[strlen(tmp)+strlen(m)+16];
       sprintf(buf,m,tmp);
       Msg(buf);
-      delete buf;
+      delete [] buf;
       delete t;
       continue;
     }
@@ -283,24 +384,23 @@ int init_config(SColors *clr,SOptions* opt)
   return 1;
 }
 
-void free_config()
+void free_config(int keepparsers)
 {
   if(Pool)xmemFreePool(Pool);
+  Pool=NULL;
   char *k;
   SParser *p;
+  free_parsers(oldparsers);
   parsers.First();
   while(parsers.Next(k,p))
   {
-    int j;
-    for(j=0;j<p->errors.Count();j++)
+    if(keepparsers)
     {
-      if(p->errors[j].re)delete p->errors[j].re;
-    }
-    for(j=0;j<p->warnings.Count();j++)
+      oldparsers.Insert(k,p);
+    }else
     {
-      if(p->warnings[j].re)delete p->warnings[j].re;
+      delete_parser(p);
     }
-    delete p;
   }
   parsers.Empty();
   for(int i=0;i<types.Count();i++)
@@ -373,28 +473,33 @@ int get_commands(const String&c,CCmdList& cmds)
 
 int match_line(const char *parser,const String& line,SLineInfo *li)
 {
-  if(!parsers.Exists(parser))return 0;
-  SParser *p=parsers[parser];
+  SParser *p=get_parser(parser);
+  if(!p)return 0;
   SParserType *pt;
   SMatch m[10];
   int n=10;
   int res=0;
-  int i;
-  for(i=0;i<p->errors.Count();i++)
-  if(p->errors[i].re && p->errors[i].re->Match(line,m,n))
-  {
-    res=1;
-    pt=&p->errors[i];
-    break;
-  }
-  if(!res)
+  int i=p->set.Match(line,m,n);
+  if(i!=-1)
   {
-    for(i=0;i<p->warnings.Count();i++)
-    if(p->warnings[i].re && p->warnings[i].re->Match(line,m,n))
+    if(i<p->contexts.Count())
+    {
+      res=DIAG_CONTEXT;
+      pt=&p->contexts[i];
+    }else
+    if((i-=p->contexts.Count())<p->notes.Count())
     {
-      res=2;
-      pt=&p->warnings[i];
-      break;
+      res=DIAG_NOTE;
+      pt=&p->notes[i];
+    }else
+    if((i-=p->notes.Count())<p->errors.Count())
+    {
+      res=DIAG_ERROR;
+      pt=&p->errors[i];
+    }else
+    {
+      res=DIAG_WARNING;
+      pt=&p->warnings[i-p->errors.Count()];
     }
   }
   if(res)
@@ -404,7 +509,10 @@ int match_line(const char *parser,const String& line,SLineInfo *li)
       li->file=line.Substr(m[pt->file].start,m[pt->file].end-m[pt->file].start);
     else
       li->file="";
-    li->line=atoi(line.Str()+m[pt->line].start);
+    if(pt->line!=-1)
+      li->line=atoi(line.Str()+m[pt->line].start);
+    else
+      li->line=0;
     if(pt->col!=-1)
       li->col=atoi(line.Str()+m[pt->col].start);
     else
@@ -45,8 +45,10 @@ static int msgwndheight=20;
 
 static int wasswitch=0;
 
-static StrList log;
-static CLineList ll;
+static CBuildLog log;
+
+//build output refresh state
+static int needrefresh;
 
 
 
@@ -65,7 +67,7 @@ static FILETIME cfglastwrite;
 static String logfile;
 static FILETIME loglastwrite;
 
-static SColors colors={0,7,12,10,15};
+static SColors colors={0,7,12,10,15,11};
 static SOptions opt;
 
 static String plugdir;
@@ -210,6 +212,7 @@ char *CurDir()
 }
 
 void Draw(int from,int cursor=0);
+void RefreshStrings();
 
 class HideCur{
   CONSOLE_CURSOR_INFO  ci;
@@ -246,13 +249,12 @@ public:
 void SetStartPos()
 {
   int lastl=0;
-  for(linepos=0;linepos<ll.Count();linepos++)
+  for(linepos=log.Next(-1,1);linepos!=-1;linepos=log.Next(linepos,1))
   {
-    if(ll[linepos] && ll[linepos]->error)lastl=linepos;
-    if(!ll[linepos] || ll[linepos]->error!=1)continue;
-    break;
+    if(log.Info(linepos)->error==DIAG_ERROR)return;
+    lastl=linepos;
   }
-  if(linepos>=log.Count())linepos=lastl;
+  linepos=lastl;
 }
 
 void MakeIt(char *cmdline,SCommand* cmd=NULL)
@@ -321,10 +323,10 @@ void MakeIt(char *cmdline,SCommand* cmd=NULL)
   hScr=ClearScreen();
 
   log.Clean();
-  ll.Clean();
   linebuf[0]=0;
   linepos=0;
   leftpos=0;
+  needrefresh=0;
 
   cmddir=CurDir();
   int err;
@@ -389,27 +391,12 @@ void ReloadLog()
   GetFileTime(h,NULL,NULL,&tm);
   CloseHandle(h);
   if(!CompareFileTime(&tm,&loglastwrite))return;
-  log.Clean();
-  ll.Clean();
-  if(!log.LoadFromFile(logfile))
+  loglastwrite=tm;
+  if(!log.Reload())
   {
     Msg(GetMsg(MLogFailed));
     return;
   }
-  int i;
-  SLineInfo li;
-  for(i=0;i<log.Count();i++)
-  {
-    if(match_line(parser,log[i],&li))
-    {
-      SLineInfo *tmp=new SLineInfo;
-      *tmp=li;
-      ll<<tmp;
-    }else
-    {
-      ll<<NULL;
-    }
-  }
   SetStartPos();
 }
 
@@ -427,7 +414,7 @@ FARAPI(HANDLE) OpenPlugin(int OpenFrom,int Item)
   GetCfgTime(tm);
   if(CompareFileTime(&tm,&cfglastwrite))
   {
-    free_config();
+    free_config(1);
     if(!read_config(cfgfile))
     {
       Msg("Failed to load config!");
@@ -514,7 +501,6 @@ FARAPI(HANDLE) OpenPlugin(int OpenFrom,int Item)
         I.Control(INVALID_HANDLE_VALUE,FCTL_GETPANELINFO,&pi);
 
         log.Clean();
-        ll.Clean();
 
 
         if(pi.ItemsNumber<=0)return INVALID_HANDLE_VALUE;
@@ -522,69 +508,51 @@ FARAPI(HANDLE) OpenPlugin(int OpenFrom,int Item)
         logfile+="\\";
         logfile+=pi.PanelItems[pi.CurrentItem].FindData.cFileName;
         cmddir=CurDir();
-        if(!log.LoadFromFile(logfile))
+        //parser is known if log was indexed before
+        if(!log.Load(logfile,NULL))
         {
           Msg(GetMsg(MLogFailed));
           return INVALID_HANDLE_VALUE;
         }
         HANDLE h=CreateFile(logfile,GENERIC_READ,
-                FILE_SHARE_READ,NULL,OPEN_EXISTING,0,NULL);
+                FILE_SHARE_READ|FILE_SHARE_WRITE,NULL,OPEN_EXISTING,0,NULL);
         GetFileTime(h,NULL,NULL,&loglastwrite);
         CloseHandle(h);
 
-        SLineInfo li;
-        StrList pars;
-        get_parsers(pars);
-        StrList menu;
-//        pars.Sort(menu);
-        for(i=0;i<pars.Count();i++)
+        //parsers that matched while log was scanned,
+        //or all of them if it was indexed, to classify it again
+        StrList pars,menu;
+        int cur=0;
+        if(log.GetParser().Length())
         {
-          for(int j=0;j<log.Count();j++)
+          get_parsers(pars);
+          pars.Sort(menu);
+          for(i=0;i<menu.Count();i++)
           {
-            if(match_line(pars[i],log[j],&li))
-            {
-//              Msg(pars[i]);
-              menu<<pars[i];
-              break;
-            }
+            if(menu[i]==log.GetParser())cur=i;
           }
-        }
-        if(menu.Count()==0)
+        }else
         {
-          Msg(GetMsg(MNoParsersFound));
-          //return INVALID_HANDLE_VALUE;
-          pars.Sort(menu);
+          log.Matched(menu);
+          if(menu.Count()==0)
+          {
+            Msg(GetMsg(MNoParsersFound));
+            get_parsers(pars);
+            pars.Sort(menu);
+          }
         }
+        parser=log.GetParser();
         if(menu.Count()>1)
         {
-//          menu.Sort(menu);
-          int sel=Menu(GetMsg(MSelectParser),menu,0);
-          if(sel==-1)
-          {
-            ll.Clean();
-            for(i=0;i<log.Count();i++)
-            {
-              ll<<NULL;
-            }
-            return INVALID_HANDLE_VALUE;
-          }
-          parser=menu[sel];
-        }else
+          int sel=Menu(GetMsg(MSelectParser),menu,cur);
+          //indexed log keeps its parser
+          if(sel==-1 && parser.Length()==0)return INVALID_HANDLE_VALUE;
+          if(sel!=-1)parser=menu[sel];
+        }else if(menu.Count()==1)
         {
           parser=menu[0];
         }
-        for(i=0;i<log.Count();i++)
-        {
-          if(match_line(parser,log[i],&li))
-          {
-            SLineInfo *tmp=new SLineInfo;
-            *tmp=li;
-            ll<<tmp;
-          }else
-          {
-            ll<<NULL;
-          }
-        }
+        if(parser.Length() && parser!=log.GetParser())log.Classify(parser);
         toppos=0;
         linepos=0;
         SetStartPos();
@@ -712,8 +680,12 @@ void Draw(int from,int cursor)
     more=log[from+i].Length()-leftpos>screenwidth;
     l=strlen(buf);
     sprintf(buf+l,"%*s",screenwidth-l,"");
-    li=ll[from+i];
-    c=(colors.bg<<4)|(!li || !li->error?colors.text:li->error==1?colors.error:colors.warning);
+    li=log.Info(from+i);
+    if(!li || li->dup)c=colors.text;
+    else if(li->error==DIAG_ERROR)c=colors.error;
+    else if(li->error==DIAG_WARNING)c=colors.warning;
+    else c=colors.note;
+    c|=colors.bg<<4;
     if(cursor && linepos==from+i)c=((c&0xf)<<4)|((c&0xf0)>>4);
     I.Text(0,drawfrom+i,c,buf);
     if(opt.shownum)
@@ -750,21 +722,11 @@ void AddStrings(void* buf, DWORD len)
       }
       SLineInfo li;
       int m=match_line(parser,linebuf,&li);
-      if(m)
-      {
-        SLineInfo *tmp=new SLineInfo;
-        *tmp=li;
-        ll<<tmp;
-      }else{
-        ll<<NULL;
-      }
-      log<<linebuf;
+      log.Add(linebuf,m?&li:NULL);
+      needrefresh=1;
 
 //      if(linepos==screenheight-(mode==MODE_EDITOR?screenheight-msgwndheight:0))
 //      {
-      int from=log.Count()-(screenheight-(mode==MODE_EDITOR?screenheight-msgwndheight:0));
-      if(from<0)from=0;
-      Draw(from);
       if(linepos==screenheight-(mode==MODE_EDITOR?screenheight-msgwndheight:0))
         linepos--;
 //      }else
@@ -785,6 +747,19 @@ void AddStrings(void* buf, DWORD len)
   }
 };
 
+void RefreshStrings()
+{
+  if(!needrefresh)return;
+  int from=log.Count()-(screenheight-(mode==MODE_EDITOR?screenheight-msgwndheight:0));
+  if(from<0)from=0;
+  Draw(from);
+  char *title=new char[strlen(GetMsg(MBuildStatus))+32];
+  sprintf(title,GetMsg(MBuildStatus),log.Errors(),log.Warnings());
+  SetConsoleTitle(title);
+  delete [] title;
+  needrefresh=0;
+}
+
 int screenheight_mode()
 {
   if(mode==MODE_EDITOR)return msgwndheight;
@@ -847,7 +822,7 @@ static int SetPos(const char *filename,int line,int col)
   }
   if(!ok)
   {
-    I.Editor(filename,"",0,0,-1,-1,EF_NONMODAL,ll[linepos]->line,ll[linepos]->col==-1?0:ll[linepos]->col);
+    I.Editor(filename,"",0,0,-1,-1,EF_NONMODAL,line,col==-1?0:col);
     return 0;
   }
 
@@ -870,25 +845,57 @@ static int SetPos(const char *filename,int line,int col)
 
 void DeleteNonErrors(bool errorsonly=false)
 {
-  for(int i=log.Count()-1;i>=0;i--)
-  {
-    if(!ll[i] || (errorsonly && ll[i]->error!=1))
-    {
-      ll.Goto(i);
-      ll.Delete();
-      log.Goto(i);
-      log.Delete();
-      if(i<linepos)linepos--;
-    }
-    //toppos=0;
-    //linepos=0;
-  }
-  if(log.Count()==0){log<<"";ll<<NULL;}
+  linepos=log.Filter(errorsonly,linepos);
+  log.EnsureLine();
   if(linepos>=log.Count())linepos=log.Count()-1;
   if(linepos<toppos)toppos=linepos;
   ClearScreen(0);
 }
 
+struct SFileItem{
+  char *name;
+  SFileDiags *fd;
+};
+
+static int cmpfirst(const void* a,const void* b)
+{
+  return ((SFileItem*)a)->fd->first-((SFileItem*)b)->fd->first;
+}
+
+//menu of files with errors and warnings counts,
+//cursor is moved to the first diagnostic of selected file
+void ShowFiles()
+{
+  CFileDiags& files=log.Files();
+  int cnt=files.GetCount();
+  if(cnt==0)return;
+  SFileItem *items=new SFileItem[cnt];
+  int n=0;
+  CFileDiags::Iterator it=files.getIterator();
+  while(n<cnt && it.Next(items[n].name,items[n].fd))n++;
+  //files in order of appearance in the log
+  qsort(items,n,sizeof(SFileItem),cmpfirst);
+  StrList menu;
+  const char *fmt=GetMsg(MFileStatus);
+  for(int i=0;i<n;i++)
+  {
+    char *buf=new char[strlen(fmt)+strlen(items[i].name)+32];
+    sprintf(buf,fmt,items[i].name,items[i].fd->errors,items[i].fd->warnings);
+    menu<<buf;
+    delete [] buf;
+  }
+  int sel=Menu(GetMsg(MFiles),menu,0);
+  int pos=sel==-1?-1:log.ViewIndex(items[sel].fd->first);
+  delete [] items;
+  if(pos==-1)return;
+  linepos=pos;
+  if(linepos<toppos || linepos>=toppos+screenheight_mode())
+  {
+    toppos=linepos-screenheight_mode()/2;
+    if(toppos<0)toppos=0;
+  }
+}
+
 void Scroll()
 {
   INPUT_RECORD ir;
@@ -909,11 +916,7 @@ void Scroll()
 
   for(;;)
   {
-    if(log.Count()==0)
-    {
-      log<<"";
-      ll<<NULL;
-    }
+    log.EnsureLine();
     Draw(toppos,1);
     if(ReadConsoleInput(GetStdHandle(STD_INPUT_HANDLE),&ir,1,&rd) && rd==1)
     {
@@ -1005,6 +1008,10 @@ void Scroll()
           {
             I.ShowHelp(I.ModuleName,"Contents",FHELP_SELFHELP);
           }continue;
+          case VK_F2:
+          {
+            ShowFiles();
+          }break;
           case VK_DELETE:{
             //DebugBreak();
             DeleteNonErrors(ir.Event.KeyEvent.dwControlKeyState&LEFT_ALT_PRESSED);
@@ -1017,20 +1024,14 @@ void Scroll()
           case VK_F4:{
             int dir=(ir.Event.KeyEvent.dwControlKeyState&SHIFT_PRESSED)?-1:1;
             int save=linepos;
-            linepos+=dir;
-            if(linepos<0)linepos=0;
-            while(!ll[linepos] && linepos<=ll.Count()-1 && linepos>=0)
-            {
-              linepos+=dir;
-            }
-            if(linepos<0)linepos=save;
-            if(linepos>=log.Count())linepos=save;
+            linepos=log.Next(linepos,dir);
+            if(linepos==-1)linepos=save;
             if(linepos<toppos)toppos=linepos;
             if(linepos>=toppos+screenheight_mode())toppos=linepos-screenheight_mode()+1;
             if(toppos<0)toppos=0;
-            if(mode==MODE_EDITOR && ll[linepos])
+            if(mode==MODE_EDITOR && log.Info(linepos))
             {
-              String file=ll[linepos]->file;
+              String file=log.Info(linepos)->file;
               if(file.Length()==0)
               {
                 EditorInfo ei;
@@ -1039,7 +1040,7 @@ void Scroll()
               }
               if(file[0]!='\\' && file[0]!='/' && file[1]!=':')
                 file=cmddir+"\\"+file;
-              if(SetPos(file,ll[linepos]->line,ll[linepos]->col))
+              if(SetPos(file,log.Info(linepos)->line,log.Info(linepos)->col))
               {
                 I.EditorControl(ECTL_REDRAW,NULL);
               }
@@ -1050,8 +1051,8 @@ void Scroll()
           }break;
           case VK_RETURN:
           {
-            if(!ll[linepos])break;
-            String file=ll[linepos]->file;
+            if(!log.Info(linepos))break;
+            String file=log.Info(linepos)->file;
             if(file.Length()==0)
             {
               if(mode!=MODE_EDITOR)break;
@@ -1062,7 +1063,7 @@ void Scroll()
             if(file[0]!='\\' && file[0]!='/' && file[1]!=':')
               file=cmddir+"\\"+file;
             hc.Restore();
-            if(!SetPos(file,ll[linepos]->line,ll[linepos]->col))wasswitch=0;
+            if(!SetPos(file,log.Info(linepos)->line,log.Info(linepos)->col))wasswitch=0;
             return;
           }break;
           case VK_ESCAPE:
@@ -1090,4 +1091,4 @@ FARAPI(int) Configure(int item)
   Msg(GetMsg(MDone));
   return TRUE;
 }
-*/
\ No newline at end of file
+*/
\ No newline at end of file
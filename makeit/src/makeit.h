@@ -22,6 +22,8 @@
 #define MAX_ORD 4
 #define TEXTSIZE 100000
 #define TEXTWIDTH 69
+//min time between screen refreshes during build, ms
+#define REFRESH_TIME 50
 
 #include "XTools.hpp"
 
@@ -44,10 +46,34 @@ struct SCommand{
 
 typedef List<SCommand*> CCmdList;
 
+//kinds of diagnostics, SLineInfo::error
+enum{
+  DIAG_ERROR=1,
+  DIAG_WARNING,
+  //continuation line after error or warning
+  DIAG_NOTE,
+  //line before error or warning, like include stack
+  DIAG_CONTEXT,
+};
+
 struct SLineInfo{
   int error;
   String file;
   int line,col;
+  //log line of the error or warning this line belongs to, -1 if none
+  int parent;
+  //error or warning was already reported by another job
+  int dup;
+  //checksum of the line text
+  DWORD sum;
+  SLineInfo()
+  {
+    error=0;
+    line=col=-1;
+    parent=-1;
+    dup=0;
+    sum=0;
+  }
 };
 
 struct SColors{
@@ -56,6 +82,7 @@ struct SColors{
   int error;
   int warning;
   int number;
+  int note;
 };
 
 struct SOptions{
@@ -78,12 +105,145 @@ struct SOptions{
 
 typedef List<SLineInfo*> CLineList;
 
+struct SLogDiag{
+  int line;
+  SLineInfo *info;
+};
+
+//line matched by one of parsers tried on log
+struct SLogMatch{
+  int parser;
+  int line;
+  SLineInfo *info;
+};
+
+struct SFileDiags{
+  int errors,warnings;
+  //log line of the first error or warning in the file
+  int first;
+  SFileDiags()
+  {
+    errors=warnings=0;
+    first=-1;
+  }
+};
+
+typedef Hash<SFileDiags> CFileDiags;
+
+/*
+  Build output or saved log with diagnostics.
+  Build output is kept in memory, saved log is read
+  from the file by pages when lines are displayed.
+  Page offsets and diagnostics of saved log are stored
+  in index file next to the log, so reopening of the log
+  doesn't require it to be parsed again, and if log was
+  appended, only new lines are parsed.
+  Notes and context lines (include stack, template
+  instantiation backtrace) are attached to their error or warning,
+  diagnostics repeated by parallel jobs are marked as duplicates.
+*/
+class CBuildLog{
+protected:
+  //build output
+  StrList mem;
+  //saved log
+  String filename;
+  HANDLE hfile;
+  LONGLONG size;
+  FILETIME mtime;
+  DWORD headsum;
+  DWORD tailsum;
+  //file offsets of each LOG_PAGE lines
+  Vector<LONGLONG> pages;
+  StrList cache[2];
+  int cachepage[2];
+  int cachelast;
+
+  int lines;
+  String parser;
+  //diagnostics sorted by line
+  Vector<SLogDiag> diags;
+  //visible lines after filtering, -1 for empty line
+  Vector<int> view;
+  int filtered;
+  //parsers tried on log opened without parser and lines they matched,
+  //Classify takes diagnostics from here instead of parsing log again
+  StrList tried;
+  Vector<SLogMatch> matches;
+
+  //grouping state
+  int lastdiag;
+  int pending;
+  Hash<int> seen;
+  CFileDiags files;
+  int errors,warnings;
+
+  int Source(int index);
+  int FindDiag(int line);
+  int FindView(int line);
+  int IsPrimary(int idx);
+  void AddDiag(int line,DWORD sum,const SLineInfo& li);
+  void Tally(int idx);
+  void Regroup();
+  void AddLine(const String& line,LONGLONG offset);
+  int ReadLines(LONGLONG pos,int count,StrList* dst);
+  void Scan(int page);
+  StrList& GetPage(int page);
+  DWORD HeadSum(LONGLONG len);
+  DWORD TailSum(LONGLONG len);
+  int Appended();
+  LONGLONG FileSize();
+  String IndexName();
+  int LoadIndex(const char* prs);
+  void SaveIndex();
+  void FreeDiags(int fromline);
+  void FreeMatches(int fromline);
+public:
+  CBuildLog();
+  ~CBuildLog();
+  void Clean();
+  int Count();
+  const String& operator[](int index);
+  //diagnostic info of the line, NULL for plain lines
+  SLineInfo* Info(int index);
+  //next error or warning in direction dir, -1 if none
+  int Next(int index,int dir);
+  //index of log line in current view, -1 if it was filtered out
+  int ViewIndex(int line);
+  //errors and warnings, without duplicates
+  int Errors(){return errors;}
+  int Warnings(){return warnings;}
+  CFileDiags& Files(){return files;}
+
+  void Add(const char* line,const SLineInfo* li);
+  //add empty line if log is empty, to have a line for cursor
+  void EnsureLine();
+  //leave only lines with diagnostics, return new index of line pos
+  int Filter(int errorsonly,int pos);
+
+  /*! Open saved log.
+      If prs is NULL, parser is taken from the index file,
+      or if there is no index, all parsers are tried on each line
+      and lines are classified by Classify.
+  */
+  int Load(const char* fname,const char* prs);
+  //parsers that matched lines of log loaded without parser
+  void Matched(StrList& dst);
+  //classify lines of saved log with another parser
+  void Classify(const char* prs);
+  //reparse changed saved log, only appended part if possible
+  int Reload();
+  const String& GetParser(){return parser;}
+  int SaveToFile(const char* fname);
+};
+
 int parse(char* s,char* fname,int* line,int *col,char*msg);
 int pipesrv(const char* command);
 
 int read_config(const char* filename);
 int init_config(SColors *clr,SOptions* opt);
-void free_config();
+//keepparsers - keep compiled parsers for config that is going to be loaded
+void free_config(int keepparsers=0);
 int get_commands(const String&,CCmdList&);
 int match_line(const char *parser,const String& line,SLineInfo *li);
 void get_parsers(StrList& lst);
@@ -122,4 +282,7 @@ enum
  MDone,
  MCompleted,
  MNoParsersFound,
+ MBuildStatus,
+ MFiles,
+ MFileStatus,
 };
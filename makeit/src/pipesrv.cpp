@@ -22,12 +22,15 @@
 #include "makeit.h"
 
 #define BUFSIZE 4096
+//build is not stopped on output while screen is refreshed
+#define PIPESIZE 65536
 
 static HANDLE hChildStdoutRd, hChildStdoutWr;
 
 BOOL CreateChildProcess(const char*);
 int ReadFromPipe(void);
 extern void AddStrings(void*,DWORD);
+extern void RefreshStrings();
 
 int
 pipesrv(const char* command)
@@ -42,7 +45,7 @@ pipesrv(const char* command)
     attr.bInheritHandle = TRUE;
     attr.lpSecurityDescriptor = NULL;
 
-    if (!CreatePipe(&hChildStdoutRd, &hChildStdoutWr, &attr, 0))
+    if (!CreatePipe(&hChildStdoutRd, &hChildStdoutWr, &attr, PIPESIZE))
         return MPipeError;
 
     if (!CreateChildProcess(command))
@@ -92,15 +95,50 @@ BOOL CreateChildProcess(const char*command)
     return ret;
 }
 
+/*
+  Repaint is much slower than parsing, so screen is refreshed
+  not more often than REFRESH_TIME, whether output comes in a flood
+  or by few lines. Everything received is shown before waiting
+  for more output, and when the build is over.
+*/
 int ReadFromPipe(void)
 {
     DWORD dwRead;
     char buf[BUFSIZE];
+    //RefreshStrings shows build status in the title
+    char title[512];
+    DWORD titlelen=GetConsoleTitle(title,sizeof(title));
+    DWORD lastrefresh=GetTickCount();
+    //output added after last refresh
+    int pending=0;
     for (;;)
     {
+        DWORD avail=0;
+        if (pending && PeekNamedPipe(hChildStdoutRd, NULL, 0, NULL, &avail, NULL) && !avail)
+        {
+            //wait for more output till it's time to refresh
+            if (GetTickCount()-lastrefresh<REFRESH_TIME)
+            {
+                Sleep(1);
+                continue;
+            }
+            RefreshStrings();
+            lastrefresh=GetTickCount();
+            pending=0;
+        }
         if (!ReadFile(hChildStdoutRd, buf, BUFSIZE, &dwRead, NULL) || !dwRead)
             break;
         AddStrings(buf,dwRead);
+        pending=1;
+        if (GetTickCount()-lastrefresh>=REFRESH_TIME)
+        {
+            RefreshStrings();
+            lastrefresh=GetTickCount();
+            pending=0;
+        }
     }
+    RefreshStrings();
+    if (titlelen)
+        SetConsoleTitle(title);
     return 0;
 }
@@ -0,0 +1,300 @@
+/*
+  Copyright (C) 2000 Konstantin Stupnik
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+  Test of CBuildLog on saved logs. Parsers are tried on every line in
+  one scan when parser is not known; appended log is parsed from its
+  last page only, but log rewritten with the same head is parsed again;
+  a log of several gigabytes is indexed within memory budget.
+  Usage: buildlogtest [log megabytes] [memory budget megabytes]
+*/
+
+#include <windows.h>
+#include <time.h>
+#include <unistd.h>
+#include "buildlog.cpp"
+
+static int failed;
+//match_line calls, to see which lines were parsed
+static int calls;
+
+static void Check(bool ok,const char* what)
+{
+  if(ok)return;
+  printf("FAIL: %s\n",what);
+  failed++;
+}
+
+//gcc: file:line: error: text, msvc: file(line) : error text
+int match_line(const char *parser,const String& line,SLineInfo *li)
+{
+  calls++;
+  const char *s=line.Str();
+  char file[256];
+  int ln;
+  if(!strcmp(parser,"gcc"))
+  {
+    int kind=strstr(s,": error: ")?DIAG_ERROR:strstr(s,": warning: ")?DIAG_WARNING:
+             strstr(s,": note: ")?DIAG_NOTE:0;
+    if(!kind || sscanf(s,"%255[^:(]:%d:",file,&ln)!=2)return 0;
+    li->error=kind;
+    li->file=file;
+    li->line=ln;
+    li->col=-1;
+    return kind;
+  }
+  if(!strcmp(parser,"msvc"))
+  {
+    if(!strstr(s,") : error ") || sscanf(s,"%255[^(](%d)",file,&ln)!=2)return 0;
+    li->error=DIAG_ERROR;
+    li->file=file;
+    li->line=ln;
+    li->col=-1;
+    return DIAG_ERROR;
+  }
+  return 0;
+}
+
+void get_parsers(StrList& lst)
+{
+  lst<<"gcc"<<"msvc"<<"none";
+}
+
+static double Now()
+{
+  timespec ts;
+  clock_gettime(CLOCK_MONOTONIC,&ts);
+  return ts.tv_sec+ts.tv_nsec/1e9;
+}
+
+static long Rss(const char* field)
+{
+  FILE *f=fopen("/proc/self/status","r");
+  if(!f)return 0;
+  char buf[256];
+  long kb=0;
+  while(fgets(buf,sizeof(buf),f))
+  {
+    if(!strncmp(buf,field,strlen(field)))kb=atol(buf+strlen(field));
+  }
+  fclose(f);
+  return kb/1024;
+}
+
+/*
+  Line n of generated log, one of every rare lines is a diagnostic.
+  Different seeds give different diagnostics at the same lines.
+*/
+static int GenLine(char* buf,int n,int seed,int rare)
+{
+  unsigned h=(n+1)*2654435761u^seed*40503u;
+  h^=h>>15;
+  int f=h%500;
+  switch(h%rare)
+  {
+    case 0:return sprintf(buf,"src/f%d.c:%d: error: '%c%d' undeclared\n",f,n%900,'a'+seed,n);
+    case 1:return sprintf(buf,"src/f%d.c:%d: warning: unused variable 'v%d'\n",f,n%700,n);
+    case 2:return sprintf(buf,"src/f%d.h:%d: note: declared here\n",f,n%300);
+    case 3:return sprintf(buf,"src\\g%d.cpp(%d) : error C2065: 'x%d' : undeclared identifier\n",f,n%800,seed);
+  }
+  return sprintf(buf,"g++ -c src/f%d.c -o obj/f%d.o -O2 -Wall -I include\n",f,f);
+}
+
+//lines [from,to) of generated log
+static void WriteLog(const char* fn,int from,int to,int seed,int rare,bool append)
+{
+  FILE *f=fopen(fn,append?"ab":"wb");
+  char buf[256];
+  for(int i=from;i<to;i++)
+  {
+    int len=GenLine(buf,i,seed,rare);
+    fwrite(buf,len,1,f);
+  }
+  fclose(f);
+}
+
+static String IndexOf(const char* fn)
+{
+  String s=fn;
+  s+=".mki";
+  return s;
+}
+
+//same lines with the same diagnostics
+static bool Same(CBuildLog& a,CBuildLog& b)
+{
+  if(a.Count()!=b.Count() || a.Errors()!=b.Errors() || a.Warnings()!=b.Warnings())return false;
+  for(int i=0;i<a.Count();i++)
+  {
+    if(a[i]!=b[i])return false;
+    SLineInfo *x=a.Info(i),*y=b.Info(i);
+    if(!x || !y)
+    {
+      if(x!=y)return false;
+      continue;
+    }
+    if(x->error!=y->error || x->file!=y->file || x->line!=y->line || x->col!=y->col ||
+       x->parent!=y->parent || x->dup!=y->dup || x->sum!=y->sum)return false;
+  }
+  return true;
+}
+
+//log parsed from scratch
+static bool SameAsNew(CBuildLog& log,const char* fn,const char* prs)
+{
+  String idx=IndexOf(fn);
+  String tmp=idx+".keep";
+  rename(idx,tmp);
+  CBuildLog fresh;
+  fresh.Load(fn,prs);
+  bool same=Same(log,fresh);
+  fresh.Clean();
+  remove(idx);
+  rename(tmp,idx);
+  return same;
+}
+
+static void TestDetect(const char* fn)
+{
+  const int count=20000;
+  WriteLog(fn,0,count,0,20,false);
+  remove(IndexOf(fn));
+  CBuildLog log;
+  calls=0;
+  log.Load(fn,NULL);
+  Check(calls==count*3,"all parsers are tried in one scan");
+  StrList matched;
+  log.Matched(matched);
+  Check(matched.Count()==2 && matched[0]=="gcc" && matched[1]=="msvc","matched parsers");
+  calls=0;
+  log.Classify("gcc");
+  Check(calls==0,"classify by parser tried in the scan doesn't parse log");
+  Check(log.Errors()>0 && SameAsNew(log,fn,"gcc"),"classified log equals parsed one");
+
+  CBuildLog again;
+  calls=0;
+  again.Load(fn,NULL);
+  Check(calls==0 && again.GetParser()=="gcc","indexed log is not parsed");
+  again.Classify("msvc");
+  Check(again.GetParser()=="msvc" && again.Errors()>0 && SameAsNew(again,fn,"msvc"),
+        "indexed log classified with another parser");
+}
+
+static void TestAppend(const char* fn)
+{
+  const int count=20000,added=1000;
+  WriteLog(fn,0,count,0,20,false);
+  remove(IndexOf(fn));
+  CBuildLog log;
+  log.Load(fn,"gcc");
+  WriteLog(fn,count,count+added,0,20,true);
+  calls=0;
+  log.Reload();
+  Check(calls<=added+LOG_PAGE,"only appended part is parsed");
+  Check(log.Count()==count+added && SameAsNew(log,fn,"gcc"),"appended log equals parsed one");
+  log.Clean();
+
+  WriteLog(fn,count+added,count+2*added,0,20,true);
+  calls=0;
+  log.Load(fn,"gcc");
+  Check(calls<=added+LOG_PAGE,"log appended while closed is parsed from the last page");
+  Check(SameAsNew(log,fn,"gcc"),"reopened log equals parsed one");
+}
+
+//same head, different lines after it, and longer than indexed
+static void TestRewrite(const char* fn)
+{
+  const int count=20000,head=1000;
+  WriteLog(fn,0,count,0,20,false);
+  remove(IndexOf(fn));
+  CBuildLog log;
+  log.Load(fn,"gcc");
+  WriteLog(fn,0,head,0,20,false);
+  WriteLog(fn,head,count+500,1,20,true);
+  calls=0;
+  log.Reload();
+  Check(calls>=count,"rewritten log is parsed again");
+  Check(SameAsNew(log,fn,"gcc"),"rewritten log equals parsed one");
+  log.Clean();
+
+  WriteLog(fn,0,head,0,20,false);
+  WriteLog(fn,head,count+1000,2,20,true);
+  calls=0;
+  log.Load(fn,"gcc");
+  Check(calls>=count,"index of rewritten log is dropped");
+  Check(SameAsNew(log,fn,"gcc"),"reopened rewritten log equals parsed one");
+}
+
+//several gigabytes of log, one line in thousand is a diagnostic
+static void TestMemory(const char* fn,int mb,int budget)
+{
+  double t=Now();
+  int lines=0;
+  {
+    FILE *f=fopen(fn,"wb");
+    long long size=0,limit=(long long)mb*1024*1024;
+    char buf[256];
+    while(size<limit)
+    {
+      int len=GenLine(buf,lines++,0,1000);
+      fwrite(buf,len,1,f);
+      size+=len;
+    }
+    fclose(f);
+  }
+  remove(IndexOf(fn));
+  printf("generated %d MB log, %d lines in %.1f s\n",mb,lines,Now()-t);
+  long before=Rss("VmRSS:");
+  t=Now();
+  CBuildLog log;
+  log.Load(fn,"gcc");
+  printf("parsed in %.1f s, %d errors, %d warnings, rss %ld MB, peak %ld MB\n",
+         Now()-t,log.Errors(),log.Warnings(),Rss("VmRSS:"),Rss("VmHWM:"));
+  Check(log.Count()==lines,"all lines of big log are counted");
+  Check(log[lines-1]==log[lines-1] && log[lines/2].Length()>0,"lines are read back");
+  Check(Rss("VmHWM:")-before<=budget,"big log is parsed within memory budget");
+  log.Clean();
+
+  t=Now();
+  log.Load(fn,"gcc");
+  printf("reopened by index in %.3f s\n",Now()-t);
+  WriteLog(fn,lines,lines+10000,0,1000,true);
+  t=Now();
+  calls=0;
+  log.Reload();
+  printf("reloaded 10000 appended lines in %.3f s\n",Now()-t);
+  Check(calls<=10000+LOG_PAGE,"only appended part of big log is parsed");
+  Check(log.Count()==lines+10000,"appended lines of big log are counted");
+  log.Clean();
+  remove(IndexOf(fn));
+  remove(fn);
+}
+
+int main(int argc,char* argv[])
+{
+  int mb=argc>1?atoi(argv[1]):2048;
+  int budget=argc>2?atoi(argv[2]):64;
+  char fn[64];
+  sprintf(fn,"/tmp/buildlogtest.%d.log",(int)getpid());
+  TestDetect(fn);
+  TestAppend(fn);
+  TestRewrite(fn);
+  remove(IndexOf(fn));
+  if(mb>0)TestMemory(fn,mb,budget);
+  remove(fn);
+  printf("buildlogtest: %d failed\n",failed);
+  return failed?1:0;
+}
@@ -0,0 +1,133 @@
+/*
+  Copyright (C) 2000 Konstantin Stupnik
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+  Test of parsers in config: broken parser definitions are reported
+  when config is loaded and left out, valid parsers are compiled once
+  when config is loaded and kept across reloads of changed config.
+*/
+
+#include <windows.h>
+#include <unistd.h>
+#include "config.cpp"
+
+static int failed;
+static int messages;
+static String lastMessage;
+
+int Msg(const char* err)
+{
+  messages++;
+  lastMessage=err;
+  return 0;
+}
+
+const char* GetMsg(int MsgId)
+{
+  return MsgId==MInvalidParser?"Invalid parser: %s":"message";
+}
+
+static void Check(bool ok,const char* what)
+{
+  if(ok)return;
+  printf("FAIL: %s\n",what);
+  failed++;
+}
+
+static const char* head=
+  "<makeit-config>\n"
+  "  <parsers>\n"
+  "    <gcc>\n"
+  "      <note pattern=\"/^(.*?):(\\d+):\\s+note:/\" file=\"1\" line=\"2\"/>\n"
+  "      <error pattern=\"/^(.*?):(\\d+):/\" file=\"1\" line=\"2\"/>\n"
+  "    </gcc>\n";
+
+static const char* tail=
+  "  </parsers>\n"
+  "  <types>\n"
+  "    <filetype filename=\"/^(.*\\.c)$/\">\n"
+  "      <command name=\"gcc\" parser=\"gcc\">gcc $1</command>\n"
+  "      <command name=\"broken\" parser=\"broken\">cc $1</command>\n"
+  "    </filetype>\n"
+  "  </types>\n"
+  "</makeit-config>\n";
+
+static void LoadConfig(const char* fn,const char* parsers)
+{
+  FILE *f=fopen(fn,"wb");
+  fprintf(f,"%s%s%s",head,parsers,tail);
+  fclose(f);
+  SColors clr;
+  SOptions opt;
+  messages=0;
+  Check(read_config(fn)==1,"config is read");
+  init_config(&clr,&opt);
+}
+
+static bool Listed(const char* name)
+{
+  StrList lst;
+  get_parsers(lst);
+  for(int i=0;i<lst.Count();i++)
+  {
+    if(lst[i]==name)return true;
+  }
+  return false;
+}
+
+int main()
+{
+  char fn[64];
+  sprintf(fn,"/tmp/configtest.%d.xml",(int)getpid());
+
+  LoadConfig(fn,
+    "    <broken>\n"
+    "      <error pattern=\"/^(.*?:(\\d+):/\" file=\"1\" line=\"2\"/>\n"
+    "    </broken>\n"
+    "    <noline>\n"
+    "      <error pattern=\"/^(.*?):/\" file=\"1\"/>\n"
+    "    </noline>\n");
+  Check(messages==2,"both broken parsers are reported at load");
+  Check(strstr(lastMessage,"noline")!=NULL,"message names the parser");
+  Check(Listed("gcc") && !Listed("broken") && !Listed("noline"),"only valid parsers are listed");
+  SParser *gcc=parsers["gcc"];
+  Check(gcc->set.Count()==2 && gcc->notes.Count()==1 && gcc->errors.Count()==1,"valid parser is compiled at load");
+
+  messages=0;
+  SLineInfo li;
+  Check(match_line("broken",String("a.c:1: x"),&li)==0,"broken parser matches nothing");
+  Check(match_line("gcc",String("a.c:10: error"),&li)==DIAG_ERROR && li.file=="a.c" && li.line==10,
+        "valid parser matches");
+  Check(match_line("gcc",String("a.c:3: note: here"),&li)==DIAG_NOTE,"note goes before error");
+  Check(messages==0,"no messages while lines are matched");
+  Check(parsers["gcc"]==gcc && gcc->set.Count()==2,"parser is not compiled again on use");
+
+  //broken parser fixed, gcc unchanged
+  free_config(1);
+  LoadConfig(fn,
+    "    <broken>\n"
+    "      <error pattern=\"/^(.*?):(\\d+):/\" file=\"1\" line=\"2\"/>\n"
+    "    </broken>\n");
+  Check(messages==0,"fixed config loads silently");
+  Check(parsers["gcc"]==gcc,"unchanged compiled parser is kept");
+  Check(Listed("broken") && match_line("broken",String("b.c:2: x"),&li)==DIAG_ERROR,"fixed parser works");
+  Check(messages==0,"no messages after fix");
+
+  free_config(0);
+  remove(fn);
+  printf("configtest: %d failed\n",failed);
+  return failed?1:0;
+}
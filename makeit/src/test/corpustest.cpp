@@ -0,0 +1,167 @@
+/*
+  Copyright (C) 2000 Konstantin Stupnik
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+
+  Test of parsers of makeit.xml on recorded compiler output:
+  each log in test/logs is read the way build output is read,
+  and kinds of its lines, their grouping, duplicates and counts
+  per file are compared with the .diag file recorded next to it.
+  Usage: corpustest [--record]
+  --record writes .diag files from current results, they must be
+  checked by hand before they are committed.
+*/
+
+#include <windows.h>
+#include "config.cpp"
+
+static int failed;
+
+int Msg(const char* err)
+{
+  printf("%s\n",err);
+  failed++;
+  return 0;
+}
+
+const char* GetMsg(int MsgId)
+{
+  return "%s";
+}
+
+//lines of log as AddStrings passes them to parser,
+//or lines of .diag file as they are if raw is set
+static int ReadLog(const char* fn,StrList& lines,int raw=0)
+{
+  FILE *f=fopen(fn,"rb");
+  if(!f)return 0;
+  char buf[4096];
+  while(fgets(buf,sizeof(buf),f))
+  {
+    int l=strlen(buf);
+    while(l>0 && (buf[l-1]==0x0d || buf[l-1]==0x0a))buf[--l]=0;
+    for(int j=0;j<l && !raw;j++)
+    {
+      if((unsigned char)buf[j]<32)buf[j]=32;
+    }
+    lines<<buf;
+  }
+  fclose(f);
+  return lines.Count();
+}
+
+/*
+  One line for each diagnostic:
+  log line, kind, file:line, log line of its error or warning,
+  and dup for repeated ones; then errors, warnings and first line
+  for each file.
+*/
+static void Classify(const char* fn,const char* parser,StrList& res)
+{
+  static const char *kinds[]={"","error","warning","note","context"};
+  StrList lines;
+  if(!ReadLog(fn,lines))
+  {
+    printf("FAIL: %s not found\n",fn);
+    failed++;
+    return;
+  }
+  CBuildLog log;
+  int i;
+  for(i=0;i<lines.Count();i++)
+  {
+    SLineInfo li;
+    int m=match_line(parser,lines[i],&li);
+    log.Add(lines[i],m?&li:NULL);
+  }
+  char buf[1024];
+  for(i=0;i<log.Count();i++)
+  {
+    SLineInfo *li=log.Info(i);
+    if(!li)continue;
+    sprintf(buf,"%d\t%s\t%s:%d\t%d%s",i+1,kinds[li->error],li->file.Str(),li->line,
+            li->parent+1,li->dup?"\tdup":"");
+    res<<buf;
+  }
+  StrList files;
+  CFileDiags::Iterator it=log.Files().getIterator();
+  char *name;
+  SFileDiags *fd;
+  while(it.Next(name,fd))
+  {
+    sprintf(buf,"file\t%s\t%d\t%d\t%d",name,fd->errors,fd->warnings,fd->first+1);
+    files<<buf;
+  }
+  StrList sorted;
+  files.Sort(sorted);
+  for(i=0;i<sorted.Count();i++)res<<sorted[i];
+  sprintf(buf,"total\t%d\t%d",log.Errors(),log.Warnings());
+  res<<buf;
+}
+
+int main(int argc,char* argv[])
+{
+  static const char *logs[][2]={
+    {"test/logs/gcc","gcc"},
+    {"test/logs/clang","gcc"},
+    {"test/logs/msvc","vcpp"},
+  };
+  int record=argc>1 && !strcmp(argv[1],"--record");
+  if(!read_config("makeit.xml"))
+  {
+    printf("makeit.xml not found\n");
+    return 1;
+  }
+  SColors clr;
+  SOptions opt;
+  init_config(&clr,&opt);
+  for(unsigned k=0;k<sizeof(logs)/sizeof(logs[0]);k++)
+  {
+    String logfile=logs[k][0],difffile=logs[k][0];
+    logfile+=".log";
+    difffile+=".diag";
+    StrList res;
+    Classify(logfile,logs[k][1],res);
+    if(record)
+    {
+      FILE *f=fopen(difffile,"wb");
+      for(int i=0;i<res.Count();i++)fprintf(f,"%s\n",res[i].Str());
+      fclose(f);
+      continue;
+    }
+    StrList ref;
+    if(!ReadLog(difffile,ref,1))
+    {
+      printf("FAIL: %s not found\n",difffile.Str());
+      failed++;
+      continue;
+    }
+    for(int i=0;i<res.Count() || i<ref.Count();i++)
+    {
+      const char *got=i<res.Count()?res[i].Str():"";
+      const char *want=i<ref.Count()?ref[i].Str():"";
+      if(strcmp(got,want))
+      {
+        printf("FAIL: %s: got '%s', expected '%s'\n",logfile.Str(),got,want);
+        failed++;
+        break;
+      }
+    }
+  }
+  free_config();
+  printf("corpustest: %d failed\n",failed);
+  return failed?1:0;
+}
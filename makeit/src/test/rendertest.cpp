@@ -0,0 +1,104 @@
+/*
+  Copyright (C) 2000 Konstantin Stupnik
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+
+  Headless test of screen refresh while build output is read:
+  repaints are counted instead of drawn, their number must depend
+  on time the build takes and not on number of lines it prints,
+  and all output must be shown when the build is over.
+  Usage: rendertest [lines]
+*/
+
+#include <windows.h>
+#include <time.h>
+#include "pipesrv.cpp"
+
+static int failed;
+static int lines;
+static int needrefresh;
+static int renders;
+//lines on screen after last repaint
+static int shown;
+
+static void Check(bool ok,const char* what)
+{
+  if(ok)return;
+  printf("FAIL: %s\n",what);
+  failed++;
+}
+
+void AddStrings(void* buf,DWORD len)
+{
+  char *s=(char*)buf;
+  for(DWORD i=0;i<len;i++)
+  {
+    if(s[i]==0x0a)lines++;
+  }
+  needrefresh=1;
+}
+
+void RefreshStrings()
+{
+  if(!needrefresh)return;
+  renders++;
+  shown=lines;
+  SetConsoleTitle("build status");
+  needrefresh=0;
+}
+
+static double Now()
+{
+  timespec ts;
+  clock_gettime(CLOCK_MONOTONIC,&ts);
+  return ts.tv_sec+ts.tv_nsec/1e9;
+}
+
+//returns number of repaints allowed for time command took
+static int Run(const char* cmd)
+{
+  lines=0;
+  renders=0;
+  shown=0;
+  double t=Now();
+  Check(pipesrv(cmd)==0,"command is started");
+  t=Now()-t;
+  char title[64];
+  GetConsoleTitle(title,sizeof(title));
+  Check(!strcmp(title,"test"),"console title is restored");
+  Check(shown==lines,"all output is shown at the end");
+  return (int)(t*1000/REFRESH_TIME)+2;
+}
+
+int main(int argc,char* argv[])
+{
+  int count=argc>1?atoi(argv[1]):1000000;
+  char cmd[256];
+  sprintf(cmd,"awk 'BEGIN{for(i=0;i<%d;i++)printf \"src/file%%d.c:%%d: error: message\\n\",i%%100,i}'",count);
+  int allowed=Run(cmd);
+  printf("rendertest: %d lines, %d repaints, %d allowed\n",lines,renders,allowed);
+  Check(lines==count,"all lines are read");
+  Check(renders<=allowed,"flood of output is repainted by time");
+
+  allowed=Run("i=0; while [ $i -lt 40 ]; do echo \"a.c:$i: error: x\"; sleep 0.01; i=$((i+1)); done");
+  printf("rendertest: %d lines, %d repaints, %d allowed\n",lines,renders,allowed);
+  Check(lines==40,"all slow lines are read");
+  Check(renders<=allowed,"slow output is repainted by time");
+  Check(renders>1,"slow output is shown while command runs");
+
+  printf("rendertest: %d failed\n",failed);
+  return failed?1:0;
+}
@@ -0,0 +1,142 @@
+/*
+  Copyright (C) 2000 Konstantin Stupnik
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+
+  Replay of recorded compiler output through parsers of makeit.xml,
+  the same way build output is read: each line is matched and added
+  to the log. Prints lines per second of matching alone and with lines
+  added to the log, and for comparison the same lines matched with
+  expressions of the parser tried one by one.
+  Usage: replaybench [lines per log]
+*/
+
+#include <windows.h>
+#include <time.h>
+#include "config.cpp"
+
+int Msg(const char* err)
+{
+  printf("%s\n",err);
+  return 0;
+}
+
+const char* GetMsg(int MsgId)
+{
+  return "%s";
+}
+
+static double Now()
+{
+  timespec ts;
+  clock_gettime(CLOCK_MONOTONIC,&ts);
+  return ts.tv_sec+ts.tv_nsec/1e9;
+}
+
+//lines of log as AddStrings passes them to parser
+static int ReadLog(const char* fn,StrList& lines)
+{
+  FILE *f=fopen(fn,"rb");
+  if(!f)return 0;
+  char buf[4096];
+  while(fgets(buf,sizeof(buf),f))
+  {
+    int l=strlen(buf);
+    while(l>0 && (buf[l-1]==0x0d || buf[l-1]==0x0a))buf[--l]=0;
+    for(int j=0;j<l;j++)
+    {
+      if((unsigned char)buf[j]<32)buf[j]=32;
+    }
+    lines<<buf;
+  }
+  fclose(f);
+  return lines.Count();
+}
+
+//match without RegExpSet, as parsers were matched before
+static int MatchOneByOne(SParser *p,const String& line)
+{
+  CParserTypesList *lists[]={&p->contexts,&p->notes,&p->errors,&p->warnings};
+  for(int k=0;k<4;k++)
+  {
+    for(int j=0;j<lists[k]->Count();j++)
+    {
+      SMatch m[10];
+      int n=10;
+      if((*lists[k])[j].re->Match(line,m,n))return k+1;
+    }
+  }
+  return 0;
+}
+
+int main(int argc,char* argv[])
+{
+  static const char *logs[][2]={
+    {"test/logs/gcc.log","gcc"},
+    {"test/logs/clang.log","gcc"},
+    {"test/logs/msvc.log","vcpp"},
+  };
+  int count=argc>1?atoi(argv[1]):1000000;
+  if(!read_config("makeit.xml"))
+  {
+    printf("makeit.xml not found\n");
+    return 1;
+  }
+  SColors clr;
+  SOptions opt;
+  init_config(&clr,&opt);
+  for(unsigned k=0;k<sizeof(logs)/sizeof(logs[0]);k++)
+  {
+    StrList rec,lines;
+    if(!ReadLog(logs[k][0],rec))
+    {
+      printf("%s not found\n",logs[k][0]);
+      return 1;
+    }
+    for(int i=0;i<count;i++)lines<<rec[i%rec.Count()];
+    SLineInfo li;
+    int matched=0;
+    double t0=Now();
+    for(int i=0;i<count;i++)
+    {
+      if(match_line(logs[k][1],lines[i],&li))matched++;
+    }
+    t0=Now()-t0;
+    CBuildLog log;
+    double t=Now();
+    for(int i=0;i<count;i++)
+    {
+      SLineInfo li;
+      int m=match_line(logs[k][1],lines[i],&li);
+      log.Add(lines[i],m?&li:NULL);
+    }
+    t=Now()-t;
+    SParser *p=get_parser(logs[k][1]);
+    int found=0;
+    double t1=Now();
+    for(int i=0;i<count;i++)
+    {
+      if(MatchOneByOne(p,lines[i]))found++;
+    }
+    t1=Now()-t1;
+    printf("%s: %d lines, %d matched, %d errors, %d warnings\n",logs[k][0],count,matched,log.Errors(),log.Warnings());
+    printf("  match %10.0f lines/s, match and add to log %10.0f lines/s, one by one %10.0f lines/s\n",
+           count/t0,count/t,count/t1);
+    if(found!=matched)printf("  one by one matched %d lines\n",found);
+  }
+  free_config();
+  return 0;
+}
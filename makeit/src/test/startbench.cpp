@@ -0,0 +1,116 @@
+/*
+  Copyright (C) 2000 Konstantin Stupnik
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+
+  Startup benchmark: time from reading of config to the first
+  classified line of build output, for makeit.xml and for a large
+  generated profile, when config is loaded for the first time
+  and when it is reloaded after it was changed by user.
+  Usage: startbench [parsers] [patterns per parser]
+*/
+
+#include <windows.h>
+#include <time.h>
+#include <unistd.h>
+#include "config.cpp"
+
+int Msg(const char* err)
+{
+  printf("%s\n",err);
+  return 0;
+}
+
+const char* GetMsg(int MsgId)
+{
+  return "%s";
+}
+
+static double Now()
+{
+  timespec ts;
+  clock_gettime(CLOCK_MONOTONIC,&ts);
+  return ts.tv_sec+ts.tv_nsec/1e9;
+}
+
+//ms from reading of config to the first line matched by parser
+static double FirstLine(const char* fn,const char* parser,const char* line,int reload)
+{
+  double t=Now();
+  if(reload)free_config(1);
+  if(!read_config(fn))
+  {
+    printf("%s not read\n",fn);
+    exit(1);
+  }
+  SColors clr;
+  SOptions opt;
+  init_config(&clr,&opt);
+  SLineInfo li;
+  if(!match_line(parser,line,&li))
+  {
+    printf("%s: line is not classified\n",fn);
+    exit(1);
+  }
+  return (Now()-t)*1000;
+}
+
+//profile with parsers p0..pN, only one of them is used by build
+static void WriteProfile(const char* fn,int count,int patterns,int changed)
+{
+  FILE *f=fopen(fn,"wb");
+  fprintf(f,"<makeit-config>\n  <parsers>\n");
+  for(int i=0;i<count;i++)
+  {
+    fprintf(f,"    <p%d>\n",i);
+    for(int j=0;j<patterns;j++)
+    {
+      fprintf(f,"      <warning pattern=\"/^((\\w:)?[^:]*?):(\\d+):(\\d+:)?\\s+warning W%d%d:/\" file=\"1\" line=\"3\"/>\n",
+              i==changed?i+count:i,j);
+    }
+    fprintf(f,"      <error pattern=\"/^((\\w:)?[^:]*?):(\\d+):(\\d+:)?\\s+error:/\" file=\"1\" line=\"3\"/>\n");
+    fprintf(f,"    </p%d>\n",i);
+  }
+  fprintf(f,"  </parsers>\n  <types>\n    <filetype filename=\"/.*/\">\n");
+  fprintf(f,"      <command name=\"make\" parser=\"p0\">make</command>\n");
+  fprintf(f,"    </filetype>\n  </types>\n</makeit-config>\n");
+  fclose(f);
+}
+
+int main(int argc,char* argv[])
+{
+  int count=argc>1?atoi(argv[1]):100;
+  int patterns=argc>2?atoi(argv[2]):20;
+  const char *line="src/main.cpp:10:3: error: expected ';' before '}' token";
+  double first=FirstLine("makeit.xml","gcc",line,0);
+  double same=FirstLine("makeit.xml","gcc",line,1);
+  printf("makeit.xml: first line in %.2f ms, after reload %.2f ms\n",first,same);
+  free_config();
+
+  char fn[64];
+  sprintf(fn,"/tmp/startbench.%d.xml",(int)getpid());
+  WriteProfile(fn,count,patterns,-1);
+  first=FirstLine(fn,"p0",line,0);
+  same=FirstLine(fn,"p0",line,1);
+  //user edited one parser that is not used
+  WriteProfile(fn,count,patterns,count/2);
+  double changed=FirstLine(fn,"p0",line,1);
+  printf("%d parsers of %d patterns: first line in %.2f ms, after reload %.2f ms, "
+         "after change of one parser %.2f ms\n",count,patterns+1,first,same,changed);
+  free_config();
+  remove(fn);
+  return 0;
+}
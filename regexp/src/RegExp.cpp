@@ -649,6 +649,9 @@ void RegExp::Init(const prechar expr,int options)
 {
   //memset(this,0,sizeof(*this));
   code=NULL;
+  nfa=NULL;
+  backtracks=-1;
+  literallength=0;
   brhandler=NULL;
   brhdata=NULL;
 #ifndef UNICODE
@@ -660,6 +663,11 @@ void RegExp::Init(const prechar expr,int options)
 #endif //UNICODE
 #ifdef NAMEDBRACKETS
   havenamedbrackets=0;
+#endif
+#ifdef RELIB
+  relib=NULL;
+  matchlist=NULL;
+  ResetRecursion();
 #endif
   stack=&initstack[0];
   st=&stack[0];
@@ -684,6 +692,9 @@ RegExp::RegExp()
 {
   //memset(this,0,sizeof(*this));
   code=NULL;
+  nfa=NULL;
+  backtracks=-1;
+  literallength=0;
   brhandler=NULL;
   brhdata=NULL;
   slashChar='/';
@@ -697,6 +708,11 @@ RegExp::RegExp()
 #endif//UNICODE
 #ifdef NAMEDBRACKETS
   havenamedbrackets=0;
+#endif
+#ifdef RELIB
+  relib=NULL;
+  matchlist=NULL;
+  ResetRecursion();
 #endif
   stack=&initstack[0];
   st=&stack[0];
@@ -749,6 +765,7 @@ RegExp::~RegExp()
     code=NULL;
     #endif
   }
+  NfaFree();
   CleanStack();
 #ifdef UNICODE
   delete firstptr;
@@ -935,6 +952,7 @@ int RegExp::Compile(const RECHAR* src,int options)
     backslashChar='\\';
   }
   havefirst=0;
+  NfaFree();
   #ifdef RE_NO_NEWARRAY
   DeleteArray(reinterpret_cast<void**>(&code),REOpCode::OnDelete);
   #else
@@ -942,6 +960,7 @@ int RegExp::Compile(const RECHAR* src,int options)
   code=NULL;
   #endif
   minlength=0;
+  literallength=0;
   if(options&OP_PERLSTYLE)
   {
     if(src[0]!=slashChar)return SetError(errSyntax,0);
@@ -1008,7 +1027,12 @@ int RegExp::Compile(const RECHAR* src,int options)
   }else
   {
     errorcode=errNone;
-    if(options&OP_OPTIMIZE)Optimize();
+    if(options&OP_OPTIMIZE)
+    {
+      Optimize();
+      FindLiteral();
+    }
+    NfaCompile();
   }
   return result;
 }
@@ -1920,17 +1944,6 @@ int RegExp::InnerCompile(const prechar src,int srclength,int options)
         }
         continue;
       }// case +*?{
-      case ' ':
-      case '\t':
-      case '\n':
-      case '\r':
-      {
-        if(options&OP_XTENDEDSYNTAX)
-        {
-          pos--;
-          continue;
-        }
-      }
 #ifdef RELIB
       case '%':
       {
@@ -1949,6 +1962,17 @@ int RegExp::InnerCompile(const prechar src,int srclength,int options)
         continue;
       }
 #endif
+      case ' ':
+      case '\t':
+      case '\n':
+      case '\r':
+      {
+        if(options&OP_XTENDEDSYNTAX)
+        {
+          pos--;
+          continue;
+        }
+      }
       default:
       {
         op->op=options&OP_IGNORECASE?opSymbolIgnoreCase:opSymbol;
@@ -3003,6 +3027,9 @@ int RegExp::InnerMatch(prechar str,const prechar end,PMatch match,int& matchcoun
           if(j==0)continue;
           else break;
         }
+        // empty text repeated any number of times does not move,
+        // and would never stop the loops below
+        if(m->start==m->end)continue;
 
         for(i=0;i<j;i++)
         {
@@ -3253,6 +3280,8 @@ int RegExp::InnerMatch(prechar str,const prechar end,PMatch match,int& matchcoun
     for(;;PopState())
     {
       if(0==(ps=GetState()))return 0;
+      //too much backtracking, let linear time matcher do the job
+      if(backtracks>=0 && --backtracks<0)return -2;
       //dpf(("ps->op:%s\n",ops[ps->op]));
       switch(ps->op)
       {
@@ -3649,6 +3678,552 @@ int RegExp::InnerMatch(prechar str,const prechar end,PMatch match,int& matchcoun
   return 1;
 }
 
+/*
+  Linear time matching.
+  Expressions without backreferences, assertions and named brackets
+  are additionally compiled into a program for a Thompson NFA,
+  which is simulated in lock step (pike vm). Threads are kept in
+  priority order, so result is the same as of backtracking engine,
+  but time is O(n*m) for any input.
+  Backtracking is still tried first, since it is faster on usual
+  input, but it is given up after (n+1)*m backtracks, so total
+  time stays linear.
+*/
+
+#ifdef RE_NO_NEWARRAY
+  #define RE_ALLOC(type,count) static_cast<type*>(malloc(sizeof(type)*(count)))
+  #define RE_FREE(ptr) free(ptr)
+#else
+  #define RE_ALLOC(type,count) new type[count]
+  #define RE_FREE(ptr) delete [] ptr
+#endif
+
+//! Max size of nfa program, longer expressions are matched by backtracking
+#ifndef MAXNFASIZE
+static const int MAXNFASIZE=8192;
+#endif
+
+enum RENfaOp{
+  nfaTest,        // consume one char if test op matches
+  nfaLineEnd,     // $ in multiline mode, can consume \r\n
+  nfaEatLF,       // \n after \r consumed by nfaLineEnd
+  nfaAssert,      // zero width test op
+  nfaSplit,       // fork to x (preferred) and y
+  nfaJump,        // goto x
+  nfaLoop,        // goto x, or to y if x was passed at current position
+  nfaSave,        // store position to slot x
+  nfaMatch,
+};
+
+struct RENfaInst{
+  int op;
+  int test;
+  int x,y;
+  rechar symbol;
+  int type;
+#ifdef UNICODE
+  UniSet *symbolclass;
+#else
+  prechar symbolclass;
+#endif
+};
+
+struct RENfa{
+  RENfaInst *code;
+  int count;
+  int size;
+  int slots;
+  // runtime data
+  int *marks;
+  int gen;
+  int *pcs[2];
+  int *caps[2];
+  int *stack;
+  int *tmp;
+};
+
+static int NfaEmit(RENfa *n,int op)
+{
+  if(n->count==MAXNFASIZE)return -1;
+  if(n->count==n->size)
+  {
+    int newsize=n->size?n->size*2:64;
+    RENfaInst *newcode=RE_ALLOC(RENfaInst,newsize);
+    if(n->count)memcpy(newcode,n->code,sizeof(RENfaInst)*n->count);
+    RE_FREE(n->code);
+    n->code=newcode;
+    n->size=newsize;
+  }
+  RENfaInst& in=n->code[n->count];
+  memset(&in,0,sizeof(in));
+  in.op=op;
+  return n->count++;
+}
+
+static int NfaEmitTest(RENfa *n,int test,PREOpCode op,int isrange,int ignorecase)
+{
+  int i=NfaEmit(n,nfaTest);
+  if(i==-1)return -1;
+  RENfaInst& in=n->code[i];
+  in.test=test;
+  if(!isrange)
+  {
+    in.symbol=op->symbol;
+    in.type=op->type;
+    in.symbolclass=op->symbolclass;
+    return i;
+  }
+  //range ops keep operand in range union, and case flag is global
+  in.symbol=op->range.symbol;
+  in.type=op->range.type;
+  in.symbolclass=op->range.symbolclass;
+  switch(op->op)
+  {
+    case opSymbolRange:
+    case opSymbolMinRange:
+      in.test=ignorecase?opSymbolIgnoreCase:opSymbol;
+      break;
+    case opNotSymbolRange:
+    case opNotSymbolMinRange:
+      in.test=ignorecase?opNotSymbolIgnoreCase:opNotSymbol;
+      break;
+    case opAnyRange:
+    case opAnyMinRange:
+      in.test=op->range.op;
+      break;
+    case opTypeRange:
+    case opTypeMinRange:
+      in.test=opType;
+      break;
+    case opNotTypeRange:
+    case opNotTypeMinRange:
+      in.test=opNotType;
+      break;
+    case opClassRange:
+    case opClassMinRange:
+      in.test=opSymbolClass;
+      break;
+  }
+  return i;
+}
+
+static int NfaEmitGroup(RENfa *n,PREOpCode open,int ignorecase);
+
+//one item of expression, range items are emitted as single repetition
+static int NfaEmitItem(RENfa *n,PREOpCode op,int ignorecase)
+{
+  switch(op->op)
+  {
+    case opType:
+    case opNotType:
+    case opCharAny:
+    case opCharAnyAll:
+    case opSymbol:
+    case opNotSymbol:
+    case opSymbolIgnoreCase:
+    case opNotSymbolIgnoreCase:
+    case opSymbolClass:
+      return NfaEmitTest(n,op->op,op,0,ignorecase);
+    case opLineStart:
+    case opDataStart:
+    case opDataEnd:
+    case opWordBound:
+    case opNotWordBound:
+    {
+      int i=NfaEmit(n,nfaAssert);
+      if(i!=-1)n->code[i].test=op->op;
+      return i;
+    }
+    case opLineEnd:
+      if(NfaEmit(n,nfaLineEnd)==-1)return -1;
+      return NfaEmit(n,nfaEatLF);
+    case opOpenBracket:
+      return NfaEmitGroup(n,op,ignorecase);
+    case opSymbolRange:
+    case opSymbolMinRange:
+    case opNotSymbolRange:
+    case opNotSymbolMinRange:
+    case opAnyRange:
+    case opAnyMinRange:
+    case opTypeRange:
+    case opTypeMinRange:
+    case opNotTypeRange:
+    case opNotTypeMinRange:
+    case opClassRange:
+    case opClassMinRange:
+      return NfaEmitTest(n,0,op,1,ignorecase);
+    case opBracketRange:
+    case opBracketMinRange:
+      return NfaEmitGroup(n,op,ignorecase);
+  }
+  return -1;
+}
+
+static int NfaEmitRange(RENfa *n,PREOpCode op,int ignorecase)
+{
+  int minimizing=(op->op-opRangesBegin)%2==0;
+  int i,j,split;
+  for(i=0;i<op->range.min;i++)
+  {
+    if(NfaEmitItem(n,op,ignorecase)==-1)return -1;
+  }
+  if(op->range.max==-2)
+  {
+    split=NfaEmit(n,nfaSplit);
+    if(split==-1 || NfaEmitItem(n,op,ignorecase)==-1)return -1;
+    j=NfaEmit(n,nfaLoop);
+    if(j==-1)return -1;
+    n->code[j].x=split;
+    n->code[j].y=n->count;
+    n->code[split].x=minimizing?n->count:split+1;
+    n->code[split].y=minimizing?split+1:n->count;
+    return j;
+  }
+  //optional copies, each one can leave to the end; splits are linked through y
+  int chain=-1;
+  for(i=op->range.min;i<op->range.max;i++)
+  {
+    split=NfaEmit(n,nfaSplit);
+    if(split==-1)return -1;
+    n->code[split].y=chain;
+    chain=split;
+    if(NfaEmitItem(n,op,ignorecase)==-1)return -1;
+  }
+  while(chain!=-1)
+  {
+    j=n->code[chain].y;
+    n->code[chain].x=minimizing?n->count:chain+1;
+    n->code[chain].y=minimizing?chain+1:n->count;
+    chain=j;
+  }
+  return n->count-1;
+}
+
+//sequence of ops up to stop
+static int NfaEmitSeq(RENfa *n,PREOpCode op,PREOpCode stop,int ignorecase)
+{
+  for(;op!=stop;op=op->next)
+  {
+    if(op->op>opRangesBegin && op->op<opRangesEnd)
+    {
+      if(NfaEmitRange(n,op,ignorecase)==-1)return -1;
+    }else
+    {
+      if(NfaEmitItem(n,op,ignorecase)==-1)return -1;
+    }
+    if(op->op==opOpenBracket || op->op==opBracketRange || op->op==opBracketMinRange)
+    {
+      op=op->bracket.pairindex;
+    }
+  }
+  return 0;
+}
+
+static int NfaEmitGroup(RENfa *n,PREOpCode open,int ignorecase)
+{
+  int index=open->bracket.index;
+  int i,split,jumps=-1;
+  if(index>=0)
+  {
+    i=NfaEmit(n,nfaSave);
+    if(i==-1)return -1;
+    n->code[i].x=index*2;
+  }
+  PREOpCode close=open->bracket.pairindex;
+  PREOpCode alt=open->bracket.nextalt;
+  PREOpCode from=open->next;
+  for(;;)
+  {
+    split=-1;
+    if(alt)
+    {
+      split=NfaEmit(n,nfaSplit);
+      if(split==-1)return -1;
+      n->code[split].x=split+1;
+    }
+    if(NfaEmitSeq(n,from,alt?alt:close,ignorecase)==-1)return -1;
+    if(!alt)break;
+    //chain of jumps to the end of group, linked through y
+    i=NfaEmit(n,nfaJump);
+    if(i==-1)return -1;
+    n->code[i].y=jumps;
+    jumps=i;
+    n->code[split].y=n->count;
+    from=alt->next;
+    alt=alt->alternative.nextalt;
+  }
+  while(jumps!=-1)
+  {
+    i=n->code[jumps].y;
+    n->code[jumps].x=n->count;
+    n->code[jumps].y=0;
+    jumps=i;
+  }
+  if(index>=0)
+  {
+    i=NfaEmit(n,nfaSave);
+    if(i==-1)return -1;
+    n->code[i].x=index*2+1;
+  }
+  return n->count-1;
+}
+
+void RegExp::NfaFree()
+{
+  if(!nfa)return;
+  RE_FREE(nfa->code);
+  RE_FREE(nfa->marks);
+  RE_FREE(nfa->pcs[0]);
+  RE_FREE(nfa->pcs[1]);
+  RE_FREE(nfa->caps[0]);
+  RE_FREE(nfa->caps[1]);
+  RE_FREE(nfa->stack);
+  RE_FREE(nfa->tmp);
+  RE_FREE(nfa);
+  nfa=NULL;
+}
+
+int RegExp::NfaCompile()
+{
+  NfaFree();
+#ifdef RELIB
+  //match lists are filled by backtracking engine only
+  return 0;
+#endif
+  if(maxbackref || havelookahead)return 0;
+#ifdef NAMEDBRACKETS
+  if(havenamedbrackets)return 0;
+#endif
+  PREOpCode op;
+  for(op=code;op->op!=opRegExpEnd;op=op->next)
+  {
+    switch(op->op)
+    {
+      case opLookBehind:
+      case opNotLookBehind:
+      case opNoReturn:
+        return 0;
+    }
+  }
+  nfa=RE_ALLOC(RENfa,1);
+  memset(nfa,0,sizeof(*nfa));
+  if(NfaEmitGroup(nfa,code,ignorecase)==-1 || NfaEmit(nfa,nfaMatch)==-1)
+  {
+    NfaFree();
+    return 0;
+  }
+  int cnt=nfa->count;
+  nfa->slots=bracketscount*2;
+  nfa->marks=RE_ALLOC(int,cnt);
+  memset(nfa->marks,0,sizeof(int)*cnt);
+  nfa->gen=0;
+  nfa->pcs[0]=RE_ALLOC(int,cnt);
+  nfa->pcs[1]=RE_ALLOC(int,cnt);
+  nfa->caps[0]=RE_ALLOC(int,cnt*nfa->slots);
+  nfa->caps[1]=RE_ALLOC(int,cnt*nfa->slots);
+  nfa->stack=RE_ALLOC(int,cnt*4);
+  nfa->tmp=RE_ALLOC(int,nfa->slots);
+  return 1;
+}
+
+/*
+  Add thread at pc with captures caps to list of threads,
+  following all non consuming instructions.
+  Captures changed by nfaSave are restored from stack on the way back.
+*/
+inline void RegExp::NfaAddThread(int lst,int& cnt,int pc,int *caps,prechar str,const prechar end)
+{
+  RENfa &n=*nfa;
+  int *stk=n.stack;
+  int sp=0;
+  stk[sp++]=pc;
+  stk[sp++]=-1;
+  while(sp)
+  {
+    int slot=stk[--sp];
+    pc=stk[--sp];
+    if(slot!=-1)
+    {
+      caps[slot]=pc;
+      continue;
+    }
+    for(;;)
+    {
+      if(n.marks[pc]==n.gen)break;
+      n.marks[pc]=n.gen;
+      RENfaInst &in=n.code[pc];
+      if(in.op==nfaJump)
+      {
+        pc=in.x;
+        continue;
+      }
+      if(in.op==nfaLoop)
+      {
+        //iteration that matched empty string ends the loop
+        pc=n.marks[in.x]==n.gen?in.y:in.x;
+        continue;
+      }
+      if(in.op==nfaSplit)
+      {
+        stk[sp++]=in.y;
+        stk[sp++]=-1;
+        pc=in.x;
+        continue;
+      }
+      if(in.op==nfaSave)
+      {
+        stk[sp++]=caps[in.x];
+        stk[sp++]=in.x;
+        caps[in.x]=str-start;
+        pc++;
+        continue;
+      }
+      if(in.op==nfaAssert)
+      {
+        int ok=0;
+        switch(in.test)
+        {
+          case opLineStart:
+            ok=str==start || str[-1]==0x0d || str[-1]==0x0a;
+            break;
+          case opDataStart:
+            ok=str==start;
+            break;
+          case opDataEnd:
+            ok=str==end;
+            break;
+          case opWordBound:
+          case opNotWordBound:
+            ok=(str==start && ISWORD(*str))||
+               (!(ISWORD(str[-1])) && ISWORD(*str)) ||
+               (!(ISWORD(*str)) && ISWORD(str[-1])) ||
+               (str==end && ISWORD(str[-1]));
+            if(in.test==opNotWordBound)ok=!ok;
+            break;
+        }
+        if(!ok)break;
+        pc++;
+        continue;
+      }
+      if(in.op==nfaLineEnd && str==end)
+      {
+        pc+=2;
+        continue;
+      }
+      //consuming instruction or match
+      n.pcs[lst][cnt]=pc;
+      memcpy(n.caps[lst]+cnt*n.slots,caps,sizeof(int)*n.slots);
+      cnt++;
+      break;
+    }
+  }
+}
+
+int RegExp::NfaBudget(const prechar str,const prechar end)
+{
+  if(!nfa || brhandler)return -1;
+  int len=end-str+1;
+  if(len>=0x7fffffff/nfa->count)return 0x7fffffff;
+  return len*nfa->count;
+}
+
+int RegExp::NfaExec(prechar str,const prechar end,PMatch match,int& matchcount,int search)
+{
+  RENfa &n=*nfa;
+  int i,cur=0,ccnt=0,ncnt,matched=0,started=0;
+  int *caps;
+  errorcode=errNone;
+  if(bracketscount<matchcount)matchcount=bracketscount;
+  memset(match,-1,sizeof(*match)*matchcount);
+  for(;;)
+  {
+    //new thread for each position in search mode, with the lowest priority
+    if(!matched && (search || !started))
+    {
+      if(ccnt==0)
+      {
+        n.gen++;
+        if(search && havefirst)
+        {
+          while(str<end && !first[*str])str++;
+        }
+      }
+      for(i=0;i<n.slots;i++)n.tmp[i]=-1;
+      NfaAddThread(cur,ccnt,0,n.tmp,str,end);
+      started=1;
+    }
+    if(ccnt==0)
+    {
+      if(!search || matched || str>=end)break;
+      str++;
+      continue;
+    }
+    n.gen++;
+    ncnt=0;
+    for(i=0;i<ccnt;i++)
+    {
+      int pc=n.pcs[cur][i];
+      RENfaInst &in=n.code[pc];
+      caps=n.caps[cur]+i*n.slots;
+      if(in.op==nfaMatch)
+      {
+        for(int j=0;j<matchcount;j++)
+        {
+          match[j].start=caps[j*2];
+          match[j].end=caps[j*2+1];
+        }
+        matched=1;
+        //threads with lower priority are cut off
+        break;
+      }
+      if(str>=end)continue;
+      rechar c=*str;
+      int ok=0;
+      switch(in.op)
+      {
+        case nfaTest:
+        {
+          switch(in.test)
+          {
+            case opType:ok=ISTYPE(c,in.type)!=0;break;
+            case opNotType:ok=ISTYPE(c,in.type)==0;break;
+            case opCharAny:ok=c!=0x0d && c!=0x0a;break;
+            case opCharAnyAll:ok=1;break;
+            case opSymbol:ok=c==in.symbol;break;
+            case opNotSymbol:ok=c!=in.symbol;break;
+            case opSymbolIgnoreCase:ok=TOLOWER(c)==in.symbol;break;
+            case opNotSymbolIgnoreCase:ok=TOLOWER(c)!=in.symbol;break;
+            case opSymbolClass:ok=GetBit(in.symbolclass,c)!=0;break;
+          }
+          if(ok)NfaAddThread(cur^1,ncnt,pc+1,caps,str+1,end);
+          break;
+        }
+        case nfaLineEnd:
+        {
+          if(c==0x0d && str+1<end && str[1]==0x0a)
+          {
+            NfaAddThread(cur^1,ncnt,pc+1,caps,str+1,end);
+          }else if(c==0x0d || c==0x0a)
+          {
+            NfaAddThread(cur^1,ncnt,pc+2,caps,str+1,end);
+          }
+          break;
+        }
+        case nfaEatLF:
+        {
+          if(c==0x0a)NfaAddThread(cur^1,ncnt,pc+1,caps,str+1,end);
+          break;
+        }
+      }
+    }
+    if(str>=end)break;
+    cur^=1;
+    ccnt=ncnt;
+    str++;
+  }
+  return matched;
+}
+
 int RegExp::Match(const RECHAR* textstart,const RECHAR* textend,PMatch match,int& matchcount
 #ifdef NAMEDBRACKETS
   ,PMatchHash hmatch
@@ -3661,11 +4236,14 @@ int RegExp::Match(const RECHAR* textstart,const RECHAR* textend,PMatch match,int
   TrimTail(tempend);
   if(tempend<start)return 0;
   if(minlength!=0 && tempend-start<minlength)return 0;
+  if(!HaveLiteral(start,(const prechar)textend))return 0;
+  backtracks=NfaBudget(start,tempend);
   int res=InnerMatch(start,tempend,match,matchcount
 #ifdef NAMEDBRACKETS
   ,hmatch
 #endif
   );
+  if(res==-2)res=NfaExec(start,tempend,match,matchcount,0);
   if(res==1)
   {
     int i;
@@ -3700,11 +4278,13 @@ int RegExp::MatchEx(const RECHAR* datastart,const RECHAR* textstart,const RECHAR
   end=(const prechar)textend;
   if(tempend<(const prechar)textstart)return 0;
   if(minlength!=0 && tempend-start<minlength)return 0;
+  backtracks=NfaBudget((const prechar)textstart,tempend);
   int res=InnerMatch((const prechar)textstart,tempend,match,matchcount
 #ifdef NAMEDBRACKETS
   ,hmatch
 #endif
   );
+  if(res==-2)res=NfaExec((const prechar)textstart,tempend,match,matchcount,0);
   if(res==1)
   {
     int i;
@@ -3897,6 +4477,12 @@ int RegExp::Optimize()
       {
         continue;
       }
+      //zero width, first symbol is the same
+      case opLineStart:
+      case opDataStart:
+      {
+        continue;
+      }
       case opAlternative:
       {
         return 0;
@@ -4002,13 +4588,16 @@ int RegExp::Search(const RECHAR* textstart,const RECHAR* textend,PMatch match,in
   TrimTail(tempend);
   if(tempend<start)return 0;
   if(minlength!=0 && tempend-start<minlength)return 0;
+  if(!HaveLiteral(start,(const prechar)textend))return 0;
   if(code->bracket.nextalt==0 && code->next->op==opDataStart)
   {
-    return InnerMatch(start,tempend,match,matchcount
+    backtracks=NfaBudget(start,tempend);
+    int res=InnerMatch(start,tempend,match,matchcount
 #ifdef NAMEDBRACKETS
     ,hmatch
 #endif
     );
+    return res==-2?NfaExec(start,tempend,match,matchcount,0):res;
   }
   if(code->bracket.nextalt==0 && code->next->op==opDataEnd && code->next->next->op==opClosingBracket)
   {
@@ -4018,6 +4607,8 @@ int RegExp::Search(const RECHAR* textstart,const RECHAR* textend,PMatch match,in
     return 1;
   }
   int res=0;
+  prechar from=str;
+  backtracks=NfaBudget(str,tempend);
   if(havefirst)
   {
     do{
@@ -4032,13 +4623,13 @@ int RegExp::Search(const RECHAR* textstart,const RECHAR* textend,PMatch match,in
       }
       str++;
     }while(str<tempend);
-    if(!res && InnerMatch(str,tempend,match,matchcount
+    if(!res)
+    {
+      res=InnerMatch(str,tempend,match,matchcount
 #ifdef NAMEDBRACKETS
-       ,hmatch
+         ,hmatch
 #endif
-    ))
-    {
-      res=1;
+      );
     }
   }else
   {
@@ -4054,6 +4645,7 @@ int RegExp::Search(const RECHAR* textstart,const RECHAR* textend,PMatch match,in
       str++;
     }while(str<=tempend);
   }
+  if(res==-2)res=NfaExec(from,tempend,match,matchcount,1);
   if(res==1)
   {
     int i;
@@ -4082,11 +4674,13 @@ int RegExp::SearchEx(const RECHAR* datastart,const RECHAR* textstart,const RECHA
   if(minlength!=0 && tempend-start<minlength)return 0;
   if(code->bracket.nextalt==0 && code->next->op==opDataStart)
   {
-    return InnerMatch(str,tempend,match,matchcount
+    backtracks=NfaBudget(str,tempend);
+    int res=InnerMatch(str,tempend,match,matchcount
 #ifdef NAMEDBRACKETS
     ,hmatch
 #endif
     );
+    return res==-2?NfaExec(str,tempend,match,matchcount,0):res;
   }
   if(code->bracket.nextalt==0 && code->next->op==opDataEnd && code->next->next->op==opClosingBracket)
   {
@@ -4096,6 +4690,8 @@ int RegExp::SearchEx(const RECHAR* datastart,const RECHAR* textstart,const RECHA
     return 1;
   }
   int res=0;
+  prechar from=str;
+  backtracks=NfaBudget(str,tempend);
   if(havefirst)
   {
     do{
@@ -4110,13 +4706,13 @@ int RegExp::SearchEx(const RECHAR* datastart,const RECHAR* textstart,const RECHA
       }
       str++;
     }while(str<tempend);
-    if(!res && InnerMatch(str,tempend,match,matchcount
+    if(!res)
+    {
+      res=InnerMatch(str,tempend,match,matchcount
 #ifdef NAMEDBRACKETS
-       ,hmatch
+         ,hmatch
 #endif
-    ))
-    {
-      res=1;
+      );
     }
   }else
   {
@@ -4132,6 +4728,7 @@ int RegExp::SearchEx(const RECHAR* datastart,const RECHAR* textstart,const RECHA
       str++;
     }while(str<=tempend);
   }
+  if(res==-2)res=NfaExec(from,tempend,match,matchcount,1);
   if(res==1)
   {
     int i;
@@ -4146,6 +4743,100 @@ int RegExp::SearchEx(const RECHAR* datastart,const RECHAR* textstart,const RECHA
   return res;
 }
 
+/*
+  Find longest sequence of symbols that must be present in
+  any matched text. Only top level sequence is examined,
+  brackets with alternatives and quantified brackets are skipped.
+*/
+void RegExp::FindLiteral()
+{
+  rechar run[MAXLITERAL];
+  int runlength=0;
+  int i;
+  literallength=0;
+  if(!code || code->bracket.nextalt || ignorecase)return;
+  PREOpCode op=code->next;
+  PREOpCode stop=code->bracket.pairindex;
+  while(op && op!=stop)
+  {
+    int endrun=1;
+    switch(OP.op)
+    {
+      case opSymbol:
+      {
+        if(runlength<MAXLITERAL)run[runlength++]=OP.symbol;
+        endrun=0;
+        break;
+      }
+      case opSymbolRange:
+      case opSymbolMinRange:
+      {
+        for(i=0;i<OP.range.min && runlength<MAXLITERAL;i++)run[runlength++]=OP.range.symbol;
+        endrun=OP.range.min!=OP.range.max;
+        break;
+      }
+#ifdef NAMEDBRACKETS
+      case opNamedBracket:
+#endif
+      case opOpenBracket:
+      {
+        if(OP.bracket.nextalt)op=OP.bracket.pairindex;
+        else endrun=0;
+        break;
+      }
+      case opClosingBracket:
+      {
+        endrun=0;
+        break;
+      }
+      case opBracketRange:
+      case opBracketMinRange:
+      {
+        op=OP.range.bracket.pairindex;
+        break;
+      }
+      case opLookAhead:
+      case opNotLookAhead:
+      case opLookBehind:
+      case opNotLookBehind:
+      {
+        op=OP.assert.pairindex;
+        break;
+      }
+    }
+    if(endrun)
+    {
+      if(runlength>literallength)
+      {
+        for(i=0;i<runlength;i++)literal[i]=run[i];
+        literallength=runlength;
+      }
+      runlength=0;
+    }
+    op=op->next;
+  }
+  if(runlength>literallength)
+  {
+    for(i=0;i<runlength;i++)literal[i]=run[i];
+    literallength=runlength;
+  }
+}
+
+inline int RegExp::HaveLiteral(prechar str,const prechar end)
+{
+  if(!literallength)return 1;
+  const prechar last=end-literallength;
+  rechar c=literal[0];
+  for(;str<=last;str++)
+  {
+    if(*str!=c)continue;
+    int i=1;
+    while(i<literallength && str[i]==literal[i])i++;
+    if(i==literallength)return 1;
+  }
+  return 0;
+}
+
 void RegExp::TrimTail(prechar& end)
 {
   if(havelookahead)return;
@@ -4300,6 +4991,255 @@ void RegExp::SetLocaleInfo(prechar newlc,prechar newuc,prechar newchartypes
 }
 #endif //UNICODE
 
+RegExpSet::RegExpSet()
+{
+  re=NULL;
+  count=0;
+  size=0;
+  cand=NULL;
+  litok=NULL;
+  live=NULL;
+  livecount=0;
+  prepared=0;
+}
+
+RegExpSet::~RegExpSet()
+{
+  Clean();
+}
+
+void RegExpSet::Clean()
+{
+  if(re)RE_FREE(re);
+  if(cand)RE_FREE(cand);
+  if(litok)RE_FREE(litok);
+  if(live)RE_FREE(live);
+  re=NULL;
+  cand=NULL;
+  litok=NULL;
+  live=NULL;
+  livecount=0;
+  count=0;
+  size=0;
+  prepared=0;
+}
+
+int RegExpSet::Add(RegExp* expr)
+{
+  if(count==size)
+  {
+    size=size?size*2:16;
+    RegExp **newre=RE_ALLOC(RegExp*,size);
+    for(int i=0;i<count;i++)newre[i]=re[i];
+    if(re)RE_FREE(re);
+    re=newre;
+  }
+  re[count]=expr;
+  prepared=0;
+  return count++;
+}
+
+inline int RegExpSet::CanStart(RegExp* r,int c)
+{
+  //empty slot or expression that failed to compile never matches
+  if(!r || !r->code)return 0;
+  if(!r->havefirst)return 1;
+  if(c==256)return 0;
+#ifdef UNICODE
+  return (*r->firstptr)[(rechar)c];
+#else
+  return r->first[c];
+#endif
+}
+
+void RegExpSet::Prepare()
+{
+  int i,c;
+  if(cand)RE_FREE(cand);
+  if(litok)RE_FREE(litok);
+  if(live)RE_FREE(live);
+  litok=RE_ALLOC(int,count?count:1);
+  live=RE_ALLOC(int,count?count:1);
+  livecount=0;
+  //count candidates first, then fill
+  int total=0;
+  for(c=0;c<=256;c++)
+  {
+    candidx[c]=total;
+    for(i=0;i<count;i++)
+    {
+      if(CanStart(re[i],c))total++;
+    }
+  }
+  candidx[257]=total;
+  cand=RE_ALLOC(int,total?total:1);
+  total=0;
+  for(c=0;c<=256;c++)
+  {
+    for(i=0;i<count;i++)
+    {
+      if(CanStart(re[i],c))cand[total++]=i;
+    }
+  }
+  prepared=1;
+}
+
+/*
+  MatchEx keeps trimmed end of the text between calls with the same
+  text bounds, so it must be reset when new text is passed,
+  since the same buffer can be reused for another line.
+  Text is checked for literal of expression before matching,
+  in Search mode it is done once for whole text.
+  When fewer expressions passed that check than there are candidates
+  for the symbol, passed ones are walked instead, both lists are
+  in order of index, so the first match is the same.
+*/
+inline int RegExpSet::TryAt(const prechar datastart,const prechar str,const prechar end,PMatch match,int& matchcount,int from,int reset
+#ifdef NAMEDBRACKETS
+                            ,PMatchHash hmatch
+#endif
+                           )
+{
+  int c=str<end?*str:256;
+#ifdef UNICODE
+  if(str<end && c>255)
+  {
+    //no table for wide symbols, try all expressions
+    for(int i=from;i<count;i++)
+    {
+      if(!re[i] || !re[i]->code)continue;
+      if(reset)
+      {
+        re[i]->end=NULL;
+        if(!re[i]->HaveLiteral(str,end))continue;
+      }else if(!litok[i])continue;
+      int n=matchcount;
+      if(re[i]->MatchEx((const RECHAR*)datastart,(const RECHAR*)str,(const RECHAR*)end,match,n
+#ifdef NAMEDBRACKETS
+         ,hmatch
+#endif
+      )==1)
+      {
+        matchcount=n;
+        return i;
+      }
+    }
+    return -1;
+  }
+#endif
+  if(!reset && livecount<candidx[c+1]-candidx[c])
+  {
+    for(int j=0;j<livecount;j++)
+    {
+      int i=live[j];
+      if(i<from || !CanStart(re[i],c))continue;
+      int n=matchcount;
+      if(re[i]->MatchEx((const RECHAR*)datastart,(const RECHAR*)str,(const RECHAR*)end,match,n
+#ifdef NAMEDBRACKETS
+         ,hmatch
+#endif
+      )==1)
+      {
+        matchcount=n;
+        return i;
+      }
+    }
+    return -1;
+  }
+  for(int j=candidx[c];j<candidx[c+1];j++)
+  {
+    int i=cand[j];
+    if(i<from)continue;
+    if(reset)
+    {
+      re[i]->end=NULL;
+      if(!re[i]->HaveLiteral(str,end))continue;
+    }else if(!litok[i])continue;
+    int n=matchcount;
+    if(re[i]->MatchEx((const RECHAR*)datastart,(const RECHAR*)str,(const RECHAR*)end,match,n
+#ifdef NAMEDBRACKETS
+       ,hmatch
+#endif
+    )==1)
+    {
+      matchcount=n;
+      return i;
+    }
+  }
+  return -1;
+}
+
+int RegExpSet::Match(const RECHAR* textstart,const RECHAR* textend,PMatch match,int& matchcount,int from
+#ifdef NAMEDBRACKETS
+                     ,PMatchHash hmatch
+#endif
+                    )
+{
+  if(!prepared)Prepare();
+  return TryAt((const prechar)textstart,(const prechar)textstart,(const prechar)textend,match,matchcount,from,1
+#ifdef NAMEDBRACKETS
+               ,hmatch
+#endif
+              );
+}
+
+int RegExpSet::Match(const RECHAR* textstart,PMatch match,int& matchcount,int from
+#ifdef NAMEDBRACKETS
+                     ,PMatchHash hmatch
+#endif
+                    )
+{
+  return Match(textstart,textstart+strlen(textstart),match,matchcount,from
+#ifdef NAMEDBRACKETS
+               ,hmatch
+#endif
+              );
+}
+
+int RegExpSet::Search(const RECHAR* textstart,const RECHAR* textend,PMatch match,int& matchcount
+#ifdef NAMEDBRACKETS
+                      ,PMatchHash hmatch
+#endif
+                     )
+{
+  if(!prepared)Prepare();
+  prechar str=(prechar)textstart;
+  prechar end=(prechar)textend;
+  livecount=0;
+  for(int i=0;i<count;i++)
+  {
+    litok[i]=0;
+    if(!re[i] || !re[i]->code)continue;
+    re[i]->end=NULL;
+    litok[i]=re[i]->HaveLiteral(str,end);
+    if(litok[i])live[livecount++]=i;
+  }
+  if(!livecount)return -1;
+  for(;str<=end;str++)
+  {
+    int res=TryAt((const prechar)textstart,str,end,match,matchcount,0,0
+#ifdef NAMEDBRACKETS
+                  ,hmatch
+#endif
+                 );
+    if(res!=-1)return res;
+  }
+  return -1;
+}
+
+int RegExpSet::Search(const RECHAR* textstart,PMatch match,int& matchcount
+#ifdef NAMEDBRACKETS
+                      ,PMatchHash hmatch
+#endif
+                     )
+{
+  return Search(textstart,textstart+strlen(textstart),match,matchcount
+#ifdef NAMEDBRACKETS
+                ,hmatch
+#endif
+               );
+}
+
 #ifdef RELIB
 
 int RELibMatch(RELib& relib,MatchList& ml,const char* name,const char* start)
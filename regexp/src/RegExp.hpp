@@ -102,12 +102,19 @@ enum REError{
 struct REOpCode;
 //! Used internally
 typedef REOpCode *PREOpCode;
+//! Used internally
+struct RENfa;
 
 //! Max brackets depth can be redefined in compile time
 #ifndef MAXDEPTH
 static const int MAXDEPTH=256;
 #endif
 
+//! Max length of literal string used to reject text before matching
+#ifndef MAXLITERAL
+static const int MAXLITERAL=16;
+#endif
+
 /**
   \defgroup options Regular expression compile time options
 */
@@ -312,6 +319,16 @@ private:
 
   int minlength;
 
+  // longest string that any match must contain,
+  // text without it is rejected without matching
+  rechar literal[MAXLITERAL];
+  int literallength;
+
+  // linear time matcher, NULL if expression needs backtracking
+  RENfa *nfa;
+  // number of backtracks left before switching to linear time matcher
+  int backtracks;
+
   // error info
   int errorcode;
   int errorpos;
@@ -352,8 +369,23 @@ private:
 
   void TrimTail(prechar& end);
 
+  void FindLiteral();
+  int HaveLiteral(prechar str,const prechar end);
+
+  int NfaCompile();
+  void NfaFree();
+  void NfaAddThread(int lst,int& cnt,int pc,int *caps,prechar str,const prechar end);
+  int NfaBudget(const prechar str,const prechar end);
+  int NfaExec(prechar str,const prechar end,PMatch match,int& matchcount,int search);
+
   int SetError(int code,int pos){errorcode=code;errorpos=pos;return 0;}
 
+  friend class RegExpSet;
+#ifdef RE_TESTING
+  //access to both matchers from tests
+  friend struct RegExpTest;
+#endif
+
   int GetNum(const prechar src,int& i);
 
   static inline void SetBit(prechar bitset,int charindex)
@@ -541,6 +573,93 @@ protected:
   void* brhdata;
 };
 
+/*! Set of regular expressions matched together.
+
+Start symbol tables of all expressions are merged into one
+table, so for each position of the text only expressions that
+can start with the symbol at that position are tried.
+Expressions are tried in the order they were added.
+Expressions are not owned by the set, and must be compiled
+(and optimized) before they are added.
+*/
+class RegExpSet{
+private:
+  RegExp **re;
+  int count;
+  int size;
+
+  // candidates for symbol c are cand[candidx[c]]..cand[candidx[c+1]-1],
+  // entry 256 is for expressions without start symbol table
+  int *cand;
+  int candidx[258];
+  int prepared;
+  // literal test result for each expression, for current Search
+  int *litok;
+  // expressions that passed literal test, for current Search
+  int *live;
+  int livecount;
+
+  static int CanStart(RegExp* r,int c);
+  void Prepare();
+  int TryAt(const prechar datastart,const prechar str,const prechar end,PMatch match,int& matchcount,int from,int reset
+#ifdef NAMEDBRACKETS
+            ,PMatchHash hmatch
+#endif
+            );
+  RegExpSet(const RegExpSet& s){};
+public:
+  RegExpSet();
+  ~RegExpSet();
+
+  /*! Add expression to the set.
+      NULL or not compiled expression takes its index,
+      but is never matched.
+      \return index of expression in the set.
+  */
+  int Add(RegExp* expr);
+  //! Remove all expressions from the set.
+  void Clean();
+  //! Number of expressions in the set.
+  int Count() const {return count;}
+  RegExp* operator[](int index){return re[index];}
+
+  /*! Match string with expressions of the set.
+      Parameters are the same as for RegExp::Match.
+      \param from - index of the first expression to try.
+      \return index of first matched expression, -1 if none matched.
+      match receive brackets of matched expression.
+      Call again with from set to returned index+1 to get
+      the rest of matched expressions.
+  */
+  int Match(const RECHAR* textstart,const RECHAR* textend,PMatch match,int& matchcount,int from=0
+#ifdef NAMEDBRACKETS
+                 ,PMatchHash hmatch=NULL
+#endif
+  );
+  //! Same as Match with textend, but for ASCIIZ string.
+  int Match(const RECHAR* textstart,PMatch match,int& matchcount,int from=0
+#ifdef NAMEDBRACKETS
+                 ,PMatchHash hmatch=NULL
+#endif
+  );
+  /*! Find leftmost fragment of text matched by any expression of the set.
+      Text is scanned once for all expressions. If several expressions
+      match at the same position, first added wins.
+      \return index of matched expression, -1 if none matched.
+  */
+  int Search(const RECHAR* textstart,const RECHAR* textend,PMatch match,int& matchcount
+#ifdef NAMEDBRACKETS
+                 ,PMatchHash hmatch=NULL
+#endif
+  );
+  //! Same as Search with textend, but for ASCIIZ string.
+  int Search(const RECHAR* textstart,PMatch match,int& matchcount
+#ifdef NAMEDBRACKETS
+                 ,PMatchHash hmatch=NULL
+#endif
+  );
+};
+
 #ifdef RELIB
 int RELibMatch(RELib& relib,MatchList& ml,const RECHAR* name,const RECHAR* start);
 int RELibMatch(RELib& relib,MatchList& ml,const RECHAR* name,const RECHAR* start,const RECHAR* end);
@@ -0,0 +1,91 @@
+/*
+  Copyright (C) 2000 Konstantin Stupnik
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+  Benchmark of expressions with exponential backtracking.
+  Each one is searched in text of growing length that almost matches,
+  once as usual, when backtracking falls to the linear time matcher,
+  and once with backtracking only, for short texts where it finishes.
+  nfabench [maxbacktracklength]
+*/
+
+#include "RegExp.hpp"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+namespace XClasses{
+
+struct RegExpTest{
+  static void Backtracking(RegExp& re){re.NfaFree();}
+};
+
+}
+
+using namespace XClasses;
+
+struct BenchCase{
+  const char* expr;
+  const char* tail; // appended to run of 'a'
+};
+
+static BenchCase cases[]={
+  {"/(a+)+b/","c b"},
+  {"/(a|aa)+b/","c b"},
+  {"/^(\\w+\\s?)*;/","!;"},
+  {"/(.*a){12}/",""},
+  {"/(a*)*b/",""},
+};
+
+static double Run(const char* expr,const char* text,int backtracking,int& res)
+{
+  RegExp re(expr);
+  if(backtracking)RegExpTest::Backtracking(re);
+  SMatch m[10];
+  int n=10;
+  clock_t t=clock();
+  res=re.Search(text,m,n);
+  return (double)(clock()-t)*1000/CLOCKS_PER_SEC;
+}
+
+int main(int argc,char* argv[])
+{
+  RegExp::InitLocale();
+  int maxbt=argc>1?atoi(argv[1]):20;
+  static const int lengths[]={16,20,24,1000,100000};
+  char* text=new char[100000+8];
+  for(unsigned k=0;k<sizeof(cases)/sizeof(cases[0]);k++)
+  {
+    for(unsigned l=0;l<sizeof(lengths)/sizeof(lengths[0]);l++)
+    {
+      int len=lengths[l];
+      memset(text,'a',len);
+      strcpy(text+len,cases[k].tail);
+      int res;
+      double t=Run(cases[k].expr,text,0,res);
+      printf("%-16s n=%-6d %10.3f ms res=%d",cases[k].expr,len,t,res);
+      if(len<=maxbt)
+      {
+        t=Run(cases[k].expr,text,1,res);
+        printf("   backtracking %10.3f ms res=%d",t,res);
+      }
+      printf("\n");
+    }
+  }
+  delete [] text;
+  return 0;
+}
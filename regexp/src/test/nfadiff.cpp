@@ -0,0 +1,134 @@
+/*
+  Copyright (C) 2000 Konstantin Stupnik
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+  Differential test of the linear time matcher against backtracking.
+  Every expression is compiled twice, one copy runs the nfa directly,
+  the other has nfa freed and runs backtracking only; results on
+  random texts must be the same.
+  In expressions flagged as 'e' loop body can match empty string,
+  backtracking keeps the brackets of the last empty iteration,
+  nfa keeps the previous ones, so only whole match is compared there.
+*/
+
+#include "RegExp.hpp"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+namespace XClasses{
+
+struct RegExpTest{
+  static int HaveNfa(RegExp& re){return re.nfa!=NULL;}
+  static void Backtracking(RegExp& re){re.NfaFree();}
+  static int Nfa(RegExp& re,const char* text,PMatch m,int& n,int search)
+  {
+    re.start=(prechar)text;
+    re.end=(prechar)text+strlen(text);
+    int res=re.NfaExec((prechar)text,re.end,m,n,search);
+    if(res)
+    {
+      for(int i=0;i<n;i++)
+      {
+        if(m[i].start==-1 || m[i].end==-1 || m[i].start>m[i].end)m[i].start=m[i].end=-1;
+      }
+    }
+    return res;
+  }
+};
+
+}
+
+using namespace XClasses;
+
+struct DiffCase{
+  const char* expr;
+  char flags;
+};
+
+static DiffCase cases[]={
+  {"/a*b/",0},{"/(a|ab)(c|bcd)(d*)/",0},{"/(a+)+b/",0},{"/^(\\w+)\\s*=\\s*(.*)$/",0},
+  {"/x(y|z)*?w/",0},{"/(a|b)*?c/",0},{"/[a-c]{2,4}/",0},{"/a{3}/",0},{"/(ab){1,3}/",0},
+  {"/(ab){0,2}?b/",0},{"/\\bfoo\\b/",0},{"/\\Bo/",0},{"/^$/",0},{"/a|b|cd|c/",0},
+  {"/(\\d+)\\.(\\d*)/",0},{"/[^ab]+/i",0},{"/AB+c/i",0},{"/.*:(\\d+):/",0},
+  {"/(.*):(\\d+):(.*)/",0},{"/^(.*?)\\((\\d+)\\)/",0},{"/a$/m",0},{"/^b/m",0},{"/a$\\nb/m",0},
+  {"/x?y?z?/",0},{"/(a*)*/",'e'},{"/(a*)+b/",'e'},{"/(|a)+/",'e'},{"/[\\w.]+@\\w+/",0},
+  {"/\\S+\\s\\S+/",0},{"/(?:ab|a)(?:bc|c)/",0},{"/((a)|(b))+/",0},{"/(a?){3}/",0},
+  {"/.+?x/s",0},{"/e\\.g\\./",0},{"/a{2,}/",0},{"/(foo|foobar)(bar)?/",0},{"/\\w+?\\d/",0},
+  {"/^\\s*(\\S+)\\s+(\\S+)/",0},{"/(\\w+\\s?)*;/",0},{"/(a|aa)+c/",0},
+};
+
+static unsigned seed=1;
+
+static int Rand()
+{
+  seed=seed*1103515245+12345;
+  return (seed>>16)&0x7fff;
+}
+
+static void Print(const char* name,int res,PMatch m,int n)
+{
+  printf("  %s %d:",name,res);
+  if(res)for(int i=0;i<n;i++)printf(" %d,%d",m[i].start,m[i].end);
+  printf("\n");
+}
+
+int main(int argc,char* argv[])
+{
+  RegExp::InitLocale();
+  int texts=argc>1?atoi(argv[1]):3000;
+  static const char chars[]="aabbcdxyzw0123 .:=()\n\rfoE_;";
+  int total=0,failed=0;
+  for(unsigned k=0;k<sizeof(cases)/sizeof(cases[0]);k++)
+  {
+    RegExp nfa(cases[k].expr),bt(cases[k].expr);
+    if(!RegExpTest::HaveNfa(nfa))
+    {
+      printf("%s: no nfa\n",cases[k].expr);
+      failed++;
+      continue;
+    }
+    RegExpTest::Backtracking(bt);
+    int reported=0;
+    for(int t=0;t<texts;t++)
+    {
+      char text[64];
+      int len=Rand()%24;
+      for(int i=0;i<len;i++)text[i]=chars[Rand()%(sizeof(chars)-1)];
+      text[len]=0;
+      for(int search=0;search<2;search++)
+      {
+        SMatch m1[10],m2[10];
+        int n1=10,n2=10;
+        int r1=RegExpTest::Nfa(nfa,text,m1,n1,search);
+        int r2=search?bt.Search(text,m2,n2):bt.Match(text,m2,n2);
+        int cmp=cases[k].flags=='e'?1:n1;
+        int diff=r1!=r2 || (r1 && (n1!=n2 || memcmp(m1,m2,sizeof(SMatch)*cmp)));
+        total++;
+        if(!diff)continue;
+        failed++;
+        if(reported++)continue;
+        printf("%s %s [",cases[k].expr,search?"search":"match");
+        for(char* c=text;*c;c++)printf(*c<32?"\\%d":"%c",*c);
+        printf("]\n");
+        Print("nfa",r1,m1,n1);
+        Print("backtracking",r2,m2,n2);
+      }
+    }
+  }
+  printf("nfadiff: %d of %d differ\n",failed,total);
+  return failed?1:0;
+}
@@ -0,0 +1,178 @@
+/*
+  Copyright (C) 2000 Konstantin Stupnik
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+  Micro-benchmarks of the regular expressions library.
+  Each case searches every line of a generated source-like text
+  and prints the time per line and the number of matches,
+  so changes of the matcher can be compared on the same numbers.
+  Last case is RegExpSet with 1 to 500 expressions against the same
+  expressions searched one by one.
+  rebench [lines]
+*/
+
+#include "RegExp.hpp"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+using namespace XClasses;
+
+static char** lines;
+static int linecount;
+
+static void MakeText(int count)
+{
+  static const char* words[]={"int","char","return","value","index","buffer","count","while","static","const",
+    "x","i","len","ptr","next","first","error","warning","note","10","255","0x1F","127.0.0.1"};
+  unsigned seed=1;
+  lines=new char*[count];
+  for(int i=0;i<count;i++)
+  {
+    char buf[256];
+    int len=0;
+    int n=4+(seed=seed*1103515245+12345)%12;
+    for(int j=0;j<n;j++)
+    {
+      seed=seed*1103515245+12345;
+      const char* w=words[(seed>>16)%(sizeof(words)/sizeof(words[0]))];
+      len+=sprintf(buf+len,j?" %s":"%s",w);
+      if(((seed>>8)&7)==0)buf[len++]=(seed&1)?'(':';';
+    }
+    if(i%50==0)len+=sprintf(buf+len," file.c:%d: error: undeclared",i);
+    buf[len]=0;
+    lines[i]=strdup(buf);
+  }
+  linecount=count;
+}
+
+static void Run(const char* name,RegExp& re)
+{
+  SMatch m[16];
+  int found=0;
+  clock_t t=clock();
+  for(int i=0;i<linecount;i++)
+  {
+    int n=16;
+    if(re.Search(lines[i],m,n))found++;
+  }
+  t=clock()-t;
+  printf("%-14s %8.1f ns/line %8d matches\n",name,(double)t*1e9/CLOCKS_PER_SEC/linecount,found);
+}
+
+//n-th expression of the set sweep, kinds alternate, numbers keep them distinct
+static void MakePattern(int n,char* buf)
+{
+  if(n==0)strcpy(buf,"/:(\\d+): error: (\\w+)/");
+  else if(n%3==0)sprintf(buf,"/\\bvalue%d\\b/",n);
+  else if(n%3==1)sprintf(buf,"/^(\\w+)\\.c:(\\d+): warning %d/",n);
+  else sprintf(buf,"/[a-z_]+\\s*=\\s*%d;/",n);
+}
+
+//RegExpSet search time per line by number of expressions in the set
+static void SetSweep()
+{
+  static const int sizes[]={1,2,5,10,20,50,100,200,500};
+  const int maxsize=500;
+  int count=linecount<20000?linecount:20000;
+  RegExp* all[maxsize];
+  char buf[64];
+  for(int i=0;i<maxsize;i++)
+  {
+    MakePattern(i,buf);
+    all[i]=new RegExp(buf);
+  }
+  printf("%d lines\n",count);
+  for(unsigned k=0;k<sizeof(sizes)/sizeof(sizes[0]);k++)
+  {
+    int n=sizes[k];
+    RegExpSet set;
+    for(int i=0;i<n;i++)set.Add(all[i]);
+    SMatch m[16];
+    int setfound=0,onefound=0;
+    clock_t t=clock();
+    for(int i=0;i<count;i++)
+    {
+      int mc=16;
+      if(set.Search(lines[i],m,mc)>=0)setfound++;
+    }
+    clock_t setTime=clock()-t;
+    t=clock();
+    for(int i=0;i<count;i++)
+    {
+      for(int j=0;j<n;j++)
+      {
+        int mc=16;
+        if(all[j]->Search(lines[i],m,mc))
+        {
+          onefound++;
+          break;
+        }
+      }
+    }
+    clock_t oneTime=clock()-t;
+    printf("set of %-6d %8.1f ns/line, one by one %9.1f ns/line %8d/%d matches\n",n,
+           (double)setTime*1e9/CLOCKS_PER_SEC/count,(double)oneTime*1e9/CLOCKS_PER_SEC/count,
+           setfound,onefound);
+  }
+  for(int i=0;i<maxsize;i++)delete all[i];
+}
+
+int main(int argc,char* argv[])
+{
+  RegExp::InitLocale();
+  MakeText(argc>1?atoi(argv[1]):200000);
+
+  // required literal lets the matcher skip lines without it
+  RegExp prefix("/:(\\d+): error: (\\w+)/");
+  Run("literal",prefix);
+
+  // identifier followed by a call bracket, first char table only
+  RegExp classes("/[a-z_][a-z0-9_]*\\s*\\(/i");
+  Run("classes",classes);
+
+  RegExp alt("/\\b(?:while|return|static|warning|note)\\b/");
+  Run("alternation",alt);
+
+#ifdef RELIB
+  // the same named pattern called several times from one expression
+  RELib lib;
+  RegExp num("/\\d+/"),ip("/%num%\\.%num%\\.%num%\\.%num%/");
+  lib.SetItem("num",&num);
+  RegExp find("/.*?%ip%/");
+  lib.SetItem("ip",&ip);
+  lib.SetItem("find",&find);
+  num.SetRELib(&lib);
+  ip.SetRELib(&lib);
+  find.SetRELib(&lib);
+  // match lists are owned by the caller and not freed by the library,
+  // so this case runs on a part of the text only
+  int count=linecount<20000?linecount:20000;
+  int found=0;
+  clock_t t=clock();
+  for(int i=0;i<count;i++)
+  {
+    MatchList ml;
+    if(RELibMatch(lib,ml,"find",lines[i]))found++;
+  }
+  t=clock()-t;
+  printf("%-14s %8.1f ns/line %8d matches\n","named pattern",(double)t*1e9/CLOCKS_PER_SEC/count,found);
+#endif
+
+  SetSweep();
+  return 0;
+}
@@ -0,0 +1,169 @@
+/*
+  Copyright (C) 2000 Konstantin Stupnik
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+  Fuzz harness of the regular expressions library.
+  Input is split into expression and text at the first zero byte,
+  the expression is compiled with options taken from the first byte,
+  and matched and searched in the text. Found brackets must lie
+  inside the text.
+
+  Built with clang -fsanitize=fuzzer it is a libFuzzer target.
+  Otherwise main replays files given on the command line, or runs
+  random inputs: refuzz [-seed N] [-runs N].
+*/
+
+#include "RegExp.hpp"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+using namespace XClasses;
+
+static void Check(int res,PMatch m,int n,int len)
+{
+  if(!res)return;
+  if(m[0].start<0 || m[0].start>m[0].end || m[0].end>len)abort();
+  for(int i=1;i<n;i++)
+  {
+    if(m[i].start<-1 || m[i].end>len)abort();
+  }
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const unsigned char* data,size_t size)
+{
+  if(size<2 || size>4096)return 0;
+  static int inited;
+  if(!inited)
+  {
+    RegExp::InitLocale();
+    inited=1;
+  }
+  int options=OP_PERLSTYLE;
+  if(data[0]&1)options|=OP_OPTIMIZE;
+  if(data[0]&2)options|=OP_IGNORECASE;
+  if(data[0]&4)options|=OP_MULTILINE;
+  if(data[0]&8)options|=OP_SINGLELINE;
+  if(data[0]&16)options|=OP_XTENDEDSYNTAX;
+  data++;
+  size--;
+  const unsigned char* sep=(const unsigned char*)memchr(data,0,size);
+  size_t exprlen=sep?sep-data:size;
+  char* expr=new char[exprlen+3];
+  expr[0]='/';
+  for(size_t i=0;i<exprlen;i++)expr[i+1]=data[i]=='/'?'.':data[i];
+  // a trailing backslash would escape the closing slash
+  if(exprlen && expr[exprlen]=='\\')expr[exprlen]='.';
+  expr[exprlen+1]='/';
+  expr[exprlen+2]=0;
+  const char* text=sep?(const char*)sep+1:"";
+  int len=sep?size-exprlen-1:0;
+
+  RegExp re;
+  if(re.Compile(expr,options))
+  {
+    SMatch m[16];
+    int n=16;
+    int res=re.Match(text,text+len,m,n);
+    Check(res,m,n,len);
+    n=16;
+    res=re.Search(text,text+len,m,n);
+    Check(res,m,n,len);
+    RegExpSet set;
+    set.Add(&re);
+    n=16;
+    res=set.Search(text,text+len,m,n);
+    Check(res>=0,m,n,len);
+  }
+  delete [] expr;
+  return 0;
+}
+
+#ifndef RE_LIBFUZZER
+
+static unsigned rnd(unsigned& seed)
+{
+  seed=seed*1103515245+12345;
+  return (seed>>16)&0x7fff;
+}
+
+// random input built from regexp syntax pieces, so most of them compile
+static int Generate(unsigned& seed,unsigned char* buf)
+{
+  static const char* pieces[]={"a","b","ab",".","*","+","?","*?","+?","{2}","{1,3}","{2,}","(",")","(?:","|",
+    "[ab]","[^a]","[a-z]","\\d","\\w","\\s","\\b","\\B","^","$","\\1","(?=","(?!","(?<=","\\.","\\x41","\\n","x"};
+  static const char textchars[]="aabbx. \n1A_";
+  int len=0;
+  buf[len++]=rnd(seed)&31;
+  int n=rnd(seed)%12,open=0;
+  for(int i=0;i<n;i++)
+  {
+    const char* p=pieces[rnd(seed)%(sizeof(pieces)/sizeof(pieces[0]))];
+    if(*p==')')
+    {
+      if(!open)continue;
+      open--;
+    }
+    else if(*p=='(')open++;
+    while(*p)buf[len++]=*p++;
+  }
+  while(open--)buf[len++]=')';
+  buf[len++]=0;
+  n=rnd(seed)%40;
+  for(int i=0;i<n;i++)buf[len++]=textchars[rnd(seed)%(sizeof(textchars)-1)];
+  return len;
+}
+
+int main(int argc,char* argv[])
+{
+  unsigned seed=1;
+  long runs=100000;
+  int files=0;
+  for(int i=1;i<argc;i++)
+  {
+    if(!strcmp(argv[i],"-seed") && i+1<argc)seed=atoi(argv[++i]);
+    else if(!strcmp(argv[i],"-runs") && i+1<argc)runs=atol(argv[++i]);
+    else
+    {
+      FILE* f=fopen(argv[i],"rb");
+      if(!f)
+      {
+        printf("refuzz: can't open %s\n",argv[i]);
+        return 1;
+      }
+      static unsigned char buf[4097];
+      size_t size=fread(buf,1,sizeof(buf),f);
+      fclose(f);
+      LLVMFuzzerTestOneInput(buf,size);
+      files++;
+    }
+  }
+  if(files)
+  {
+    printf("refuzz: %d files replayed\n",files);
+    return 0;
+  }
+  unsigned char buf[1024];
+  for(long i=0;i<runs;i++)
+  {
+    int len=Generate(seed,buf);
+    LLVMFuzzerTestOneInput(buf,len);
+  }
+  printf("refuzz: %ld random inputs\n",runs);
+  return 0;
+}
+
+#endif
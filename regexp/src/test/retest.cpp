@@ -0,0 +1,281 @@
+/*
+  Copyright (C) 2000 Konstantin Stupnik
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+  Unit tests of the regular expressions library.
+  Every case is compiled, run with Match or Search, and the brackets
+  positions are compared with the expected ones.
+*/
+
+#include "RegExp.hpp"
+#include <stdio.h>
+#include <string.h>
+
+using namespace XClasses;
+
+struct TestCase{
+  const char* expr;
+  const char* text;
+  char mode;            // 'm' - Match, 's' - Search
+  int result;
+  const char* brackets; // "start,end" of each bracket, space separated
+};
+
+static TestCase cases[]={
+  {"/abc/","xabcx",'s',1,"1,4"},
+  {"/abc/","xabcx",'m',0,""},
+  {"/abc/","abcx",'m',1,"0,3"},
+  {"/^abc$/","abc",'s',1,"0,3"},
+  {"/^abc$/","abcd",'s',0,""},
+  {"/a.c/","a\nc",'s',0,""},
+  {"/a.c/s","a\nc",'s',1,"0,3"},
+  {"/a*b/","aaab",'m',1,"0,4"},
+  {"/a+b/","b",'s',0,""},
+  {"/a?b/","ab",'m',1,"0,2"},
+  {"/a{2,3}/","aaaa",'m',1,"0,3"},
+  {"/a{2,}/","aaaaa",'m',1,"0,5"},
+  {"/a{3}/","aa",'s',0,""},
+  {"/a*?b/","aaab",'m',1,"0,4"},
+  {"/a+?/","aaa",'m',1,"0,1"},
+  {"/(ab){1,3}?/","ababab",'m',1,"0,2 0,2"},
+  {"/(a|ab)(c|bcd)(d*)/","abcd",'m',1,"0,4 0,1 1,4 4,4"},
+  {"/(foo|foobar)(bar)?/","foobar",'m',1,"0,6 0,3 3,6"},
+  {"/[a-c]+/","xxabcaz",'s',1,"2,6"},
+  {"/[^a-c]+/","abcxyz",'s',1,"3,6"},
+  {"/[[:x]/","[",'s',1,"0,1"},
+  {"/\\d+/","ab123cd",'s',1,"2,5"},
+  {"/\\D+/","12ab34",'s',1,"2,4"},
+  {"/\\w+/","  foo_1 ",'s',1,"2,7"},
+  {"/\\W+/","ab, cd",'s',1,"2,4"},
+  {"/\\s+/","a \t b",'s',1,"1,4"},
+  {"/\\S+/","  xy  ",'s',1,"2,4"},
+  {"/\\bfoo\\b/","a foo b",'s',1,"2,5"},
+  {"/\\bfoo\\b/","afoob",'s',0,""},
+  {"/\\Bo/","foo",'s',1,"1,2"},
+  {"/ABC/i","xabcx",'s',1,"1,4"},
+  {"/[a-c]+/i","XABCX",'s',1,"1,4"},
+  {"/^b/m","a\nb",'s',1,"2,3"},
+  // in multiline mode $ takes the line break into the match
+  {"/a$/m","a\nb",'s',1,"0,2"},
+  {"/^b/","a\nb",'s',0,""},
+  {"/(\\d+)\\.(\\d*)/","v 12.5",'s',1,"2,6 2,4 5,6"},
+  {"/(.*):(\\d+):(.*)/","file.c:12: error",'m',1,"0,16 0,6 7,9 10,16"},
+  {"/^(.*?)\\((\\d+)\\)/","x.cpp(42) : error",'m',1,"0,9 0,5 6,8"},
+  {"/(a)|(b)/","b",'m',1,"0,1 -1,-1 0,1"},
+  {"/((a)|(b))+/","ab",'m',1,"0,2 1,2 0,1 1,2"},
+  {"/(?:ab|a)(?:bc|c)/","abc",'m',1,"0,3"},
+  {"/x(y|z)*?w/","xyzyw",'m',1,"0,5 3,4"},
+  {"/a(?=b)/","ab",'s',1,"0,1"},
+  {"/a(?!b)/","abac",'s',1,"2,3"},
+  {"/(a)\\1/","aa",'m',1,"0,2 0,1"},
+  {"/(a+)b\\1/","aabaa",'m',1,"0,5 0,2"},
+  {"/a|b|cd|c/","cd",'m',1,"0,2"},
+  {"/e\\.g\\./","see e.g. this",'s',1,"4,8"},
+  {"/\\x41/","A",'m',1,"0,1"},
+  {"/a\\tb/","a\tb",'m',1,"0,3"},
+  {"/^$/","",'m',1,"0,0"},
+  {"/x?y?z?/","",'m',1,"0,0"},
+  {"/a b c/x","abc",'m',1,"0,3"},
+  {"/(a*)*b/","aaab",'m',1,"0,4 3,3"},
+  {"/(a*)+b/","aab",'s',1,"0,3 2,2"},
+  {"/[\\w.]+@\\w+/","mail me@host now",'s',1,"5,12"},
+  {"/^\\s*(\\S+)\\s+(\\S+)/","  gcc -c",'m',1,"0,8 2,5 6,8"},
+};
+
+struct ErrorCase{
+  const char* expr;
+  int error;
+};
+
+static ErrorCase errors[]={
+  {"abc",errSyntax},
+  {"/abc",errSyntax},
+  {"/(abc/",errBrackets},
+  {"/abc)/",errBrackets},
+  {"/[abc/",errBrackets},
+  {"/(a)\\2/",errInvalidBackRef},
+  {"/a{3,2}/",errInvalidRange},
+  {"/(?<=a+)b/",errVariableLengthLookBehind},
+};
+
+static int failed;
+
+static void Fail(const char* what,const char* expr,const char* text,const char* got,const char* expected)
+{
+  printf("FAIL %s %s on \"%s\": got \"%s\", expected \"%s\"\n",what,expr,text,got,expected);
+  failed++;
+}
+
+static void FormatBrackets(char* buf,PMatch m,int n)
+{
+  *buf=0;
+  for(int i=0;i<n;i++)
+  {
+    int s=m[i].start,e=m[i].end;
+    if(s<0 || e<0 || s>e)s=e=-1;
+    buf+=sprintf(buf,i?" %d,%d":"%d,%d",s,e);
+  }
+}
+
+static void RunCases()
+{
+  for(unsigned i=0;i<sizeof(cases)/sizeof(cases[0]);i++)
+  {
+    TestCase& c=cases[i];
+    RegExp re(c.expr);
+    if(re.LastError())
+    {
+      char buf[32];
+      sprintf(buf,"error %d",re.LastError());
+      Fail("compile",c.expr,c.text,buf,"");
+      continue;
+    }
+    SMatch m[16];
+    int n=16;
+    int res=c.mode=='m'?re.Match(c.text,m,n):re.Search(c.text,m,n);
+    char got[256];
+    if(res)FormatBrackets(got,m,n);
+    else *got=0;
+    if(res!=c.result || strcmp(got,c.brackets))
+      Fail(c.mode=='m'?"match":"search",c.expr,c.text,got,c.brackets);
+  }
+}
+
+static void RunErrors()
+{
+  for(unsigned i=0;i<sizeof(errors)/sizeof(errors[0]);i++)
+  {
+    RegExp re(errors[i].expr);
+    if(re.LastError()!=errors[i].error)
+    {
+      char got[32],exp[32];
+      sprintf(got,"error %d",re.LastError());
+      sprintf(exp,"error %d",errors[i].error);
+      Fail("compile",errors[i].expr,"",got,exp);
+    }
+  }
+}
+
+// SearchEx from the end of the previous match, like perl's /g
+static void RunGlobal()
+{
+  RegExp re("/\\d+/");
+  const char* text="a1 b22 c333 d";
+  const char* end=text+strlen(text);
+  const char* pos=text;
+  char got[64]="";
+  SMatch m[1];
+  int n=1;
+  while(re.SearchEx(text,pos,end,m,n))
+  {
+    sprintf(got+strlen(got),"%s%d,%d",*got?" ":"",m[0].start,m[0].end);
+    pos=text+m[0].end;
+    n=1;
+  }
+  if(strcmp(got,"1,2 4,6 8,11"))Fail("searchex","/\\d+/",text,got,"1,2 4,6 8,11");
+}
+
+static void RunSet()
+{
+  RegExp a("/error/"),b("/warning/"),c("/\\d+/"),d("/err/");
+  RegExpSet set;
+  set.Add(&a);
+  set.Add(&b);
+  set.Add(&c);
+  set.Add(&d);
+  SMatch m[4];
+  int n=4;
+  // leftmost match wins, on the same position the first added one
+  int idx=set.Search("x.c:10: error: y",m,n);
+  if(idx!=2 || m[0].start!=4 || m[0].end!=6)Fail("set search","4 expressions","x.c:10: error: y","","2 at 4,6");
+  n=4;
+  idx=set.Search("see error",m,n);
+  if(idx!=0 || m[0].start!=4)Fail("set search","4 expressions","see error","","0 at 4");
+  n=4;
+  idx=set.Search("nothing here",m,n);
+  if(idx!=-1)Fail("set search","4 expressions","nothing here","","-1");
+  // Match reports every matching expression through from
+  char got[32]="";
+  for(idx=0;;idx++)
+  {
+    n=4;
+    idx=set.Match("error 1",m,n,idx);
+    if(idx<0)break;
+    sprintf(got+strlen(got),"%s%d",*got?" ":"",idx);
+  }
+  if(strcmp(got,"0 3"))Fail("set match","4 expressions","error 1",got,"0 3");
+
+  // empty slots keep indices of the following expressions
+  RegExp none,bad("/(error/");
+  RegExpSet holes;
+  holes.Add(NULL);
+  holes.Add(&none);
+  holes.Add(&bad);
+  holes.Add(&a);
+  n=4;
+  idx=holes.Search("see error",m,n);
+  if(idx!=3 || m[0].start!=4)Fail("set search","NULL, empty, invalid, error","see error","","3 at 4");
+  n=4;
+  idx=holes.Match("error",m,n);
+  if(idx!=3)Fail("set match","NULL, empty, invalid, error","error","","3");
+}
+
+#ifdef RELIB
+// named brackets and expressions calling each other by name
+static void RunLib()
+{
+  SMatch m[4];
+  int n=4;
+  MatchHash h;
+  RegExp nb("/(?{key}\\w+)=(?{val}\\w+)/");
+  if(!nb.Search("a key=val",m,n,&h) || h["key"].start!=2 || h["key"].end!=5 || h["val"].start!=6 || h["val"].end!=9)
+    Fail("named brackets","(?{key}\\w+)=(?{val}\\w+)","a key=val","","key 2,5 val 6,9");
+
+  RELib lib;
+  RegExp num("/\\d+/"),ip("/%num%\\.%num%\\.%num%\\.%num%/");
+  lib.SetItem("num",&num);
+  lib.SetItem("ip",&ip);
+  num.SetRELib(&lib);
+  ip.SetRELib(&lib);
+  MatchList ml;
+  if(!RELibMatch(lib,ml,"ip","10.0.12.255 rest") || ml.First().Get().start!=0 || ml.First().Get().end!=11)
+    Fail("relib","%num%\\.%num%\\.%num%\\.%num%","10.0.12.255 rest","","0,11");
+  MatchList ml2;
+  if(RELibMatch(lib,ml2,"ip","10.0.x.1"))
+    Fail("relib","%num%\\.%num%\\.%num%\\.%num%","10.0.x.1","match","no match");
+  // space is plain symbol, not start of library call
+  RegExp line("/line %num%/");
+  line.SetRELib(&lib);
+  lib.SetItem("line",&line);
+  MatchList ml3;
+  if(!RELibMatch(lib,ml3,"line","line 12 x") || ml3.First().Get().start!=0 || ml3.First().Get().end!=7)
+    Fail("relib","line %num%","line 12 x","","0,7");
+}
+#endif
+
+int main()
+{
+  RegExp::InitLocale();
+  RunCases();
+  RunErrors();
+  RunGlobal();
+  RunSet();
+#ifdef RELIB
+  RunLib();
+#endif
+  printf("retest: %d failed\n",failed);
+  return failed?1:0;
+}
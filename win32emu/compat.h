@@ -0,0 +1,37 @@
+/*
+  Copyright (C) 2000 Konstantin Stupnik
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+  Names of Microsoft C runtime used by the sources,
+  forced into every test translation unit.
+*/
+
+#ifndef __TEST_COMPAT_H__
+#define __TEST_COMPAT_H__
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <ctype.h>
+
+#define stricmp strcasecmp
+#define strnicmp strncasecmp
+#define memicmp(a,b,n) strncasecmp((const char*)(a),(const char*)(b),n)
+#define _snprintf snprintf
+#define _vsnprintf vsnprintf
+
+#endif
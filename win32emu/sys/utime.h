@@ -0,0 +1,2 @@
+/* sys/utime.h of Microsoft C runtime */
+#include <utime.h>
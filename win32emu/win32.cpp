@@ -0,0 +1,1106 @@
+/*
+  Copyright (C) 2000 Konstantin Stupnik
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+  POSIX implementation of windows.h of the host tests.
+*/
+
+#include "windows.h"
+#include "wincon.h"
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <fnmatch.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <strings.h>
+#include <sys/mman.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+#include <deque>
+#include <map>
+#include <string>
+
+enum HandleKind{hkFile,hkMapping,hkThread,hkProcess,hkEvent,hkSemaphore,hkMutex,hkFind};
+
+/*
+  Threads, events, semaphores and mutexes are waited for under one
+  lock, any change of their state wakes all waiting threads.
+  Thread handle is released by both CloseHandle and the thread itself.
+*/
+struct Handle{
+  int kind;
+  int fd;
+  pthread_t thread;
+  int refs;
+  LONG count;
+  LONG maxcount;
+  BOOL manual;
+  pthread_t owner;
+  char* name;
+  DIR* dir;
+};
+
+//mapped views, UnmapViewOfFile gets address only
+struct View{
+  void* addr;
+  size_t len;
+  View* next;
+};
+
+static View* views;
+static pthread_mutex_t viewsLock=PTHREAD_MUTEX_INITIALIZER;
+static __thread DWORD lastError;
+static pthread_mutex_t waitLock=PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t waitCond=PTHREAD_COND_INITIALIZER;
+
+static HANDLE NewHandle(int kind,int fd)
+{
+  Handle* h=new Handle;
+  memset(h,0,sizeof(*h));
+  h->kind=kind;
+  h->fd=fd;
+  h->refs=1;
+  return h;
+}
+
+static void ReleaseHandle(Handle* h)
+{
+  pthread_mutex_lock(&waitLock);
+  int refs=--h->refs;
+  pthread_mutex_unlock(&waitLock);
+  if(refs)return;
+  free(h->name);
+  delete h;
+}
+
+static void SetError(int err)
+{
+  switch(err)
+  {
+    case ENOENT:lastError=ERROR_FILE_NOT_FOUND;break;
+    case ENOTDIR:lastError=ERROR_PATH_NOT_FOUND;break;
+    case EACCES:case EPERM:lastError=ERROR_ACCESS_DENIED;break;
+    case EEXIST:lastError=ERROR_FILE_EXISTS;break;
+    default:lastError=err;
+  }
+}
+
+//sources build paths with backslashes
+static const char* HostPath(const char* name,char* buf)
+{
+  size_t i;
+  for(i=0;name[i] && i<MAX_PATH*2-1;i++)buf[i]=name[i]=='\\'?'/':name[i];
+  buf[i]=0;
+  return buf;
+}
+
+HANDLE CreateFile(const char* name,DWORD access,DWORD share,LPSECURITY_ATTRIBUTES sa,
+                  DWORD disposition,DWORD flags,HANDLE tmpl)
+{
+  char path[MAX_PATH*2];
+  int mode=access&GENERIC_WRITE?O_RDWR:O_RDONLY;
+  if(disposition==CREATE_NEW)mode|=O_CREAT|O_EXCL;
+  if(disposition==CREATE_ALWAYS)mode|=O_CREAT|O_TRUNC;
+  if(disposition==OPEN_ALWAYS)mode|=O_CREAT;
+  int fd=open(HostPath(name,path),mode,0644);
+  if(fd==-1)
+  {
+    SetError(errno);
+    return INVALID_HANDLE_VALUE;
+  }
+  Handle* h=(Handle*)NewHandle(hkFile,fd);
+  if(flags&FILE_FLAG_DELETE_ON_CLOSE)h->name=strdup(path);
+  return h;
+}
+
+static int Fd(HANDLE h)
+{
+  return ((Handle*)h)->fd;
+}
+
+BOOL ReadFile(HANDLE file,LPVOID buf,DWORD size,LPDWORD rd,LPOVERLAPPED ov)
+{
+  ssize_t n=read(Fd(file),buf,size);
+  if(n==-1)
+  {
+    SetError(errno);
+    *rd=0;
+    return FALSE;
+  }
+  *rd=(DWORD)n;
+  return TRUE;
+}
+
+BOOL WriteFile(HANDLE file,LPCVOID buf,DWORD size,LPDWORD wr,LPOVERLAPPED ov)
+{
+  ssize_t n=write(Fd(file),buf,size);
+  if(n==-1)
+  {
+    SetError(errno);
+    *wr=0;
+    return FALSE;
+  }
+  *wr=(DWORD)n;
+  return TRUE;
+}
+
+DWORD SetFilePointer(HANDLE file,LONG low,PLONG high,DWORD method)
+{
+  off_t off=high?((off_t)*high<<32)|(DWORD)low:low;
+  int whence=method==FILE_BEGIN?SEEK_SET:method==FILE_CURRENT?SEEK_CUR:SEEK_END;
+  off_t pos=lseek(Fd(file),off,whence);
+  if(pos==(off_t)-1)
+  {
+    SetError(errno);
+    return INVALID_SET_FILE_POINTER;
+  }
+  if(high)*high=(LONG)(pos>>32);
+  return (DWORD)pos;
+}
+
+DWORD GetFileSize(HANDLE file,LPDWORD high)
+{
+  struct stat st;
+  if(fstat(Fd(file),&st)==-1)
+  {
+    SetError(errno);
+    return INVALID_FILE_SIZE;
+  }
+  lastError=NO_ERROR;
+  unsigned long long size=st.st_size;
+  if(high)*high=(DWORD)(size>>32);
+  return (DWORD)size;
+}
+
+//in 100 ns intervals, as FILETIME has it
+BOOL GetFileTime(HANDLE file,FILETIME* created,FILETIME* accessed,FILETIME* written)
+{
+  struct stat st;
+  if(fstat(Fd(file),&st)==-1)
+  {
+    SetError(errno);
+    return FALSE;
+  }
+  unsigned long long t=(unsigned long long)st.st_mtim.tv_sec*10000000+st.st_mtim.tv_nsec/100;
+  FILETIME ft;
+  ft.dwLowDateTime=(DWORD)(t&0xffffffff);
+  ft.dwHighDateTime=(DWORD)(t>>32);
+  if(created)*created=ft;
+  if(accessed)*accessed=ft;
+  if(written)*written=ft;
+  return TRUE;
+}
+
+LONG CompareFileTime(const FILETIME* a,const FILETIME* b)
+{
+  if(a->dwHighDateTime!=b->dwHighDateTime)return a->dwHighDateTime<b->dwHighDateTime?-1:1;
+  if(a->dwLowDateTime!=b->dwLowDateTime)return a->dwLowDateTime<b->dwLowDateTime?-1:1;
+  return 0;
+}
+
+HANDLE CreateFileMapping(HANDLE file,LPSECURITY_ATTRIBUTES sa,DWORD protect,
+                         DWORD sizehigh,DWORD sizelow,const char* name)
+{
+  int fd=dup(((Handle*)file)->fd);
+  if(fd==-1)return NULL;
+  return NewHandle(hkMapping,fd);
+}
+
+LPVOID MapViewOfFile(HANDLE map,DWORD access,DWORD offhigh,DWORD offlow,SIZE_T size)
+{
+  int fd=((Handle*)map)->fd;
+  off_t off=((off_t)offhigh<<32)|offlow;
+  if(size==0)
+  {
+    struct stat st;
+    if(fstat(fd,&st)==-1)return NULL;
+    size=st.st_size-off;
+  }
+  void* p=mmap(NULL,size,PROT_READ,MAP_SHARED,fd,off);
+  if(p==MAP_FAILED)
+  {
+    SetError(errno);
+    return NULL;
+  }
+  View* v=new View;
+  v->addr=p;
+  v->len=size;
+  pthread_mutex_lock(&viewsLock);
+  v->next=views;
+  views=v;
+  pthread_mutex_unlock(&viewsLock);
+  return p;
+}
+
+BOOL UnmapViewOfFile(LPCVOID addr)
+{
+  pthread_mutex_lock(&viewsLock);
+  View** v=&views;
+  while(*v && (*v)->addr!=addr)v=&(*v)->next;
+  View* found=*v;
+  if(found)*v=found->next;
+  pthread_mutex_unlock(&viewsLock);
+  if(!found)return FALSE;
+  munmap(found->addr,found->len);
+  delete found;
+  return TRUE;
+}
+
+BOOL DeleteFile(const char* name)
+{
+  char path[MAX_PATH*2];
+  if(unlink(HostPath(name,path))==0)return TRUE;
+  SetError(errno);
+  return FALSE;
+}
+
+BOOL FlushFileBuffers(HANDLE file)
+{
+  if(fsync(Fd(file))==0)return TRUE;
+  SetError(errno);
+  return FALSE;
+}
+
+BOOL SetEndOfFile(HANDLE file)
+{
+  off_t pos=lseek(Fd(file),0,SEEK_CUR);
+  if(pos!=(off_t)-1 && ftruncate(Fd(file),pos)==0)return TRUE;
+  SetError(errno);
+  return FALSE;
+}
+
+BOOL MoveFileEx(const char* from,const char* to,DWORD flags)
+{
+  char src[MAX_PATH*2],dst[MAX_PATH*2];
+  HostPath(from,src);
+  HostPath(to,dst);
+  if(!(flags&MOVEFILE_REPLACE_EXISTING))
+  {
+    //link fails if destination exists, as MoveFile does
+    if(link(src,dst)==0 && unlink(src)==0)return TRUE;
+  }
+  else if(rename(src,dst)==0)return TRUE;
+  SetError(errno);
+  return FALSE;
+}
+
+BOOL MoveFile(const char* from,const char* to)
+{
+  return MoveFileEx(from,to,0);
+}
+
+BOOL CreateDirectory(const char* name,LPSECURITY_ATTRIBUTES sa)
+{
+  char path[MAX_PATH*2];
+  if(mkdir(HostPath(name,path),0755)==0)return TRUE;
+  SetError(errno);
+  if(errno==EEXIST)lastError=ERROR_ALREADY_EXISTS;
+  return FALSE;
+}
+
+BOOL RemoveDirectory(const char* name)
+{
+  char path[MAX_PATH*2];
+  if(rmdir(HostPath(name,path))==0)return TRUE;
+  SetError(errno);
+  return FALSE;
+}
+
+DWORD GetTempPath(DWORD size,char* buf)
+{
+  const char* tmp=getenv("TMPDIR");
+  if(!tmp || !*tmp)tmp="/tmp";
+  DWORD len=strlen(tmp)+1;
+  if(len>=size)return len+1;
+  strcpy(buf,tmp);
+  strcat(buf,"/");
+  return len;
+}
+
+DWORD GetTempFileName(const char* path,const char* prefix,DWORD unique,char* name)
+{
+  static LONG counter;
+  size_t len=strlen(path);
+  const char* sep=len && (path[len-1]=='/' || path[len-1]=='\\')?"":"/";
+  for(int i=0;i<65535;i++)
+  {
+    DWORD n=unique?unique:(getpid()+__sync_add_and_fetch(&counter,1))&0xFFFF;
+    if(!n)continue;
+    snprintf(name,MAX_PATH,"%s%s%.3s%04X.tmp",path,sep,prefix,n);
+    if(unique)return n;
+    char host[MAX_PATH*2];
+    int fd=open(HostPath(name,host),O_CREAT|O_EXCL|O_WRONLY,0644);
+    if(fd!=-1)
+    {
+      close(fd);
+      return n;
+    }
+    if(errno!=EEXIST)break;
+  }
+  SetError(errno);
+  return 0;
+}
+
+static void FillFindData(Handle* h,const char* file,WIN32_FIND_DATA* fd)
+{
+  char path[MAX_PATH*2];
+  snprintf(path,sizeof(path),"%s/%s",h->name,file);
+  memset(fd,0,sizeof(*fd));
+  struct stat st;
+  if(stat(path,&st)==0)
+  {
+    fd->dwFileAttributes=S_ISDIR(st.st_mode)?FILE_ATTRIBUTE_DIRECTORY:FILE_ATTRIBUTE_ARCHIVE;
+    unsigned long long t=(unsigned long long)st.st_mtim.tv_sec*10000000+st.st_mtim.tv_nsec/100;
+    fd->ftLastWriteTime.dwLowDateTime=(DWORD)(t&0xffffffff);
+    fd->ftLastWriteTime.dwHighDateTime=(DWORD)(t>>32);
+    fd->ftCreationTime=fd->ftLastAccessTime=fd->ftLastWriteTime;
+    fd->nFileSizeLow=(DWORD)st.st_size;
+    fd->nFileSizeHigh=(DWORD)((unsigned long long)st.st_size>>32);
+  }
+  strncpy(fd->cFileName,file,MAX_PATH-1);
+}
+
+//name of directory is kept in name, mask after it
+BOOL FindNextFile(HANDLE find,WIN32_FIND_DATA* fd)
+{
+  Handle* h=(Handle*)find;
+  const char* mask=h->name+strlen(h->name)+1;
+  while(dirent* de=readdir(h->dir))
+  {
+    if(fnmatch(mask,de->d_name,FNM_CASEFOLD)==0)
+    {
+      FillFindData(h,de->d_name,fd);
+      return TRUE;
+    }
+  }
+  lastError=ERROR_NO_MORE_FILES;
+  return FALSE;
+}
+
+HANDLE FindFirstFile(const char* mask,WIN32_FIND_DATA* fd)
+{
+  char path[MAX_PATH*2];
+  HostPath(mask,path);
+  char* file=strrchr(path,'/');
+  const char* dir=".";
+  if(file)
+  {
+    *file++=0;
+    dir=*path?path:"/";
+  }
+  else file=path;
+  DIR* d=opendir(dir);
+  if(!d)
+  {
+    SetError(errno);
+    return INVALID_HANDLE_VALUE;
+  }
+  Handle* h=(Handle*)NewHandle(hkFind,-1);
+  size_t dirlen=strlen(dir);
+  h->name=(char*)malloc(dirlen+strlen(file)+2);
+  strcpy(h->name,dir);
+  strcpy(h->name+dirlen+1,strcmp(file,"*.*")?file:"*");
+  h->dir=d;
+  if(FindNextFile(h,fd))return h;
+  FindClose(h);
+  lastError=ERROR_FILE_NOT_FOUND;
+  return INVALID_HANDLE_VALUE;
+}
+
+BOOL FindClose(HANDLE find)
+{
+  Handle* h=(Handle*)find;
+  closedir(h->dir);
+  ReleaseHandle(h);
+  return TRUE;
+}
+
+BOOL CloseHandle(HANDLE h)
+{
+  Handle* hh=(Handle*)h;
+  if(!hh || h==INVALID_HANDLE_VALUE)return FALSE;
+  if(hh->kind==hkFile || hh->kind==hkMapping)
+  {
+    close(hh->fd);
+    if(hh->name)unlink(hh->name);
+  }
+  ReleaseHandle(hh);
+  return TRUE;
+}
+
+DWORD GetLastError()
+{
+  return lastError;
+}
+
+struct ThreadStart{
+  LPTHREAD_START_ROUTINE proc;
+  LPVOID param;
+  Handle* handle;
+};
+
+static void* ThreadProc(void* p)
+{
+  ThreadStart ts=*(ThreadStart*)p;
+  delete (ThreadStart*)p;
+  ts.proc(ts.param);
+  pthread_mutex_lock(&waitLock);
+  ts.handle->count=1;
+  pthread_cond_broadcast(&waitCond);
+  pthread_mutex_unlock(&waitLock);
+  ReleaseHandle(ts.handle);
+  return NULL;
+}
+
+HANDLE CreateThread(LPSECURITY_ATTRIBUTES sa,SIZE_T stack,LPTHREAD_START_ROUTINE proc,
+                    LPVOID param,DWORD flags,LPDWORD tid)
+{
+  ThreadStart* ts=new ThreadStart;
+  ts->proc=proc;
+  ts->param=param;
+  Handle* h=(Handle*)NewHandle(hkThread,-1);
+  h->refs=2;
+  h->manual=TRUE;
+  ts->handle=h;
+  if(pthread_create(&h->thread,NULL,ThreadProc,ts)!=0)
+  {
+    delete ts;
+    delete h;
+    return NULL;
+  }
+  pthread_detach(h->thread);
+  return h;
+}
+
+//called under waitLock
+static BOOL Signaled(Handle* h)
+{
+  if(h->kind==hkProcess)return TRUE;
+  if(h->kind==hkMutex)return h->count==0 || pthread_equal(h->owner,pthread_self());
+  return h->count>0;
+}
+
+static void Acquire(Handle* h)
+{
+  if(h->kind==hkMutex)
+  {
+    h->owner=pthread_self();
+    h->count++;
+  }
+  else if(!h->manual)h->count--;
+}
+
+DWORD WaitForMultipleObjects(DWORD count,const HANDLE* h,BOOL all,DWORD timeout)
+{
+  timespec until;
+  clock_gettime(CLOCK_REALTIME,&until);
+  until.tv_sec+=timeout/1000;
+  until.tv_nsec+=(timeout%1000)*1000000;
+  if(until.tv_nsec>=1000000000)
+  {
+    until.tv_sec++;
+    until.tv_nsec-=1000000000;
+  }
+  DWORD res=WAIT_TIMEOUT;
+  pthread_mutex_lock(&waitLock);
+  for(;;)
+  {
+    DWORD ready=0,first=count;
+    for(DWORD i=0;i<count;i++)
+    {
+      if(Signaled((Handle*)h[i]))
+      {
+        ready++;
+        if(first==count)first=i;
+      }
+    }
+    if(all?ready==count:ready>0)
+    {
+      if(all)for(DWORD i=0;i<count;i++)Acquire((Handle*)h[i]);
+      else Acquire((Handle*)h[first]);
+      res=WAIT_OBJECT_0+(all?0:first);
+      break;
+    }
+    if(timeout==INFINITE)pthread_cond_wait(&waitCond,&waitLock);
+    else if(pthread_cond_timedwait(&waitCond,&waitLock,&until)==ETIMEDOUT)break;
+  }
+  pthread_mutex_unlock(&waitLock);
+  return res;
+}
+
+DWORD WaitForSingleObject(HANDLE h,DWORD timeout)
+{
+  return WaitForMultipleObjects(1,&h,FALSE,timeout);
+}
+
+static HANDLE NewWaitable(int kind,LONG count,LONG maxcount,BOOL manual)
+{
+  Handle* h=(Handle*)NewHandle(kind,-1);
+  h->count=count;
+  h->maxcount=maxcount;
+  h->manual=manual;
+  return h;
+}
+
+static BOOL SetCount(HANDLE h,LONG count,LONG add,PLONG prev)
+{
+  Handle* hh=(Handle*)h;
+  BOOL res=TRUE;
+  pthread_mutex_lock(&waitLock);
+  if(prev)*prev=hh->count;
+  if(hh->kind==hkMutex && (!hh->count || !pthread_equal(hh->owner,pthread_self())))res=FALSE;
+  else if(add && hh->count+add>hh->maxcount)res=FALSE;
+  else hh->count=add?hh->count+add:count;
+  if(res)pthread_cond_broadcast(&waitCond);
+  pthread_mutex_unlock(&waitLock);
+  return res;
+}
+
+HANDLE CreateEvent(LPSECURITY_ATTRIBUTES sa,BOOL manual,BOOL state,const char* name)
+{
+  return NewWaitable(hkEvent,state?1:0,1,manual);
+}
+
+BOOL SetEvent(HANDLE event)
+{
+  return SetCount(event,1,0,NULL);
+}
+
+BOOL ResetEvent(HANDLE event)
+{
+  return SetCount(event,0,0,NULL);
+}
+
+HANDLE CreateSemaphore(LPSECURITY_ATTRIBUTES sa,LONG count,LONG maxcount,const char* name)
+{
+  return NewWaitable(hkSemaphore,count,maxcount,FALSE);
+}
+
+BOOL ReleaseSemaphore(HANDLE sem,LONG count,PLONG prev)
+{
+  return SetCount(sem,0,count,prev);
+}
+
+HANDLE CreateMutex(LPSECURITY_ATTRIBUTES sa,BOOL owned,const char* name)
+{
+  Handle* h=(Handle*)NewWaitable(hkMutex,owned?1:0,0x7fffffff,FALSE);
+  h->owner=pthread_self();
+  return h;
+}
+
+BOOL ReleaseMutex(HANDLE mutex)
+{
+  return SetCount(mutex,0,-1,NULL);
+}
+
+void InitializeCriticalSection(CRITICAL_SECTION* cs)
+{
+  pthread_mutexattr_t attr;
+  pthread_mutexattr_init(&attr);
+  pthread_mutexattr_settype(&attr,PTHREAD_MUTEX_RECURSIVE);
+  pthread_mutex_init(cs,&attr);
+  pthread_mutexattr_destroy(&attr);
+}
+
+void DeleteCriticalSection(CRITICAL_SECTION* cs)
+{
+  pthread_mutex_destroy(cs);
+}
+
+void EnterCriticalSection(CRITICAL_SECTION* cs)
+{
+  pthread_mutex_lock(cs);
+}
+
+void LeaveCriticalSection(CRITICAL_SECTION* cs)
+{
+  pthread_mutex_unlock(cs);
+}
+
+LONG InterlockedIncrement(LONG volatile* val)
+{
+  return __sync_add_and_fetch(val,1);
+}
+
+LONG InterlockedDecrement(LONG volatile* val)
+{
+  return __sync_sub_and_fetch(val,1);
+}
+
+LONG InterlockedExchange(LONG volatile* dst,LONG val)
+{
+  return __sync_lock_test_and_set(dst,val);
+}
+
+LONG InterlockedCompareExchange(LONG volatile* dst,LONG val,LONG cmp)
+{
+  return __sync_val_compare_and_swap(dst,cmp,val);
+}
+
+void GetSystemInfo(SYSTEM_INFO* si)
+{
+  long n=sysconf(_SC_NPROCESSORS_ONLN);
+  si->dwNumberOfProcessors=n>0?n:1;
+  si->dwAllocationGranularity=65536;
+}
+
+void GetStartupInfo(STARTUPINFO* si)
+{
+  memset(si,0,sizeof(*si));
+  si->cb=sizeof(*si);
+}
+
+/*
+  Command runs to completion, there is no process to wait for,
+  unless its output is redirected: then it runs along with caller,
+  which reads the output. Command is started by intermediate process,
+  so it is not left as zombie when handles are closed, and handles
+  can't be waited for.
+*/
+BOOL CreateProcess(const char* app,char* cmd,LPSECURITY_ATTRIBUTES psa,LPSECURITY_ATTRIBUTES tsa,
+                   BOOL inherit,DWORD flags,LPVOID env,const char* dir,
+                   STARTUPINFO* si,PROCESS_INFORMATION* pi)
+{
+  memset(pi,0,sizeof(*pi));
+  if(!(si->dwFlags&STARTF_USESTDHANDLES))return system(cmd)==0;
+  pid_t pid=fork();
+  if(pid==-1)
+  {
+    SetError(errno);
+    return FALSE;
+  }
+  if(pid==0)
+  {
+    if(fork()==0)
+    {
+      dup2(Fd(si->hStdOutput),1);
+      dup2(Fd(si->hStdError),2);
+      for(int fd=3;fd<256;fd++)close(fd);
+      execl("/bin/sh","sh","-c",cmd,(char*)NULL);
+    }
+    _exit(127);
+  }
+  waitpid(pid,NULL,0);
+  pi->hProcess=NewHandle(hkProcess,-1);
+  pi->hThread=NewHandle(hkProcess,-1);
+  return TRUE;
+}
+
+BOOL CreatePipe(HANDLE* rd,HANDLE* wr,LPSECURITY_ATTRIBUTES sa,DWORD size)
+{
+  int fd[2];
+  if(pipe(fd)==-1)
+  {
+    SetError(errno);
+    return FALSE;
+  }
+  *rd=NewHandle(hkFile,fd[0]);
+  *wr=NewHandle(hkFile,fd[1]);
+  return TRUE;
+}
+
+//only number of available bytes is supported
+BOOL PeekNamedPipe(HANDLE pipe,LPVOID buf,DWORD size,LPDWORD rd,LPDWORD avail,LPDWORD left)
+{
+  int n=0;
+  if(ioctl(Fd(pipe),FIONREAD,&n)==-1)
+  {
+    SetError(errno);
+    return FALSE;
+  }
+  if(rd)*rd=0;
+  if(avail)*avail=n;
+  if(left)*left=0;
+  return TRUE;
+}
+
+//standard handles are not closed, they live as long as process
+HANDLE GetStdHandle(DWORD std)
+{
+  static Handle handles[3]={{hkFile,0},{hkFile,1},{hkFile,2}};
+  DWORD n=(DWORD)-10-std;
+  return n<3?&handles[n]:INVALID_HANDLE_VALUE;
+}
+
+//there is no console, modes are not kept
+BOOL GetConsoleMode(HANDLE h,LPDWORD mode)
+{
+  *mode=0;
+  return TRUE;
+}
+
+BOOL SetConsoleMode(HANDLE h,DWORD mode)
+{
+  return TRUE;
+}
+
+//console input is a queue, tests put keys into it by WriteConsoleInput
+static std::deque<INPUT_RECORD> consoleInput;
+static pthread_mutex_t consoleLock=PTHREAD_MUTEX_INITIALIZER;
+
+static BOOL GetConsoleInput(INPUT_RECORD* buf,DWORD len,LPDWORD read,BOOL remove)
+{
+  pthread_mutex_lock(&consoleLock);
+  DWORD n=0;
+  for(;n<len&&n<consoleInput.size();n++)buf[n]=consoleInput[n];
+  if(remove)consoleInput.erase(consoleInput.begin(),consoleInput.begin()+n);
+  pthread_mutex_unlock(&consoleLock);
+  *read=n;
+  return TRUE;
+}
+
+BOOL PeekConsoleInput(HANDLE h,INPUT_RECORD* buf,DWORD len,LPDWORD read)
+{
+  return GetConsoleInput(buf,len,read,FALSE);
+}
+
+BOOL ReadConsoleInput(HANDLE h,INPUT_RECORD* buf,DWORD len,LPDWORD read)
+{
+  return GetConsoleInput(buf,len,read,TRUE);
+}
+
+BOOL WriteConsoleInput(HANDLE h,const INPUT_RECORD* buf,DWORD len,LPDWORD written)
+{
+  pthread_mutex_lock(&consoleLock);
+  consoleInput.insert(consoleInput.end(),buf,buf+len);
+  pthread_mutex_unlock(&consoleLock);
+  *written=len;
+  return TRUE;
+}
+
+static char consoleTitle[1024]="test";
+
+DWORD GetConsoleTitle(char* buf,DWORD size)
+{
+  if(!size)return 0;
+  strncpy(buf,consoleTitle,size-1);
+  buf[size-1]=0;
+  return strlen(buf);
+}
+
+BOOL SetConsoleTitle(const char* title)
+{
+  strncpy(consoleTitle,title,sizeof(consoleTitle)-1);
+  return TRUE;
+}
+
+DWORD GetTickCount()
+{
+  timespec ts;
+  clock_gettime(CLOCK_MONOTONIC,&ts);
+  return (DWORD)(ts.tv_sec*1000+ts.tv_nsec/1000000);
+}
+
+void Sleep(DWORD ms)
+{
+  usleep(ms*1000);
+}
+
+DWORD GetEnvironmentVariable(const char* name,char* buf,DWORD size)
+{
+  const char* val=getenv(name);
+  if(!val)return 0;
+  DWORD len=strlen(val);
+  if(len>=size)return len+1;
+  strcpy(buf,val);
+  return len;
+}
+
+DWORD GetCurrentDirectory(DWORD size,char* buf)
+{
+  if(!getcwd(buf,size))return 0;
+  return strlen(buf);
+}
+
+DWORD GetFileAttributes(const char* name)
+{
+  char path[MAX_PATH*2];
+  struct stat st;
+  if(stat(HostPath(name,path),&st)==-1)
+  {
+    SetError(errno);
+    return 0xFFFFFFFF;
+  }
+  return S_ISDIR(st.st_mode)?FILE_ATTRIBUTE_DIRECTORY:FILE_ATTRIBUTE_NORMAL;
+}
+
+//attributes other than directory are not kept
+BOOL SetFileAttributes(const char* name,DWORD attr)
+{
+  return GetFileAttributes(name)!=0xFFFFFFFF;
+}
+
+static void FillSystemTime(const tm* t,long ms,SYSTEMTIME* st)
+{
+  st->wYear=t->tm_year+1900;
+  st->wMonth=t->tm_mon+1;
+  st->wDayOfWeek=t->tm_wday;
+  st->wDay=t->tm_mday;
+  st->wHour=t->tm_hour;
+  st->wMinute=t->tm_min;
+  st->wSecond=t->tm_sec;
+  st->wMilliseconds=ms;
+}
+
+void GetLocalTime(SYSTEMTIME* st)
+{
+  timespec ts;
+  tm t;
+  clock_gettime(CLOCK_REALTIME,&ts);
+  localtime_r(&ts.tv_sec,&t);
+  FillSystemTime(&t,ts.tv_nsec/1000000,st);
+}
+
+void GetSystemTime(SYSTEMTIME* st)
+{
+  timespec ts;
+  tm t;
+  clock_gettime(CLOCK_REALTIME,&ts);
+  gmtime_r(&ts.tv_sec,&t);
+  FillSystemTime(&t,ts.tv_nsec/1000000,st);
+}
+
+//only the current bias is known, it is given as standard one
+DWORD GetTimeZoneInformation(TIME_ZONE_INFORMATION* tzi)
+{
+  time_t now=time(NULL);
+  tm t;
+  localtime_r(&now,&t);
+  memset(tzi,0,sizeof(*tzi));
+  tzi->Bias=-(LONG)(t.tm_gmtoff/60);
+  return TIME_ZONE_ID_STANDARD;
+}
+
+int lstrlen(const char* s)
+{
+  return s?strlen(s):0;
+}
+
+char* lstrcpy(char* dst,const char* src)
+{
+  return strcpy(dst,src);
+}
+
+char* lstrcpyn(char* dst,const char* src,int size)
+{
+  if(size<=0)return dst;
+  int i;
+  for(i=0;i<size-1 && src[i];i++)dst[i]=src[i];
+  dst[i]=0;
+  return dst;
+}
+
+char* lstrcat(char* dst,const char* src)
+{
+  return strcat(dst,src);
+}
+
+int lstrcmp(const char* a,const char* b)
+{
+  int res=strcmp(a,b);
+  return res<0?-1:res>0;
+}
+
+int lstrcmpi(const char* a,const char* b)
+{
+  int res=strcasecmp(a,b);
+  return res<0?-1:res>0;
+}
+
+/*
+  Registry lives in memory of the process, names of keys and values
+  are case insensitive. Key handle keeps full name of the key,
+  predefined roots are keys with empty names.
+*/
+struct NoCase{
+  bool operator()(const std::string& a,const std::string& b)const
+  {
+    return strcasecmp(a.c_str(),b.c_str())<0;
+  }
+};
+
+struct RegValue{
+  DWORD type;
+  std::string data;
+};
+
+typedef std::map<std::string,RegValue,NoCase> RegValues;
+typedef std::map<std::string,RegValues,NoCase> RegKeys;
+
+static RegKeys registry;
+static pthread_mutex_t registryLock=PTHREAD_MUTEX_INITIALIZER;
+//enumeration goes on from the last value while nothing is added or deleted
+static unsigned registryGen=0,enumGen=(unsigned)-1;
+static std::string enumKey;
+static DWORD enumIndex;
+static RegValues::iterator enumPos;
+
+static std::string KeyName(HKEY root,const char* key)
+{
+  std::string name;
+  if(root!=HKEY_CURRENT_USER)name=*(std::string*)root;
+  if(key && *key)
+  {
+    if(!name.empty())name+='\\';
+    name+=key;
+  }
+  while(!name.empty() && name[name.size()-1]=='\\')name.erase(name.size()-1);
+  return name;
+}
+
+LONG RegCreateKeyEx(HKEY root,const char* key,DWORD reserved,char* cls,DWORD options,
+                    DWORD access,LPSECURITY_ATTRIBUTES sa,HKEY* result,LPDWORD disposition)
+{
+  std::string name=KeyName(root,key);
+  pthread_mutex_lock(&registryLock);
+  BOOL created=registry.find(name)==registry.end();
+  registryGen++;
+  //parents exist as well
+  for(size_t pos=0;(pos=name.find('\\',pos))!=std::string::npos;pos++)registry[name.substr(0,pos)];
+  registry[name];
+  pthread_mutex_unlock(&registryLock);
+  if(disposition)*disposition=created?1:2;
+  *result=(HKEY)new std::string(name);
+  return ERROR_SUCCESS;
+}
+
+LONG RegOpenKeyEx(HKEY root,const char* key,DWORD options,DWORD access,HKEY* result)
+{
+  std::string name=KeyName(root,key);
+  pthread_mutex_lock(&registryLock);
+  BOOL found=registry.find(name)!=registry.end();
+  pthread_mutex_unlock(&registryLock);
+  if(!found)return ERROR_FILE_NOT_FOUND;
+  *result=(HKEY)new std::string(name);
+  return ERROR_SUCCESS;
+}
+
+LONG RegCloseKey(HKEY key)
+{
+  if(!key || key==HKEY_CURRENT_USER)return ERROR_SUCCESS;
+  delete (std::string*)key;
+  return ERROR_SUCCESS;
+}
+
+LONG RegSetValueEx(HKEY key,const char* name,DWORD reserved,DWORD type,const BYTE* data,DWORD size)
+{
+  if(!key)return ERROR_FILE_NOT_FOUND;
+  pthread_mutex_lock(&registryLock);
+  RegValue& v=registry[KeyName(key,NULL)][name?name:""];
+  registryGen++;
+  v.type=type;
+  v.data.assign((const char*)data,size);
+  pthread_mutex_unlock(&registryLock);
+  return ERROR_SUCCESS;
+}
+
+static LONG GetValue(const RegValue& v,LPDWORD type,LPBYTE data,LPDWORD size)
+{
+  if(type)*type=v.type;
+  if(!size)return ERROR_SUCCESS;
+  DWORD len=v.data.size();
+  LONG res=ERROR_SUCCESS;
+  if(data)
+  {
+    if(*size<len)res=234;//ERROR_MORE_DATA
+    else memcpy(data,v.data.data(),len);
+  }
+  *size=len;
+  return res;
+}
+
+LONG RegQueryValueEx(HKEY key,const char* name,LPDWORD reserved,LPDWORD type,LPBYTE data,LPDWORD size)
+{
+  if(!key)return ERROR_FILE_NOT_FOUND;
+  LONG res=ERROR_FILE_NOT_FOUND;
+  pthread_mutex_lock(&registryLock);
+  RegKeys::iterator k=registry.find(KeyName(key,NULL));
+  if(k!=registry.end())
+  {
+    RegValues::iterator v=k->second.find(name?name:"");
+    if(v!=k->second.end())res=GetValue(v->second,type,data,size);
+  }
+  pthread_mutex_unlock(&registryLock);
+  return res;
+}
+
+LONG RegEnumValue(HKEY key,DWORD index,char* name,LPDWORD namesize,LPDWORD reserved,
+                  LPDWORD type,LPBYTE data,LPDWORD size)
+{
+  LONG res=ERROR_NO_MORE_ITEMS;
+  pthread_mutex_lock(&registryLock);
+  RegKeys::iterator k=registry.find(KeyName(key,NULL));
+  if(k!=registry.end() && index<k->second.size())
+  {
+    RegValues::iterator v;
+    if(enumGen==registryGen && index==enumIndex+1 && !strcasecmp(enumKey.c_str(),k->first.c_str()))
+      v=++enumPos;
+    else
+    {
+      v=k->second.begin();
+      for(DWORD i=0;i<index;i++)++v;
+    }
+    enumGen=registryGen;
+    enumKey=k->first;
+    enumIndex=index;
+    enumPos=v;
+    if(v->first.size()>=*namesize)res=234;
+    else
+    {
+      strcpy(name,v->first.c_str());
+      *namesize=v->first.size();
+      res=GetValue(v->second,type,data,size);
+    }
+  }
+  pthread_mutex_unlock(&registryLock);
+  return res;
+}
+
+LONG RegDeleteValue(HKEY key,const char* name)
+{
+  LONG res=ERROR_FILE_NOT_FOUND;
+  pthread_mutex_lock(&registryLock);
+  RegKeys::iterator k=registry.find(KeyName(key,NULL));
+  if(k!=registry.end() && k->second.erase(name?name:""))res=ERROR_SUCCESS;
+  registryGen++;
+  pthread_mutex_unlock(&registryLock);
+  return res;
+}
+
+//subkeys are deleted along with the key
+LONG RegDeleteKey(HKEY key,const char* subkey)
+{
+  std::string name=KeyName(key,subkey);
+  std::string prefix=name+'\\';
+  LONG res=ERROR_FILE_NOT_FOUND;
+  pthread_mutex_lock(&registryLock);
+  registryGen++;
+  for(RegKeys::iterator k=registry.begin();k!=registry.end();)
+  {
+    if(!strcasecmp(k->first.c_str(),name.c_str()) || !strncasecmp(k->first.c_str(),prefix.c_str(),prefix.size()))
+    {
+      registry.erase(k++);
+      res=ERROR_SUCCESS;
+    }
+    else ++k;
+  }
+  pthread_mutex_unlock(&registryLock);
+  return res;
+}
@@ -0,0 +1,56 @@
+/*
+  Copyright (C) 2000 Konstantin Stupnik
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+  Console types of the host tests. There is no console, console
+  input is a queue that tests fill with WriteConsoleInput.
+*/
+
+#ifndef __TEST_WINCON_H__
+#define __TEST_WINCON_H__
+
+#include "windows.h"
+
+#define KEY_EVENT 0x0001
+
+typedef struct _KEY_EVENT_RECORD{
+  BOOL bKeyDown;
+  WORD wRepeatCount;
+  WORD wVirtualKeyCode;
+  WORD wVirtualScanCode;
+  union{
+    CHAR AsciiChar;
+  }uChar;
+  DWORD dwControlKeyState;
+}KEY_EVENT_RECORD;
+
+typedef struct _INPUT_RECORD{
+  WORD EventType;
+  union{
+    KEY_EVENT_RECORD KeyEvent;
+  }Event;
+}INPUT_RECORD;
+
+typedef struct _CHAR_INFO{
+  char AsciiChar;
+  WORD Attributes;
+}CHAR_INFO;
+
+BOOL PeekConsoleInput(HANDLE h,INPUT_RECORD* buf,DWORD len,LPDWORD read);
+BOOL ReadConsoleInput(HANDLE h,INPUT_RECORD* buf,DWORD len,LPDWORD read);
+BOOL WriteConsoleInput(HANDLE h,const INPUT_RECORD* buf,DWORD len,LPDWORD written);
+
+#endif
@@ -0,0 +1,300 @@
+/*
+  Copyright (C) 2000 Konstantin Stupnik
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+  Part of Win32 API used by the plugins, implemented over POSIX,
+  so their engines can be tested and benchmarked on build hosts
+  without Windows. Shared by host tests of all plugins, only what
+  the tested sources call is declared here.
+*/
+
+#ifndef __TEST_WINDOWS_H__
+#define __TEST_WINDOWS_H__
+
+#include <pthread.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define WINAPI
+#define TRUE 1
+#define FALSE 0
+#define INFINITE 0xFFFFFFFF
+#define MAX_PATH 260
+
+typedef int BOOL;
+typedef unsigned char BYTE;
+typedef unsigned short WORD;
+//32 bits, as on Windows: checksums, offsets and index fields depend on it
+typedef unsigned int DWORD;
+typedef int LONG;
+typedef long long LONGLONG;
+typedef DWORD *LPDWORD;
+typedef LONG *PLONG;
+typedef void *LPVOID;
+typedef const void *LPCVOID;
+typedef void *HANDLE;
+typedef void *LPOVERLAPPED;
+typedef uintptr_t SIZE_T;
+
+#define INVALID_HANDLE_VALUE ((HANDLE)(intptr_t)-1)
+#define INVALID_FILE_SIZE 0xFFFFFFFF
+#define INVALID_SET_FILE_POINTER 0xFFFFFFFF
+#define NO_ERROR 0
+#define ERROR_SUCCESS 0
+#define ERROR_FILE_NOT_FOUND 2
+#define ERROR_PATH_NOT_FOUND 3
+#define ERROR_ACCESS_DENIED 5
+#define ERROR_NO_MORE_FILES 18
+#define ERROR_FILE_EXISTS 80
+#define ERROR_ALREADY_EXISTS 183
+#define ERROR_NO_MORE_ITEMS 259
+#define WAIT_OBJECT_0 0
+#define WAIT_TIMEOUT 258
+#define WAIT_FAILED 0xFFFFFFFF
+
+#define GENERIC_READ 0x80000000
+#define GENERIC_WRITE 0x40000000
+#define FILE_SHARE_READ 1
+#define FILE_SHARE_WRITE 2
+#define FILE_SHARE_DELETE 4
+#define CREATE_NEW 1
+#define CREATE_ALWAYS 2
+#define OPEN_EXISTING 3
+#define OPEN_ALWAYS 4
+#define FILE_BEGIN 0
+#define FILE_CURRENT 1
+#define FILE_END 2
+#define FILE_ATTRIBUTE_HIDDEN 0x02
+#define FILE_ATTRIBUTE_DIRECTORY 0x10
+#define FILE_ATTRIBUTE_ARCHIVE 0x20
+#define FILE_ATTRIBUTE_NORMAL 0x80
+#define FILE_ATTRIBUTE_TEMPORARY 0x100
+#define FILE_FLAG_DELETE_ON_CLOSE 0x04000000
+#define FILE_FLAG_SEQUENTIAL_SCAN 0x08000000
+#define MOVEFILE_REPLACE_EXISTING 1
+#define MOVEFILE_WRITE_THROUGH 8
+#define PAGE_READONLY 2
+#define FILE_MAP_READ 4
+#define MAXIMUM_WAIT_OBJECTS 64
+#define STARTF_USESTDHANDLES 0x100
+#define STD_INPUT_HANDLE ((DWORD)-10)
+#define STD_OUTPUT_HANDLE ((DWORD)-11)
+#define STD_ERROR_HANDLE ((DWORD)-12)
+#define VK_ESCAPE 0x1B
+
+typedef struct{
+  DWORD nLength;
+  LPVOID lpSecurityDescriptor;
+  BOOL bInheritHandle;
+}SECURITY_ATTRIBUTES,*LPSECURITY_ATTRIBUTES;
+
+typedef struct{
+  DWORD dwLowDateTime;
+  DWORD dwHighDateTime;
+}FILETIME;
+
+typedef struct{
+  DWORD cb;
+  char* lpReserved;
+  char* lpDesktop;
+  char* lpTitle;
+  DWORD dwFlags;
+  WORD cbReserved2;
+  BYTE* lpReserved2;
+  HANDLE hStdInput;
+  HANDLE hStdOutput;
+  HANDLE hStdError;
+}STARTUPINFO;
+
+typedef struct{
+  HANDLE hProcess;
+  HANDLE hThread;
+  DWORD dwProcessId;
+  DWORD dwThreadId;
+}PROCESS_INFORMATION;
+
+typedef struct{
+  DWORD dwNumberOfProcessors;
+  DWORD dwAllocationGranularity;
+}SYSTEM_INFO;
+
+typedef DWORD (WINAPI *LPTHREAD_START_ROUTINE)(LPVOID);
+
+//types of FAR plugin API, used in declarations only
+#define WINAPIV
+#define __cdecl
+#define __declspec(x)
+#define _export
+typedef long long __int64;
+typedef char CHAR;
+typedef BYTE *LPBYTE;
+typedef void *HMODULE;
+typedef void *HKEY;
+
+typedef struct{
+  LONG left,top,right,bottom;
+}RECT;
+
+typedef struct{
+  short Left,Top,Right,Bottom;
+}SMALL_RECT;
+
+typedef struct{
+  DWORD dwFileAttributes;
+  FILETIME ftCreationTime;
+  FILETIME ftLastAccessTime;
+  FILETIME ftLastWriteTime;
+  DWORD nFileSizeHigh;
+  DWORD nFileSizeLow;
+  DWORD dwReserved0;
+  DWORD dwReserved1;
+  CHAR cFileName[MAX_PATH];
+  CHAR cAlternateFileName[14];
+}WIN32_FIND_DATA;
+
+typedef BYTE *PBYTE;
+
+#define REG_SZ 1
+#define REG_BINARY 3
+#define REG_DWORD 4
+#define KEY_READ 0x20019
+#define KEY_WRITE 0x20006
+#define KEY_ALL_ACCESS 0xF003F
+#define HKEY_CURRENT_USER ((HKEY)(uintptr_t)0x80000001)
+
+#define TIME_ZONE_ID_UNKNOWN 0
+#define TIME_ZONE_ID_STANDARD 1
+#define TIME_ZONE_ID_DAYLIGHT 2
+
+typedef struct{
+  WORD wYear;
+  WORD wMonth;
+  WORD wDayOfWeek;
+  WORD wDay;
+  WORD wHour;
+  WORD wMinute;
+  WORD wSecond;
+  WORD wMilliseconds;
+}SYSTEMTIME;
+
+typedef struct{
+  LONG Bias;
+  wchar_t StandardName[32];
+  SYSTEMTIME StandardDate;
+  LONG StandardBias;
+  wchar_t DaylightName[32];
+  SYSTEMTIME DaylightDate;
+  LONG DaylightBias;
+}TIME_ZONE_INFORMATION;
+
+typedef pthread_mutex_t CRITICAL_SECTION;
+
+//winapi abs() gets int, timeouts are checked as abs(GetTickCount()-tick)
+inline int abs(DWORD val)
+{
+  return abs((int)val);
+}
+
+HANDLE CreateFile(const char* name,DWORD access,DWORD share,LPSECURITY_ATTRIBUTES sa,
+                  DWORD disposition,DWORD flags,HANDLE tmpl);
+BOOL ReadFile(HANDLE file,LPVOID buf,DWORD size,LPDWORD rd,LPOVERLAPPED ov);
+BOOL WriteFile(HANDLE file,LPCVOID buf,DWORD size,LPDWORD wr,LPOVERLAPPED ov);
+DWORD SetFilePointer(HANDLE file,LONG low,PLONG high,DWORD method);
+DWORD GetFileSize(HANDLE file,LPDWORD high);
+BOOL GetFileTime(HANDLE file,FILETIME* created,FILETIME* accessed,FILETIME* written);
+LONG CompareFileTime(const FILETIME* a,const FILETIME* b);
+HANDLE CreateFileMapping(HANDLE file,LPSECURITY_ATTRIBUTES sa,DWORD protect,
+                         DWORD sizehigh,DWORD sizelow,const char* name);
+LPVOID MapViewOfFile(HANDLE map,DWORD access,DWORD offhigh,DWORD offlow,SIZE_T size);
+BOOL UnmapViewOfFile(LPCVOID addr);
+BOOL DeleteFile(const char* name);
+BOOL FlushFileBuffers(HANDLE file);
+BOOL SetEndOfFile(HANDLE file);
+BOOL MoveFile(const char* from,const char* to);
+BOOL MoveFileEx(const char* from,const char* to,DWORD flags);
+BOOL CreateDirectory(const char* name,LPSECURITY_ATTRIBUTES sa);
+BOOL RemoveDirectory(const char* name);
+DWORD GetTempPath(DWORD size,char* buf);
+DWORD GetTempFileName(const char* path,const char* prefix,DWORD unique,char* name);
+HANDLE FindFirstFile(const char* mask,WIN32_FIND_DATA* fd);
+BOOL FindNextFile(HANDLE find,WIN32_FIND_DATA* fd);
+BOOL FindClose(HANDLE find);
+BOOL CloseHandle(HANDLE h);
+DWORD GetLastError();
+
+HANDLE CreateThread(LPSECURITY_ATTRIBUTES sa,SIZE_T stack,LPTHREAD_START_ROUTINE proc,
+                    LPVOID param,DWORD flags,LPDWORD tid);
+DWORD WaitForSingleObject(HANDLE h,DWORD timeout);
+DWORD WaitForMultipleObjects(DWORD count,const HANDLE* h,BOOL all,DWORD timeout);
+HANDLE CreateEvent(LPSECURITY_ATTRIBUTES sa,BOOL manual,BOOL state,const char* name);
+BOOL SetEvent(HANDLE event);
+BOOL ResetEvent(HANDLE event);
+HANDLE CreateSemaphore(LPSECURITY_ATTRIBUTES sa,LONG count,LONG maxcount,const char* name);
+BOOL ReleaseSemaphore(HANDLE sem,LONG count,PLONG prev);
+HANDLE CreateMutex(LPSECURITY_ATTRIBUTES sa,BOOL owned,const char* name);
+BOOL ReleaseMutex(HANDLE mutex);
+void InitializeCriticalSection(CRITICAL_SECTION* cs);
+void DeleteCriticalSection(CRITICAL_SECTION* cs);
+void EnterCriticalSection(CRITICAL_SECTION* cs);
+void LeaveCriticalSection(CRITICAL_SECTION* cs);
+LONG InterlockedIncrement(LONG volatile* val);
+LONG InterlockedDecrement(LONG volatile* val);
+LONG InterlockedExchange(LONG volatile* dst,LONG val);
+LONG InterlockedCompareExchange(LONG volatile* dst,LONG val,LONG cmp);
+void GetSystemInfo(SYSTEM_INFO* si);
+
+void GetStartupInfo(STARTUPINFO* si);
+BOOL CreateProcess(const char* app,char* cmd,LPSECURITY_ATTRIBUTES psa,LPSECURITY_ATTRIBUTES tsa,
+                   BOOL inherit,DWORD flags,LPVOID env,const char* dir,
+                   STARTUPINFO* si,PROCESS_INFORMATION* pi);
+BOOL CreatePipe(HANDLE* rd,HANDLE* wr,LPSECURITY_ATTRIBUTES sa,DWORD size);
+BOOL PeekNamedPipe(HANDLE pipe,LPVOID buf,DWORD size,LPDWORD rd,LPDWORD avail,LPDWORD left);
+HANDLE GetStdHandle(DWORD std);
+BOOL GetConsoleMode(HANDLE h,LPDWORD mode);
+BOOL SetConsoleMode(HANDLE h,DWORD mode);
+DWORD GetConsoleTitle(char* buf,DWORD size);
+BOOL SetConsoleTitle(const char* title);
+DWORD GetTickCount();
+void Sleep(DWORD ms);
+DWORD GetEnvironmentVariable(const char* name,char* buf,DWORD size);
+DWORD GetCurrentDirectory(DWORD size,char* buf);
+DWORD GetFileAttributes(const char* name);
+BOOL SetFileAttributes(const char* name,DWORD attr);
+void GetLocalTime(SYSTEMTIME* st);
+void GetSystemTime(SYSTEMTIME* st);
+DWORD GetTimeZoneInformation(TIME_ZONE_INFORMATION* tzi);
+
+int lstrlen(const char* s);
+char* lstrcpy(char* dst,const char* src);
+char* lstrcpyn(char* dst,const char* src,int size);
+char* lstrcat(char* dst,const char* src);
+int lstrcmp(const char* a,const char* b);
+int lstrcmpi(const char* a,const char* b);
+
+LONG RegCreateKeyEx(HKEY root,const char* key,DWORD reserved,char* cls,DWORD options,
+                    DWORD access,LPSECURITY_ATTRIBUTES sa,HKEY* result,LPDWORD disposition);
+LONG RegOpenKeyEx(HKEY root,const char* key,DWORD options,DWORD access,HKEY* result);
+LONG RegCloseKey(HKEY key);
+LONG RegSetValueEx(HKEY key,const char* name,DWORD reserved,DWORD type,const BYTE* data,DWORD size);
+LONG RegQueryValueEx(HKEY key,const char* name,LPDWORD reserved,LPDWORD type,LPBYTE data,LPDWORD size);
+LONG RegEnumValue(HKEY key,DWORD index,char* name,LPDWORD namesize,LPDWORD reserved,
+                  LPDWORD type,LPBYTE data,LPDWORD size);
+LONG RegDeleteValue(HKEY key,const char* name);
+LONG RegDeleteKey(HKEY key,const char* subkey);
+
+#endif
@@ -0,0 +1,85 @@
+/*
+  Copyright (C) 2000 Konstantin Stupnik
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+  Winsock 1.1 of the host tests over BSD sockets. Differences of
+  winsock the sources rely on are kept: nfds of select is ignored
+  and its timeout is not changed, connect in progress is reported
+  as WSAEWOULDBLOCK.
+*/
+
+#ifndef __TEST_WINSOCK_H__
+#define __TEST_WINSOCK_H__
+
+#include "windows.h"
+#include <errno.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <sys/ioctl.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+typedef int SOCKET;
+typedef sockaddr_in SOCKADDR_IN;
+
+#define INVALID_SOCKET (-1)
+#define SOCKET_ERROR (-1)
+#define WSAEWOULDBLOCK EWOULDBLOCK
+#define MAKEWORD(a,b) ((WORD)(((BYTE)(a))|((WORD)((BYTE)(b)))<<8))
+
+typedef struct{
+  WORD wVersion;
+}WSAData,WSADATA;
+
+inline int WSAStartup(WORD version,WSAData* data)
+{
+  data->wVersion=version;
+  return 0;
+}
+
+inline int WSACleanup()
+{
+  return 0;
+}
+
+inline int WSAGetLastError()
+{
+  return errno==EINPROGRESS?WSAEWOULDBLOCK:errno;
+}
+
+inline int closesocket(SOCKET s)
+{
+  return close(s);
+}
+
+inline int ioctlsocket(SOCKET s,long cmd,u_long* arg)
+{
+  int val=(int)*arg;
+  return ioctl(s,cmd,&val);
+}
+
+inline int WinSelect(fd_set* rd,fd_set* wr,fd_set* ex,const timeval* timeout)
+{
+  timeval tv;
+  if(timeout)tv=*timeout;
+  return select(FD_SETSIZE,rd,wr,ex,timeout?&tv:NULL);
+}
+
+#define select(n,rd,wr,ex,timeout) WinSelect(rd,wr,ex,timeout)
+
+#endif